@@ -21,6 +21,7 @@
 #define _XOPEN_SOURCE 700 /*required for strptime of GNU libc*/
 #endif
 
+#include <ctype.h>
 #include <time.h>
 
 #if !defined(_WIN32) && !defined(__ANDROID__) && !defined(__QNXNTO__)
@@ -375,6 +376,63 @@ BELLE_SIP_INSTANCIATE_VPTR(LinphoneCallLog, belle_sip_object_t,
  * SQL storage related functions                                               *
  ******************************************************************************/
 
+#define CALL_LOG_COLUMNS "id, caller, callee, direction, duration, start_time, connected_time, status, videoEnabled, quality, call_id, refkey"
+#define CALL_LOG_COLUMN_COUNT 12
+
+static char *call_log_lowercase(char *str) {
+	char *it;
+	for (it = str; *it != '\0'; it++)
+		*it = (char)tolower((unsigned char)*it);
+	return str;
+}
+
+/*
+ * Caller and callee are looked up by their uri without display name nor parameters.
+ * Scheme and host are case insensitive (RFC 3261 19.1.4) so they are lowercased, the username and the port are kept.
+ * The same form is used when storing and when looking up a call log.
+ * The returned string must be freed with ms_free().
+ */
+static char *call_log_address_to_uri(const LinphoneAddress *addr) {
+	const char *scheme = linphone_address_get_scheme(addr);
+	const char *username = linphone_address_get_username(addr);
+	const char *domain = linphone_address_get_domain(addr);
+	int port = linphone_address_get_port(addr);
+	char *lower_scheme = call_log_lowercase(ms_strdup(scheme ? scheme : "sip"));
+	char *host;
+	char *uri;
+
+	if (domain && strchr(domain, ':'))
+		host = ms_strdup_printf("[%s]", domain);
+	else
+		host = ms_strdup(domain ? domain : "");
+	call_log_lowercase(host);
+	if (port > 0) {
+		char *host_port = ms_strdup_printf("%s:%i", host, port);
+		ms_free(host);
+		host = host_port;
+	}
+
+	if (username)
+		uri = ms_strdup_printf("%s:%s@%s", lower_scheme, username, host);
+	else
+		uri = ms_strdup_printf("%s:%s", lower_scheme, host);
+	ms_free(lower_scheme);
+	ms_free(host);
+	return uri;
+}
+
+static char *call_log_string_to_uri(const char *str) {
+	LinphoneAddress *addr;
+	char *uri;
+
+	if (!str) return NULL;
+	addr = linphone_address_new(str);
+	if (!addr) return NULL;
+	uri = call_log_address_to_uri(addr);
+	linphone_address_unref(addr);
+	return uri;
+}
+
 static void linphone_create_call_log_table(sqlite3* db) {
 	char* errmsg=NULL;
 	int ret;
@@ -397,6 +455,44 @@ static void linphone_create_call_log_table(sqlite3* db) {
 	}
 }
 
+static void linphone_update_call_log_uris(sqlite3* db) {
+	sqlite3_stmt *select_stmt = NULL;
+	sqlite3_stmt *update_stmt = NULL;
+	uint64_t begin, end;
+	int count = 0;
+
+	begin = ortp_get_cur_time_ms();
+	if (sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL) != SQLITE_OK) {
+		ms_error("Unable to start call_history uris migration: %s.", sqlite3_errmsg(db));
+		return;
+	}
+	if (sqlite3_prepare_v2(db, "SELECT id, caller, callee FROM call_history", -1, &select_stmt, NULL) != SQLITE_OK
+		|| sqlite3_prepare_v2(db, "UPDATE call_history SET caller_uri = ?1, callee_uri = ?2 WHERE id = ?3", -1, &update_stmt, NULL) != SQLITE_OK) {
+		ms_error("Unable to fill call_history uris: %s.", sqlite3_errmsg(db));
+	} else {
+		while (sqlite3_step(select_stmt) == SQLITE_ROW) {
+			char *caller_uri = call_log_string_to_uri((const char *)sqlite3_column_text(select_stmt, 1));
+			char *callee_uri = call_log_string_to_uri((const char *)sqlite3_column_text(select_stmt, 2));
+
+			sqlite3_bind_text(update_stmt, 1, caller_uri, -1, SQLITE_TRANSIENT);
+			sqlite3_bind_text(update_stmt, 2, callee_uri, -1, SQLITE_TRANSIENT);
+			sqlite3_bind_int64(update_stmt, 3, sqlite3_column_int64(select_stmt, 0));
+			if (sqlite3_step(update_stmt) != SQLITE_DONE)
+				ms_error("Unable to update call_history uris: %s.", sqlite3_errmsg(db));
+			sqlite3_reset(update_stmt);
+			count++;
+
+			if (caller_uri) ms_free(caller_uri);
+			if (callee_uri) ms_free(callee_uri);
+		}
+	}
+	sqlite3_finalize(select_stmt);
+	sqlite3_finalize(update_stmt);
+	sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
+	end = ortp_get_cur_time_ms();
+	ms_message("Table call_history updated with uris of %i call logs in %i ms.", count, (int)(end - begin));
+}
+
 static void linphone_update_call_log_table(sqlite3* db) {
 	char* errmsg=NULL;
 	int ret;
@@ -415,6 +511,125 @@ static void linphone_update_call_log_table(sqlite3* db) {
 			ms_debug("Table call_history updated successfully for call_id and refkey.");
 		}
 	}
+
+	// for indexed lookups by address
+	ret=sqlite3_exec(db,"ALTER TABLE call_history ADD COLUMN caller_uri TEXT;",NULL,NULL,&errmsg);
+	if(ret != SQLITE_OK) {
+		ms_message("Table already up to date: %s.", errmsg);
+		sqlite3_free(errmsg);
+	} else {
+		ret=sqlite3_exec(db,"ALTER TABLE call_history ADD COLUMN callee_uri TEXT;",NULL,NULL,&errmsg);
+		if(ret != SQLITE_OK) {
+			ms_message("Table already up to date: %s.", errmsg);
+			sqlite3_free(errmsg);
+		} else {
+			linphone_update_call_log_uris(db);
+		}
+	}
+
+	ret=sqlite3_exec(db,"CREATE INDEX IF NOT EXISTS call_history_caller_uri_index ON call_history (caller_uri, callee_uri);",NULL,NULL,&errmsg);
+	if(ret != SQLITE_OK) {
+		ms_error("Error in creation of caller_uri index: %s.", errmsg);
+		sqlite3_free(errmsg);
+	}
+	ret=sqlite3_exec(db,"CREATE INDEX IF NOT EXISTS call_history_callee_uri_index ON call_history (callee_uri);",NULL,NULL,&errmsg);
+	if(ret != SQLITE_OK) {
+		ms_error("Error in creation of callee_uri index: %s.", errmsg);
+		sqlite3_free(errmsg);
+	}
+}
+
+static sqlite3_stmt *linphone_call_log_prepare_stmt(sqlite3 *db, const char *query) {
+	sqlite3_stmt *stmt = NULL;
+	if (sqlite3_prepare_v2(db, query, -1, &stmt, NULL) != SQLITE_OK) {
+		ms_error("Unable to prepare statement %s: %s.", query, sqlite3_errmsg(db));
+		sqlite3_finalize(stmt);
+		return NULL;
+	}
+	return stmt;
+}
+
+static void linphone_core_call_log_prepare_stmts(LinphoneCore *lc) {
+	sqlite3 *db = lc->logs_db;
+
+	lc->logs_db_insert_stmt = linphone_call_log_prepare_stmt(db,
+		"INSERT INTO call_history (caller, callee, direction, duration, start_time, connected_time, status, videoEnabled, quality, call_id, refkey, caller_uri, callee_uri)"
+		" VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11, ?12, ?13)"
+	);
+	lc->logs_db_delete_stmt = linphone_call_log_prepare_stmt(db, "DELETE FROM call_history WHERE id = ?1");
+	lc->logs_db_delete_all_stmt = linphone_call_log_prepare_stmt(db, "DELETE FROM call_history");
+	lc->logs_db_count_stmt = linphone_call_log_prepare_stmt(db, "SELECT count(*) FROM call_history");
+	lc->logs_db_history_stmt = linphone_call_log_prepare_stmt(db,
+		"SELECT " CALL_LOG_COLUMNS " FROM call_history ORDER BY id DESC LIMIT ?1"
+	);
+	lc->logs_db_peer_stmt = linphone_call_log_prepare_stmt(db,
+		"SELECT " CALL_LOG_COLUMNS " FROM call_history"
+		" WHERE caller_uri = ?1 OR callee_uri = ?1"
+		" ORDER BY id DESC LIMIT ?3 OFFSET ?4"
+	);
+	lc->logs_db_peer_and_local_stmt = linphone_call_log_prepare_stmt(db,
+		"SELECT " CALL_LOG_COLUMNS " FROM call_history"
+		" WHERE (caller_uri = ?2 AND callee_uri = ?1 AND direction = 0) OR (caller_uri = ?1 AND callee_uri = ?2 AND direction = 1)"
+		" ORDER BY id DESC LIMIT ?3 OFFSET ?4"
+	);
+	lc->logs_db_last_outgoing_stmt = linphone_call_log_prepare_stmt(db,
+		"SELECT " CALL_LOG_COLUMNS " FROM call_history WHERE direction = 0 ORDER BY id DESC LIMIT 1"
+	);
+	lc->logs_db_call_id_stmt = linphone_call_log_prepare_stmt(db,
+		"SELECT " CALL_LOG_COLUMNS " FROM call_history WHERE call_id = ?1 ORDER BY id DESC LIMIT 1"
+	);
+}
+
+static void linphone_core_call_log_finalize_stmts(LinphoneCore *lc) {
+	sqlite3_stmt **stmts[] = {
+		&lc->logs_db_insert_stmt,
+		&lc->logs_db_delete_stmt,
+		&lc->logs_db_delete_all_stmt,
+		&lc->logs_db_count_stmt,
+		&lc->logs_db_history_stmt,
+		&lc->logs_db_peer_stmt,
+		&lc->logs_db_peer_and_local_stmt,
+		&lc->logs_db_last_outgoing_stmt,
+		&lc->logs_db_call_id_stmt
+	};
+	size_t i;
+
+	for (i = 0; i < sizeof(stmts) / sizeof(stmts[0]); i++) {
+		sqlite3_finalize(*stmts[i]);
+		*stmts[i] = NULL;
+	}
+}
+
+/*
+ * The bctbx vfs has no shared memory support, WAL is only available in exclusive locking mode.
+ * Other processes can not open the database while it is in use, so WAL is disabled by default.
+ * The journal mode is persistent: when WAL is disabled the database is brought back to the rollback journal.
+ */
+static void linphone_call_log_enable_wal(sqlite3 *db, bool_t enable) {
+	sqlite3_stmt *stmt;
+	bool_t enabled = FALSE;
+
+	if (!enable) {
+		sqlite3_exec(db, "PRAGMA journal_mode=DELETE;", NULL, NULL, NULL);
+		return;
+	}
+
+	sqlite3_exec(db, "PRAGMA locking_mode=EXCLUSIVE;", NULL, NULL, NULL);
+	stmt = linphone_call_log_prepare_stmt(db, "PRAGMA journal_mode=WAL;");
+	if (stmt && sqlite3_step(stmt) == SQLITE_ROW) {
+		const char *mode = (const char *)sqlite3_column_text(stmt, 0);
+		enabled = mode && strcmp(mode, "wal") == 0;
+	}
+	sqlite3_finalize(stmt);
+
+	if (enabled) {
+		// Commits are durable at the next checkpoint, the database stays consistent.
+		sqlite3_exec(db, "PRAGMA synchronous=NORMAL;", NULL, NULL, NULL);
+	} else {
+		sqlite3_exec(db, "PRAGMA journal_mode=DELETE;", NULL, NULL, NULL);
+		sqlite3_exec(db, "PRAGMA locking_mode=NORMAL;", NULL, NULL, NULL);
+		ms_warning("Unable to enable WAL journal mode on call logs database.");
+	}
 }
 
 void linphone_core_call_log_storage_init(LinphoneCore *lc) {
@@ -432,9 +647,15 @@ void linphone_core_call_log_storage_init(LinphoneCore *lc) {
 		return;
 	}
 
+	linphone_call_log_enable_wal(db, !!lp_config_get_int(lc->config, "misc", "call_logs_db_wal_enabled", 0));
+
 	linphone_create_call_log_table(db);
 	linphone_update_call_log_table(db);
 	lc->logs_db = db;
+	linphone_core_call_log_prepare_stmts(lc);
+
+	lc->logs_db_batch_size = lp_config_get_int(lc->config, "misc", "call_logs_db_batch_size", 1);
+	lc->logs_db_batch_delay = lp_config_get_int(lc->config, "misc", "call_logs_db_batch_delay_ms", 1000);
 
 	// Load the existing call logs
 	linphone_core_get_call_history(lc);
@@ -442,6 +663,17 @@ void linphone_core_call_log_storage_init(LinphoneCore *lc) {
 
 void linphone_core_call_log_storage_close(LinphoneCore *lc) {
 	if (lc->logs_db){
+		linphone_core_flush_call_logs(lc);
+		if (lc->logs_db_pending_logs) {
+			ms_error("%u call logs could not be written before closing the call logs database.", (unsigned int)bctbx_list_size(lc->logs_db_pending_logs));
+			lc->logs_db_pending_logs = bctbx_list_free_with_data(lc->logs_db_pending_logs, (void (*)(void*))linphone_call_log_unref);
+			if (lc->logs_db_flush_timer) {
+				if (lc->sal) lc->sal->cancelTimer(lc->logs_db_flush_timer);
+				belle_sip_object_unref(lc->logs_db_flush_timer);
+				lc->logs_db_flush_timer = NULL;
+			}
+		}
+		linphone_core_call_log_finalize_stmts(lc);
 		sqlite3_close(lc->logs_db);
 		lc->logs_db = NULL;
 	}
@@ -525,53 +757,146 @@ error:
 	return 0;
 }
 
-static void linphone_sql_request_call_log(sqlite3 *db, const char *stmt, CallLogStorageResult *clsres) {
-	char* errmsg = NULL;
+static void linphone_sql_request_call_log_stmt(sqlite3 *db, sqlite3_stmt *stmt, CallLogStorageResult *clsres) {
+	char *argv[CALL_LOG_COLUMN_COUNT];
 	int ret;
-	ret = sqlite3_exec(db, stmt, create_call_log, clsres, &errmsg);
-	if (ret != SQLITE_OK) {
-		ms_error("linphone_sql_request: statement %s -> error sqlite3_exec(): %s.", stmt, errmsg);
-		sqlite3_free(errmsg);
+	int i;
+
+	if (!stmt) return;
+
+	while ((ret = sqlite3_step(stmt)) == SQLITE_ROW) {
+		for (i = 0; i < CALL_LOG_COLUMN_COUNT; i++)
+			argv[i] = (char *)sqlite3_column_text(stmt, i);
+		create_call_log(clsres, CALL_LOG_COLUMN_COUNT, argv, NULL);
+	}
+	if (ret != SQLITE_DONE) {
+		ms_error("linphone_sql_request: statement %s -> error sqlite3_step(): %s.", sqlite3_sql(stmt), sqlite3_errmsg(db));
 	}
+	sqlite3_reset(stmt);
+	sqlite3_clear_bindings(stmt);
 }
 
-static int linphone_sql_request_generic(sqlite3* db, const char *stmt) {
-	char* errmsg = NULL;
+static int linphone_sql_request_generic_stmt(sqlite3 *db, sqlite3_stmt *stmt) {
 	int ret;
-	ret = sqlite3_exec(db, stmt, NULL, NULL, &errmsg);
-	if (ret != SQLITE_OK) {
-		ms_error("linphone_sql_request: statement %s -> error sqlite3_exec(): %s.", stmt, errmsg);
-		sqlite3_free(errmsg);
+
+	if (!stmt) return SQLITE_ERROR;
+
+	ret = sqlite3_step(stmt);
+	if (ret != SQLITE_DONE) {
+		ms_error("linphone_sql_request: statement %s -> error sqlite3_step(): %s.", sqlite3_sql(stmt), sqlite3_errmsg(db));
 	}
+	sqlite3_reset(stmt);
+	sqlite3_clear_bindings(stmt);
 	return ret;
 }
 
-void linphone_core_store_call_log(LinphoneCore *lc, LinphoneCallLog *log) {
-	if (lc && lc->logs_db){
-		char *from, *to;
-		char *buf;
-
-		from = linphone_address_as_string(log->from);
-		to = linphone_address_as_string(log->to);
-		buf = sqlite3_mprintf("INSERT INTO call_history VALUES(NULL,%Q,%Q,%i,%i,%lld,%lld,%i,%i,%f,%Q,%Q);",
-						from,
-						to,
-						log->dir,
-						log->duration,
-						(int64_t)log->start_date_time,
-						(int64_t)log->connected_date_time,
-						log->status,
-						log->video_enabled ? 1 : 0,
-						log->quality,
-						log->call_id,
-						log->refkey
-					);
-		linphone_sql_request_generic(lc->logs_db, buf);
-		sqlite3_free(buf);
-		ms_free(from);
-		ms_free(to);
+static int linphone_core_write_call_log(LinphoneCore *lc, LinphoneCallLog *log) {
+	sqlite3_stmt *stmt = lc->logs_db_insert_stmt;
+	char *from, *to;
+	char *from_uri, *to_uri;
+	int ret;
 
+	if (!stmt) return SQLITE_ERROR;
+
+	from = linphone_address_as_string(log->from);
+	to = linphone_address_as_string(log->to);
+	from_uri = call_log_address_to_uri(log->from);
+	to_uri = call_log_address_to_uri(log->to);
+
+	sqlite3_bind_text(stmt, 1, from, -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 2, to, -1, SQLITE_STATIC);
+	sqlite3_bind_int(stmt, 3, log->dir);
+	sqlite3_bind_int(stmt, 4, log->duration);
+	sqlite3_bind_int64(stmt, 5, (int64_t)log->start_date_time);
+	sqlite3_bind_int64(stmt, 6, (int64_t)log->connected_date_time);
+	sqlite3_bind_int(stmt, 7, log->status);
+	sqlite3_bind_int(stmt, 8, log->video_enabled ? 1 : 0);
+	sqlite3_bind_double(stmt, 9, log->quality);
+	sqlite3_bind_text(stmt, 10, log->call_id, -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 11, log->refkey, -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 12, from_uri, -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 13, to_uri, -1, SQLITE_STATIC);
+
+	ret = linphone_sql_request_generic_stmt(lc->logs_db, stmt);
+	if (ret == SQLITE_DONE)
 		log->storage_id = (unsigned int)sqlite3_last_insert_rowid(lc->logs_db);
+
+	ms_free(from);
+	ms_free(to);
+	ms_free(from_uri);
+	ms_free(to_uri);
+	return ret;
+}
+
+static int call_logs_flush_timer_cb(void *data, unsigned int revents) {
+	LinphoneCore *lc = (LinphoneCore *)data;
+	linphone_core_flush_call_logs(lc);
+	return BELLE_SIP_STOP;
+}
+
+static void linphone_core_schedule_call_logs_flush(LinphoneCore *lc) {
+	if (!lc->logs_db_flush_timer && lc->sal)
+		lc->logs_db_flush_timer = lc->sal->createTimer(call_logs_flush_timer_cb, lc, (unsigned int)lc->logs_db_batch_delay, "Call logs flush");
+}
+
+void linphone_core_flush_call_logs(LinphoneCore *lc) {
+	bctbx_list_t *pending_logs;
+	bctbx_list_t *it;
+	char *errmsg = NULL;
+
+	if (lc->logs_db_flush_timer) {
+		if (lc->sal) lc->sal->cancelTimer(lc->logs_db_flush_timer);
+		belle_sip_object_unref(lc->logs_db_flush_timer);
+		lc->logs_db_flush_timer = NULL;
+	}
+
+	if (!lc->logs_db_pending_logs) return;
+
+	if (sqlite3_exec(lc->logs_db, "BEGIN;", NULL, NULL, &errmsg) != SQLITE_OK) {
+		ms_error("Unable to begin call logs flush: %s.", errmsg);
+		sqlite3_free(errmsg);
+		linphone_core_schedule_call_logs_flush(lc);
+		return;
+	}
+
+	pending_logs = lc->logs_db_pending_logs;
+	for (it = pending_logs; it != NULL; it = bctbx_list_next(it)) {
+		if (linphone_core_write_call_log(lc, (LinphoneCallLog *)bctbx_list_get_data(it)) != SQLITE_DONE)
+			break;
+	}
+	if (it == NULL && sqlite3_exec(lc->logs_db, "COMMIT;", NULL, NULL, &errmsg) != SQLITE_OK) {
+		ms_error("Unable to commit call logs flush: %s.", errmsg);
+		sqlite3_free(errmsg);
+		it = pending_logs;
+	}
+
+	if (it != NULL) {
+		// Nothing was written, the whole batch is kept for the next flush.
+		sqlite3_exec(lc->logs_db, "ROLLBACK;", NULL, NULL, NULL);
+		for (it = pending_logs; it != NULL; it = bctbx_list_next(it))
+			((LinphoneCallLog *)bctbx_list_get_data(it))->storage_id = 0;
+		ms_warning("%u call logs not flushed, retrying later.", (unsigned int)bctbx_list_size(pending_logs));
+		linphone_core_schedule_call_logs_flush(lc);
+		return;
+	}
+
+	lc->logs_db_pending_logs = NULL;
+	ms_debug("%u call logs flushed.", (unsigned int)bctbx_list_size(pending_logs));
+	bctbx_list_free_with_data(pending_logs, (void (*)(void*))linphone_call_log_unref);
+}
+
+void linphone_core_store_call_log(LinphoneCore *lc, LinphoneCallLog *log) {
+	if (lc && lc->logs_db){
+		if (lc->logs_db_batch_size > 1 && lc->sal) {
+			// Written later with other call logs in a single transaction.
+			lc->logs_db_pending_logs = bctbx_list_append(lc->logs_db_pending_logs, linphone_call_log_ref(log));
+			if (bctbx_list_size(lc->logs_db_pending_logs) >= (size_t)lc->logs_db_batch_size)
+				linphone_core_flush_call_logs(lc);
+			else
+				linphone_core_schedule_call_logs_flush(lc);
+		} else {
+			linphone_core_write_call_log(lc, log);
+		}
 	}
 
 	if (lc) {
@@ -580,156 +905,160 @@ void linphone_core_store_call_log(LinphoneCore *lc, LinphoneCallLog *log) {
 }
 
 const bctbx_list_t *linphone_core_get_call_history(LinphoneCore *lc) {
-	char *buf;
 	uint64_t begin,end;
 	CallLogStorageResult clsres;
 
 	if (!lc || lc->logs_db == NULL) return NULL;
 		if (lc->call_logs != NULL) return lc->call_logs;
 
-	if (lc->max_call_logs != LINPHONE_MAX_CALL_HISTORY_UNLIMITED){
-		buf = sqlite3_mprintf("SELECT * FROM call_history ORDER BY id DESC LIMIT %i", lc->max_call_logs);
-	}else{
-		buf = sqlite3_mprintf("SELECT * FROM call_history ORDER BY id DESC");
+	linphone_core_flush_call_logs(lc);
+	if (lc->logs_db_history_stmt) {
+		sqlite3_bind_int(lc->logs_db_history_stmt, 1,
+			lc->max_call_logs != LINPHONE_MAX_CALL_HISTORY_UNLIMITED ? lc->max_call_logs : -1
+		);
 	}
 
 	clsres.core = lc;
 	clsres.result = NULL;
 	begin = ortp_get_cur_time_ms();
-	linphone_sql_request_call_log(lc->logs_db, buf, &clsres);
+	linphone_sql_request_call_log_stmt(lc->logs_db, lc->logs_db_history_stmt, &clsres);
 	end = ortp_get_cur_time_ms();
 	ms_message("%s(): completed in %i ms",__FUNCTION__, (int)(end-begin));
-	sqlite3_free(buf);
 
 	lc->call_logs = clsres.result;
 	return lc->call_logs;
 }
 
 void linphone_core_delete_call_history(LinphoneCore *lc) {
-	char *buf;
-
 	if (!lc || lc->logs_db == NULL) return ;
 
-	buf = sqlite3_mprintf("DELETE FROM call_history");
-	linphone_sql_request_generic(lc->logs_db, buf);
-	sqlite3_free(buf);
+	lc->logs_db_pending_logs = bctbx_list_free_with_data(lc->logs_db_pending_logs, (void (*)(void*))linphone_call_log_unref);
+	linphone_sql_request_generic_stmt(lc->logs_db, lc->logs_db_delete_all_stmt);
 }
 
 void linphone_core_delete_call_log(LinphoneCore *lc, LinphoneCallLog *log) {
-	char *buf;
-
 	if (!lc || lc->logs_db == NULL) return ;
 
-	buf = sqlite3_mprintf("DELETE FROM call_history WHERE id = %u", log->storage_id);
-	linphone_sql_request_generic(lc->logs_db, buf);
-	sqlite3_free(buf);
+	// Not written yet.
+	if (bctbx_list_find(lc->logs_db_pending_logs, log)) {
+		lc->logs_db_pending_logs = bctbx_list_remove(lc->logs_db_pending_logs, log);
+		linphone_call_log_unref(log);
+		return;
+	}
+
+	if (lc->logs_db_delete_stmt) {
+		sqlite3_bind_int64(lc->logs_db_delete_stmt, 1, log->storage_id);
+		linphone_sql_request_generic_stmt(lc->logs_db, lc->logs_db_delete_stmt);
+	}
 }
 
 int linphone_core_get_call_history_size(LinphoneCore *lc) {
 	int numrows = 0;
-	char *buf;
-	sqlite3_stmt *selectStatement;
-	int returnValue;
+	sqlite3_stmt *stmt;
 
 	if (!lc)
 		return 0;
 	if (!lc->logs_db)
 		return (int)bctbx_list_size(lc->call_logs);
 
-	buf = sqlite3_mprintf("SELECT count(*) FROM call_history");
-	returnValue = sqlite3_prepare_v2(lc->logs_db, buf, -1, &selectStatement, NULL);
-	if (returnValue == SQLITE_OK){
-		if(sqlite3_step(selectStatement) == SQLITE_ROW){
-			numrows = sqlite3_column_int(selectStatement, 0);
-		}
-	}
-	sqlite3_finalize(selectStatement);
-	sqlite3_free(buf);
+	linphone_core_flush_call_logs(lc);
+	stmt = lc->logs_db_count_stmt;
+	if (!stmt)
+		return 0;
+	if (sqlite3_step(stmt) == SQLITE_ROW)
+		numrows = sqlite3_column_int(stmt, 0);
+	sqlite3_reset(stmt);
 
 	return numrows;
 }
 
-bctbx_list_t * linphone_core_get_call_history_for_address(LinphoneCore *lc, const LinphoneAddress *addr) {
-	char *buf;
-	char *sipAddress;
-	uint64_t begin,end;
+/*
+ * Call logs exchanged with peer_addr, and local_addr if not NULL, most recent first.
+ * A negative limit returns all the call logs from offset.
+ */
+static bctbx_list_t *linphone_core_request_call_history(
+	LinphoneCore *lc,
+	const LinphoneAddress *peer_addr,
+	const LinphoneAddress *local_addr,
+	int offset,
+	int limit
+) {
+	sqlite3_stmt *stmt = local_addr ? lc->logs_db_peer_and_local_stmt : lc->logs_db_peer_stmt;
+	char *peer_uri;
+	char *local_uri = NULL;
+	uint64_t begin, end;
 	CallLogStorageResult clsres;
 
-	if (!lc || lc->logs_db == NULL || addr == NULL) return NULL;
-
-	/*since we want to append query parameters depending on arguments given, we use malloc instead of sqlite3_mprintf*/
-	sipAddress = linphone_address_as_string_uri_only(addr);
-	buf = sqlite3_mprintf("SELECT * FROM call_history WHERE caller LIKE '%%%q%%' OR callee LIKE '%%%q%%' ORDER BY id DESC", sipAddress, sipAddress); // The '%%%q%%' takes care of the eventual presence of a display name
+	if (!stmt) return NULL;
 
 	clsres.core = lc;
 	clsres.result = NULL;
+
+	linphone_core_flush_call_logs(lc);
+
+	peer_uri = call_log_address_to_uri(peer_addr);
+	sqlite3_bind_text(stmt, 1, peer_uri, -1, SQLITE_STATIC);
+	if (local_addr) {
+		local_uri = call_log_address_to_uri(local_addr);
+		sqlite3_bind_text(stmt, 2, local_uri, -1, SQLITE_STATIC);
+	}
+	sqlite3_bind_int(stmt, 3, limit);
+	sqlite3_bind_int(stmt, 4, offset);
+
 	begin = ortp_get_cur_time_ms();
-	linphone_sql_request_call_log(lc->logs_db, buf, &clsres);
+	linphone_sql_request_call_log_stmt(lc->logs_db, stmt, &clsres);
 	end = ortp_get_cur_time_ms();
-	ms_message("%s(): completed in %i ms",__FUNCTION__, (int)(end-begin));
-	sqlite3_free(buf);
-	ms_free(sipAddress);
+	ms_message("%s(): completed in %i ms", __FUNCTION__, (int)(end - begin));
+
+	ms_free(peer_uri);
+	if (local_uri) ms_free(local_uri);
 
 	return clsres.result;
 }
 
+bctbx_list_t * linphone_core_get_call_history_for_address(LinphoneCore *lc, const LinphoneAddress *addr) {
+	if (!lc || lc->logs_db == NULL || addr == NULL) return NULL;
+
+	return linphone_core_request_call_history(lc, addr, NULL, 0, -1);
+}
+
 bctbx_list_t *linphone_core_get_call_history_2(
 	LinphoneCore *lc,
 	const LinphoneAddress *peer_addr,
 	const LinphoneAddress *local_addr
 ) {
-	char *buf;
-	char *peer_addr_str;
-	char *local_addr_str;
-	uint64_t begin, end;
-	CallLogStorageResult clsres;
-
 	if (!lc || !lc->logs_db || !peer_addr || !local_addr) return NULL;
 
-	peer_addr_str = bctbx_strdup(L_GET_CPP_PTR_FROM_C_OBJECT(peer_addr)->asStringUriOnly().c_str());
-	local_addr_str = bctbx_strdup(L_GET_CPP_PTR_FROM_C_OBJECT(local_addr)->asStringUriOnly().c_str());
-	buf = sqlite3_mprintf(
-		"SELECT * FROM call_history WHERE "
-		"(caller LIKE '%%%q%%' AND callee LIKE '%%%q%%' AND direction = 0) OR "
-		"(caller LIKE '%%%q%%' AND callee LIKE '%%%q%%' AND direction = 1) "
-		"ORDER BY id DESC",
-		local_addr_str,
-		peer_addr_str,
-		peer_addr_str,
-		local_addr_str
-	);
+	return linphone_core_request_call_history(lc, peer_addr, local_addr, 0, -1);
+}
 
-	clsres.core = lc;
-	clsres.result = NULL;
-	begin = ortp_get_cur_time_ms();
-	linphone_sql_request_call_log(lc->logs_db, buf, &clsres);
-	end = ortp_get_cur_time_ms();
-	bctbx_message("%s(): completed in %i ms", __FUNCTION__, (int)(end - begin));
-	sqlite3_free(buf);
-	bctbx_free(peer_addr_str);
-	bctbx_free(local_addr_str);
+bctbx_list_t *linphone_core_get_call_history_range(
+	LinphoneCore *lc,
+	const LinphoneAddress *peer_addr,
+	const LinphoneAddress *local_addr,
+	int offset,
+	int limit
+) {
+	if (!lc || !lc->logs_db || !peer_addr || offset < 0 || limit <= 0) return NULL;
 
-	return clsres.result;
+	return linphone_core_request_call_history(lc, peer_addr, local_addr, offset, limit);
 }
 
 LinphoneCallLog * linphone_core_get_last_outgoing_call_log(LinphoneCore *lc) {
-	char *buf;
 	uint64_t begin,end;
 	CallLogStorageResult clsres;
 	LinphoneCallLog *result = NULL;
 
 	if (!lc || lc->logs_db == NULL) return NULL;
 
-	/*since we want to append query parameters depending on arguments given, we use malloc instead of sqlite3_mprintf*/
-	buf = sqlite3_mprintf("SELECT * FROM call_history WHERE direction = 0 ORDER BY id DESC LIMIT 1");
+	linphone_core_flush_call_logs(lc);
 
 	clsres.core = lc;
 	clsres.result = NULL;
 	begin = ortp_get_cur_time_ms();
-	linphone_sql_request_call_log(lc->logs_db, buf, &clsres);
+	linphone_sql_request_call_log_stmt(lc->logs_db, lc->logs_db_last_outgoing_stmt, &clsres);
 	end = ortp_get_cur_time_ms();
 	ms_message("%s(): completed in %i ms",__FUNCTION__, (int)(end-begin));
-	sqlite3_free(buf);
 
 	if (clsres.result != NULL) {
 		result = (LinphoneCallLog *)bctbx_list_get_data(clsres.result);
@@ -739,23 +1068,21 @@ LinphoneCallLog * linphone_core_get_last_outgoing_call_log(LinphoneCore *lc) {
 }
 
 LinphoneCallLog * linphone_core_find_call_log_from_call_id(LinphoneCore *lc, const char *call_id) {
-	char *buf;
 	uint64_t begin,end;
 	CallLogStorageResult clsres;
 	LinphoneCallLog* result = NULL;
 
-	if (!lc || lc->logs_db == NULL) return NULL;
+	if (!lc || lc->logs_db == NULL || lc->logs_db_call_id_stmt == NULL) return NULL;
 
-	/*since we want to append query parameters depending on arguments given, we use malloc instead of sqlite3_mprintf*/
-	buf = sqlite3_mprintf("SELECT * FROM call_history WHERE call_id = '%q' ORDER BY id DESC LIMIT 1", call_id);
+	linphone_core_flush_call_logs(lc);
+	sqlite3_bind_text(lc->logs_db_call_id_stmt, 1, call_id, -1, SQLITE_STATIC);
 
 	clsres.core = lc;
 	clsres.result = NULL;
 	begin = ortp_get_cur_time_ms();
-	linphone_sql_request_call_log(lc->logs_db, buf, &clsres);
+	linphone_sql_request_call_log_stmt(lc->logs_db, lc->logs_db_call_id_stmt, &clsres);
 	end = ortp_get_cur_time_ms();
 	ms_message("%s(): completed in %i ms",__FUNCTION__, (int)(end-begin));
-	sqlite3_free(buf);
 
 	if (clsres.result != NULL) {
 		result = (LinphoneCallLog *)bctbx_list_get_data(clsres.result);
@@ -215,10 +215,11 @@ end:
 }
 
 static int find_matching_vcard(LinphoneCardDavResponse *response, LinphoneFriend *lf) {
-	if (!response->url || !lf || !lf->vcard || !linphone_vcard_get_url(lf->vcard)) {
+	LinphoneVcard *lvc = lf ? linphone_friend_get_vcard(lf) : NULL;
+	if (!response->url || !lvc || !linphone_vcard_get_url(lvc)) {
 		return 1;
 	}
-	return strcmp(response->url, linphone_vcard_get_url(lf->vcard));
+	return strcmp(response->url, linphone_vcard_get_url(lvc));
 }
 
 static void linphone_carddav_vcards_fetched(LinphoneCardDavContext *cdc, bctbx_list_t *vCards) {
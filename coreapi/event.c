@@ -323,8 +323,7 @@ LinphoneStatus linphone_event_deny_subscription(LinphoneEvent *lev, LinphoneReas
 	return err;
 }
 
-LinphoneStatus linphone_event_notify(LinphoneEvent *lev, const LinphoneContent *body){
-	SalBodyHandler *body_handler;
+LinphoneStatus _linphone_event_notify_body_handler(LinphoneEvent *lev, const SalBodyHandler *body_handler){
 	if (lev->subscription_state!=LinphoneSubscriptionActive && lev->subscription_state!=LinphoneSubscriptionIncomingReceived){
 		ms_error("linphone_event_notify(): cannot notify if subscription is not active.");
 		return -1;
@@ -333,11 +332,14 @@ LinphoneStatus linphone_event_notify(LinphoneEvent *lev, const LinphoneContent *
 		ms_error("linphone_event_notify(): cannot notify if not an incoming subscription.");
 		return -1;
 	}
-	body_handler = sal_body_handler_from_content(body, false);
 	auto subscribeOp = dynamic_cast<SalSubscribeOp *>(lev->op);
 	return subscribeOp->notify(body_handler);
 }
 
+LinphoneStatus linphone_event_notify(LinphoneEvent *lev, const LinphoneContent *body){
+	return _linphone_event_notify_body_handler(lev, sal_body_handler_from_content(body, false));
+}
+
 LinphoneEvent *_linphone_core_create_publish(LinphoneCore *core, LinphoneProxyConfig *cfg, const LinphoneAddress *resource, const char *event, int expires){
 	LinphoneCore *lc = core;
 	LinphoneEvent *lev;
@@ -62,6 +62,8 @@ struct _LinphoneFactory {
 	char *cached_msplugins_dir;
 	LinphoneErrorInfo* ei;
 
+	bool_t config_cache_enabled;
+
 	void *user_data;
 };
 
@@ -164,7 +166,13 @@ static LinphoneCore *_linphone_factory_create_core (
 	bool_t automatically_start
 ) {
 	bctbx_init_logger(FALSE);
-	LpConfig *config = lp_config_new_with_factory(config_path, factory_config_path);
+	LpConfig *config;
+	if (factory->config_cache_enabled && config_path) {
+		char *cache_path = bctbx_strdup_printf("%s.cache", config_path);
+		config = linphone_config_new_with_cache(config_path, factory_config_path, cache_path);
+		bctbx_free(cache_path);
+	} else
+		config = lp_config_new_with_factory(config_path, factory_config_path);
 	LinphoneCore *lc = _linphone_core_new_with_config(cbs, config, user_data, system_context, automatically_start);
 	lp_config_unref(config);
 	bctbx_uninit_logger();
@@ -437,6 +445,14 @@ LinphoneConfig *linphone_factory_create_config_with_factory(LinphoneFactory *fac
 	return linphone_config_new_with_factory(path, factory_path);
 }
 
+void linphone_factory_enable_config_cache(LinphoneFactory *factory, bool_t enable) {
+	factory->config_cache_enabled = enable;
+}
+
+bool_t linphone_factory_config_cache_enabled(const LinphoneFactory *factory) {
+	return factory->config_cache_enabled;
+}
+
 LinphoneConfig *linphone_factory_create_config_from_string(LinphoneFactory *factory, const char *data) {
 	return linphone_config_new_from_buffer(data);
 }
@@ -185,6 +185,8 @@ bctbx_list_t *linphone_find_friend_by_address(bctbx_list_t *fl, const LinphoneAd
 	return res;
 }
 
+static void add_op_to_list_map(LinphoneFriend *lf, const SalOp *op);
+
 void __linphone_friend_do_subscribe(LinphoneFriend *fr){
 	LinphoneCore *lc=fr->lc;
 	const LinphoneAddress *addr = linphone_friend_get_address(fr);
@@ -198,12 +200,14 @@ void __linphone_friend_do_subscribe(LinphoneFriend *fr){
 				fr->lc->vtable.notify_recv(fr->lc,(LinphoneFriend*)fr);
 			*/
 		}else{
+			linphone_friend_remove_op_from_list_map(fr, fr->outsub);
 			fr->outsub->release();
 			fr->outsub=NULL;
 		}
 		fr->outsub=new SalPresenceOp(lc->sal);
 		linphone_configure_op(lc,fr->outsub,addr,NULL,TRUE);
 		fr->outsub->subscribe(lp_config_get_int(lc->config,"sip","subscribe_expires",600));
+		add_op_to_list_map(fr, fr->outsub);
 		fr->subscribe_active=TRUE;
 	} else {
 		ms_error("Can't send a SUBSCRIBE for friend [%p] without an address!", fr);
@@ -220,6 +224,64 @@ LinphoneFriend * linphone_friend_new(void){
 	return obj;
 }
 
+static void linphone_friend_clear_vcard_cache(LinphoneFriend *lf) {
+	if (lf->vcard_buffer) {
+		ms_free(lf->vcard_buffer);
+		lf->vcard_buffer = NULL;
+	}
+	if (lf->vcard_etag) {
+		ms_free(lf->vcard_etag);
+		lf->vcard_etag = NULL;
+	}
+	if (lf->vcard_url) {
+		ms_free(lf->vcard_url);
+		lf->vcard_url = NULL;
+	}
+	if (lf->cached_name) {
+		ms_free(lf->cached_name);
+		lf->cached_name = NULL;
+	}
+	lf->cached_addresses = bctbx_list_free_with_data(lf->cached_addresses, (bctbx_list_free_func)linphone_address_unref);
+	lf->cached_phone_numbers = bctbx_list_free_with_data(lf->cached_phone_numbers, (bctbx_list_free_func)ms_free);
+}
+
+/*
+ * Friends fetched from the database only keep their raw vCard, next to the name, addresses and phone numbers
+ * cached in their own columns. The vCard is parsed the first time something needs more than that.
+ */
+static LinphoneVcard *linphone_friend_load_vcard(const LinphoneFriend *cfr) {
+	LinphoneFriend *fr = (LinphoneFriend *)cfr;
+	LinphoneVcardContext *context;
+	LinphoneVcard *vcard;
+
+	if (!fr->vcard_buffer) return fr->vcard;
+
+	context = fr->lc ? fr->lc->vcard_context : linphone_vcard_context_new();
+	vcard = linphone_vcard_context_get_vcard_from_buffer(context, fr->vcard_buffer);
+	if (!fr->lc) linphone_vcard_context_destroy(context);
+	if (!vcard) {
+		const bctbx_list_t *it;
+		ms_warning("Couldn't parse vCard of friend [%p], rebuilding it from cached fields", fr);
+		vcard = linphone_factory_create_vcard(linphone_factory_get());
+		if (fr->cached_name) linphone_vcard_set_full_name(vcard, fr->cached_name);
+		for (it = fr->cached_addresses; it != NULL; it = bctbx_list_next(it)) {
+			char *uri = linphone_address_as_string_uri_only((const LinphoneAddress *)bctbx_list_get_data(it));
+			linphone_vcard_add_sip_address(vcard, uri);
+			ms_free(uri);
+		}
+		for (it = fr->cached_phone_numbers; it != NULL; it = bctbx_list_next(it)) {
+			linphone_vcard_add_phone_number(vcard, (const char *)bctbx_list_get_data(it));
+		}
+	}
+	linphone_vcard_set_etag(vcard, fr->vcard_etag);
+	linphone_vcard_set_url(vcard, fr->vcard_url);
+	if (fr->vcard) linphone_vcard_unref(fr->vcard);
+	fr->vcard = vcard;
+	// From now on the getters read the parsed vCard, the cached values would only duplicate it.
+	linphone_friend_clear_vcard_cache(fr);
+	return vcard;
+}
+
 #if __clang__ || ((__GNUC__ == 4 && __GNUC_MINOR__ >= 6) || __GNUC__ > 4)
 #pragma GCC diagnostic push
 #endif
@@ -295,6 +357,9 @@ void linphone_core_interpret_friend_uri(LinphoneCore *lc, const char *uri, char
 
 const LinphoneAddress * linphone_friend_get_address(const LinphoneFriend *lf) {
 	if (linphone_core_vcard_supported()) {
+		if (lf->vcard_buffer) {
+			return lf->cached_addresses ? (const LinphoneAddress *)bctbx_list_get_data(lf->cached_addresses) : NULL;
+		}
 		if (lf->vcard) {
 			const bctbx_list_t *sip_addresses = linphone_vcard_get_sip_addresses(lf->vcard);
 			if (sip_addresses) {
@@ -308,11 +373,11 @@ const LinphoneAddress * linphone_friend_get_address(const LinphoneFriend *lf) {
 	return NULL;
 }
 
-static void add_friend_to_list_map_if_not_in_it_yet(LinphoneFriend *lf, const char *uri) {
-	if (!lf || !lf->friend_list || !uri || strlen(uri) == 0) return;
+static void add_friend_to_map_if_not_in_it_yet(LinphoneFriend *lf, bctbx_map_t *map, const char *uri) {
+	if (!lf || !map || !uri || strlen(uri) == 0) return;
 
-	bctbx_iterator_t *it = bctbx_map_cchar_find_key(lf->friend_list->friends_map_uri, uri);
-	bctbx_iterator_t *end = bctbx_map_cchar_end(lf->friend_list->friends_map_uri);
+	bctbx_iterator_t *it = bctbx_map_cchar_find_key(map, uri);
+	bctbx_iterator_t *end = bctbx_map_cchar_end(map);
 	bool_t found = FALSE;
 
 	// Map is sorted, check if next entry matches key otherwise stop
@@ -331,15 +396,15 @@ static void add_friend_to_list_map_if_not_in_it_yet(LinphoneFriend *lf, const ch
 
 	if (!found) {
 		bctbx_pair_t *pair = (bctbx_pair_t*) bctbx_pair_cchar_new(uri, linphone_friend_ref(lf));
-		bctbx_map_cchar_insert_and_delete(lf->friend_list->friends_map_uri, pair);
+		bctbx_map_cchar_insert_and_delete(map, pair);
 	}
 }
 
-static void remove_friend_from_list_map_if_already_in_it(LinphoneFriend *lf, const char *uri) {
-	if (!lf || !lf->friend_list || !uri || strlen(uri) == 0) return;
+static void remove_friend_from_map_if_already_in_it(LinphoneFriend *lf, bctbx_map_t *map, const char *uri) {
+	if (!lf || !map || !uri || strlen(uri) == 0) return;
 
-	bctbx_iterator_t *it = bctbx_map_cchar_find_key(lf->friend_list->friends_map_uri, uri);
-	bctbx_iterator_t *end = bctbx_map_cchar_end(lf->friend_list->friends_map_uri);
+	bctbx_iterator_t *it = bctbx_map_cchar_find_key(map, uri);
+	bctbx_iterator_t *end = bctbx_map_cchar_end(map);
 
 	// Map is sorted, check if next entry matches key otherwise stop
 	while (!bctbx_iterator_cchar_equals(it, end)) {
@@ -349,7 +414,7 @@ static void remove_friend_from_list_map_if_already_in_it(LinphoneFriend *lf, con
 		LinphoneFriend *lf2 = (LinphoneFriend*) bctbx_pair_cchar_get_second(pair);
 		if (lf2 == lf) {
 			linphone_friend_unref(lf2);
-			bctbx_map_cchar_erase(lf->friend_list->friends_map_uri, it);
+			bctbx_map_cchar_erase(map, it);
 			break;
 		}
 		it = bctbx_iterator_cchar_get_next(it);
@@ -358,6 +423,26 @@ static void remove_friend_from_list_map_if_already_in_it(LinphoneFriend *lf, con
 	bctbx_iterator_cchar_delete(end);
 }
 
+static void add_friend_to_list_map_if_not_in_it_yet(LinphoneFriend *lf, const char *uri) {
+	if (lf && lf->friend_list) add_friend_to_map_if_not_in_it_yet(lf, lf->friend_list->friends_map_uri, uri);
+}
+
+static void remove_friend_from_list_map_if_already_in_it(LinphoneFriend *lf, const char *uri) {
+	if (lf && lf->friend_list) remove_friend_from_map_if_already_in_it(lf, lf->friend_list->friends_map_uri, uri);
+}
+
+/*
+ * Subscription ops are indexed by their Call-ID: an out-subscription and the ops of its forked dialogs share it,
+ * and in-subscriptions all have their own.
+ */
+static void add_op_to_list_map(LinphoneFriend *lf, const SalOp *op) {
+	if (lf && lf->friend_list && op) add_friend_to_map_if_not_in_it_yet(lf, lf->friend_list->friends_map_call_id, op->getCallId().c_str());
+}
+
+void linphone_friend_remove_op_from_list_map(LinphoneFriend *lf, const SalOp *op) {
+	if (lf && lf->friend_list && op) remove_friend_from_map_if_already_in_it(lf, lf->friend_list->friends_map_call_id, op->getCallId().c_str());
+}
+
 LinphoneStatus linphone_friend_set_address(LinphoneFriend *lf, const LinphoneAddress *addr) {
 	LinphoneAddress *fr = linphone_address_clone(addr);
 	char *address;
@@ -374,6 +459,7 @@ LinphoneStatus linphone_friend_set_address(LinphoneFriend *lf, const LinphoneAdd
 	}
 
 	if (linphone_core_vcard_supported()) {
+		linphone_friend_load_vcard(lf);
 		if (!lf->vcard) {
 			const char *dpname = linphone_address_get_display_name(fr) ? linphone_address_get_display_name(fr) : linphone_address_get_username(fr);
 			linphone_friend_create_vcard(lf, dpname);
@@ -403,7 +489,7 @@ void linphone_friend_add_address(LinphoneFriend *lf, const LinphoneAddress *addr
 	}
 
 	if (linphone_core_vcard_supported()) {
-		if (lf->vcard) {
+		if (linphone_friend_load_vcard(lf)) {
 			linphone_vcard_add_sip_address(lf->vcard, uri);
 			linphone_address_unref(fr);
 		}
@@ -418,7 +504,9 @@ const bctbx_list_t* linphone_friend_get_addresses(const LinphoneFriend *lf) {
 	if (!lf) return NULL;
 
 	if (linphone_core_vcard_supported()) {
-		const bctbx_list_t * addresses = linphone_vcard_get_sip_addresses(lf->vcard);
+		const bctbx_list_t * addresses;
+		if (lf->vcard_buffer) return lf->cached_addresses;
+		addresses = linphone_vcard_get_sip_addresses(lf->vcard);
 		return addresses;
 	} else {
 		bctbx_list_t *addresses = NULL;
@@ -428,7 +516,7 @@ const bctbx_list_t* linphone_friend_get_addresses(const LinphoneFriend *lf) {
 
 void linphone_friend_remove_address(LinphoneFriend *lf, const LinphoneAddress *addr) {
 	char *address ;
-	if (!lf || !addr || !lf->vcard) return;
+	if (!lf || !addr || !linphone_friend_load_vcard(lf)) return;
 
 	address = linphone_address_as_string_uri_only(addr);
 	if (lf->friend_list) {
@@ -450,6 +538,7 @@ void linphone_friend_add_phone_number(LinphoneFriend *lf, const char *phone) {
 	}
 
 	if (linphone_core_vcard_supported()) {
+		linphone_friend_load_vcard(lf);
 		if (!lf->vcard) {
 			linphone_friend_create_vcard(lf, phone);
 		}
@@ -458,16 +547,17 @@ void linphone_friend_add_phone_number(LinphoneFriend *lf, const char *phone) {
 }
 
 bctbx_list_t* linphone_friend_get_phone_numbers(const LinphoneFriend *lf) {
-	if (!lf || !lf->vcard) return NULL;
+	if (!lf) return NULL;
 
 	if (linphone_core_vcard_supported()) {
-		return linphone_vcard_get_phone_numbers(lf->vcard);
+		if (lf->vcard_buffer) return bctbx_list_copy(lf->cached_phone_numbers);
+		if (lf->vcard) return linphone_vcard_get_phone_numbers(lf->vcard);
 	}
 	return NULL;
 }
 
 void linphone_friend_remove_phone_number(LinphoneFriend *lf, const char *phone) {
-	if (!lf || !phone || !lf->vcard) return;
+	if (!lf || !phone || !linphone_friend_load_vcard(lf)) return;
 
 	if (lf->friend_list) {
 		const char *uri = linphone_friend_phone_number_to_sip_uri(lf, phone);
@@ -483,7 +573,7 @@ void linphone_friend_remove_phone_number(LinphoneFriend *lf, const char *phone)
 
 LinphoneStatus linphone_friend_set_name(LinphoneFriend *lf, const char *name){
 	if (linphone_core_vcard_supported()) {
-		if (!lf->vcard) linphone_friend_create_vcard(lf, name);
+		if (!linphone_friend_load_vcard(lf)) linphone_friend_create_vcard(lf, name);
 		linphone_vcard_set_full_name(lf->vcard, name);
 	} else {
 		if (!lf->uri) {
@@ -506,6 +596,11 @@ LinphoneStatus linphone_friend_set_inc_subscribe_policy(LinphoneFriend *fr, Linp
 }
 
 void linphone_friend_notify(LinphoneFriend *lf, LinphonePresenceModel *presence){
+	LinphonePrivate::SalPresenceOp::PresenceBodies bodies;
+	linphone_friend_notify_with_bodies(lf, presence, &bodies);
+}
+
+void linphone_friend_notify_with_bodies(LinphoneFriend *lf, LinphonePresenceModel *presence, LinphonePrivate::SalPresenceOp::PresenceBodies *bodies){
 	bctbx_list_t *elem;
 	if (lf->insubs){
 		const LinphoneAddress *addr = linphone_friend_get_address(lf);
@@ -517,17 +612,19 @@ void linphone_friend_notify(LinphoneFriend *lf, LinphonePresenceModel *presence)
 	}
 	for(elem=lf->insubs; elem!=NULL; elem=bctbx_list_next(elem)){
 		auto op = reinterpret_cast<SalPresenceOp *>(bctbx_list_get_data(elem));
-		op->notifyPresence((SalPresenceModel *)presence);
+		op->notifyPresence((SalPresenceModel *)presence, bodies);
 	}
 }
 
 void linphone_friend_add_incoming_subscription(LinphoneFriend *lf, SalOp *op){
 	/*ownership of the op is transfered from sal to the LinphoneFriend*/
 	lf->insubs = bctbx_list_append(lf->insubs, op);
+	add_op_to_list_map(lf, op);
 }
 
 void linphone_friend_remove_incoming_subscription(LinphoneFriend *lf, SalOp *op){
 	if (bctbx_list_find(lf->insubs, op)){
+		linphone_friend_remove_op_from_list_map(lf, op);
 		op->release();
 		lf->insubs = bctbx_list_remove(lf->insubs, op);
 	}
@@ -546,6 +643,7 @@ void linphone_friend_invalidate_subscription(LinphoneFriend *lf){
 	LinphoneCore *lc = lf->lc;
 
 	if (lf->outsub!=NULL) {
+		linphone_friend_remove_op_from_list_map(lf, lf->outsub);
 		lf->outsub->release();
 		lf->outsub=NULL;
 	}
@@ -578,8 +676,20 @@ static void release_sal_op(SalOp *op) {
 	op->release();
 }
 
+void linphone_friend_remove_ops_from_list_map(LinphoneFriend *lf) {
+	bctbx_list_t *elem;
+	for (elem = lf->insubs; elem != NULL; elem = bctbx_list_next(elem)) {
+		linphone_friend_remove_op_from_list_map(lf, (SalOp *)bctbx_list_get_data(elem));
+	}
+	linphone_friend_remove_op_from_list_map(lf, lf->outsub);
+}
+
 static void linphone_friend_close_incoming_subscriptions(LinphoneFriend *lf) {
+	bctbx_list_t *elem;
 	bctbx_list_for_each(lf->insubs, (MSIterateFunc) close_presence_notification);
+	for (elem = lf->insubs; elem != NULL; elem = bctbx_list_next(elem)) {
+		linphone_friend_remove_op_from_list_map(lf, (SalOp *)bctbx_list_get_data(elem));
+	}
 	lf->insubs = bctbx_list_free_with_data(lf->insubs, (MSIterateFunc)release_sal_op);
 }
 
@@ -589,6 +699,7 @@ void linphone_friend_close_subscriptions(LinphoneFriend *lf){
 }
 
 static void _linphone_friend_release_ops(LinphoneFriend *lf){
+	linphone_friend_remove_ops_from_list_map(lf);
 	lf->insubs = bctbx_list_free_with_data(lf->insubs, (MSIterateFunc) release_sal_op);
 	if (lf->outsub){
 		lf->outsub->release();
@@ -603,6 +714,7 @@ static void _linphone_friend_destroy(LinphoneFriend *lf){
 	if (lf->uri!=NULL) linphone_address_unref(lf->uri);
 	if (lf->info!=NULL) buddy_info_free(lf->info);
 	if (lf->vcard != NULL) linphone_vcard_unref(lf->vcard);
+	linphone_friend_clear_vcard_cache(lf);
 	if (lf->refkey != NULL) ms_free(lf->refkey);
 }
 
@@ -621,6 +733,7 @@ const char * linphone_friend_get_name(const LinphoneFriend *lf) {
 	if (!lf) return NULL;
 
 	if (linphone_core_vcard_supported()) {
+		if (lf->vcard_buffer) return lf->cached_name;
 		if (lf->vcard) return linphone_vcard_get_full_name(lf->vcard);
 	} else if (lf->uri) {
 		return linphone_address_get_display_name(lf->uri);
@@ -866,7 +979,7 @@ void linphone_friend_apply(LinphoneFriend *fr, LinphoneCore *lc) {
 }
 
 void linphone_friend_edit(LinphoneFriend *fr) {
-	if (fr && linphone_core_vcard_supported() && fr->vcard) {
+	if (fr && linphone_core_vcard_supported() && linphone_friend_load_vcard(fr)) {
 		linphone_vcard_compute_md5_hash(fr->vcard);
 	}
 }
@@ -1156,7 +1269,7 @@ void linphone_friend_destroy(LinphoneFriend *lf) {
 }
 
 LinphoneVcard* linphone_friend_get_vcard(const LinphoneFriend *fr) {
-	if (fr && linphone_core_vcard_supported()) return fr->vcard;
+	if (fr && linphone_core_vcard_supported()) return linphone_friend_load_vcard(fr);
 	return NULL;
 }
 
@@ -1165,6 +1278,7 @@ void linphone_friend_set_vcard(LinphoneFriend *fr, LinphoneVcard *vcard) {
 
 	if (vcard) linphone_vcard_ref(vcard);
 
+	linphone_friend_clear_vcard_cache(fr);
 	if (fr->vcard) linphone_vcard_unref(fr->vcard);
 	fr->vcard = vcard;
 	linphone_friend_save(fr, fr->lc);
@@ -1183,7 +1297,7 @@ bool_t linphone_friend_create_vcard(LinphoneFriend *fr, const char *name) {
 		ms_warning("VCard support is not builtin");
 		return FALSE;
 	}
-	if (fr->vcard) {
+	if (fr->vcard || fr->vcard_buffer) {
 		ms_error("Friend already has a VCard");
 		return FALSE;
 	}
@@ -1269,7 +1383,10 @@ static void linphone_create_friends_table(sqlite3* db) {
 						"vCard             TEXT,"
 						"vCard_etag        TEXT,"
 						"vCard_url         TEXT,"
-						"presence_received INTEGER"
+						"presence_received INTEGER,"
+						"display_name      TEXT,"
+						"sip_addresses     TEXT,"
+						"phone_numbers     TEXT"
 						");",
 			0, 0, &errmsg);
 	if (ret != SQLITE_OK) {
@@ -1304,7 +1421,7 @@ static bool_t linphone_update_friends_table(sqlite3* db) {
 	}
 		sqlite3_finalize(stmt_version);
 
-	if (database_user_version != 3100) { // Linphone 3.10.0
+	if (database_user_version < 3100) { // Linphone 3.10.0
 		int ret = sqlite3_exec(db,
 			"BEGIN TRANSACTION;\n"
 			"ALTER TABLE friends RENAME TO temp_friends;\n"
@@ -1318,15 +1435,35 @@ static bool_t linphone_update_friends_table(sqlite3* db) {
 						"vCard             TEXT,"
 						"vCard_etag        TEXT,"
 						"vCard_url         TEXT,"
-						"presence_received INTEGER"
+						"presence_received INTEGER,"
+						"display_name      TEXT,"
+						"sip_addresses     TEXT,"
+						"phone_numbers     TEXT"
 						");\n"
-			"INSERT INTO friends SELECT id, friend_list_id, sip_uri, subscribe_policy, send_subscribe, ref_key, vCard, vCard_etag, vCard_url, presence_received FROM temp_friends;\n"
+			"INSERT INTO friends (id, friend_list_id, sip_uri, subscribe_policy, send_subscribe, ref_key, vCard, vCard_etag, vCard_url, presence_received) "
+				"SELECT id, friend_list_id, sip_uri, subscribe_policy, send_subscribe, ref_key, vCard, vCard_etag, vCard_url, presence_received FROM temp_friends;\n"
 			"DROP TABLE temp_friends;\n"
-			"PRAGMA user_version = 3100;\n"
+			"PRAGMA user_version = 3200;\n"
+			"COMMIT;", 0, 0, &errmsg);
+		if (ret != SQLITE_OK) {
+			ms_error("Error altering table friends: %s.", errmsg);
+			sqlite3_free(errmsg);
+			return FALSE;
+		}
+		return TRUE;
+	}
+	if (database_user_version < 3200) { // Cached vCard columns, filled back when friends are fetched
+		int ret = sqlite3_exec(db,
+			"BEGIN TRANSACTION;\n"
+			"ALTER TABLE friends ADD COLUMN display_name TEXT;\n"
+			"ALTER TABLE friends ADD COLUMN sip_addresses TEXT;\n"
+			"ALTER TABLE friends ADD COLUMN phone_numbers TEXT;\n"
+			"PRAGMA user_version = 3200;\n"
 			"COMMIT;", 0, 0, &errmsg);
 		if (ret != SQLITE_OK) {
 			ms_error("Error altering table friends: %s.", errmsg);
 			sqlite3_free(errmsg);
+			sqlite3_exec(db, "ROLLBACK;", 0, 0, NULL);
 			return FALSE;
 		}
 		return TRUE;
@@ -1422,7 +1559,44 @@ static int create_friend_list(void *data, int argc, char **argv, char **colName)
  * | 7  | vCard eTag
  * | 8  | vCard URL
  * | 9  | presence_received
+ * | 10 | display_name
+ * | 11 | sip_addresses
+ * | 12 | phone_numbers
  */
+static bctbx_list_t *split_cached_column(const char *value) {
+	bctbx_list_t *result = NULL;
+	const char *begin = value;
+
+	while (begin && *begin != '\0') {
+		const char *end = strchr(begin, '\n');
+		size_t length = end ? (size_t)(end - begin) : strlen(begin);
+		char *item = reinterpret_cast<char *>(ms_malloc(length + 1));
+		memcpy(item, begin, length);
+		item[length] = '\0';
+		result = bctbx_list_append(result, item);
+		begin = end ? end + 1 : NULL;
+	}
+	return result;
+}
+
+static LinphoneFriend *linphone_friend_new_from_cached_columns(char **argv) {
+	LinphoneFriend *lf = linphone_friend_new();
+	bctbx_list_t *uris = split_cached_column(argv[11]);
+	bctbx_list_t *it;
+
+	lf->vcard_buffer = ms_strdup(argv[6]);
+	if (argv[7]) lf->vcard_etag = ms_strdup(argv[7]);
+	if (argv[8]) lf->vcard_url = ms_strdup(argv[8]);
+	if (argv[10]) lf->cached_name = ms_strdup(argv[10]);
+	for (it = uris; it != NULL; it = bctbx_list_next(it)) {
+		LinphoneAddress *addr = linphone_address_new((const char *)bctbx_list_get_data(it));
+		if (addr) lf->cached_addresses = bctbx_list_append(lf->cached_addresses, addr);
+	}
+	bctbx_list_free_with_data(uris, (bctbx_list_free_func)ms_free);
+	lf->cached_phone_numbers = split_cached_column(argv[12]);
+	return lf;
+}
+
 static int create_friend(void *data, int argc, char **argv, char **colName) {
 	LinphoneVcardContext *context = (LinphoneVcardContext *)data;
 	bctbx_list_t **list = (bctbx_list_t **)linphone_vcard_context_get_user_data(context);
@@ -1430,12 +1604,17 @@ static int create_friend(void *data, int argc, char **argv, char **colName) {
 	LinphoneVcard *vcard = NULL;
 	unsigned int storage_id = (unsigned int)atoi(argv[0]);
 
-	vcard = linphone_vcard_context_get_vcard_from_buffer(context, argv[6]);
-	if (vcard) {
-		linphone_vcard_set_etag(vcard, argv[7]);
-		linphone_vcard_set_url(vcard, argv[8]);
-		lf = linphone_friend_new_from_vcard(vcard);
-		linphone_vcard_unref(vcard);
+	if (linphone_core_vcard_supported() && argv[6] && argv[11] && argv[12]) {
+		lf = linphone_friend_new_from_cached_columns(argv);
+	} else {
+		// Rows written before the cached columns existed, parse the vCard right away.
+		vcard = linphone_vcard_context_get_vcard_from_buffer(context, argv[6]);
+		if (vcard) {
+			linphone_vcard_set_etag(vcard, argv[7]);
+			linphone_vcard_set_url(vcard, argv[8]);
+			lf = linphone_friend_new_from_vcard(vcard);
+			linphone_vcard_unref(vcard);
+		}
 	}
 	if (!lf) {
 		lf = linphone_friend_new();
@@ -1494,11 +1673,31 @@ static int linphone_sql_request_generic(sqlite3* db, const char *stmt) {
 	return ret;
 }
 
+static char *join_cached_addresses(const bctbx_list_t *addresses) {
+	char *result = ms_strdup("");
+	for (; addresses != NULL; addresses = bctbx_list_next(addresses)) {
+		char *uri = linphone_address_as_string_uri_only((const LinphoneAddress *)bctbx_list_get_data(addresses));
+		result = ms_strcat_printf(result, "%s%s", result[0] ? "\n" : "", uri);
+		ms_free(uri);
+	}
+	return result;
+}
+
+static char *join_cached_phone_numbers(const bctbx_list_t *phone_numbers) {
+	char *result = ms_strdup("");
+	for (; phone_numbers != NULL; phone_numbers = bctbx_list_next(phone_numbers)) {
+		result = ms_strcat_printf(result, "%s%s", result[0] ? "\n" : "", (const char *)bctbx_list_get_data(phone_numbers));
+	}
+	return result;
+}
+
 void linphone_core_store_friend_in_db(LinphoneCore *lc, LinphoneFriend *lf) {
 	if (lc && lc->friends_db) {
 		char *buf;
 		int store_friends = lp_config_get_int(lc->config, "misc", "store_friends", 1);
 		LinphoneVcard *vcard = NULL;
+		const char *vcard_str = NULL, *vcard_etag = NULL, *vcard_url = NULL, *name = NULL;
+		char *addresses_str = NULL, *phone_numbers_str = NULL;
 		const LinphoneAddress *addr;
 		char *addr_str = NULL;
 
@@ -1516,36 +1715,63 @@ void linphone_core_store_friend_in_db(LinphoneCore *lc, LinphoneFriend *lf) {
 			linphone_core_store_friends_list_in_db(lc, lf->friend_list);
 		}
 
-		if (linphone_core_vcard_supported()) vcard = linphone_friend_get_vcard(lf);
+		if (linphone_core_vcard_supported()) {
+			if (lf->vcard_buffer) {
+				// vCard was never parsed, hence never modified: write it back as it was read.
+				vcard_str = lf->vcard_buffer;
+				vcard_etag = lf->vcard_etag;
+				vcard_url = lf->vcard_url;
+				name = lf->cached_name;
+				addresses_str = join_cached_addresses(lf->cached_addresses);
+				phone_numbers_str = join_cached_phone_numbers(lf->cached_phone_numbers);
+			} else if ((vcard = lf->vcard) != NULL) {
+				bctbx_list_t *phone_numbers = linphone_vcard_get_phone_numbers(vcard);
+				vcard_str = linphone_vcard_as_vcard4_string(vcard);
+				vcard_etag = linphone_vcard_get_etag(vcard);
+				vcard_url = linphone_vcard_get_url(vcard);
+				name = linphone_vcard_get_full_name(vcard);
+				addresses_str = join_cached_addresses(linphone_vcard_get_sip_addresses(vcard));
+				phone_numbers_str = join_cached_phone_numbers(phone_numbers);
+				bctbx_list_free(phone_numbers);
+			}
+		}
 		addr = linphone_friend_get_address(lf);
 		if (addr != NULL) addr_str = linphone_address_as_string(addr);
 		if (lf->storage_id > 0) {
-			buf = sqlite3_mprintf("UPDATE friends SET friend_list_id=%u,sip_uri=%Q,subscribe_policy=%i,send_subscribe=%i,ref_key=%Q,vCard=%Q,vCard_etag=%Q,vCard_url=%Q,presence_received=%i WHERE (id = %u);",
+			buf = sqlite3_mprintf("UPDATE friends SET friend_list_id=%u,sip_uri=%Q,subscribe_policy=%i,send_subscribe=%i,ref_key=%Q,vCard=%Q,vCard_etag=%Q,vCard_url=%Q,presence_received=%i,display_name=%Q,sip_addresses=%Q,phone_numbers=%Q WHERE (id = %u);",
 				lf->friend_list->storage_id,
 				addr_str,
 				lf->pol,
 				lf->subscribe,
 				lf->refkey,
-				vcard ? linphone_vcard_as_vcard4_string(vcard) : NULL,
-				vcard ? linphone_vcard_get_etag(vcard) : NULL,
-				vcard ? linphone_vcard_get_url(vcard): NULL,
+				vcard_str,
+				vcard_etag,
+				vcard_url,
 				lf->presence_received,
+				name,
+				addresses_str,
+				phone_numbers_str,
 				lf->storage_id
 			);
 		} else {
-			buf = sqlite3_mprintf("INSERT INTO friends VALUES(NULL,%u,%Q,%i,%i,%Q,%Q,%Q,%Q,%i);",
+			buf = sqlite3_mprintf("INSERT INTO friends (friend_list_id,sip_uri,subscribe_policy,send_subscribe,ref_key,vCard,vCard_etag,vCard_url,presence_received,display_name,sip_addresses,phone_numbers) VALUES(%u,%Q,%i,%i,%Q,%Q,%Q,%Q,%i,%Q,%Q,%Q);",
 				lf->friend_list->storage_id,
 				addr_str,
 				lf->pol,
 				lf->subscribe,
 				lf->refkey,
-				vcard ? linphone_vcard_as_vcard4_string(vcard) : NULL,
-				vcard ? linphone_vcard_get_etag(vcard) : NULL,
-				vcard ? linphone_vcard_get_url(vcard) : NULL,
-				lf->presence_received
+				vcard_str,
+				vcard_etag,
+				vcard_url,
+				lf->presence_received,
+				name,
+				addresses_str,
+				phone_numbers_str
 			);
 		}
 		if (addr_str != NULL) ms_free(addr_str);
+		if (addresses_str != NULL) ms_free(addresses_str);
+		if (phone_numbers_str != NULL) ms_free(phone_numbers_str);
 
 		linphone_sql_request_generic(lc->friends_db, buf);
 		sqlite3_free(buf);
@@ -1654,6 +1880,11 @@ void linphone_friend_add_addresses_and_numbers_into_maps(LinphoneFriend *lf, Lin
 		}
 		iterator = bctbx_list_next(iterator);
 	}
+
+	if (lf->outsub) add_op_to_list_map(lf, lf->outsub);
+	for (iterator = lf->insubs; iterator != NULL; iterator = bctbx_list_next(iterator)) {
+		add_op_to_list_map(lf, (SalOp *)bctbx_list_get_data(iterator));
+	}
 }
 
 bctbx_list_t* linphone_core_fetch_friends_from_db(LinphoneCore *lc, LinphoneFriendList *list) {
@@ -1661,6 +1892,7 @@ bctbx_list_t* linphone_core_fetch_friends_from_db(LinphoneCore *lc, LinphoneFrie
 	uint64_t begin,end;
 	bctbx_list_t *result = NULL;
 	bctbx_list_t *elem = NULL;
+	bool_t outdated_rows = FALSE;
 
 	if (!lc || lc->friends_db == NULL || list == NULL) {
 		ms_warning("Either lc (or list) is NULL or friends database wasn't initialized with linphone_core_friends_storage_init() yet");
@@ -1669,7 +1901,8 @@ bctbx_list_t* linphone_core_fetch_friends_from_db(LinphoneCore *lc, LinphoneFrie
 
 	linphone_vcard_context_set_user_data(lc->vcard_context, &result);
 
-	buf = sqlite3_mprintf("SELECT * FROM friends WHERE friend_list_id = %u ORDER BY id", list->storage_id);
+	buf = sqlite3_mprintf("SELECT id, friend_list_id, sip_uri, subscribe_policy, send_subscribe, ref_key, vCard, vCard_etag, vCard_url, presence_received, display_name, sip_addresses, phone_numbers"
+		" FROM friends WHERE friend_list_id = %u ORDER BY id", list->storage_id);
 
 	begin = ortp_get_cur_time_ms();
 	linphone_sql_request_friend(lc->friends_db, buf, lc->vcard_context);
@@ -1682,7 +1915,16 @@ bctbx_list_t* linphone_core_fetch_friends_from_db(LinphoneCore *lc, LinphoneFrie
 		lf->lc = lc;
 		lf->friend_list = list;
 		linphone_friend_add_addresses_and_numbers_into_maps(lf, list);
+		if (linphone_core_vcard_supported() && lf->vcard) {
+			// vCard was parsed right away because the cached columns were empty, fill them for the next startup.
+			if (!outdated_rows) {
+				outdated_rows = TRUE;
+				linphone_sql_request_generic(lc->friends_db, "BEGIN TRANSACTION;");
+			}
+			linphone_core_store_friend_in_db(lc, lf);
+		}
 	}
+	if (outdated_rows) linphone_sql_request_generic(lc->friends_db, "COMMIT;");
 	linphone_vcard_context_set_user_data(lc->vcard_context, NULL);
 
 	return result;
@@ -260,44 +260,165 @@ static void linphone_friend_presence_received(LinphoneFriendList *list, Linphone
 	linphone_core_notify_notify_presence_received(list->lc, lf);
 }
 
+static bool_t linphone_friend_list_is_rlmi_element(const xmlNode *node, const char *name) {
+	return (node->type == XML_ELEMENT_NODE)
+		&& node->ns && node->ns->href && (xmlStrcmp(node->ns->href, (const xmlChar *)"urn:ietf:params:xml:ns:rlmi") == 0)
+		&& (xmlStrcmp(node->name, (const xmlChar *)name) == 0);
+}
+
+static void linphone_friend_list_set_rlmi_name(LinphoneFriendList *list, const char *uri, const char *name) {
+	LinphoneFriend *lf;
+	LinphoneAddress *addr = linphone_address_new(uri);
+	if (!addr)
+		return;
+	lf = linphone_friend_list_find_friend_by_address(list, addr);
+	linphone_address_unref(addr);
+	if (!lf && list->bodyless_subscription) {
+		lf = linphone_core_create_friend_with_address(list->lc, uri);
+		linphone_friend_list_add_friend(list, lf);
+		linphone_friend_unref(lf);
+	}
+	if (lf)
+		linphone_friend_set_name(lf, name);
+}
+
+static void linphone_friend_list_set_rlmi_presence(LinphoneFriendList *list, const char *resource_uri, SalPresenceModel *presence, bctbx_list_t **list_friends_presence_received) {
+	LinphoneFriend *lf;
+	char *uri;
+	LinphoneAddress *addr = linphone_address_new(resource_uri);
+	if (!addr)
+		return;
+
+	// Clean the URI
+	if (linphone_address_has_uri_param(addr, "gr")) {
+		linphone_address_remove_uri_param(addr, "gr");
+	}
+	uri = linphone_address_as_string_uri_only(addr);
+	linphone_address_unref(addr);
+
+	bctbx_iterator_t *it = bctbx_map_cchar_find_key(list->friends_map_uri, uri);
+	bctbx_iterator_t *end = bctbx_map_cchar_end(list->friends_map_uri);
+	if (bctbx_iterator_cchar_equals(it, end)) {
+		if (list->bodyless_subscription) {
+			lf = linphone_core_create_friend_with_address(list->lc, uri);
+			linphone_friend_list_add_friend(list, lf);
+			linphone_friend_unref(lf);
+
+			linphone_friend_presence_received(list, lf, uri, (LinphonePresenceModel *)presence);
+			*list_friends_presence_received = bctbx_list_prepend(*list_friends_presence_received, lf);
+		}
+	} else {
+		// Map is sorted, check if next entry matches key otherwise stop
+		while (!bctbx_iterator_cchar_equals(it, end)) {
+			bctbx_pair_t *pair = bctbx_iterator_cchar_get_pair(it);
+			const char *key = bctbx_pair_cchar_get_first(reinterpret_cast<bctbx_pair_cchar_t *>(pair));
+			if (!key || strcmp(uri, key) != 0) break;
+			lf = (LinphoneFriend*) bctbx_pair_cchar_get_second(pair);
+			if (lf) {
+				linphone_friend_presence_received(list, lf, uri, (LinphonePresenceModel *)presence);
+				*list_friends_presence_received = bctbx_list_prepend(*list_friends_presence_received, lf);
+			}
+			it = bctbx_iterator_cchar_get_next(it);
+		}
+	}
+	bctbx_iterator_cchar_delete(it);
+	bctbx_iterator_cchar_delete(end);
+	ms_free(uri);
+}
+
+/*
+ * Handles a rlmi:resource in a single walk of its children: the friend name is updated from the first rlmi:name,
+ * and its presence from the part referenced by the first active rlmi:instance.
+ */
+static void linphone_friend_list_parse_rlmi_resource(LinphoneFriendList *list, xmlNodePtr resource, bctbx_map_t *parts_by_cid, bctbx_list_t **list_friends_presence_received) {
+	xmlNodePtr child;
+	xmlChar *cid = NULL;
+	bool_t name_found = FALSE;
+	xmlChar *uri = xmlGetProp(resource, (const xmlChar *)"uri");
+	if (!uri)
+		return;
+
+	for (child = resource->children; child != NULL; child = child->next) {
+		if (!name_found && linphone_friend_list_is_rlmi_element(child, "name")) {
+			xmlChar *name = xmlNodeGetContent(child);
+			name_found = TRUE;
+			if (name) {
+				linphone_friend_list_set_rlmi_name(list, (const char *)uri, (const char *)name);
+				xmlFree(name);
+			}
+		} else if (!cid && linphone_friend_list_is_rlmi_element(child, "instance")) {
+			xmlChar *state = xmlGetProp(child, (const xmlChar *)"state");
+			if (state && (xmlStrcmp(state, (const xmlChar *)"active") == 0))
+				cid = xmlGetProp(child, (const xmlChar *)"cid");
+			if (state)
+				xmlFree(state);
+		}
+	}
+
+	if (cid) {
+		LinphoneContent *presence_part = NULL;
+		bctbx_iterator_t *it = bctbx_map_cchar_find_key(parts_by_cid, (const char *)cid);
+		bctbx_iterator_t *end = bctbx_map_cchar_end(parts_by_cid);
+		if (!bctbx_iterator_cchar_equals(it, end))
+			presence_part = (LinphoneContent *)bctbx_pair_cchar_get_second(bctbx_iterator_cchar_get_pair(it));
+		bctbx_iterator_cchar_delete(it);
+		bctbx_iterator_cchar_delete(end);
+
+		if (!presence_part) {
+			ms_warning("rlmi+xml: Cannot find part with Content-Id: %s", (const char *)cid);
+		} else {
+			SalPresenceModel *presence = NULL;
+			linphone_notify_parse_presence(linphone_content_get_type(presence_part), linphone_content_get_subtype(presence_part), linphone_content_get_string_buffer(presence_part), &presence);
+			if (presence) {
+				linphone_friend_list_set_rlmi_presence(list, (const char *)uri, presence, list_friends_presence_received);
+				linphone_presence_model_unref((LinphonePresenceModel *)presence);
+			}
+		}
+		xmlFree(cid);
+	}
+	xmlFree(uri);
+}
+
 static void linphone_friend_list_parse_multipart_related_body(LinphoneFriendList *list, const LinphoneContent *body, const char *first_part_body) {
 	xmlparsing_context_t *xml_ctx = linphone_xmlparsing_context_new();
 	xmlSetGenericErrorFunc(xml_ctx, linphone_xmlparsing_genericxml_error);
 	xml_ctx->doc = xmlReadDoc((const unsigned char*)first_part_body, 0, NULL, 0);
 	if (xml_ctx->doc) {
 		LinphoneFriend *lf;
-		LinphoneContent *presence_part;
-		xmlXPathObjectPtr resource_object;
-		xmlXPathObjectPtr name_object;
-		char *version_str = NULL;
-		char *full_state_str = NULL;
-		char *uri = NULL;
+		xmlNodePtr root = xmlDocGetRootElement(xml_ctx->doc);
+		xmlNodePtr resource;
+		xmlChar *version_str = NULL;
+		xmlChar *full_state_str = NULL;
 		bool_t full_state = FALSE;
 		int version;
-		int i;
+		bctbx_list_t *parts;
+		bctbx_list_t *it;
+		bctbx_map_t *parts_by_cid;
 		bctbx_list_t *list_friends_presence_received = NULL;
 		LinphoneFriendListCbs *list_cbs = linphone_friend_list_get_callbacks(list);
 
-		if (linphone_create_xml_xpath_context(xml_ctx) < 0) goto end;
-		xmlXPathRegisterNs(xml_ctx->xpath_ctx, (const xmlChar *)"rlmi", (const xmlChar *)"urn:ietf:params:xml:ns:rlmi");
+		if (!root || !linphone_friend_list_is_rlmi_element(root, "list")) {
+			ms_warning("rlmi+xml: Root element is not a rlmi list");
+			goto end;
+		}
 
-		version_str = linphone_get_xml_attribute_text_content(xml_ctx, "/rlmi:list", "version");
+		version_str = xmlGetProp(root, (const xmlChar *)"version");
 		if (!version_str) {
 			ms_warning("rlmi+xml: No version attribute in list");
 			goto end;
 		}
-		version = atoi(version_str);
-		linphone_free_xml_text_content(version_str);
+		version = atoi((const char *)version_str);
+		xmlFree(version_str);
 		if (version < list->expected_notification_version) { /*no longuer an error as dialog may be silently restarting by the refresher*/
 			ms_warning("rlmi+xml: Received notification with version %d expected was %d, dialog may have been reseted", version, list->expected_notification_version);
 		}
 
-		full_state_str = linphone_get_xml_attribute_text_content(xml_ctx, "/rlmi:list", "fullState");
+		full_state_str = xmlGetProp(root, (const xmlChar *)"fullState");
 		if (!full_state_str) {
 			ms_warning("rlmi+xml: No fullState attribute in list");
 			goto end;
 		}
-		if ((strcmp(full_state_str, "true") == 0) || (strcmp(full_state_str, "1") == 0)) {
+		if ((xmlStrcmp(full_state_str, (const xmlChar *)"true") == 0) || (xmlStrcmp(full_state_str, (const xmlChar *)"1") == 0)) {
 			bctbx_list_t *l = list->friends;
 			for (; l != NULL; l = bctbx_list_next(l)) {
 				lf = (LinphoneFriend *)bctbx_list_get_data(l);
@@ -305,137 +426,40 @@ static void linphone_friend_list_parse_multipart_related_body(LinphoneFriendList
 			}
 			full_state = TRUE;
 		}
-		linphone_free_xml_text_content(full_state_str);
+		xmlFree(full_state_str);
 		if ((list->expected_notification_version == 0) && !full_state) {
 			ms_warning("rlmi+xml: Notification with version 0 is not full state, this is not valid");
 			goto end;
 		}
 		list->expected_notification_version = version + 1;
 
-		name_object = linphone_get_xml_xpath_object_for_node_list(xml_ctx, "/rlmi:list/rlmi:resource/rlmi:name/..");
-		if (name_object && name_object->nodesetval) {
-			for (i = 1; i <= name_object->nodesetval->nodeNr; i++) {
-				char *name = NULL;
-				LinphoneAddress* addr;
-				linphone_xml_xpath_context_set_node(xml_ctx, xmlXPathNodeSetItem(name_object->nodesetval, i-1));
-				name = linphone_get_xml_text_content(xml_ctx, "./rlmi:name");
-				uri = linphone_get_xml_text_content(xml_ctx, "./@uri");
-				if (!uri)
-					continue;
-				addr = linphone_address_new(uri);
-				if (!addr)
-					continue;
-				lf = linphone_friend_list_find_friend_by_address(list, addr);
-				linphone_address_unref(addr);
-				if (!lf && list->bodyless_subscription) {
-					lf = linphone_core_create_friend_with_address(list->lc, uri);
-					linphone_friend_list_add_friend(list, lf);
-					linphone_friend_unref(lf);
-				}
-				if (name) {
-					linphone_friend_set_name(lf, name);
-					linphone_free_xml_text_content(name);
-				}
-			}
+		// Index the parts by Content-Id once, instead of looking them up for each resource
+		parts = linphone_content_get_parts(body);
+		parts_by_cid = bctbx_mmap_cchar_new();
+		for (it = parts; it != NULL; it = bctbx_list_next(it)) {
+			LinphoneContent *content = (LinphoneContent *)it->data;
+			const char *header = linphone_content_get_custom_header(content, "Content-Id");
+			if (header)
+				bctbx_map_cchar_insert_and_delete(parts_by_cid, (bctbx_pair_t *)bctbx_pair_cchar_new(header, content));
 		}
-		if (name_object)
-			xmlXPathFreeObject(name_object);
-
-		bctbx_list_t *parts = linphone_content_get_parts(body);
-
-		resource_object = linphone_get_xml_xpath_object_for_node_list(xml_ctx, "/rlmi:list/rlmi:resource/rlmi:instance[@state=\"active\"]/..");
-		if (resource_object && resource_object->nodesetval) {
-			for (i = 1; i <= resource_object->nodesetval->nodeNr; i++) {
-				char *cid = NULL;
-				linphone_xml_xpath_context_set_node(xml_ctx, xmlXPathNodeSetItem(resource_object->nodesetval, i-1));
-				cid = linphone_get_xml_text_content(xml_ctx, "./rlmi:instance/@cid");
-				if (cid) {
-					presence_part = nullptr;
-					bctbx_list_t *it = parts;
-					while (it != nullptr)
-					{
-						LinphoneContent *content = (LinphoneContent *)it->data;
-						const char *header = linphone_content_get_custom_header(content, "Content-Id");
-						if (header && strcmp(header, cid) == 0)
-						{
-							presence_part = linphone_content_ref(content);
-							break;
-						}
-						it = bctbx_list_next(it);
-					}
-
-					if (!presence_part) {
-						ms_warning("rlmi+xml: Cannot find part with Content-Id: %s", cid);
-					} else {
-						SalPresenceModel *presence = NULL;
-						linphone_notify_parse_presence(linphone_content_get_type(presence_part), linphone_content_get_subtype(presence_part), linphone_content_get_string_buffer(presence_part), &presence);
-						if (presence) {
-							// Try to reduce CPU cost of linphone_address_new and find_friend_by_address by only doing it when we know for sure we have a presence to notify
-							LinphoneAddress* addr;
-							uri = linphone_get_xml_text_content(xml_ctx, "./@uri");
-							if (!uri)
-								continue;
-							addr = linphone_address_new(uri);
-							if (!addr)
-								continue;
-							linphone_free_xml_text_content(uri);
-							
-							// Clean the URI
-							if (linphone_address_has_uri_param(addr, "gr")) {
-								linphone_address_remove_uri_param(addr, "gr");
-							}
-							uri = linphone_address_as_string_uri_only(addr);
-							linphone_address_unref(addr);
-
-							bctbx_iterator_t *it = bctbx_map_cchar_find_key(list->friends_map_uri, uri);
-							bctbx_iterator_t *end = bctbx_map_cchar_end(list->friends_map_uri);
-							if (bctbx_iterator_cchar_equals(it, end)) {
-								if (list->bodyless_subscription) {
-									lf = linphone_core_create_friend_with_address(list->lc, uri);
-									linphone_friend_list_add_friend(list, lf);
-									linphone_friend_unref(lf);
-
-									linphone_friend_presence_received(list, lf, uri, (LinphonePresenceModel *)presence);
-									list_friends_presence_received = bctbx_list_prepend(list_friends_presence_received, lf);
-								}
-							} else {
-								// Map is sorted, check if next entry matches key otherwise stop
-								while (!bctbx_iterator_cchar_equals(it, end)) {
-									bctbx_pair_t *pair = bctbx_iterator_cchar_get_pair(it);
-									const char *key = bctbx_pair_cchar_get_first(reinterpret_cast<bctbx_pair_cchar_t *>(pair));
-									if (!key || strcmp(uri, key) != 0) break;
-									lf = (LinphoneFriend*) bctbx_pair_cchar_get_second(pair);
-									if (lf) {
-										linphone_friend_presence_received(list, lf, uri, (LinphonePresenceModel *)presence);
-										list_friends_presence_received = bctbx_list_prepend(list_friends_presence_received, lf);
-									}
-									it = bctbx_iterator_cchar_get_next(it);
-								}
-							}
-							bctbx_iterator_cchar_delete(it);
-							bctbx_iterator_cchar_delete(end);
-							
-							linphone_content_unref(presence_part);
-							linphone_presence_model_unref((LinphonePresenceModel *)presence);
-						}
-					}
-					linphone_free_xml_text_content(cid);
-				}
-			}
-			// Notify list with all friends for which we received presence information
-			if (bctbx_list_size(list_friends_presence_received) > 0) {
-				if (list_cbs && linphone_friend_list_cbs_get_presence_received(list_cbs)) {
-					linphone_friend_list_cbs_get_presence_received(list_cbs)(list, list_friends_presence_received);
-				}
 
-				NOTIFY_IF_EXIST(PresenceReceived, presence_received, list, list_friends_presence_received)
+		for (resource = root->children; resource != NULL; resource = resource->next) {
+			if (linphone_friend_list_is_rlmi_element(resource, "resource"))
+				linphone_friend_list_parse_rlmi_resource(list, resource, parts_by_cid, &list_friends_presence_received);
+		}
+
+		// Notify list with all friends for which we received presence information
+		if (bctbx_list_size(list_friends_presence_received) > 0) {
+			if (list_cbs && linphone_friend_list_cbs_get_presence_received(list_cbs)) {
+				linphone_friend_list_cbs_get_presence_received(list_cbs)(list, list_friends_presence_received);
 			}
-			bctbx_list_free(list_friends_presence_received);
+
+			NOTIFY_IF_EXIST(PresenceReceived, presence_received, list, list_friends_presence_received)
 		}
+		bctbx_list_free(list_friends_presence_received);
 
+		bctbx_mmap_cchar_delete(parts_by_cid);
 		bctbx_list_free_with_data(parts, (void (*)(void *))linphone_content_unref);
-		if (resource_object)
-			xmlXPathFreeObject(resource_object);
 	} else {
 		ms_warning("Wrongly formatted rlmi+xml body: %s", xml_ctx->errorBuffer);
 	}
@@ -466,10 +490,23 @@ static LinphoneFriendList * linphone_friend_list_new(void) {
 	list->enable_subscriptions = FALSE;
 	list->friends_map = bctbx_mmap_cchar_new();
 	list->friends_map_uri = bctbx_mmap_cchar_new();
+	list->friends_map_call_id = bctbx_mmap_cchar_new();
 	list->bodyless_subscription = FALSE;
 	return list;
 }
 
+static void linphone_friend_list_cancel_presence_notify(LinphoneFriendList *list) {
+	if (list->presence_notify_timer) {
+		if (list->lc && list->lc->sal) list->lc->sal->cancelTimer(list->presence_notify_timer);
+		belle_sip_object_unref(list->presence_notify_timer);
+		list->presence_notify_timer = NULL;
+	}
+	if (list->presence_notify_model) {
+		linphone_presence_model_unref(list->presence_notify_model);
+		list->presence_notify_model = NULL;
+	}
+}
+
 static void linphone_friend_list_destroy(LinphoneFriendList *list) {
 	if (list->display_name != NULL) ms_free(list->display_name);
 	if (list->rls_addr) linphone_address_unref(list->rls_addr);
@@ -488,6 +525,8 @@ static void linphone_friend_list_destroy(LinphoneFriendList *list) {
 	if (list->friends) list->friends = bctbx_list_free_with_data(list->friends, (void (*)(void *))_linphone_friend_release);
 	if (list->friends_map) bctbx_mmap_cchar_delete_with_data(list->friends_map, (void (*)(void *))linphone_friend_unref);
 	if (list->friends_map_uri) bctbx_mmap_cchar_delete_with_data(list->friends_map_uri, (void (*)(void *))linphone_friend_unref);
+	if (list->friends_map_call_id) bctbx_mmap_cchar_delete_with_data(list->friends_map_call_id, (void (*)(void *))linphone_friend_unref);
+	linphone_friend_list_cancel_presence_notify(list);
 }
 
 BELLE_SIP_DECLARE_NO_IMPLEMENTED_INTERFACES(LinphoneFriendList);
@@ -516,6 +555,7 @@ LinphoneFriendList * linphone_friend_list_ref(LinphoneFriendList *list) {
 }
 
 void _linphone_friend_list_release(LinphoneFriendList *list){
+	linphone_friend_list_cancel_presence_notify(list);
 	/*drops all references to core and unref*/
 	list->lc = NULL;
 	if (list->event != NULL) {
@@ -625,10 +665,9 @@ static LinphoneFriendListStatus _linphone_friend_list_add_friend(LinphoneFriendL
 	}
 	addr = linphone_friend_get_address(lf);
 	bool_t present = FALSE;
+	/* A friend belongs to a single list, and lf->friend_list is NULL here: only ref keys can collide. */
 	if (lf->refkey) {
 		present = linphone_friend_list_find_friend_by_ref_key(list, lf->refkey) != NULL;
-	} else {
-		present = bctbx_list_find(list->friends, lf) != NULL;
 	}
 	if (present) {
 		char *tmp = NULL;
@@ -659,6 +698,8 @@ void linphone_friend_list_invalidate_friends_maps(LinphoneFriendList *list) {
 	list->friends_map = bctbx_mmap_cchar_new();
 	if (list->friends_map_uri) bctbx_mmap_cchar_delete_with_data(list->friends_map_uri, (void (*)(void *))linphone_friend_unref);
 	list->friends_map_uri = bctbx_mmap_cchar_new();
+	if (list->friends_map_call_id) bctbx_mmap_cchar_delete_with_data(list->friends_map_call_id, (void (*)(void *))linphone_friend_unref);
+	list->friends_map_call_id = bctbx_mmap_cchar_new();
 	
 	const bctbx_list_t *elem;
 	for (elem = list->friends; elem != NULL; elem = bctbx_list_next(elem)) {
@@ -768,6 +809,7 @@ static LinphoneFriendListStatus _linphone_friend_list_remove_friend(LinphoneFrie
 
 		iterator = bctbx_list_next(iterator);
 	}
+	linphone_friend_remove_ops_from_list_map(lf);
 
 	lf->friend_list = NULL;
 	linphone_friend_unref(lf);
@@ -938,28 +980,59 @@ LinphoneFriend *linphone_friend_list_find_friend_by_ref_key (const LinphoneFrien
 	return result;
 }
 
+static bool_t linphone_friend_has_inc_subscribe (const LinphoneFriend *lf, LinphonePrivate::SalOp *op) {
+	return bctbx_list_find(lf->insubs, op) != NULL;
+}
+
+static bool_t linphone_friend_has_out_subscribe (const LinphoneFriend *lf, LinphonePrivate::SalOp *op) {
+	return lf->outsub && ((lf->outsub == op) || lf->outsub->isForkedOf(op));
+}
+
+static LinphoneFriend * linphone_friend_list_find_friend_by_op (
+	const LinphoneFriendList *list,
+	LinphonePrivate::SalOp *op,
+	bool_t (*has_op)(const LinphoneFriend *, LinphonePrivate::SalOp *)
+) {
+	LinphoneFriend *result = NULL;
+	const char *call_id = op->getCallId().c_str();
+
+	if (call_id[0] == '\0') {
+		// Op was never sent nor received, hence not in the map.
+		const bctbx_list_t *elem;
+		for (elem = list->friends; elem != NULL; elem = bctbx_list_next(elem)) {
+			LinphoneFriend *lf = (LinphoneFriend *)bctbx_list_get_data(elem);
+			if (has_op(lf, op)) return lf;
+		}
+		return NULL;
+	}
+
+	bctbx_iterator_t *it = bctbx_map_cchar_find_key(list->friends_map_call_id, call_id);
+	bctbx_iterator_t *end = bctbx_map_cchar_end(list->friends_map_call_id);
+	while (!result && !bctbx_iterator_cchar_equals(it, end)) {
+		const bctbx_pair_t *pair = bctbx_iterator_cchar_get_pair(it);
+		const char *key = bctbx_pair_cchar_get_first(reinterpret_cast<const bctbx_pair_cchar_t *>(pair));
+		if (!key || strcmp(key, call_id) != 0) break;
+		LinphoneFriend *lf = (LinphoneFriend *)bctbx_pair_cchar_get_second(pair);
+		if (has_op(lf, op)) result = lf;
+		it = bctbx_iterator_cchar_get_next(it);
+	}
+	bctbx_iterator_cchar_delete(end);
+	bctbx_iterator_cchar_delete(it);
+	return result;
+}
+
 LinphoneFriend * linphone_friend_list_find_friend_by_inc_subscribe (
 	const LinphoneFriendList *list,
 	LinphonePrivate::SalOp *op
 ) {
-	const bctbx_list_t *elem;
-	for (elem = list->friends; elem != NULL; elem = bctbx_list_next(elem)) {
-		LinphoneFriend *lf = (LinphoneFriend *)bctbx_list_get_data(elem);
-		if (bctbx_list_find(lf->insubs, op)) return lf;
-	}
-	return NULL;
+	return linphone_friend_list_find_friend_by_op(list, op, linphone_friend_has_inc_subscribe);
 }
 
 LinphoneFriend * linphone_friend_list_find_friend_by_out_subscribe (
 	const LinphoneFriendList *list,
 	LinphonePrivate::SalOp *op
 ) {
-	const bctbx_list_t *elem;
-	for (elem = list->friends; elem != NULL; elem = bctbx_list_next(elem)) {
-		LinphoneFriend *lf = (LinphoneFriend *)bctbx_list_get_data(elem);
-		if (lf->outsub && ((lf->outsub == op) || lf->outsub->isForkedOf(op))) return lf;
-	}
-	return NULL;
+	return linphone_friend_list_find_friend_by_op(list, op, linphone_friend_has_out_subscribe);
 }
 
 static void linphone_friend_list_close_subscriptions(LinphoneFriendList *list) {
@@ -1118,12 +1191,66 @@ void linphone_friend_list_invalidate_subscriptions(LinphoneFriendList *list) {
 	}
 }
 
-void linphone_friend_list_notify_presence(LinphoneFriendList *list, LinphonePresenceModel *presence) {
+static void linphone_friend_list_send_presence_notify(LinphoneFriendList *list, LinphonePresenceModel *presence) {
+	// Watchers of the same model share its serialized body
+	LinphonePrivate::SalPresenceOp::PresenceBodies bodies;
 	const bctbx_list_t *elem;
 	for(elem = list->friends; elem != NULL; elem = bctbx_list_next(elem)) {
 		LinphoneFriend *lf = (LinphoneFriend *)bctbx_list_get_data(elem);
-		linphone_friend_notify(lf, presence);
+		linphone_friend_notify_with_bodies(lf, presence, &bodies);
+	}
+	list->presence_notify_last_time = ms_get_cur_time_ms();
+}
+
+static int linphone_friend_list_presence_notify_timer_cb(void *data, unsigned int revents) {
+	LinphoneFriendList *list = (LinphoneFriendList *)data;
+	LinphonePresenceModel *presence = list->presence_notify_model;
+	list->presence_notify_model = NULL;
+	linphone_friend_list_cancel_presence_notify(list);
+	if (presence) {
+		linphone_friend_list_send_presence_notify(list, presence);
+		linphone_presence_model_unref(presence);
+	}
+	return BELLE_SIP_STOP;
+}
+
+/*
+ * With [sip] presence_notify_coalescing_delay or presence_notify_min_interval set (in ms), model changes are not notified
+ * right away: only the latest model is sent once the delay has elapsed, and no sooner than the min interval after the
+ * previous NOTIFY.
+ */
+void linphone_friend_list_notify_presence(LinphoneFriendList *list, LinphonePresenceModel *presence) {
+	int delay = 0;
+	int min_interval = 0;
+	uint64_t now;
+	uint64_t wait;
+
+	if (list->lc && list->lc->sal && presence) {
+		delay = lp_config_get_int(list->lc->config, "sip", "presence_notify_coalescing_delay", 0);
+		min_interval = lp_config_get_int(list->lc->config, "sip", "presence_notify_min_interval", 0);
+	}
+	if (delay <= 0 && min_interval <= 0) {
+		linphone_friend_list_send_presence_notify(list, presence);
+		return;
+	}
+
+	// The model replaces any model still waiting for the window to end
+	linphone_presence_model_ref(presence);
+	if (list->presence_notify_model) linphone_presence_model_unref(list->presence_notify_model);
+	list->presence_notify_model = presence;
+	if (list->presence_notify_timer) return;
+
+	now = ms_get_cur_time_ms();
+	wait = (uint64_t)(delay > 0 ? delay : 0);
+	if (list->presence_notify_last_time != 0 && list->presence_notify_last_time + (uint64_t)min_interval > now + wait)
+		wait = list->presence_notify_last_time + (uint64_t)min_interval - now;
+	if (wait == 0) {
+		list->presence_notify_model = NULL;
+		linphone_friend_list_send_presence_notify(list, presence);
+		linphone_presence_model_unref(presence);
+		return;
 	}
+	list->presence_notify_timer = list->lc->sal->createTimer(linphone_friend_list_presence_notify_timer_cb, list, (unsigned int)wait, "Presence notify");
 }
 
 void linphone_friend_list_notify_presence_received(LinphoneFriendList *list, LinphoneEvent *lev, const LinphoneContent *body) {
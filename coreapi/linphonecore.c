@@ -3612,7 +3612,7 @@ void linphone_core_iterate(LinphoneCore *lc){
 	if (one_second_elapsed) {
 		bctbx_list_t *elem = NULL;
 		if (lp_config_needs_commit(lc->config)) {
-			lp_config_sync(lc->config);
+			_linphone_config_sync_in_background(lc->config);
 		}
 		for (elem = lc->friends_lists; elem != NULL; elem = bctbx_list_next(elem)) {
 			LinphoneFriendList *list = (LinphoneFriendList *)elem->data;
@@ -6377,7 +6377,7 @@ static void _linphone_core_stop(LinphoneCore *lc) {
 
 	sip_setup_unregister_all();
 
-	if (lp_config_needs_commit(lc->config)) lp_config_sync(lc->config);
+	linphone_config_flush(lc->config);
 
 	bctbx_list_for_each(lc->call_logs,(void (*)(void*))linphone_call_log_unref);
 	lc->call_logs=bctbx_list_free(lc->call_logs);
@@ -7512,6 +7512,12 @@ int linphone_core_get_unread_chat_message_count_from_active_locals (const Linpho
 	return L_GET_CPP_PTR_FROM_C_OBJECT(lc)->getUnreadChatMessageCountFromActiveLocals();
 }
 
+bctbx_list_t *linphone_core_search_chat_messages (LinphoneCore *lc, const char *text, int count, int cursor, int *next_cursor) {
+	return L_GET_RESOLVED_C_LIST_FROM_CPP_LIST(L_GET_PRIVATE_FROM_C_OBJECT(lc)->mainDb->searchChatMessages(
+		L_C_TO_STRING(text), LinphonePrivate::ConferenceId(), count, cursor, next_cursor
+	));
+}
+
 bool_t linphone_core_has_crappy_opengl(LinphoneCore *lc) {
 	MSFactory * factory = linphone_core_get_ms_factory(lc);
 	MSDevicesInfo *devices = ms_factory_get_devices_info(factory);
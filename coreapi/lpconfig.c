@@ -35,14 +35,23 @@
 
 #define MAX_LEN 16384
 
+#include "bctoolbox/map.h"
 #include "bctoolbox/vfs.h"
 #include "belle-sip/object.h"
 #include "xml2lpc.h"
 
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 #if !defined(_WIN32_WCE)
 #include <errno.h>
 #include <sys/types.h>
@@ -72,6 +81,7 @@
 #include "lpc2xml.h"
 
 #include "c-wrapper/c-wrapper.h"
+#include "mediastreamer2/mscommon.h"
 
 typedef struct _LpItem{
 	char *key;
@@ -89,6 +99,7 @@ typedef struct _LpSectionParam{
 typedef struct _LpSection{
 	char *name;
 	bctbx_list_t *items;
+	bctbx_map_t *items_map; // Index of non comment items by key, items list keeps the order for writing
 	bctbx_list_t *params;
 	bool_t overwrite; // If set to true, will add overwrite=true to all items of this section when converted to xml
 	bool_t skip; // If set to true, won't be dumped when converted to xml
@@ -100,10 +111,28 @@ struct _LpConfig{
 	char *filename;
 	char *tmpfilename;
 	char *factory_filename;
+	char *cache_filename; // Binary snapshot of the merged config, see linphone_config_new_with_cache()
 	bctbx_list_t *sections;
+	bctbx_map_t *sections_map; // Index of sections by name, sections list keeps the order for writing
 	bool_t modified;
 	bool_t readonly;
 	bctbx_vfs_t* g_bctbx_vfs;
+	/* Background writer, see _linphone_config_sync_in_background() */
+	ms_thread_t writer_thread;
+	ms_mutex_t writer_mutex;
+	ms_cond_t writer_cond;
+	char *pending_data; // Snapshot not written yet, replaced by newer ones
+	size_t pending_size;
+	char *pending_cache;
+	size_t pending_cache_size;
+	int writer_status;
+	int writer_count; // Number of snapshots written by the writer thread
+	bool_t writer_started;
+	bool_t writer_busy;
+	bool_t writer_readonly;
+	bool_t writer_failed; // Last snapshot could not be written, config must be marked as modified again
+	bool_t writer_paused;
+	bool_t writer_stop;
 };
 
 BELLE_SIP_DECLARE_NO_IMPLEMENTED_INTERFACES(LinphoneConfig);
@@ -154,6 +183,7 @@ LpSectionParam *lp_section_param_new(const char *key, const char *value){
 LpSection *lp_section_new(const char *name){
 	LpSection *sec=lp_new0(LpSection,1);
 	sec->name=ortp_strdup(name);
+	sec->items_map=bctbx_mmap_cchar_new();
 	return sec;
 }
 
@@ -176,15 +206,51 @@ void lp_section_destroy(LpSection *sec){
 	bctbx_list_for_each(sec->items,lp_item_destroy);
 	bctbx_list_for_each(sec->params,lp_section_param_destroy);
 	bctbx_list_free(sec->items);
+	bctbx_mmap_cchar_delete(sec->items_map);
 	free(sec);
 }
 
+static void *lp_map_find(bctbx_map_t *map, const char *key){
+	void *value = NULL;
+	bctbx_iterator_t *it;
+	bctbx_iterator_t *end;
+	if (map == NULL) return NULL;
+	it = bctbx_map_cchar_find_key(map, key);
+	end = bctbx_map_cchar_end(map);
+	if (!bctbx_iterator_cchar_equals(it, end))
+		value = bctbx_pair_cchar_get_second(bctbx_iterator_cchar_get_pair(it));
+	bctbx_iterator_cchar_delete(it);
+	bctbx_iterator_cchar_delete(end);
+	return value;
+}
+
+/* Like the former list walks, lookups must return the first element having the key: keep the indexed one. */
+static void lp_map_insert(bctbx_map_t *map, const char *key, void *value){
+	if (lp_map_find(map, key) != NULL) return;
+	bctbx_map_cchar_insert_and_delete(map, (bctbx_pair_t *)bctbx_pair_cchar_new(key, value));
+}
+
+static void lp_map_erase(bctbx_map_t *map, const char *key, const void *value){
+	bctbx_iterator_t *it;
+	bctbx_iterator_t *end;
+	if (map == NULL) return;
+	it = bctbx_map_cchar_find_key(map, key);
+	end = bctbx_map_cchar_end(map);
+	if (!bctbx_iterator_cchar_equals(it, end) && bctbx_pair_cchar_get_second(bctbx_iterator_cchar_get_pair(it)) == value)
+		bctbx_map_cchar_erase(map, it);
+	bctbx_iterator_cchar_delete(it);
+	bctbx_iterator_cchar_delete(end);
+}
+
 void lp_section_add_item(LpSection *sec,LpItem *item){
 	sec->items=bctbx_list_append(sec->items,(void *)item);
+	if (!item->is_comment) lp_map_insert(sec->items_map, item->key, item);
 }
 
 void linphone_config_add_section(LpConfig *lpconfig, LpSection *section){
 	lpconfig->sections=bctbx_list_append(lpconfig->sections,(void *)section);
+	if (lpconfig->sections_map == NULL) lpconfig->sections_map = bctbx_mmap_cchar_new();
+	lp_map_insert(lpconfig->sections_map, section->name, section);
 }
 
 void linphone_config_add_section_param(LpSection *section, LpSectionParam *param){
@@ -192,12 +258,34 @@ void linphone_config_add_section_param(LpSection *section, LpSectionParam *param
 }
 
 void linphone_config_remove_section(LpConfig *lpconfig, LpSection *section){
+	bctbx_list_t *elem;
 	lpconfig->sections=bctbx_list_remove(lpconfig->sections,(void *)section);
+	lp_map_erase(lpconfig->sections_map, section->name, section);
+	/* Index a duplicate, if any, in place of the removed section */
+	for (elem = lpconfig->sections; elem != NULL; elem = bctbx_list_next(elem)){
+		LpSection *other = (LpSection *)elem->data;
+		if (strcmp(other->name, section->name) == 0){
+			lp_map_insert(lpconfig->sections_map, other->name, other);
+			break;
+		}
+	}
 	lp_section_destroy(section);
 }
 
 void lp_section_remove_item(LpSection *sec, LpItem *item){
 	sec->items=bctbx_list_remove(sec->items,(void *)item);
+	if (!item->is_comment){
+		bctbx_list_t *elem;
+		lp_map_erase(sec->items_map, item->key, item);
+		/* Index a duplicate, if any, in place of the removed item */
+		for (elem = sec->items; elem != NULL; elem = bctbx_list_next(elem)){
+			LpItem *other = (LpItem *)elem->data;
+			if (!other->is_comment && strcmp(other->key, item->key) == 0){
+				lp_map_insert(sec->items_map, other->key, other);
+				break;
+			}
+		}
+	}
 	lp_item_destroy(item);
 }
 
@@ -218,17 +306,7 @@ static int is_a_comment(const char *str){
 }
 
 LpSection *linphone_config_find_section(const LpConfig *lpconfig, const char *name){
-	LpSection *sec;
-	bctbx_list_t *elem = lpconfig->sections;
-	/*printf("Looking for section %s\n",name);*/
-	for (;elem!=NULL;elem=bctbx_list_next(elem)){
-		sec=(LpSection*)elem->data;
-		if (strcmp(sec->name,name)==0){
-			/*printf("Section %s found\n",name);*/
-			return sec;
-		}
-	}
-	return NULL;
+	return (LpSection *)lp_map_find(lpconfig->sections_map, name);
 }
 
 LpSectionParam *lp_section_find_param(const LpSection *sec, const char *key){
@@ -258,17 +336,7 @@ LpItem *lp_section_find_comment(const LpSection *sec, const char *comment){
 }
 
 LpItem *lp_section_find_item(const LpSection *sec, const char *name){
-	bctbx_list_t *elem;
-	LpItem *item;
-	/*printf("Looking for item %s\n",name);*/
-	for (elem=sec->items;elem!=NULL;elem=bctbx_list_next(elem)){
-		item=(LpItem*)elem->data;
-		if (!item->is_comment && strcmp(item->key,name)==0) {
-			/*printf("Item %s found\n",name);*/
-			return item;
-		}
-	}
-	return NULL;
+	return (LpItem *)lp_map_find(sec->items_map, name);
 }
 
 static LpSection* linphone_config_parse_line(LpConfig* lpconfig, char* line, LpSection* cur) {
@@ -419,6 +487,9 @@ LpConfig * linphone_config_new_from_buffer(const char *buffer){
 	return conf;
 }
 
+static int linphone_config_load_cache(LpConfig *lpconfig);
+static void linphone_config_update_cache(LpConfig *lpconfig);
+
 static int _linphone_config_init_from_files(LinphoneConfig *lpconfig, const char *config_filename, const char *factory_config_filename) {
 	lpconfig->g_bctbx_vfs = bctbx_vfs_get_default();
 
@@ -450,6 +521,13 @@ static int _linphone_config_init_from_files(LinphoneConfig *lpconfig, const char
 
 		/*open with r+ to check if we can write on it later*/
 		lpconfig->pFile = bctbx_file_open(lpconfig->g_bctbx_vfs,lpconfig->filename, "r+");
+		if (lpconfig->pFile != NULL && lpconfig->cache_filename && linphone_config_load_cache(lpconfig) == 0){
+			/* The factory config is already merged in the snapshot */
+			ms_message("Config loaded from binary snapshot %s", lpconfig->cache_filename);
+			bctbx_file_close(lpconfig->pFile);
+			lpconfig->pFile = NULL;
+			return 0;
+		}
 #ifdef RENAME_REQUIRES_NONEXISTENT_NEW_PATH
 		if (lpconfig->pFile == NULL){
 			lpconfig->pFile = bctbx_file_open(lpconfig->g_bctbx_vfs,lpconfig->tmpfilename, "r+");
@@ -466,6 +544,7 @@ static int _linphone_config_init_from_files(LinphoneConfig *lpconfig, const char
 		}
 	}
 	_linphone_config_apply_factory_config(lpconfig);
+	if (lpconfig->filename && lpconfig->cache_filename) linphone_config_update_cache(lpconfig);
 	return 0;
 
 fail:
@@ -473,9 +552,15 @@ fail:
 }
 
 LpConfig *linphone_config_new_with_factory(const char *config_filename, const char *factory_config_filename) {
+	return linphone_config_new_with_cache(config_filename, factory_config_filename, NULL);
+}
+
+LpConfig *linphone_config_new_with_cache(const char *config_filename, const char *factory_config_filename, const char *cache_filename) {
 	LpConfig *lpconfig=belle_sip_object_new(LinphoneConfig);
 	if (factory_config_filename)
 		lpconfig->factory_filename = bctbx_strdup(factory_config_filename);
+	if (cache_filename)
+		lpconfig->cache_filename = bctbx_strdup(cache_filename);
 	if (_linphone_config_init_from_files(lpconfig, config_filename, factory_config_filename) == 0) {
 		return lpconfig;
 	} else {
@@ -581,12 +666,17 @@ void lp_item_set_value(LpItem *item, const char *value){
 }
 
 
+static void linphone_config_stop_writer(LpConfig *lpconfig);
+
 static void _linphone_config_uninit(LpConfig *lpconfig){
+	linphone_config_stop_writer(lpconfig);
 	if (lpconfig->filename!=NULL) ortp_free(lpconfig->filename);
 	if (lpconfig->tmpfilename) ortp_free(lpconfig->tmpfilename);
 	if (lpconfig->factory_filename) bctbx_free(lpconfig->factory_filename);
+	if (lpconfig->cache_filename) bctbx_free(lpconfig->cache_filename);
 	bctbx_list_for_each(lpconfig->sections,(void (*)(void*))lp_section_destroy);
 	bctbx_list_free(lpconfig->sections);
+	if (lpconfig->sections_map) bctbx_mmap_cchar_delete(lpconfig->sections_map);
 }
 
 LpConfig *linphone_config_ref(LpConfig *lpconfig){
@@ -866,64 +956,102 @@ void linphone_config_set_skip_flag_for_section(LpConfig *lpconfig, const char *s
 	}
 }
 
-void lp_item_write(LpItem *item, LpConfig *lpconfig){
-	int ret =-1 ;
-	if (item->is_comment){
-		ret = (int)bctbx_file_fprintf(lpconfig->pFile, 0, "%s\n",item->value);
+typedef struct _LpBuffer{
+	char *data;
+	size_t size;
+	size_t capacity;
+} LpBuffer;
+
+static void lp_buffer_reserve(LpBuffer *buffer, size_t len){
+	if (buffer->size + len > buffer->capacity){
+		size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+		while (buffer->size + len > capacity) capacity *= 2;
+		buffer->data = reinterpret_cast<char *>(ms_realloc(buffer->data, capacity));
+		buffer->capacity = capacity;
+	}
+}
+
+static void lp_buffer_append(LpBuffer *buffer, const char *fmt, ...){
+	va_list args;
+	int len;
+
+	va_start(args, fmt);
+	len = vsnprintf(NULL, 0, fmt, args);
+	va_end(args);
+	if (len < 0) return;
+	lp_buffer_reserve(buffer, (size_t)len + 1);
+	va_start(args, fmt);
+	vsnprintf(buffer->data + buffer->size, (size_t)len + 1, fmt, args);
+	va_end(args);
+	buffer->size += (size_t)len;
+}
 
+static void lp_item_write(LpItem *item, LpBuffer *buffer){
+	if (item->is_comment){
+		lp_buffer_append(buffer, "%s\n", item->value);
 	}
 	else if (item->value && item->value[0] != '\0' ){
-		ret = (int)bctbx_file_fprintf(lpconfig->pFile, 0, "%s=%s\n",item->key,item->value);
+		lp_buffer_append(buffer, "%s=%s\n", item->key, item->value);
 	}
-
 	else {
 		ms_warning("Not writing item %s to file, it is empty", item->key);
 	}
-	if (ret < 0){
-		ms_error("lp_item_write : not writing item to file" );
-	}
 }
 
-void lp_section_param_write(LpSectionParam *param, LpConfig *lpconfig){
+static void lp_section_param_write(LpSectionParam *param, LpBuffer *buffer){
 	if( param->value && param->value[0] != '\0') {
-		bctbx_file_fprintf(lpconfig->pFile, 0, " %s=%s", param->key, param->value);
-
+		lp_buffer_append(buffer, " %s=%s", param->key, param->value);
 	} else {
 		ms_warning("Not writing param %s to file, it is empty", param->key);
 	}
 }
 
-void lp_section_write(LpSection *sec,LpConfig *lpconfig){
-
-	if (bctbx_file_fprintf(lpconfig->pFile, 0, "[%s",sec->name) < 0) ms_error("lp_section_write : write error on %s", sec->name);
-	bctbx_list_for_each2(sec->params, (void (*)(void*, void*))lp_section_param_write, (void *)lpconfig);
-
-	if (bctbx_file_fprintf(lpconfig->pFile, 0, "]\n")< 0) ms_error("lp_section_write : write error ");
-	bctbx_list_for_each2(sec->items, (void (*)(void*, void*))lp_item_write, (void *)lpconfig);
-
-	if (bctbx_file_fprintf(lpconfig->pFile, 0, "\n")< 0) ms_error("lp_section_write : write error");
+static void lp_section_write(LpSection *sec, LpBuffer *buffer){
+	lp_buffer_append(buffer, "[%s", sec->name);
+	bctbx_list_for_each2(sec->params, (void (*)(void*, void*))lp_section_param_write, (void *)buffer);
+	lp_buffer_append(buffer, "]\n");
+	bctbx_list_for_each2(sec->items, (void (*)(void*, void*))lp_item_write, (void *)buffer);
+	lp_buffer_append(buffer, "\n");
+}
 
+/* Snapshot of the file content, cheap enough to be taken on the main thread. */
+static char *linphone_config_serialize(const LpConfig *lpconfig, size_t *size){
+	LpBuffer buffer = {NULL, 0, 0};
+	bctbx_list_for_each2(lpconfig->sections, (void (*)(void *,void*))lp_section_write, (void *)&buffer);
+	*size = buffer.size;
+	return buffer.data ? buffer.data : ms_strdup("");
 }
 
-LinphoneStatus linphone_config_sync(LpConfig *lpconfig){
-	bctbx_vfs_file_t *pFile = NULL;
-	if (lpconfig->filename==NULL) return -1;
-	if (lpconfig->readonly) return 0;
+/*
+ * Writes a snapshot to the temporary file, flushes it to the storage then renames it over the configuration file,
+ * so that the configuration file is either the previous or the new one, never a truncated one.
+ */
+static int linphone_config_write_file(const LpConfig *lpconfig, const char *data, size_t size, bool_t *readonly){
+	bctbx_vfs_file_t *pFile;
+	int err = 0;
 
 #ifndef _WIN32
 	/* don't create group/world-accessible files */
 	(void) umask(S_IRWXG | S_IRWXO);
 #endif
-	pFile  = bctbx_file_open(lpconfig->g_bctbx_vfs,lpconfig->tmpfilename, "w");
-	lpconfig->pFile = pFile;
+	pFile = bctbx_file_open(lpconfig->g_bctbx_vfs, lpconfig->tmpfilename, "w");
 	if (pFile == NULL){
 		ms_warning("Could not write %s ! Maybe it is read-only. Configuration will not be saved.",lpconfig->filename);
-		lpconfig->readonly = TRUE;
+		*readonly = TRUE;
+		return -1;
+	}
+	if (size > 0 && bctbx_file_write(pFile, data, size, 0) != (ssize_t)size) err = -1;
+	/* The vfs has no sync operation, flush the underlying descriptor as the sqlite3 bctbx vfs does. */
+#ifdef _WIN32
+	if (err == 0 && _commit(pFile->fd) != 0) err = -1;
+#else
+	if (err == 0 && fsync(pFile->fd) != 0) err = -1;
+#endif
+	if (bctbx_file_close(pFile) != 0) err = -1;
+	if (err != 0){
+		ms_error("Cannot write %s: %s", lpconfig->tmpfilename, strerror(errno));
 		return -1;
 	}
-
-	bctbx_list_for_each2(lpconfig->sections,(void (*)(void *,void*))lp_section_write,(void *)lpconfig);
-	bctbx_file_close(pFile);
 
 #ifdef RENAME_REQUIRES_NONEXISTENT_NEW_PATH
 	/* On windows, rename() does not accept that the newpath is an existing file, while it is accepted on Unix.
@@ -934,11 +1062,456 @@ LinphoneStatus linphone_config_sync(LpConfig *lpconfig){
 #endif
 	if (rename(lpconfig->tmpfilename,lpconfig->filename)!=0){
 		ms_error("Cannot rename %s into %s: %s",lpconfig->tmpfilename,lpconfig->filename,strerror(errno));
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Binary snapshot of the merged config: a header followed by the sections. Strings are stored as a 32 bits length
+ * followed by the null terminated characters, so that they can be used in place from a mapping of the file.
+ * Items and params with empty values are left out, as they are when writing the text file.
+ */
+#define LP_CONFIG_CACHE_MAGIC 0x4c504342
+#define LP_CONFIG_CACHE_VERSION 1
+
+typedef struct _LpConfigCacheHeader{
+	uint32_t magic;
+	uint32_t version;
+	int64_t config_size; // Size and modification time of the files the snapshot was made from
+	int64_t config_mtime;
+	int64_t factory_size;
+	int64_t factory_mtime;
+	uint32_t section_count;
+	uint32_t reserved;
+} LpConfigCacheHeader;
+
+typedef struct _LpCacheReader{
+	const char *pos;
+	const char *end;
+} LpCacheReader;
+
+static void lp_cache_stat(const char *filename, int64_t *size, int64_t *mtime){
+	struct stat fileStat;
+	if (filename && stat(filename, &fileStat) == 0){
+		*size = (int64_t)fileStat.st_size;
+		*mtime = (int64_t)fileStat.st_mtime;
+	}else{
+		*size = -1;
+		*mtime = -1;
+	}
+}
+
+static void lp_buffer_append_uint32(LpBuffer *buffer, uint32_t value){
+	lp_buffer_reserve(buffer, sizeof(value));
+	memcpy(buffer->data + buffer->size, &value, sizeof(value));
+	buffer->size += sizeof(value);
+}
+
+static void lp_buffer_append_string(LpBuffer *buffer, const char *str){
+	size_t len = strlen(str);
+	lp_buffer_append_uint32(buffer, (uint32_t)len);
+	lp_buffer_reserve(buffer, len + 1);
+	memcpy(buffer->data + buffer->size, str, len + 1);
+	buffer->size += len + 1;
+}
+
+static bool_t lp_cache_read_uint32(LpCacheReader *reader, uint32_t *value){
+	if ((size_t)(reader->end - reader->pos) < sizeof(*value)) return FALSE;
+	memcpy(value, reader->pos, sizeof(*value));
+	reader->pos += sizeof(*value);
+	return TRUE;
+}
+
+static const char *lp_cache_read_string(LpCacheReader *reader){
+	uint32_t len;
+	const char *str;
+	if (!lp_cache_read_uint32(reader, &len)) return NULL;
+	if ((size_t)(reader->end - reader->pos) <= (size_t)len || reader->pos[len] != '\0') return NULL;
+	str = reader->pos;
+	reader->pos += (size_t)len + 1;
+	return str;
+}
+
+static char *linphone_config_serialize_cache(const LpConfig *lpconfig, size_t *size){
+	LpBuffer buffer = {NULL, 0, 0};
+	LpConfigCacheHeader header;
+	const bctbx_list_t *elem;
+
+	/* The files information is filled once they are written, see linphone_config_write_cache_file() */
+	memset(&header, 0, sizeof(header));
+	header.magic = LP_CONFIG_CACHE_MAGIC;
+	header.version = LP_CONFIG_CACHE_VERSION;
+	header.section_count = (uint32_t)bctbx_list_size(lpconfig->sections);
+	lp_buffer_reserve(&buffer, sizeof(header));
+	memcpy(buffer.data, &header, sizeof(header));
+	buffer.size = sizeof(header);
+
+	for (elem = lpconfig->sections; elem != NULL; elem = bctbx_list_next(elem)){
+		const LpSection *sec = (const LpSection *)elem->data;
+		const bctbx_list_t *it;
+		size_t count_offset;
+		uint32_t count = 0;
+
+		lp_buffer_append_string(&buffer, sec->name);
+
+		count_offset = buffer.size;
+		lp_buffer_append_uint32(&buffer, 0);
+		for (it = sec->params; it != NULL; it = bctbx_list_next(it)){
+			const LpSectionParam *param = (const LpSectionParam *)it->data;
+			if (!param->value || param->value[0] == '\0') continue;
+			lp_buffer_append_string(&buffer, param->key);
+			lp_buffer_append_string(&buffer, param->value);
+			count++;
+		}
+		memcpy(buffer.data + count_offset, &count, sizeof(count));
+
+		count = 0;
+		count_offset = buffer.size;
+		lp_buffer_append_uint32(&buffer, 0);
+		for (it = sec->items; it != NULL; it = bctbx_list_next(it)){
+			const LpItem *item = (const LpItem *)it->data;
+			if (item->is_comment){
+				lp_buffer_append_uint32(&buffer, 1);
+				lp_buffer_append_string(&buffer, item->value);
+			}else if (item->value && item->value[0] != '\0'){
+				lp_buffer_append_uint32(&buffer, 0);
+				lp_buffer_append_string(&buffer, item->key);
+				lp_buffer_append_string(&buffer, item->value);
+			}else continue;
+			count++;
+		}
+		memcpy(buffer.data + count_offset, &count, sizeof(count));
+	}
+	*size = buffer.size;
+	return buffer.data;
+}
+
+/* To be called once the config file is written, so that the snapshot is bound to its new size and modification time. */
+static void linphone_config_write_cache_file(const LpConfig *lpconfig, char *data, size_t size){
+	LpConfigCacheHeader header;
+	char *tmpfilename;
+	bctbx_vfs_file_t *pFile;
+	int err = 0;
+
+	memcpy(&header, data, sizeof(header));
+	lp_cache_stat(lpconfig->filename, &header.config_size, &header.config_mtime);
+	lp_cache_stat(lpconfig->factory_filename, &header.factory_size, &header.factory_mtime);
+	memcpy(data, &header, sizeof(header));
+
+	tmpfilename = ortp_strdup_printf("%s.tmp", lpconfig->cache_filename);
+	pFile = bctbx_file_open(lpconfig->g_bctbx_vfs, tmpfilename, "w");
+	if (pFile == NULL){
+		ms_warning("Could not write config snapshot %s: %s", tmpfilename, strerror(errno));
+		ortp_free(tmpfilename);
+		return;
+	}
+	if (bctbx_file_write(pFile, data, size, 0) != (ssize_t)size) err = -1;
+	if (bctbx_file_close(pFile) != 0) err = -1;
+#ifdef RENAME_REQUIRES_NONEXISTENT_NEW_PATH
+	if (err == 0) remove(lpconfig->cache_filename);
+#endif
+	if (err != 0 || rename(tmpfilename, lpconfig->cache_filename) != 0){
+		ms_warning("Could not write config snapshot %s: %s", lpconfig->cache_filename, strerror(errno));
+		remove(tmpfilename);
+	}
+	ortp_free(tmpfilename);
+}
+
+static void linphone_config_update_cache(LpConfig *lpconfig){
+	size_t size;
+	char *data = linphone_config_serialize_cache(lpconfig, &size);
+	linphone_config_write_cache_file(lpconfig, data, size);
+	ms_free(data);
+}
+
+/* Maps the snapshot read-only while it is loaded, platforms without mmap read it through the vfs instead. The values are copied out of it. */
+static const char *lp_cache_map(bctbx_vfs_t *vfs, const char *filename, size_t *size){
+#ifndef _WIN32
+	struct stat fileStat;
+	void *data;
+	int fd = open(filename, O_RDONLY);
+	(void)vfs;
+	if (fd < 0) return NULL;
+	if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0){
+		close(fd);
+		return NULL;
+	}
+	*size = (size_t)fileStat.st_size;
+	data = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	return data == MAP_FAILED ? NULL : (const char *)data;
+#else
+	bctbx_vfs_file_t *pFile = bctbx_file_open(vfs, filename, "r");
+	char *data;
+	int64_t len;
+	if (pFile == NULL) return NULL;
+	len = bctbx_file_size(pFile);
+	if (len <= 0){
+		bctbx_file_close(pFile);
+		return NULL;
+	}
+	*size = (size_t)len;
+	data = reinterpret_cast<char *>(ms_malloc(*size));
+	if (bctbx_file_read(pFile, data, *size, 0) != (ssize_t)*size){
+		ms_free(data);
+		data = NULL;
+	}
+	bctbx_file_close(pFile);
+	return data;
+#endif
+}
+
+static void lp_cache_unmap(const char *data, size_t size){
+#ifndef _WIN32
+	munmap((void *)data, size);
+#else
+	(void)size;
+	ms_free((void *)data);
+#endif
+}
+
+/* Fills the config from the binary snapshot if it is still up to date with the config and factory files. */
+static int linphone_config_load_cache(LpConfig *lpconfig){
+	LpConfigCacheHeader header;
+	LpCacheReader reader;
+	int64_t size, mtime;
+	size_t data_size = 0;
+	const char *data = lp_cache_map(lpconfig->g_bctbx_vfs, lpconfig->cache_filename, &data_size);
+	uint32_t i, j, count;
+	int err = -1;
+
+	if (data == NULL) return -1;
+	if (data_size < sizeof(header)) goto end;
+	memcpy(&header, data, sizeof(header));
+	if (header.magic != LP_CONFIG_CACHE_MAGIC || header.version != LP_CONFIG_CACHE_VERSION) goto end;
+	lp_cache_stat(lpconfig->filename, &size, &mtime);
+	if (size < 0 || header.config_size != size || header.config_mtime != mtime) goto end;
+	lp_cache_stat(lpconfig->factory_filename, &size, &mtime);
+	if (header.factory_size != size || header.factory_mtime != mtime) goto end;
+
+	reader.pos = data + sizeof(header);
+	reader.end = data + data_size;
+	for (i = 0; i < header.section_count; i++){
+		const char *name = lp_cache_read_string(&reader);
+		LpSection *sec;
+		if (name == NULL || !lp_cache_read_uint32(&reader, &count)) goto end;
+		sec = lp_section_new(name);
+		linphone_config_add_section(lpconfig, sec);
+		for (j = 0; j < count; j++){
+			const char *key = lp_cache_read_string(&reader);
+			const char *value = key ? lp_cache_read_string(&reader) : NULL;
+			if (value == NULL) goto end;
+			linphone_config_add_section_param(sec, lp_section_param_new(key, value));
+		}
+		if (!lp_cache_read_uint32(&reader, &count)) goto end;
+		for (j = 0; j < count; j++){
+			uint32_t is_comment;
+			const char *key = NULL;
+			const char *value;
+			if (!lp_cache_read_uint32(&reader, &is_comment)) goto end;
+			if (!is_comment && (key = lp_cache_read_string(&reader)) == NULL) goto end;
+			if ((value = lp_cache_read_string(&reader)) == NULL) goto end;
+			lp_section_add_item(sec, is_comment ? lp_comment_new(value) : lp_item_new(key, value));
+		}
+	}
+	if (reader.pos == reader.end) err = 0;
+
+end:
+	if (err != 0){
+		ms_warning("Config snapshot %s is outdated or invalid, parsing config files.", lpconfig->cache_filename);
+		bctbx_list_for_each(lpconfig->sections,(void (*)(void*))lp_section_destroy);
+		lpconfig->sections = bctbx_list_free(lpconfig->sections);
+		if (lpconfig->sections_map){
+			bctbx_mmap_cchar_delete(lpconfig->sections_map);
+			lpconfig->sections_map = NULL;
+		}
 	}
 	lpconfig->modified = FALSE;
+	lp_cache_unmap(data, data_size);
+	return err;
+}
+
+static void *linphone_config_writer_thread(void *data){
+	LpConfig *lpconfig = (LpConfig *)data;
+
+	ms_mutex_lock(&lpconfig->writer_mutex);
+	while (TRUE){
+		char *snapshot;
+		char *cache;
+		size_t size;
+		size_t cache_size;
+		bool_t readonly = FALSE;
+		int status;
+
+		while ((!lpconfig->pending_data || lpconfig->writer_paused) && !lpconfig->writer_stop)
+			ms_cond_wait(&lpconfig->writer_cond, &lpconfig->writer_mutex);
+		if (!lpconfig->pending_data) break;
+
+		snapshot = lpconfig->pending_data;
+		size = lpconfig->pending_size;
+		cache = lpconfig->pending_cache;
+		cache_size = lpconfig->pending_cache_size;
+		lpconfig->pending_data = NULL;
+		lpconfig->pending_cache = NULL;
+		lpconfig->writer_busy = TRUE;
+		ms_mutex_unlock(&lpconfig->writer_mutex);
+
+		status = linphone_config_write_file(lpconfig, snapshot, size, &readonly);
+		ms_free(snapshot);
+		if (cache){
+			if (status == 0) linphone_config_write_cache_file(lpconfig, cache, cache_size);
+			ms_free(cache);
+		}
+
+		ms_mutex_lock(&lpconfig->writer_mutex);
+		lpconfig->writer_busy = FALSE;
+		lpconfig->writer_status = status;
+		lpconfig->writer_count++;
+		if (readonly) lpconfig->writer_readonly = TRUE;
+		/* A newer snapshot already waiting will supersede the failed one. */
+		lpconfig->writer_failed = (status != 0 && !readonly && !lpconfig->pending_data);
+		ms_cond_broadcast(&lpconfig->writer_cond);
+	}
+	ms_mutex_unlock(&lpconfig->writer_mutex);
+	return NULL;
+}
+
+/* Marks the config as modified again if the writer thread failed, must be called with the writer mutex locked. */
+static void linphone_config_check_writer_status(LpConfig *lpconfig){
+	if (lpconfig->writer_failed){
+		lpconfig->writer_failed = FALSE;
+		lpconfig->modified = TRUE;
+	}
+}
+
+/* Waits until the writer thread is idle, must be called with the writer mutex locked. */
+static void linphone_config_wait_writer(LpConfig *lpconfig, bool_t drop_pending){
+	if (drop_pending && lpconfig->pending_data){
+		ms_free(lpconfig->pending_data);
+		lpconfig->pending_data = NULL;
+		if (lpconfig->pending_cache){
+			ms_free(lpconfig->pending_cache);
+			lpconfig->pending_cache = NULL;
+		}
+	}
+	lpconfig->writer_paused = FALSE;
+	while (lpconfig->pending_data || lpconfig->writer_busy)
+		ms_cond_wait(&lpconfig->writer_cond, &lpconfig->writer_mutex);
+	if (lpconfig->writer_readonly) lpconfig->readonly = TRUE;
+	if (!drop_pending) linphone_config_check_writer_status(lpconfig);
+}
+
+static void linphone_config_stop_writer(LpConfig *lpconfig){
+	if (!lpconfig->writer_started) return;
+	ms_mutex_lock(&lpconfig->writer_mutex);
+	lpconfig->writer_stop = TRUE;
+	ms_cond_signal(&lpconfig->writer_cond);
+	ms_mutex_unlock(&lpconfig->writer_mutex);
+	ms_thread_join(lpconfig->writer_thread, NULL);
+	ms_cond_destroy(&lpconfig->writer_cond);
+	ms_mutex_destroy(&lpconfig->writer_mutex);
+	lpconfig->writer_started = FALSE;
+}
+
+LinphoneStatus linphone_config_sync(LpConfig *lpconfig){
+	char *data;
+	size_t size;
+	bool_t readonly = FALSE;
+	int err;
+
+	if (lpconfig->filename==NULL) return -1;
+	if (lpconfig->readonly) return 0;
+
+	if (lpconfig->writer_started){
+		/* A snapshot still waiting for the writer thread is older than this one, and must not be renamed over it. */
+		ms_mutex_lock(&lpconfig->writer_mutex);
+		linphone_config_wait_writer(lpconfig, TRUE);
+		ms_mutex_unlock(&lpconfig->writer_mutex);
+		if (lpconfig->readonly) return -1;
+	}
+	data = linphone_config_serialize(lpconfig, &size);
+	err = linphone_config_write_file(lpconfig, data, size, &readonly);
+	ms_free(data);
+	if (readonly){
+		lpconfig->readonly = TRUE;
+		return -1;
+	}
+	if (err != 0) return err;
+	lpconfig->modified = FALSE;
+	if (lpconfig->cache_filename) linphone_config_update_cache(lpconfig);
 	return 0;
 }
 
+void _linphone_config_sync_in_background(LpConfig *lpconfig){
+	char *data;
+	char *cache = NULL;
+	size_t size;
+	size_t cache_size = 0;
+
+	if (lpconfig->filename==NULL || lpconfig->readonly) return;
+
+	if (!lpconfig->writer_started){
+		ms_mutex_init(&lpconfig->writer_mutex, NULL);
+		ms_cond_init(&lpconfig->writer_cond, NULL);
+		lpconfig->writer_stop = FALSE;
+		lpconfig->writer_started = TRUE;
+		ms_thread_create(&lpconfig->writer_thread, NULL, linphone_config_writer_thread, lpconfig);
+	}
+
+	data = linphone_config_serialize(lpconfig, &size);
+	if (lpconfig->cache_filename) cache = linphone_config_serialize_cache(lpconfig, &cache_size);
+	ms_mutex_lock(&lpconfig->writer_mutex);
+	lpconfig->writer_failed = FALSE;
+	if (lpconfig->writer_readonly){
+		lpconfig->readonly = TRUE;
+		ms_mutex_unlock(&lpconfig->writer_mutex);
+		ms_free(data);
+		if (cache) ms_free(cache);
+		return;
+	}
+	/* Coalesce with the previous snapshot if the writer thread didn't pick it up yet */
+	if (lpconfig->pending_data) ms_free(lpconfig->pending_data);
+	if (lpconfig->pending_cache) ms_free(lpconfig->pending_cache);
+	lpconfig->pending_data = data;
+	lpconfig->pending_size = size;
+	lpconfig->pending_cache = cache;
+	lpconfig->pending_cache_size = cache_size;
+	ms_cond_signal(&lpconfig->writer_cond);
+	ms_mutex_unlock(&lpconfig->writer_mutex);
+	lpconfig->modified = FALSE;
+}
+
+LinphoneStatus linphone_config_flush(LpConfig *lpconfig){
+	LinphoneStatus status = 0;
+
+	if (lpconfig->modified) return linphone_config_sync(lpconfig);
+	if (lpconfig->writer_started){
+		ms_mutex_lock(&lpconfig->writer_mutex);
+		linphone_config_wait_writer(lpconfig, FALSE);
+		status = lpconfig->writer_status;
+		ms_mutex_unlock(&lpconfig->writer_mutex);
+	}
+	return status;
+}
+
+void _linphone_config_pause_background_writer(LpConfig *lpconfig, bool_t paused){
+	if (!lpconfig->writer_started) return;
+	ms_mutex_lock(&lpconfig->writer_mutex);
+	lpconfig->writer_paused = paused;
+	ms_cond_signal(&lpconfig->writer_cond);
+	ms_mutex_unlock(&lpconfig->writer_mutex);
+}
+
+int _linphone_config_get_background_write_count(LpConfig *lpconfig){
+	int count = 0;
+	if (!lpconfig->writer_started) return 0;
+	ms_mutex_lock(&lpconfig->writer_mutex);
+	count = lpconfig->writer_count;
+	ms_mutex_unlock(&lpconfig->writer_mutex);
+	return count;
+}
+
 int linphone_config_has_section(const LpConfig *lpconfig, const char *section){
 	if (linphone_config_find_section(lpconfig,section)!=NULL) return 1;
 	return 0;
@@ -975,6 +1548,12 @@ void linphone_config_clean_section(LpConfig *lpconfig, const char *section){
 }
 
 bool_t linphone_config_needs_commit(const LpConfig *lpconfig){
+	if (lpconfig->writer_started){
+		LpConfig *config = (LpConfig *)lpconfig;
+		ms_mutex_lock(&config->writer_mutex);
+		linphone_config_check_writer_status(config);
+		ms_mutex_unlock(&config->writer_mutex);
+	}
 	return lpconfig->modified;
 }
 
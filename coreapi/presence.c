@@ -114,9 +114,6 @@ BELLE_SIP_DECLARE_NO_IMPLEMENTED_INTERFACES(LinphonePresenceModel);
 BELLE_SIP_DECLARE_VPTR_NO_EXPORT(LinphonePresenceModel);
 
 
-static const char *person_prefix = "/pidf:presence/dm:person";
-
-
 /*****************************************************************************
  * PRIVATE FUNCTIONS                                                         *
  ****************************************************************************/
@@ -1382,124 +1379,136 @@ void * linphone_presence_note_get_user_data(const LinphonePresenceNote *note) {
  * XML PRESENCE INTERNAL HANDLING                                            *
  ****************************************************************************/
 
-static const char *service_prefix = "/pidf:presence/pidf:tuple";
+/*
+ * The PIDF document is walked once, element by element, instead of evaluating a XPath expression from the root
+ * for each field. Single valued fields keep the last non empty matching element, as the XPath based parsing did.
+ */
+#define PIDF_NS "urn:ietf:params:xml:ns:pidf"
+#define PIDF_DM_NS "urn:ietf:params:xml:ns:pidf:data-model"
+#define PIDF_RPID_NS "urn:ietf:params:xml:ns:pidf:rpid"
+#define PIDF_ONLINE_NS "http://www.linphone.org/xsds/pidfonline.xsd"
+#define PIDF_OMA_PRES_NS "urn:oma:xml:prs:pidf:oma-pres"
+
+static bool_t is_pidf_element(const xmlNode *node, const char *ns) {
+	return (node->type == XML_ELEMENT_NODE) && node->ns && node->ns->href && (xmlStrcmp(node->ns->href, (const xmlChar *)ns) == 0);
+}
+
+static bool_t is_pidf_element_named(const xmlNode *node, const char *ns, const char *name) {
+	return is_pidf_element(node, ns) && (xmlStrcmp(node->name, (const xmlChar *)name) == 0);
+}
+
+static char * get_pidf_element_text(const xmlNode *node) {
+	if (node->children == NULL) return NULL;
+	return (char *)xmlNodeListGetString(node->doc, node->children, 1);
+}
+
+static void set_pidf_element_text(char **text, const xmlNode *node) {
+	char *value = get_pidf_element_text(node);
+	if (value == NULL) return;
+	if (*text != NULL) linphone_free_xml_text_content(*text);
+	*text = value;
+}
 
-static int process_pidf_xml_presence_service_notes(xmlparsing_context_t *xml_ctx, LinphonePresenceService *service, unsigned int service_idx) {
-	char xpath_str[MAX_XPATH_LENGTH];
-	xmlXPathObjectPtr note_object;
+static LinphonePresenceNote * process_pidf_xml_presence_note(const xmlNode *node) {
 	LinphonePresenceNote *note;
-	char *note_str;
 	char *lang;
-	int i;
+	char *note_str = get_pidf_element_text(node);
+	if (note_str == NULL) return NULL;
+	lang = (char *)xmlGetNsProp(node, (const xmlChar *)"lang", XML_XML_NAMESPACE);
+	note = linphone_presence_note_new(note_str, lang);
+	if (lang != NULL) linphone_free_xml_text_content(lang);
+	linphone_free_xml_text_content(note_str);
+	return note;
+}
 
-	snprintf(xpath_str, sizeof(xpath_str), "%s[%i]/pidf:note", service_prefix, service_idx);
-	note_object = linphone_get_xml_xpath_object_for_node_list(xml_ctx, xpath_str);
-	if ((note_object != NULL) && (note_object->nodesetval != NULL)) {
-		for (i = 1; i <= note_object->nodesetval->nodeNr; i++) {
-			snprintf(xpath_str, sizeof(xpath_str), "%s[%i]/pidf:note[%i]", service_prefix, service_idx, i);
-			note_str = linphone_get_xml_text_content(xml_ctx, xpath_str);
-			if (note_str == NULL) continue;
-			snprintf(xpath_str, sizeof(xpath_str), "%s[%i]/pidf:note[%i]/@xml:lang", service_prefix, service_idx, i);
-			lang = linphone_get_xml_text_content(xml_ctx, xpath_str);
-
-			note = linphone_presence_note_new(note_str, lang);
-			presence_service_add_note(service, note);
-			if (lang != NULL) linphone_free_xml_text_content(lang);
-			linphone_free_xml_text_content(note_str);
-		}
-	}
-	if (note_object != NULL) xmlXPathFreeObject(note_object);
+static void process_pidf_xml_presence_service_description(const xmlNode *node, LinphonePresenceService *service, bctbx_list_t **services) {
+	const xmlNode *child;
+	char *service_id = NULL;
+	char *version = NULL;
 
-	return 0;
+	for (child = node->children; child != NULL; child = child->next) {
+		if (is_pidf_element_named(child, PIDF_OMA_PRES_NS, "service-id"))
+			set_pidf_element_text(&service_id, child);
+		else if (is_pidf_element_named(child, PIDF_OMA_PRES_NS, "version"))
+			set_pidf_element_text(&version, child);
+	}
+	if (service_id) {
+		*services = bctbx_list_append(*services, ms_strdup(service_id));
+		if (service) linphone_presence_service_add_capability(service, ms_strdup(service_id), ms_strdup(version));
+		linphone_free_xml_text_content(service_id);
+	}
+	if (version) linphone_free_xml_text_content(version);
 }
 
-static int process_pidf_xml_presence_services(xmlparsing_context_t *xml_ctx, LinphonePresenceModel *model) {
-	char xpath_str[MAX_XPATH_LENGTH];
-	xmlXPathObjectPtr service_object;
-	xmlXPathObjectPtr pidfonline_object;
+static int process_pidf_xml_presence_service(const xmlNode *tuple, LinphonePresenceModel *model) {
+	const xmlNode *child;
 	LinphonePresenceService *service;
-	char *basic_status_str;
-	char *service_id_str;
-	char *timestamp_str;
-	char *contact_str;
 	LinphonePresenceBasicStatus basic_status;
-	int i;
-	xmlXPathObjectPtr service_descriptions;
-
-	service_object = linphone_get_xml_xpath_object_for_node_list(xml_ctx, service_prefix);
-	if ((service_object != NULL) && (service_object->nodesetval != NULL)) {
-		for (i = 1; i <= service_object->nodesetval->nodeNr; i++) {
-			snprintf(xpath_str, sizeof(xpath_str), "%s[%i]/pidf:status/pidf:basic", service_prefix, i);
-			basic_status_str = linphone_get_xml_text_content(xml_ctx, xpath_str);
-			if (basic_status_str == NULL)
-				continue;
-
-			if (strcmp(basic_status_str, "open") == 0) {
-				basic_status = LinphonePresenceBasicStatusOpen;
-			} else if (strcmp(basic_status_str, "closed") == 0) {
-				basic_status = LinphonePresenceBasicStatusClosed;
-			} else {
-				/* Invalid value for basic status. */
-				linphone_free_xml_text_content(basic_status_str);
-				return -1;
-			}
+	char *basic_status_str = NULL;
+	char *timestamp_str = NULL;
+	char *contact_str = NULL;
+	char *service_id_str;
+	bool_t online = FALSE;
+	bctbx_list_t *services = nullptr;
+	int err = 0;
 
-			snprintf(xpath_str, sizeof(xpath_str), "%s[%i]/pidf:status/pidfonline:online", service_prefix, i);
-			pidfonline_object = linphone_get_xml_xpath_object_for_node_list(xml_ctx, xpath_str);
-			if (pidfonline_object) {
-				if (pidfonline_object->nodesetval && pidfonline_object->nodesetval->nodeNr > 0)
-					model->is_online = TRUE;
-				xmlXPathFreeObject(pidfonline_object);
+	for (child = tuple->children; child != NULL; child = child->next) {
+		if (is_pidf_element_named(child, PIDF_NS, "status")) {
+			const xmlNode *status_child;
+			for (status_child = child->children; status_child != NULL; status_child = status_child->next) {
+				if (is_pidf_element_named(status_child, PIDF_NS, "basic"))
+					set_pidf_element_text(&basic_status_str, status_child);
+				else if (is_pidf_element_named(status_child, PIDF_ONLINE_NS, "online"))
+					online = TRUE;
 			}
+		} else if (is_pidf_element_named(child, PIDF_NS, "timestamp")) {
+			set_pidf_element_text(&timestamp_str, child);
+		} else if (is_pidf_element_named(child, PIDF_NS, "contact")) {
+			set_pidf_element_text(&contact_str, child);
+		}
+	}
+	if (basic_status_str == NULL)
+		goto end;
 
-			snprintf(xpath_str, sizeof(xpath_str), "%s[%i]/pidf:timestamp", service_prefix, i);
-			timestamp_str = linphone_get_xml_text_content(xml_ctx, xpath_str);
-
-			snprintf(xpath_str, sizeof(xpath_str), "%s[%i]/pidf:contact", service_prefix, i);
-			contact_str = linphone_get_xml_text_content(xml_ctx, xpath_str);
-
-			snprintf(xpath_str, sizeof(xpath_str), "%s[%i]/@id", service_prefix, i);
-			service_id_str = linphone_get_xml_text_content(xml_ctx, xpath_str);
-			service = presence_service_new(service_id_str, basic_status);
-
-			snprintf(xpath_str, sizeof(xpath_str), "%s[%i]/oma-pres:service-description", service_prefix, i);
-			service_descriptions = linphone_get_xml_xpath_object_for_node_list(xml_ctx, xpath_str);
-			bctbx_list_t *services = nullptr;
-			if (service_descriptions && service_descriptions->nodesetval) {
-				for (int j = 1; j <= service_descriptions->nodesetval->nodeNr; j++) {
-					char *service_id = nullptr;
-					char *version = nullptr;
-					linphone_xml_xpath_context_set_node(xml_ctx, xmlXPathNodeSetItem(service_descriptions->nodesetval, j-1));
-					service_id = linphone_get_xml_text_content(xml_ctx, "./oma-pres:service-id");
-					if (service_id) {
-						version = linphone_get_xml_text_content(xml_ctx, "./oma-pres:version");
-						services = bctbx_list_append(services, ms_strdup(service_id));
-
-						if (service) linphone_presence_service_add_capability(service, ms_strdup(service_id), ms_strdup(version));
-
-						linphone_free_xml_text_content(service_id);
-						linphone_free_xml_text_content(version);
-					}
-				}
-			}
+	if (strcmp(basic_status_str, "open") == 0) {
+		basic_status = LinphonePresenceBasicStatusOpen;
+	} else if (strcmp(basic_status_str, "closed") == 0) {
+		basic_status = LinphonePresenceBasicStatusClosed;
+	} else {
+		/* Invalid value for basic status. */
+		err = -1;
+		goto end;
+	}
+	if (online) model->is_online = TRUE;
+
+	service_id_str = (char *)xmlGetNoNsProp(tuple, (const xmlChar *)"id");
+	service = presence_service_new(service_id_str, basic_status);
+	if (service_id_str) linphone_free_xml_text_content(service_id_str);
 
-			if (service) {
-				if (timestamp_str) presence_service_set_timestamp(service, parse_timestamp(timestamp_str));
-				if (contact_str) linphone_presence_service_set_contact(service, contact_str);
-				if (services) linphone_presence_service_set_service_descriptions(service, services);
-				process_pidf_xml_presence_service_notes(xml_ctx, service, (unsigned int)i);
-				linphone_presence_model_add_service(model, service);
-				linphone_presence_service_unref(service);
+	for (child = tuple->children; child != NULL; child = child->next) {
+		if (is_pidf_element_named(child, PIDF_OMA_PRES_NS, "service-description"))
+			process_pidf_xml_presence_service_description(child, service, &services);
+	}
+
+	if (service) {
+		if (timestamp_str) presence_service_set_timestamp(service, parse_timestamp(timestamp_str));
+		if (contact_str) linphone_presence_service_set_contact(service, contact_str);
+		if (services) linphone_presence_service_set_service_descriptions(service, services);
+		for (child = tuple->children; child != NULL; child = child->next) {
+			if (is_pidf_element_named(child, PIDF_NS, "note")) {
+				LinphonePresenceNote *note = process_pidf_xml_presence_note(child);
+				if (note) presence_service_add_note(service, note);
 			}
-			if (timestamp_str) linphone_free_xml_text_content(timestamp_str);
-			if (contact_str) linphone_free_xml_text_content(contact_str);
-			if (service_id_str) linphone_free_xml_text_content(service_id_str);
-			linphone_free_xml_text_content(basic_status_str);
 		}
+		linphone_presence_model_add_service(model, service);
+		linphone_presence_service_unref(service);
 	}
-	if (service_object != NULL) xmlXPathFreeObject(service_object);
 
-	return 0;
+end:
+	if (timestamp_str) linphone_free_xml_text_content(timestamp_str);
+	if (contact_str) linphone_free_xml_text_content(contact_str);
+	if (basic_status_str) linphone_free_xml_text_content(basic_status_str);
+	return err;
 }
 
 static bool_t is_valid_activity_name(const char *name) {
@@ -1512,193 +1521,92 @@ static bool_t is_valid_activity_name(const char *name) {
 	return FALSE;
 }
 
-static int process_pidf_xml_presence_person_activities(xmlparsing_context_t *xml_ctx, LinphonePresencePerson *person, unsigned int person_idx) {
-	char xpath_str[MAX_XPATH_LENGTH];
-	xmlXPathObjectPtr activities_nodes_object;
-	xmlXPathObjectPtr activities_object;
-	xmlNodePtr activity_node;
+static int process_pidf_xml_presence_person_activities(const xmlNode *activities, LinphonePresencePerson *person) {
+	const xmlNode *activity_node;
 	LinphonePresenceActivity *activity;
 	char *description;
-	int i, j;
 	int err = 0;
 
-	snprintf(xpath_str, sizeof(xpath_str), "%s[%i]/rpid:activities", person_prefix, person_idx);
-	activities_nodes_object = linphone_get_xml_xpath_object_for_node_list(xml_ctx, xpath_str);
-	if ((activities_nodes_object != NULL) && (activities_nodes_object->nodesetval != NULL)) {
-		for (i = 1; i <= activities_nodes_object->nodesetval->nodeNr; i++) {
-			snprintf(xpath_str, sizeof(xpath_str), "%s[%i]/rpid:activities[%i]/rpid:*", person_prefix, person_idx, i);
-			activities_object = linphone_get_xml_xpath_object_for_node_list(xml_ctx, xpath_str);
-			if ((activities_object != NULL) && (activities_object->nodesetval != NULL)) {
-				for (j = 0; j < activities_object->nodesetval->nodeNr; j++) {
-					activity_node = activities_object->nodesetval->nodeTab[j];
-					if ((activity_node->name != NULL) && (is_valid_activity_name((const char *)activity_node->name) == TRUE)) {
-						LinphonePresenceActivityType acttype;
-						description = (char *)xmlNodeGetContent(activity_node);
-						if ((description != NULL) && (description[0] == '\0')) {
-							linphone_free_xml_text_content(description);
-							description = NULL;
-						}
-						err = activity_name_to_presence_activity_type((const char *)activity_node->name, &acttype);
-						if (err < 0) break;
-						activity = linphone_presence_activity_new(acttype, description);
-						linphone_presence_person_add_activity(person, activity);
-						linphone_presence_activity_unref(activity);
-						if (description != NULL) linphone_free_xml_text_content(description);
-					}
-				}
-			}
-			if (activities_object != NULL) xmlXPathFreeObject(activities_object);
+	for (activity_node = activities->children; activity_node != NULL; activity_node = activity_node->next) {
+		if (is_pidf_element(activity_node, PIDF_RPID_NS) && (is_valid_activity_name((const char *)activity_node->name) == TRUE)) {
+			LinphonePresenceActivityType acttype;
+			err = activity_name_to_presence_activity_type((const char *)activity_node->name, &acttype);
 			if (err < 0) break;
+			description = (char *)xmlNodeGetContent(activity_node);
+			if ((description != NULL) && (description[0] == '\0')) {
+				linphone_free_xml_text_content(description);
+				description = NULL;
+			}
+			activity = linphone_presence_activity_new(acttype, description);
+			linphone_presence_person_add_activity(person, activity);
+			linphone_presence_activity_unref(activity);
+			if (description != NULL) linphone_free_xml_text_content(description);
 		}
 	}
-	if (activities_nodes_object != NULL) xmlXPathFreeObject(activities_nodes_object);
-
 	return err;
 }
 
-static int process_pidf_xml_presence_person_notes(xmlparsing_context_t *xml_ctx, LinphonePresencePerson *person, unsigned int person_idx) {
-	char xpath_str[MAX_XPATH_LENGTH];
-	xmlXPathObjectPtr note_object;
-	LinphonePresenceNote *note;
-	char *note_str;
-	char *lang;
-	int i;
-
-	snprintf(xpath_str, sizeof(xpath_str), "%s[%i]/rpid:activities/rpid:note", person_prefix, person_idx);
-	note_object = linphone_get_xml_xpath_object_for_node_list(xml_ctx, xpath_str);
-	if ((note_object != NULL) && (note_object->nodesetval != NULL)) {
-		for (i = 1; i <= note_object->nodesetval->nodeNr; i++) {
-			snprintf(xpath_str, sizeof(xpath_str), "%s[%i]/rpid:activities/rpid:note[%i]", person_prefix, person_idx, i);
-			note_str = linphone_get_xml_text_content(xml_ctx, xpath_str);
-			if (note_str == NULL) continue;
-			snprintf(xpath_str, sizeof(xpath_str), "%s[%i]/rpid:activities/rpid:note[%i]/@xml:lang", person_prefix, person_idx, i);
-			lang = linphone_get_xml_text_content(xml_ctx, xpath_str);
-
-			note = linphone_presence_note_new(note_str, lang);
-			presence_person_add_activities_note(person, note);
-			if (lang != NULL) linphone_free_xml_text_content(lang);
-			linphone_free_xml_text_content(note_str);
-		}
-	}
-	if (note_object != NULL) xmlXPathFreeObject(note_object);
-
-	snprintf(xpath_str, sizeof(xpath_str), "%s[%i]/dm:note", person_prefix, person_idx);
-	note_object = linphone_get_xml_xpath_object_for_node_list(xml_ctx, xpath_str);
-	if ((note_object != NULL) && (note_object->nodesetval != NULL)) {
-		for (i = 1; i <= note_object->nodesetval->nodeNr; i++) {
-			snprintf(xpath_str, sizeof(xpath_str), "%s[%i]/dm:note[%i]", person_prefix, person_idx, i);
-			note_str = linphone_get_xml_text_content(xml_ctx, xpath_str);
-			if (note_str == NULL) continue;
-			snprintf(xpath_str, sizeof(xpath_str), "%s[%i]/dm:note[%i]/@xml:lang", person_prefix, person_idx, i);
-			lang = linphone_get_xml_text_content(xml_ctx, xpath_str);
-
-			note = linphone_presence_note_new(note_str, lang);
-			presence_person_add_note(person, note);
-			if (lang != NULL) linphone_free_xml_text_content(lang);
-			linphone_free_xml_text_content(note_str);
-		}
-	}
-	if (note_object != NULL) xmlXPathFreeObject(note_object);
-
-	return 0;
-}
-
-static int process_pidf_xml_presence_persons(xmlparsing_context_t *xml_ctx, LinphonePresenceModel *model) {
-	char xpath_str[MAX_XPATH_LENGTH];
-	xmlXPathObjectPtr person_object;
+static int process_pidf_xml_presence_person(const xmlNode *node, LinphonePresenceModel *model) {
+	const xmlNode *child;
 	LinphonePresencePerson *person;
 	char *person_id_str;
-	char *person_timestamp_str;
+	char *person_timestamp_str = NULL;
 	time_t timestamp;
-	int i;
 	int err = 0;
 
-	person_object = linphone_get_xml_xpath_object_for_node_list(xml_ctx, person_prefix);
-	if ((person_object != NULL) && (person_object->nodesetval != NULL)) {
-		for (i = 1; i <= person_object->nodesetval->nodeNr; i++) {
-			snprintf(xpath_str, sizeof(xpath_str), "%s[%i]/@id", person_prefix, i);
-			person_id_str = linphone_get_xml_text_content(xml_ctx, xpath_str);
-			snprintf(xpath_str, sizeof(xpath_str), "%s[%i]/pidf:timestamp", person_prefix, i);
-			person_timestamp_str = linphone_get_xml_text_content(xml_ctx, xpath_str);
-			if (person_timestamp_str == NULL)
-				timestamp = time(NULL);
-			else
-				timestamp = parse_timestamp(person_timestamp_str);
-			person = presence_person_new(person_id_str, timestamp);
-
-			if (person != NULL) {
-				err = process_pidf_xml_presence_person_activities(xml_ctx, person, (unsigned int)i);
-				if (err == 0) {
-					err = process_pidf_xml_presence_person_notes(xml_ctx, person, (unsigned int)i);
-				}
-				if (err == 0) {
-					presence_model_add_person(model, person);
-					linphone_presence_person_unref(person);
-				} else {
-					linphone_presence_person_unref(person);
-					break;
+	for (child = node->children; child != NULL; child = child->next) {
+		if (is_pidf_element_named(child, PIDF_NS, "timestamp"))
+			set_pidf_element_text(&person_timestamp_str, child);
+	}
+	if (person_timestamp_str == NULL)
+		timestamp = time(NULL);
+	else
+		timestamp = parse_timestamp(person_timestamp_str);
+	person_id_str = (char *)xmlGetNoNsProp(node, (const xmlChar *)"id");
+	person = presence_person_new(person_id_str, timestamp);
+
+	if (person != NULL) {
+		for (child = node->children; (child != NULL) && (err == 0); child = child->next) {
+			if (is_pidf_element_named(child, PIDF_RPID_NS, "activities")) {
+				const xmlNode *activities_child;
+				err = process_pidf_xml_presence_person_activities(child, person);
+				for (activities_child = child->children; (activities_child != NULL) && (err == 0); activities_child = activities_child->next) {
+					if (is_pidf_element_named(activities_child, PIDF_RPID_NS, "note")) {
+						LinphonePresenceNote *note = process_pidf_xml_presence_note(activities_child);
+						if (note) presence_person_add_activities_note(person, note);
+					}
 				}
+			} else if (is_pidf_element_named(child, PIDF_DM_NS, "note")) {
+				LinphonePresenceNote *note = process_pidf_xml_presence_note(child);
+				if (note) presence_person_add_note(person, note);
 			}
-			if (person_id_str != NULL) linphone_free_xml_text_content(person_id_str);
-			if (person_timestamp_str != NULL) linphone_free_xml_text_content(person_timestamp_str);
 		}
+		if (err == 0) presence_model_add_person(model, person);
+		linphone_presence_person_unref(person);
 	}
-	if (person_object != NULL) xmlXPathFreeObject(person_object);
-
-	if (err < 0) {
-		/* Remove all the persons added since there was an error. */
-		bctbx_list_for_each(model->persons, presence_person_unref);
-	}
+	if (person_id_str != NULL) linphone_free_xml_text_content(person_id_str);
+	if (person_timestamp_str != NULL) linphone_free_xml_text_content(person_timestamp_str);
 	return err;
 }
 
-static int process_pidf_xml_presence_notes(xmlparsing_context_t *xml_ctx, LinphonePresenceModel *model) {
-	char xpath_str[MAX_XPATH_LENGTH];
-	xmlXPathObjectPtr note_object;
-	LinphonePresenceNote *note;
-	char *note_str;
-	char *lang;
-	int i;
-
-	note_object = linphone_get_xml_xpath_object_for_node_list(xml_ctx, "/pidf:presence/pidf:note");
-	if ((note_object != NULL) && (note_object->nodesetval != NULL)) {
-		for (i = 1; i <= note_object->nodesetval->nodeNr; i++) {
-			snprintf(xpath_str, sizeof(xpath_str), "/pidf:presence/pidf:note[%i]", i);
-			note_str = linphone_get_xml_text_content(xml_ctx, xpath_str);
-			if (note_str == NULL) continue;
-			snprintf(xpath_str, sizeof(xpath_str), "/pidf:presence/pidf:note[%i]/@xml:lang", i);
-			lang = linphone_get_xml_text_content(xml_ctx, xpath_str);
-
-			note = linphone_presence_note_new(note_str, lang);
-			presence_model_add_note(model, note);
-			if (lang != NULL) linphone_free_xml_text_content(lang);
-			linphone_free_xml_text_content(note_str);
-		}
-	}
-	if (note_object != NULL) xmlXPathFreeObject(note_object);
-
-	return 0;
-}
-
 static LinphonePresenceModel * process_pidf_xml_presence_notification(xmlparsing_context_t *xml_ctx) {
-	LinphonePresenceModel *model = NULL;
-	int err;
-
-	if (linphone_create_xml_xpath_context(xml_ctx) < 0)
-		return NULL;
+	LinphonePresenceModel *model = linphone_presence_model_new();
+	const xmlNode *root = xmlDocGetRootElement(xml_ctx->doc);
+	const xmlNode *child;
+	int err = 0;
 
-	model = linphone_presence_model_new();
-	xmlXPathRegisterNs(xml_ctx->xpath_ctx, (const xmlChar *)"pidf", (const xmlChar *)"urn:ietf:params:xml:ns:pidf");
-	xmlXPathRegisterNs(xml_ctx->xpath_ctx, (const xmlChar *)"dm", (const xmlChar *)"urn:ietf:params:xml:ns:pidf:data-model");
-	xmlXPathRegisterNs(xml_ctx->xpath_ctx, (const xmlChar *)"rpid", (const xmlChar *)"urn:ietf:params:xml:ns:pidf:rpid");
-	xmlXPathRegisterNs(xml_ctx->xpath_ctx, (const xmlChar *)"pidfonline", (const xmlChar *)"http://www.linphone.org/xsds/pidfonline.xsd");
-	xmlXPathRegisterNs(xml_ctx->xpath_ctx, (const xmlChar *)"oma-pres", (const xmlChar *)"urn:oma:xml:prs:pidf:oma-pres");
-	err = process_pidf_xml_presence_services(xml_ctx, model);
-	if (err == 0) {
-		err = process_pidf_xml_presence_persons(xml_ctx, model);
-	}
-	if (err == 0) {
-		err = process_pidf_xml_presence_notes(xml_ctx, model);
+	if ((root == NULL) || !is_pidf_element_named(root, PIDF_NS, "presence"))
+		return model;
+
+	for (child = root->children; (child != NULL) && (err == 0); child = child->next) {
+		if (is_pidf_element_named(child, PIDF_NS, "tuple")) {
+			err = process_pidf_xml_presence_service(child, model);
+		} else if (is_pidf_element_named(child, PIDF_DM_NS, "person")) {
+			err = process_pidf_xml_presence_person(child, model);
+		} else if (is_pidf_element_named(child, PIDF_NS, "note")) {
+			LinphonePresenceNote *note = process_pidf_xml_presence_note(child);
+			if (note) presence_model_add_note(model, note);
+		}
 	}
 
 	if (err < 0) {
@@ -2194,6 +2102,7 @@ void linphone_notify_recv(LinphoneCore *lc, SalOp *op, SalSubscribeStatus ss, Sa
 				op->release();
 			}
 			if (lf->outsub){
+				linphone_friend_remove_op_from_list_map(lf, lf->outsub);
 				lf->outsub->release();
 				lf->outsub=NULL;
 			}
@@ -168,6 +168,7 @@ void linphone_friend_close_subscriptions(LinphoneFriend *lf);
 void _linphone_friend_release(LinphoneFriend *lf);
 LINPHONE_PUBLIC void linphone_friend_update_subscribes(LinphoneFriend *fr, bool_t only_when_registered);
 void linphone_friend_notify(LinphoneFriend *lf, LinphonePresenceModel *presence);
+void linphone_friend_notify_with_bodies(LinphoneFriend *lf, LinphonePresenceModel *presence, LinphonePrivate::SalPresenceOp::PresenceBodies *bodies);
 void linphone_friend_apply(LinphoneFriend *fr, LinphoneCore *lc);
 void linphone_friend_add_incoming_subscription(LinphoneFriend *lf, LinphonePrivate::SalOp *op);
 void linphone_friend_remove_incoming_subscription(LinphoneFriend *lf, LinphonePrivate::SalOp *op);
@@ -194,6 +195,8 @@ LINPHONE_PUBLIC LinphoneFriendListStatus linphone_friend_list_import_friend(Linp
 LinphoneFriendListCbs * linphone_friend_list_cbs_new(void);
 void linphone_friend_list_set_current_callbacks(LinphoneFriendList *friend_list, LinphoneFriendListCbs *cbs);
 void linphone_friend_add_addresses_and_numbers_into_maps(LinphoneFriend *lf, LinphoneFriendList *list);
+void linphone_friend_remove_op_from_list_map(LinphoneFriend *lf, const LinphonePrivate::SalOp *op);
+void linphone_friend_remove_ops_from_list_map(LinphoneFriend *lf);
 
 int linphone_parse_host_port(const char *input, char *host, size_t hostlen, int *port);
 int parse_hostname_to_addr(const char *server, struct sockaddr_storage *ss, socklen_t *socklen, int default_port);
@@ -393,6 +396,7 @@ void call_logs_write_to_config_file(LinphoneCore *lc);
 void linphone_core_call_log_storage_init(LinphoneCore *lc);
 void linphone_core_call_log_storage_close(LinphoneCore *lc);
 void linphone_core_store_call_log(LinphoneCore *lc, LinphoneCallLog *log);
+void linphone_core_flush_call_logs(LinphoneCore *lc);
 LINPHONE_PUBLIC const MSList *linphone_core_get_call_history(LinphoneCore *lc);
 LINPHONE_PUBLIC void linphone_core_delete_call_history(LinphoneCore *lc);
 LINPHONE_PUBLIC void linphone_core_delete_call_log(LinphoneCore *lc, LinphoneCallLog *log);
@@ -440,6 +444,7 @@ bool_t linphone_event_is_internal(LinphoneEvent *lev);
 void linphone_event_set_state(LinphoneEvent *lev, LinphoneSubscriptionState state);
 void linphone_event_set_publish_state(LinphoneEvent *lev, LinphonePublishState state);
 void _linphone_event_notify_notify_response(LinphoneEvent *lev);
+LinphoneStatus _linphone_event_notify_body_handler(LinphoneEvent *lev, const SalBodyHandler *body_handler);
 LinphoneSubscriptionState linphone_subscription_state_from_sal(SalSubscribeStatus ss);
 LinphoneContent *linphone_content_from_sal_body_handler(const SalBodyHandler *ref, bool parseMultipart = true);
 void linphone_core_invalidate_friend_subscriptions(LinphoneCore *lc);
@@ -604,6 +609,8 @@ LinphoneVideoDefinition * linphone_factory_find_supported_video_definition_by_na
 const char* _linphone_config_load_from_xml_string(LpConfig *lpc, const char *buffer);
 LinphoneNatPolicy * linphone_config_create_nat_policy_from_section(const LinphoneConfig *config, const char* section);
 void _linphone_config_apply_factory_config (LpConfig *config);
+/* Snapshots the config on the calling thread and writes it to disk from a background thread. */
+void _linphone_config_sync_in_background(LpConfig *lpconfig);
 
 SalCustomHeader *linphone_info_message_get_headers (const LinphoneInfoMessage *im);
 void linphone_info_message_set_headers (LinphoneInfoMessage *im, const SalCustomHeader *headers);
@@ -175,6 +175,12 @@ struct _LinphoneFriend{
 	bool_t initial_subscribes_sent; /*used to know if initial subscribe message was sent or not*/
 	bool_t presence_received;
 	LinphoneVcard *vcard;
+	char *vcard_buffer; /* vCard read from the database, parsed into vcard on first use */
+	char *vcard_etag;
+	char *vcard_url;
+	char *cached_name; /* following cached fields are only valid while vcard_buffer is set */
+	bctbx_list_t *cached_addresses; /* list of LinphoneAddress */
+	bctbx_list_t *cached_phone_numbers; /* list of char * */
 	unsigned int storage_id;
 	LinphoneFriendList *friend_list;
 	LinphoneSubscriptionState out_sub_state;
@@ -207,6 +213,7 @@ struct _LinphoneFriendList {
 	MSList *friends;
 	bctbx_map_t *friends_map;
 	bctbx_map_t *friends_map_uri;
+	bctbx_map_t *friends_map_call_id; /* Call-ID of friends' subscription ops */
 	unsigned char *content_digest;
 	int expected_notification_version;
 	unsigned int storage_id;
@@ -216,6 +223,9 @@ struct _LinphoneFriendList {
 	LinphoneFriendListCbs *cbs; // Deprecated, use a list of Cbs instead
 	bctbx_list_t *callbacks;
 	LinphoneFriendListCbs *currentCbs;
+	belle_sip_source_t *presence_notify_timer; /* End of the coalescing window of outgoing presence NOTIFYs */
+	LinphonePresenceModel *presence_notify_model; /* Latest model to notify once the window ends */
+	uint64_t presence_notify_last_time;
 	bool_t enable_subscriptions;
 	bool_t bodyless_subscription;
 };
@@ -845,6 +855,19 @@ namespace LinphonePrivate {
 	sqlite3 *zrtp_cache_db; \
 	bctbx_mutex_t zrtp_cache_db_mutex; \
 	sqlite3 *logs_db; \
+	sqlite3_stmt *logs_db_insert_stmt; \
+	sqlite3_stmt *logs_db_delete_stmt; \
+	sqlite3_stmt *logs_db_delete_all_stmt; \
+	sqlite3_stmt *logs_db_count_stmt; \
+	sqlite3_stmt *logs_db_history_stmt; \
+	sqlite3_stmt *logs_db_peer_stmt; \
+	sqlite3_stmt *logs_db_peer_and_local_stmt; \
+	sqlite3_stmt *logs_db_last_outgoing_stmt; \
+	sqlite3_stmt *logs_db_call_id_stmt; \
+	bctbx_list_t *logs_db_pending_logs; \
+	belle_sip_source_t *logs_db_flush_timer; \
+	int logs_db_batch_size; \
+	int logs_db_batch_delay; \
 	sqlite3 *friends_db; \
 	bool_t debug_storage; \
 	void *system_context; \
@@ -25,6 +25,8 @@
 #include "core/core-p.h"
 #include "c-wrapper/c-wrapper.h"
 #include "conference/session/media-session-p.h"
+#include "content/content.h"
+#include "content/content-type.h"
 #include "event-log/conference/conference-chat-message-event.h"
 
 using namespace std;
@@ -51,6 +53,42 @@ void linphone_core_set_zrtp_cache_db(LinphoneCore *lc, sqlite3 *cache_db) {
 	lc->zrtp_cache_db = cache_db;
 }
 
+static xmlFreeFunc xml_free_func;
+static xmlMallocFunc xml_malloc_func;
+static xmlReallocFunc xml_realloc_func;
+static xmlStrdupFunc xml_strdup_func;
+static unsigned int xml_allocations_count;
+
+static void *counting_xml_malloc(size_t size) {
+	xml_allocations_count++;
+	return xml_malloc_func(size);
+}
+
+static void *counting_xml_realloc(void *ptr, size_t size) {
+	xml_allocations_count++;
+	return xml_realloc_func(ptr, size);
+}
+
+static char *counting_xml_strdup(const char *str) {
+	xml_allocations_count++;
+	return xml_strdup_func(str);
+}
+
+LinphonePresenceModel *linphone_presence_model_parse_pidf(const char *body, unsigned int *xml_allocations) {
+	SalPresenceModel *model = NULL;
+	if (xml_allocations) {
+		xmlMemGet(&xml_free_func, &xml_malloc_func, &xml_realloc_func, &xml_strdup_func);
+		xmlMemSetup(xml_free_func, counting_xml_malloc, counting_xml_realloc, counting_xml_strdup);
+		xml_allocations_count = 0;
+	}
+	linphone_notify_parse_presence("application", "pidf+xml", body, &model);
+	if (xml_allocations) {
+		xmlMemSetup(xml_free_func, xml_malloc_func, xml_realloc_func, xml_strdup_func);
+		*xml_allocations = xml_allocations_count;
+	}
+	return (LinphonePresenceModel *)model;
+}
+
 LinphoneCoreCbs *linphone_core_get_first_callbacks(const LinphoneCore *lc) {
 	return ((VTableReference *)lc->vtable_refs->data)->cbs;
 }
@@ -107,6 +145,33 @@ int linphone_friend_list_get_revision(const LinphoneFriendList *lfl) {
 	return lfl->revision;
 }
 
+const char *linphone_friend_get_out_subscribe_call_id(const LinphoneFriend *lf) {
+	return lf->outsub ? lf->outsub->getCallId().c_str() : NULL;
+}
+
+LinphoneFriend *linphone_friend_list_find_friend_by_out_subscribe_of(const LinphoneFriendList *lfl, const LinphoneFriend *lf) {
+	return lf->outsub ? linphone_friend_list_find_friend_by_out_subscribe(lfl, lf->outsub) : NULL;
+}
+
+LinphoneFriend *linphone_core_find_friend_by_out_subscribe_of(const LinphoneCore *lc, const LinphoneFriend *lf) {
+	return lf->outsub ? linphone_core_find_friend_by_out_subscribe(lc, lf->outsub) : NULL;
+}
+
+LinphoneFriend *linphone_core_find_friend_by_inc_subscribe_of(const LinphoneCore *lc, const LinphoneFriend *lf) {
+	return lf->insubs ? linphone_core_find_friend_by_inc_subscribe(lc, (SalOp *)bctbx_list_get_data(lf->insubs)) : NULL;
+}
+
+LinphoneFriend *linphone_friend_list_find_friend_by_call_id(const LinphoneFriendList *lfl, const char *call_id) {
+	LinphoneFriend *lf = NULL;
+	bctbx_iterator_t *it = bctbx_map_cchar_find_key(lfl->friends_map_call_id, call_id);
+	bctbx_iterator_t *end = bctbx_map_cchar_end(lfl->friends_map_call_id);
+	if (!bctbx_iterator_cchar_equals(it, end))
+		lf = (LinphoneFriend *)bctbx_pair_cchar_get_second(bctbx_iterator_cchar_get_pair(it));
+	bctbx_iterator_cchar_delete(it);
+	bctbx_iterator_cchar_delete(end);
+	return lf;
+}
+
 unsigned int _linphone_call_get_nb_audio_starts (const LinphoneCall *call) {
 	return L_GET_PRIVATE_FROM_C_OBJECT(call)->getAudioStartCount();
 }
@@ -211,3 +276,18 @@ const char *linphone_core_get_tone_file(LinphoneCore *lc, LinphoneToneID id){
 	LinphoneToneDescription *tone = L_GET_PRIVATE_FROM_C_OBJECT(lc)->getToneManager()->getToneFromId(id);
 	return tone ? tone->audiofile : NULL;
 }
+
+int linphone_core_fan_out_message(LinphoneCore *lc, const LinphoneAddress *from, const bctbx_list_t *recipients, const char *content_type, const char *body) {
+	list<IdentityAddress> recipientAddresses;
+	for (const bctbx_list_t *it = recipients; it; it = bctbx_list_next(it))
+		recipientAddresses.push_back(IdentityAddress(*L_GET_CPP_PTR_FROM_C_OBJECT(static_cast<const LinphoneAddress *>(bctbx_list_get_data(it)))));
+	Content content;
+	content.setContentType(ContentType(content_type));
+	content.setBody(body);
+	SalCustomHeader *headers = sal_custom_header_append(nullptr, "Session-mode", "true");
+	size_t sent = L_GET_PRIVATE_FROM_C_OBJECT(lc)->fanOutMessage(
+		IdentityAddress(*L_GET_CPP_PTR_FROM_C_OBJECT(from)), recipientAddresses, content, headers
+	);
+	sal_custom_header_free(headers);
+	return (int)sent;
+}
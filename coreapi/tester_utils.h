@@ -76,6 +76,10 @@ LINPHONE_PUBLIC void linphone_core_set_zrtp_cache_db(LinphoneCore *lc, sqlite3 *
 LINPHONE_PUBLIC LinphoneCoreCbs *linphone_core_get_first_callbacks(const LinphoneCore *lc);
 LINPHONE_PUBLIC void _linphone_core_add_callbacks(LinphoneCore *lc, LinphoneCoreCbs *vtable, bool_t internal);
 
+/* Keeps the background writer from picking up snapshots, until unpaused or the config is flushed or synced. */
+LINPHONE_PUBLIC void _linphone_config_pause_background_writer(LpConfig *lpconfig, bool_t paused);
+LINPHONE_PUBLIC int _linphone_config_get_background_write_count(LpConfig *lpconfig);
+
 LINPHONE_PUBLIC bctbx_list_t * linphone_core_read_call_logs_from_config_file(LinphoneCore *lc);
 LINPHONE_PUBLIC bctbx_list_t **linphone_core_get_call_logs_attribute(LinphoneCore *lc);
 LINPHONE_PUBLIC void linphone_core_delete_call_log(LinphoneCore *lc, LinphoneCallLog *log);
@@ -133,15 +137,41 @@ LINPHONE_PUBLIC LinphoneFriendList *linphone_friend_get_friend_list(const Linpho
 LINPHONE_PUBLIC bctbx_list_t **linphone_friend_list_get_friends_attribute(LinphoneFriendList *lfl);
 LINPHONE_PUBLIC const bctbx_list_t *linphone_friend_list_get_dirty_friends_to_update(const LinphoneFriendList *lfl);
 LINPHONE_PUBLIC int linphone_friend_list_get_revision(const LinphoneFriendList *lfl);
+LINPHONE_PUBLIC const char *linphone_friend_get_out_subscribe_call_id(const LinphoneFriend *lf);
+LINPHONE_PUBLIC LinphoneFriend *linphone_friend_list_find_friend_by_out_subscribe_of(const LinphoneFriendList *lfl, const LinphoneFriend *lf);
+LINPHONE_PUBLIC LinphoneFriend *linphone_friend_list_find_friend_by_call_id(const LinphoneFriendList *lfl, const char *call_id);
+LINPHONE_PUBLIC LinphoneFriend *linphone_core_find_friend_by_out_subscribe_of(const LinphoneCore *lc, const LinphoneFriend *lf);
+LINPHONE_PUBLIC LinphoneFriend *linphone_core_find_friend_by_inc_subscribe_of(const LinphoneCore *lc, const LinphoneFriend *lf);
 
 LINPHONE_PUBLIC int linphone_remote_provisioning_load_file( LinphoneCore* lc, const char* file_path);
 
+/**
+ * Parses a pidf+xml document as received in a NOTIFY.
+ * @param[in] body The pidf+xml document
+ * @param[out] xml_allocations If not NULL, filled with the number of allocations done by libxml2 while parsing
+ * @return The parsed presence model or NULL if the document is invalid
+ * @donotwrap Exists for tests purposes only
+**/
+LINPHONE_PUBLIC LinphonePresenceModel *linphone_presence_model_parse_pidf(const char *body, unsigned int *xml_allocations);
+
 LINPHONE_PUBLIC char *linphone_core_get_device_identity(LinphoneCore *lc);
 
 LINPHONE_PUBLIC LinphoneCoreToneManagerStats *linphone_core_get_tone_manager_stats(LinphoneCore *lc);
 LINPHONE_PUBLIC void linphone_core_reset_tone_manager_stats(LinphoneCore *lc);
 LINPHONE_PUBLIC const char *linphone_core_get_tone_file(LinphoneCore *lc, LinphoneToneID id);
 
+/**
+ * Sends the same MESSAGE to several recipients the way a server group chat room does.
+ * @param[in] lc LinphoneCore object
+ * @param[in] from The address the messages are sent from
+ * @param[in] recipients List of LinphoneAddress the message is sent to
+ * @param[in] content_type The content type of the message
+ * @param[in] body The body of the message
+ * @return The number of MESSAGE requests sent
+ * @donotwrap Exists for tests purposes only
+**/
+LINPHONE_PUBLIC int linphone_core_fan_out_message(LinphoneCore *lc, const LinphoneAddress *from, const bctbx_list_t *recipients, const char *content_type, const char *body);
+
 /**
  * Send an XML-RPC request to delete a Linphone account.
  * @param[in] creator LinphoneAccountCreator object
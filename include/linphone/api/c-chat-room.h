@@ -235,6 +235,17 @@ LINPHONE_PUBLIC bctbx_list_t *linphone_chat_room_get_history_events (LinphoneCha
  */
 LINPHONE_PUBLIC bctbx_list_t *linphone_chat_room_get_history_range_events (LinphoneChatRoom *cr, int begin, int end);
 
+/**
+ * Gets up to nb_events events older than the given cursor, sorted from oldest to most recent.
+ * Unlike #linphone_chat_room_get_history_range_events, the cost of a page does not depend on its depth in the history.
+ * @param[in] cr The #LinphoneChatRoom object corresponding to the conversation for which events should be retrieved
+ * @param[in] before_event_id Cursor returned by a previous call, or 0 to start from the most recent event.
+ * @param[in] nb_events Number of events to retrieve.
+ * @param[out] next_event_id Cursor to use to retrieve the next (older) page, set to 0 when the beginning of the history is reached.
+ * @return \bctbx_list{LinphoneEventLog} \onTheFlyList
+ */
+LINPHONE_PUBLIC bctbx_list_t *linphone_chat_room_get_history_events_before (LinphoneChatRoom *cr, int64_t before_event_id, int nb_events, int64_t *next_event_id);
+
 /**
  * Gets the number of events in a chat room.
  * @param[in] cr The #LinphoneChatRoom object corresponding to the conversation for which size has to be computed
@@ -257,6 +268,18 @@ LINPHONE_PUBLIC LinphoneChatMessage *linphone_chat_room_get_last_message_in_hist
  */
 LINPHONE_PUBLIC LinphoneChatMessage * linphone_chat_room_find_message(LinphoneChatRoom *cr, const char *message_id);
 
+/**
+ * Searches the text messages of this chat room, sorted by relevance.
+ * Requires the full_text_search_enabled option of the storage section to be set.
+ * @param[in] cr The #LinphoneChatRoom object corresponding to the conversation in which messages should be searched
+ * @param[in] text The words to search
+ * @param[in] count Maximum number of messages to retrieve
+ * @param[in] cursor Cursor returned by a previous call, or 0 to get the first page
+ * @param[out] next_cursor Cursor to use to retrieve the next page, set to 0 when there are no more results
+ * @return \bctbx_list{LinphoneChatMessage} \onTheFlyList
+ */
+LINPHONE_PUBLIC bctbx_list_t *linphone_chat_room_search_messages (LinphoneChatRoom *cr, const char *text, int count, int cursor, int *next_cursor);
+
 /**
  * Notifies the destination of the chat message being composed that the user is typing a new message.
  * @param[in] cr The #LinphoneChatRoom object corresponding to the conversation for which a new message is being typed.
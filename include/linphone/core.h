@@ -155,6 +155,18 @@ LINPHONE_PUBLIC int linphone_core_get_unread_chat_message_count_from_local (
  */
 LINPHONE_PUBLIC int linphone_core_get_unread_chat_message_count_from_active_locals (const LinphoneCore *lc);
 
+/**
+ * Searches the text messages of all chat rooms, sorted by relevance.
+ * Requires the full_text_search_enabled option of the storage section to be set.
+ * @param[in] lc #LinphoneCore object.
+ * @param[in] text The words to search.
+ * @param[in] count Maximum number of messages to retrieve.
+ * @param[in] cursor Cursor returned by a previous call, or 0 to get the first page.
+ * @param[out] next_cursor Cursor to use to retrieve the next page, set to 0 when there are no more results.
+ * @return \bctbx_list{LinphoneChatMessage} \onTheFlyList
+ */
+LINPHONE_PUBLIC bctbx_list_t *linphone_core_search_chat_messages (LinphoneCore *lc, const char *text, int count, int cursor, int *next_cursor);
+
 /**
  * @}
  */
@@ -3451,6 +3463,24 @@ LINPHONE_PUBLIC bctbx_list_t *linphone_core_get_call_history_2(
 	const LinphoneAddress *local_addr
 );
 
+/**
+ * Get a page of the call logs (past calls) exchanged with the given address, most recent first.
+ * At the contrary of linphone_core_get_call_logs, it is your responsibility to unref the logs and free this list once you are done using it.
+ * @param[in] lc #LinphoneCore object.
+ * @param[in] peer_addr A #LinphoneAddress object.
+ * @param[in] local_addr A #LinphoneAddress object, or NULL to get the call logs of all local addresses.
+ * @param[in] offset Number of most recent call logs to skip.
+ * @param[in] limit Maximum number of call logs to return.
+ * @return \bctbx_list{LinphoneCallLog} \onTheFlyList
+**/
+LINPHONE_PUBLIC bctbx_list_t *linphone_core_get_call_history_range(
+	LinphoneCore *lc,
+	const LinphoneAddress *peer_addr,
+	const LinphoneAddress *local_addr,
+	int offset,
+	int limit
+);
+
 /**
  * Get the latest outgoing call log.
  * @param[in] lc #LinphoneCore object
@@ -481,6 +481,22 @@ LINPHONE_PUBLIC LinphoneConfig *linphone_factory_create_config_with_factory(Linp
  */
 LINPHONE_PUBLIC LinphoneConfig *linphone_factory_create_config_from_string(LinphoneFactory *factory, const char *data);
 
+/**
+ * Enables or disables the binary snapshot of the config files for the cores created afterwards from config paths.
+ * The snapshot is stored next to the user config file, with a ".cache" suffix. It is disabled by default.
+ * @param[in] factory the #LinphoneFactory
+ * @param[in] enable TRUE to load the config of the cores from a binary snapshot when it is up to date
+ * @see linphone_config_new_with_cache
+ */
+LINPHONE_PUBLIC void linphone_factory_enable_config_cache(LinphoneFactory *factory, bool_t enable);
+
+/**
+ * Tells whether the cores created from config paths use a binary snapshot of their config files.
+ * @param[in] factory the #LinphoneFactory
+ * @return TRUE if the config cache is enabled
+ */
+LINPHONE_PUBLIC bool_t linphone_factory_config_cache_enabled(const LinphoneFactory *factory);
+
 /**
  * Gets the user data in the #LinphoneFactory object
  * @param[in] factory the #LinphoneFactory
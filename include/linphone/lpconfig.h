@@ -85,6 +85,21 @@ LINPHONE_PUBLIC LinphoneConfig * linphone_config_new_from_buffer(const char *buf
  */
 LINPHONE_PUBLIC LinphoneConfig * linphone_config_new_with_factory(const char *config_filename, const char *factory_config_filename);
 
+/**
+ * Instantiates a #LinphoneConfig object from a user config file and a factory config file, like linphone_config_new_with_factory(),
+ * using a binary snapshot of the resulting configuration to avoid parsing the files at each startup.
+ * The caller of this constructor owns a reference. linphone_config_unref() must be called when this object is no longer needed.
+ * @ingroup misc
+ * @param config_filename the filename of the user config file to read to fill the instantiated #LinphoneConfig
+ * @param factory_config_filename the filename of the factory config file to read to fill the instantiated #LinphoneConfig
+ * @param cache_filename the filename of the binary snapshot
+ * @see linphone_config_new_with_factory
+ *
+ * The snapshot is used as long as the size and modification time of both config files match the ones it was made from,
+ * otherwise the files are parsed and the snapshot is rebuilt. It is refreshed each time the config is written.
+ */
+LINPHONE_PUBLIC LinphoneConfig * linphone_config_new_with_cache(const char *config_filename, const char *factory_config_filename, const char *cache_filename);
+
 /**
  * Reads a user config file and fill the #LinphoneConfig with the read config values.
  * @ingroup misc
@@ -213,6 +228,13 @@ LINPHONE_PUBLIC void linphone_config_set_float(LinphoneConfig *lpconfig,const ch
 **/
 LINPHONE_PUBLIC LinphoneStatus linphone_config_sync(LinphoneConfig *lpconfig);
 
+/**
+ * Waits for the pending writes of the config file to complete, writing the uncommited modifications if any.
+ * To be called before the config is released, typically at shutdown.
+ * @return 0 if the config file is up to date, -1 if the last write failed.
+**/
+LINPHONE_PUBLIC LinphoneStatus linphone_config_flush(LinphoneConfig *lpconfig);
+
 /**
  * Returns 1 if a given section is present in the configuration.
 **/
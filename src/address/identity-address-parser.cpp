@@ -17,14 +17,17 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <set>
-#include <unordered_map>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <mutex>
 
 #include <belr/abnf.h>
 #include <belr/grammarbuilder.h>
 
 #include "linphone/utils/utils.h"
 
+#include "containers/lru-cache.h"
 #include "logger/logger.h"
 #include "object/object-p.h"
 
@@ -38,14 +41,112 @@ LINPHONE_BEGIN_NAMESPACE
 
 namespace {
 	string IdentityGrammar("identity_grammar");
+	string GruuParameter(";gr=");
+
+	inline bool isUserChar (char c) {
+		return isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' || c == '.' || c == '+';
+	}
+
+	inline bool isGruuChar (char c) {
+		return isalnum(static_cast<unsigned char>(c)) || c == '-' || c == ':';
+	}
+
+	// Dot separated labels of letters, digits and inner hyphens, the last one starting with a letter.
+	bool isHostname (const string &input, size_t begin, size_t end) {
+		size_t labelBegin = begin;
+		while (labelBegin < end) {
+			size_t labelEnd = input.find('.', labelBegin);
+			if (labelEnd == string::npos || labelEnd > end)
+				labelEnd = end;
+			if (labelEnd == labelBegin || input[labelBegin] == '-' || input[labelEnd - 1] == '-')
+				return false;
+			for (size_t i = labelBegin; i < labelEnd; i++) {
+				if (!isalnum(static_cast<unsigned char>(input[i])) && input[i] != '-')
+					return false;
+			}
+			if (labelEnd == end)
+				return isalpha(static_cast<unsigned char>(input[labelBegin])) != 0;
+			labelBegin = labelEnd + 1;
+		}
+		return false;
+	}
+
+	// Parse the common "sip:user@domain" and "sip:user@domain;gr=value" forms without belr. Anything else,
+	// including escaped characters, IP addresses and other URI parameters, is left to the grammar.
+	shared_ptr<IdentityAddress> parseSimpleAddress (const string &input) {
+		size_t userBegin;
+		string scheme;
+		if (input.compare(0, 4, "sip:") == 0) {
+			scheme = "sip";
+			userBegin = 4;
+		} else if (input.compare(0, 5, "sips:") == 0) {
+			scheme = "sips";
+			userBegin = 5;
+		} else
+			return nullptr;
+
+		size_t userEnd = input.find('@', userBegin);
+		if (userEnd == string::npos || userEnd == userBegin)
+			return nullptr;
+		for (size_t i = userBegin; i < userEnd; i++) {
+			if (!isUserChar(input[i]))
+				return nullptr;
+		}
+
+		size_t hostBegin = userEnd + 1;
+		size_t hostEnd = input.find(';', hostBegin);
+		if (hostEnd == string::npos)
+			hostEnd = input.size();
+		if (!isHostname(input, hostBegin, hostEnd))
+			return nullptr;
+
+		string gruu;
+		if (hostEnd != input.size()) {
+			if (input.compare(hostEnd, GruuParameter.size(), GruuParameter) != 0)
+				return nullptr;
+			size_t gruuBegin = hostEnd + GruuParameter.size();
+			if (gruuBegin == input.size())
+				return nullptr;
+			for (size_t i = gruuBegin; i < input.size(); i++) {
+				if (!isGruuChar(input[i]))
+					return nullptr;
+			}
+			gruu = input.substr(gruuBegin);
+		}
+
+		shared_ptr<IdentityAddress> identityAddress = make_shared<IdentityAddress>();
+		identityAddress->setScheme(scheme);
+		identityAddress->setUsername(input.substr(userBegin, userEnd - userBegin));
+		identityAddress->setDomain(input.substr(hostBegin, hostEnd - hostBegin));
+		if (!gruu.empty())
+			identityAddress->setGruu(gruu);
+		return identityAddress;
+	}
 }
 
 // -----------------------------------------------------------------------------
 
+// The parser is shared by all the cores of the process, which may run in different threads. Each cache shard
+// has its own mutex guarding its entries and stats. The grammar parser has its own mutex so that cache hits are
+// not blocked by a slow parse.
 class IdentityAddressParserPrivate : public ObjectPrivate {
 public:
+	struct CacheShard {
+		LruCache<string, shared_ptr<IdentityAddress>> cache;
+		IdentityAddressParser::CacheStats stats;
+		mutable mutex cacheMutex;
+	};
+
+	CacheShard &getCacheShard (const string &input) {
+		return cacheShards[hash<string>()(input) % IdentityAddressParser::CacheShardCount];
+	}
+
 	shared_ptr<belr::Parser<shared_ptr<IdentityAddress> >> parser;
-    unordered_map<string, shared_ptr<IdentityAddress >> cache;
+	mutex parserMutex;
+
+	array<CacheShard, IdentityAddressParser::CacheShardCount> cacheShards;
+	atomic<int> cacheCapacity{ 0 };
+	atomic<bool> fastParsingEnabled{ true };
 };
 
 IdentityAddressParser::IdentityAddressParser () : Singleton(*new IdentityAddressParserPrivate) {
@@ -61,6 +162,8 @@ IdentityAddressParser::IdentityAddressParser () : Singleton(*new IdentityAddress
 		->setCollector("user", belr::make_sfn(&IdentityAddress::setUsername))
 		->setCollector("host", belr::make_sfn(&IdentityAddress::setDomain))
 		->setCollector("gruu-value", belr::make_sfn(&IdentityAddress::setGruu));
+
+	setCacheCapacity(DefaultCacheCapacity);
 }
 
 // -----------------------------------------------------------------------------
@@ -68,19 +171,96 @@ IdentityAddressParser::IdentityAddressParser () : Singleton(*new IdentityAddress
 shared_ptr<IdentityAddress> IdentityAddressParser::parseAddress (const string &input) {
 	L_D();
 
-    auto it = d->cache.find(input);
-    if (it == d->cache.end()) {
-        size_t parsedSize;
-        shared_ptr<IdentityAddress> identityAddress = d->parser->parseInput("Address", input, &parsedSize);
-        if (!identityAddress) {
-            lDebug() << "Unable to parse identity address from " << input;
-            return nullptr;
-        }
-        d->cache[input] = identityAddress;
-        return identityAddress;
-    } else {
-        return it->second;
-    }
+	IdentityAddressParserPrivate::CacheShard &shard = d->getCacheShard(input);
+	{
+		lock_guard<mutex> lock(shard.cacheMutex);
+		shared_ptr<IdentityAddress> *cachedAddress = shard.cache[input];
+		if (cachedAddress) {
+			shard.stats.hits++;
+			return *cachedAddress;
+		}
+		shard.stats.misses++;
+	}
+
+	shared_ptr<IdentityAddress> identityAddress;
+	bool fastParsed = d->fastParsingEnabled && (identityAddress = parseSimpleAddress(input));
+	if (!fastParsed) {
+		size_t parsedSize;
+		lock_guard<mutex> lock(d->parserMutex);
+		identityAddress = d->parser->parseInput("Address", input, &parsedSize);
+		if (!identityAddress) {
+			lDebug() << "Unable to parse identity address from " << input;
+			return nullptr;
+		}
+	}
+
+	lock_guard<mutex> lock(shard.cacheMutex);
+	if (fastParsed)
+		shard.stats.fastParses++;
+	shard.cache.insert(input, identityAddress);
+	return identityAddress;
+}
+
+// -----------------------------------------------------------------------------
+
+int IdentityAddressParser::getCacheCapacity () const {
+	L_D();
+	return d->cacheCapacity;
+}
+
+// Each shard gets an equal part of the capacity, rounded up.
+void IdentityAddressParser::setCacheCapacity (int capacity) {
+	L_D();
+	d->cacheCapacity = capacity;
+	const int shardCapacity = (capacity + CacheShardCount - 1) / CacheShardCount;
+	for (auto &shard : d->cacheShards) {
+		lock_guard<mutex> lock(shard.cacheMutex);
+		shard.cache.setCapacity(shardCapacity);
+	}
+}
+
+void IdentityAddressParser::clearCache () {
+	L_D();
+	for (auto &shard : d->cacheShards) {
+		lock_guard<mutex> lock(shard.cacheMutex);
+		shard.cache.clear();
+	}
+}
+
+bool IdentityAddressParser::isFastParsingEnabled () const {
+	L_D();
+	return d->fastParsingEnabled;
+}
+
+void IdentityAddressParser::enableFastParsing (bool enable) {
+	L_D();
+	d->fastParsingEnabled = enable;
+}
+
+IdentityAddressParser::CacheStats IdentityAddressParser::getCacheStats () const {
+	L_D();
+	CacheStats stats;
+	for (const auto &shard : d->cacheShards) {
+		lock_guard<mutex> lock(shard.cacheMutex);
+		stats.hits += shard.stats.hits;
+		stats.misses += shard.stats.misses;
+		stats.fastParses += shard.stats.fastParses;
+	}
+	return stats;
+}
+
+double IdentityAddressParser::getCacheHitRate () const {
+	CacheStats stats = getCacheStats();
+	unsigned long long lookups = stats.hits + stats.misses;
+	return lookups ? double(stats.hits) / double(lookups) : 0.;
+}
+
+void IdentityAddressParser::resetCacheStats () {
+	L_D();
+	for (auto &shard : d->cacheShards) {
+		lock_guard<mutex> lock(shard.cacheMutex);
+		shard.stats = CacheStats();
+	}
 }
 
-LINPHONE_END_NAMESPACE
\ No newline at end of file
+LINPHONE_END_NAMESPACE
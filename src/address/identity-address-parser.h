@@ -29,12 +29,36 @@ LINPHONE_BEGIN_NAMESPACE
 
 class IdentityAddressParserPrivate;
 
-class IdentityAddressParser : public Singleton<IdentityAddressParser> {
+// Process-wide parser, it may be used from any thread. The cache capacity and the fast parsing setting are
+// shared by all the cores: they are taken from the configuration of the first core that is initialized.
+// The cache is split in CacheShardCount LRU caches selected by a hash of the input, each with its own lock, so
+// that threads parsing different addresses do not contend. Each shard holds an equal part of the capacity.
+class LINPHONE_PUBLIC IdentityAddressParser : public Singleton<IdentityAddressParser> {
 	friend class Singleton<IdentityAddressParser>;
 
 public:
+	struct CacheStats {
+		unsigned long long hits = 0;
+		unsigned long long misses = 0;
+		unsigned long long fastParses = 0; // Misses parsed without the belr grammar.
+	};
+
 	std::shared_ptr<IdentityAddress> parseAddress (const std::string &input);
 
+	int getCacheCapacity () const;
+	void setCacheCapacity (int capacity);
+	void clearCache ();
+
+	bool isFastParsingEnabled () const;
+	void enableFastParsing (bool enable);
+
+	CacheStats getCacheStats () const;
+	double getCacheHitRate () const;
+	void resetCacheStats ();
+
+	static constexpr int DefaultCacheCapacity = 10000;
+	static constexpr int CacheShardCount = 16;
+
 private:
 	IdentityAddressParser ();
 
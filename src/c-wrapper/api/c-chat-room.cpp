@@ -257,6 +257,16 @@ bctbx_list_t *linphone_chat_room_get_history_range_events (LinphoneChatRoom *cr,
 	return L_GET_RESOLVED_C_LIST_FROM_CPP_LIST(L_GET_CPP_PTR_FROM_C_OBJECT(cr)->getHistoryRange(begin, end));
 }
 
+bctbx_list_t *linphone_chat_room_get_history_events_before (LinphoneChatRoom *cr, int64_t before_event_id, int nb_events, int64_t *next_event_id) {
+	long long nextEventId = 0;
+	bctbx_list_t *result = L_GET_RESOLVED_C_LIST_FROM_CPP_LIST(
+		L_GET_CPP_PTR_FROM_C_OBJECT(cr)->getHistoryBefore(before_event_id, nb_events, &nextEventId)
+	);
+	if (next_event_id)
+		*next_event_id = nextEventId;
+	return result;
+}
+
 int linphone_chat_room_get_history_events_size(LinphoneChatRoom *cr) {
 	return L_GET_CPP_PTR_FROM_C_OBJECT(cr)->getHistorySize();
 }
@@ -273,6 +283,13 @@ LinphoneChatMessage *linphone_chat_room_find_message (LinphoneChatRoom *cr, cons
 	return L_GET_C_BACK_PTR(L_GET_CPP_PTR_FROM_C_OBJECT(cr)->findChatMessage(message_id));
 }
 
+bctbx_list_t *linphone_chat_room_search_messages (LinphoneChatRoom *cr, const char *text, int count, int cursor, int *next_cursor) {
+	shared_ptr<LinphonePrivate::AbstractChatRoom> chatRoom = L_GET_CPP_PTR_FROM_C_OBJECT(cr);
+	return L_GET_RESOLVED_C_LIST_FROM_CPP_LIST(L_GET_PRIVATE(chatRoom->getCore())->mainDb->searchChatMessages(
+		L_C_TO_STRING(text), chatRoom->getConferenceId(), count, cursor, next_cursor
+	));
+}
+
 LinphoneChatRoomState linphone_chat_room_get_state (const LinphoneChatRoom *cr) {
 	return (LinphoneChatRoomState)L_GET_CPP_PTR_FROM_C_OBJECT(cr)->getState();
 }
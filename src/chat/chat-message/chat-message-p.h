@@ -204,6 +204,8 @@ private:
 
 public:
 	mutable MainDbChatMessageKey dbKey;
+	// Read state last written to or loaded from the database.
+	bool dbMarkedAsRead = false;
 
 protected:
 	bool displayNotificationRequired = true;
@@ -76,6 +76,7 @@ public:
 	virtual int getMessageHistorySize () const = 0;
 	virtual std::list<std::shared_ptr<EventLog>> getHistory (int nLast) const = 0;
 	virtual std::list<std::shared_ptr<EventLog>> getHistoryRange (int begin, int end) const = 0;
+	virtual std::list<std::shared_ptr<EventLog>> getHistoryBefore (long long beforeEventId, int count, long long *nextEventId) const = 0;
 	virtual int getHistorySize () const = 0;
 
 	virtual void deleteFromDb () = 0;
@@ -464,6 +464,16 @@ list<shared_ptr<EventLog>> ChatRoom::getHistoryRange (int begin, int end) const
 	);
 }
 
+list<shared_ptr<EventLog>> ChatRoom::getHistoryBefore (long long beforeEventId, int count, long long *nextEventId) const {
+	return getCore()->getPrivate()->mainDb->getHistoryBefore(
+		getConferenceId(),
+		beforeEventId,
+		count,
+		MainDb::FilterMask({ MainDb::Filter::ConferenceChatMessageFilter, MainDb::Filter::ConferenceInfoNoDeviceFilter }),
+		nextEventId
+	);
+}
+
 int ChatRoom::getHistorySize () const {
 	return getCore()->getPrivate()->mainDb->getHistorySize(getConferenceId());
 }
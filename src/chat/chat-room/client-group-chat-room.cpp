@@ -475,6 +475,19 @@ list<shared_ptr<EventLog>> ClientGroupChatRoom::getHistoryRange (int begin, int
 	);
 }
 
+list<shared_ptr<EventLog>> ClientGroupChatRoom::getHistoryBefore (long long beforeEventId, int count, long long *nextEventId) const {
+	L_D();
+	return getCore()->getPrivate()->mainDb->getHistoryBefore(
+		getConferenceId(),
+		beforeEventId,
+		count,
+		(d->capabilities & Capabilities::OneToOne) ?
+			MainDb::Filter::ConferenceChatMessageSecurityFilter :
+			MainDb::FilterMask({MainDb::Filter::ConferenceChatMessageFilter, MainDb::Filter::ConferenceInfoNoDeviceFilter}),
+		nextEventId
+	);
+}
+
 bool ClientGroupChatRoom::addParticipant (const IdentityAddress &addr, const CallSessionParams *params, bool hasMedia) {
 	list<IdentityAddress> addressesList({addr});
 
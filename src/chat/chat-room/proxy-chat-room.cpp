@@ -125,6 +125,11 @@ list<shared_ptr<EventLog>> ProxyChatRoom::getHistoryRange (int begin, int end) c
 	return d->chatRoom->getHistoryRange(begin, end);
 }
 
+list<shared_ptr<EventLog>> ProxyChatRoom::getHistoryBefore (long long beforeEventId, int count, long long *nextEventId) const {
+	L_D();
+	return d->chatRoom->getHistoryBefore(beforeEventId, count, nextEventId);
+}
+
 int ProxyChatRoom::getHistorySize () const {
 	L_D();
 	return d->chatRoom->getHistorySize();
@@ -51,6 +51,7 @@ public:
 	int getMessageHistorySize () const override;
 	std::list<std::shared_ptr<EventLog>> getHistory (int nLast) const override;
 	std::list<std::shared_ptr<EventLog>> getHistoryRange (int begin, int end) const override;
+	std::list<std::shared_ptr<EventLog>> getHistoryBefore (long long beforeEventId, int count, long long *nextEventId) const override;
 	int getHistorySize () const override;
 
 	void deleteFromDb () override;
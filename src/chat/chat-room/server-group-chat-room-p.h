@@ -20,8 +20,7 @@
 #ifndef _L_SERVER_GROUP_CHAT_ROOM_P_H_
 #define _L_SERVER_GROUP_CHAT_ROOM_P_H_
 
-#include <chrono>
-#include <queue>
+#include <deque>
 #include <unordered_map>
 #include <map>
 
@@ -29,6 +28,7 @@
 #include "server-group-chat-room.h"
 
 #include "conference/participant-device.h"
+#include "db/main-db.h"
 #include "object/clonable-object.h"
 #include "object/clonable-object-p.h"
 
@@ -81,7 +81,7 @@ public:
 	void confirmJoining (SalCallOp *op);
 	void confirmRecreation (SalCallOp *op);
 	void declineSession (const std::shared_ptr<CallSession> &session, LinphoneReason reason);
-	void dispatchQueuedMessages ();
+	void dispatchQueuedMessages (const std::shared_ptr<ParticipantDevice> &device);
 
 	void subscribeReceived (LinphoneEvent *event);
 	void subscriptionStateChanged (LinphoneEvent *event, LinphoneSubscriptionState state);
@@ -107,40 +107,20 @@ public:
 	void notifyParticipantDeviceRegistration(const IdentityAddress &participantDevice);
 
 private:
-	struct Message {
-		Message (const std::string &from, const ContentType &contentType, const std::string &text, const SalCustomHeader *salCustomHeaders)
-			: fromAddr(from)
-		{
-			content.setContentType(contentType);
-			if (!text.empty())
-				content.setBodyFromUtf8(text);
-			if (salCustomHeaders)
-				customHeaders = sal_custom_header_clone(salCustomHeaders);
-		}
-
-		~Message () {
-			if (customHeaders)
-				sal_custom_header_free(customHeaders);
-		}
-
-		IdentityAddress fromAddr;
-		Content content;
-		std::chrono::system_clock::time_point timestamp = std::chrono::system_clock::now();
-		SalCustomHeader *customHeaders = nullptr;
-	};
+	using Message = MainDb::ServerQueuedChatMessage;
 
-	static void copyMessageHeaders (const std::shared_ptr<Message> &fromMessage, const std::shared_ptr<ChatMessage> &toMessage);
 	static bool allDevicesLeft(const std::shared_ptr<Participant> &participant);
 	void addParticipantDevice (const std::shared_ptr<Participant> &participant, const ParticipantDeviceIdentity &deviceInfo);
 	void designateAdmin ();
-	void sendMessage (const std::shared_ptr<Message> &message, const IdentityAddress &deviceAddr);
+	void sendMessage (const std::shared_ptr<Message> &message, const std::list<IdentityAddress> &deviceAddresses);
 	void finalizeCreation ();
 	std::shared_ptr<CallSession> makeSession(const std::shared_ptr<ParticipantDevice> &device);
 	void inviteDevice (const std::shared_ptr<ParticipantDevice> &device);
 	void byeDevice (const std::shared_ptr<ParticipantDevice> &device);
 	bool isAdminLeft () const;
-	void queueMessage (const std::shared_ptr<Message> &message);
-	void queueMessage (const std::shared_ptr<Message> &msg, const IdentityAddress &deviceAddress);
+	void dispatchMessage (const std::shared_ptr<Message> &message);
+	void queueMessage (const std::shared_ptr<Message> &message, const std::list<IdentityAddress> &deviceAddresses);
+	void deleteQueuedMessages (const IdentityAddress &deviceAddress);
 	void removeParticipantDevice (const std::shared_ptr<Participant> &participant, const IdentityAddress &deviceAddress);
 
 	void onParticipantDeviceLeft (const std::shared_ptr<ParticipantDevice> &device);
@@ -171,7 +151,9 @@ private:
 	int unnotifiedRegistrationSubscriptions = 0; /*count of not-yet notified registration subscriptions*/
 	std::shared_ptr<ParticipantDevice> mInitiatorDevice; /*pointer to the ParticipantDevice that is creating the chat room*/
 	bool joiningPendingAfterCreation = false;
-	std::unordered_map<std::string, std::queue<std::shared_ptr<Message>>> queuedMessages;
+	// Messages which cannot be stored in the database are queued here, indexed by device address.
+	// A message is shared by all the devices it is queued for.
+	std::unordered_map<IdentityAddress, std::deque<std::shared_ptr<Message>>> queuedMessages;
 
 	L_DECLARE_PUBLIC(ServerGroupChatRoom);
 };
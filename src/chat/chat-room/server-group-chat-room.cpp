@@ -170,17 +170,16 @@ void ServerGroupChatRoomPrivate::resumeParticipant(const std::shared_ptr<Partici
 
 void ServerGroupChatRoomPrivate::setParticipantDeviceState (const shared_ptr<ParticipantDevice> &device, ParticipantDevice::State state) {
 	L_Q();
-	string address(device->getAddress().asString());
-	lInfo() << q << ": Set participant device '" << address << "' state to " << state;
+	lInfo() << q << ": Set participant device '" << device->getAddress() << "' state to " << state;
 	device->setState(state);
 	q->getCore()->getPrivate()->mainDb->updateChatRoomParticipantDevice(q->getSharedFromThis(), device);
 	switch (state){
 		case ParticipantDevice::State::ScheduledForLeaving:
 		case ParticipantDevice::State::Leaving:
-			queuedMessages.erase(address);
+			deleteQueuedMessages(device->getAddress());
 		break;
 		case ParticipantDevice::State::Left:
-			queuedMessages.erase(address);
+			deleteQueuedMessages(device->getAddress());
 			onParticipantDeviceLeft(device);
 		break;
 		default:
@@ -303,6 +302,8 @@ void ServerGroupChatRoomPrivate::confirmJoining (SalCallOp *op) {
 			}
 			participant->getPrivate()->setAdmin(true);
 		}
+		// The device may be new and the admin status may have changed, none of them was notified.
+		qConference->getPrivate()->eventHandler->invalidateFullState();
 		session = device->getSession();
 	}
 
@@ -365,37 +366,64 @@ void ServerGroupChatRoomPrivate::declineSession (const shared_ptr<CallSession> &
 	session->decline(reason);
 }
 
-void ServerGroupChatRoomPrivate::dispatchQueuedMessages () {
+void ServerGroupChatRoomPrivate::dispatchMessage (const shared_ptr<Message> &message) {
 	L_Q();
+	/*
+	 * Send the message to each device in Present state and queue it for the others. In a one to one chatroom,
+	 * a device in Left state must be invited first.
+	 */
+	list<IdentityAddress> presentDeviceAddresses;
+	list<IdentityAddress> queuedDeviceAddresses;
+	list<shared_ptr<ParticipantDevice>> devicesToInvite;
 	for (const auto &participant : q->getParticipants()) {
-		/*
-		 * Dispatch messages for each device in Present state. In a one to one chatroom, if a device
-		 * is found is Left state, it must be invited first.
-		 */
-		
 		for (const auto &device : participant->getPrivate()->getDevices()) {
-			
-			string uri(device->getAddress().asString());
-			auto & msgQueue = queuedMessages[uri];
-			
-			if (!msgQueue.empty()){
-				if ( (capabilities & ServerGroupChatRoom::Capabilities::OneToOne) && device->getState() == ParticipantDevice::State::Left){
-					lInfo() << "There is a message to transmit to a participant in left state in a one to one chatroom, so inviting first.";
-					inviteDevice(device);
-					continue;
-				}
-				if (device->getState() != ParticipantDevice::State::Present)
-					continue;
-				size_t nbMessages = msgQueue.size();
-				lInfo() << q << ": Dispatching " << nbMessages << " queued message(s) for '" << uri << "'";
-				while (!msgQueue.empty()) {
-					shared_ptr<Message> msg = msgQueue.front();
-					sendMessage(msg, device->getAddress());
-					msgQueue.pop();
-				}
+			// The device that sent the message does not receive it back.
+			if (device->getAddress() == message->fromAddress)
+				continue;
+			if (device->getState() == ParticipantDevice::State::Present) {
+				presentDeviceAddresses.push_back(device->getAddress());
+				continue;
 			}
+			queuedDeviceAddresses.push_back(device->getAddress());
+			if ((capabilities & ServerGroupChatRoom::Capabilities::OneToOne) && device->getState() == ParticipantDevice::State::Left)
+				devicesToInvite.push_back(device);
 		}
 	}
+
+	sendMessage(message, presentDeviceAddresses);
+	queueMessage(message, queuedDeviceAddresses);
+	for (const auto &device : devicesToInvite) {
+		lInfo() << "There is a message to transmit to a participant in left state in a one to one chatroom, so inviting first.";
+		inviteDevice(device);
+	}
+}
+
+void ServerGroupChatRoomPrivate::dispatchQueuedMessages (const shared_ptr<ParticipantDevice> &device) {
+	L_Q();
+	const IdentityAddress &deviceAddress = device->getAddress();
+
+	list<shared_ptr<Message>> messages;
+	const unique_ptr<MainDb> &mainDb = q->getCore()->getPrivate()->mainDb;
+	if (mainDb->isInitialized()) {
+		for (auto &message : mainDb->takeServerQueuedChatMessages(q->getConferenceId(), deviceAddress))
+			messages.push_back(make_shared<Message>(move(message)));
+	}
+
+	auto it = queuedMessages.find(deviceAddress);
+	if (it != queuedMessages.end()) {
+		messages.insert(messages.end(), it->second.begin(), it->second.end());
+		queuedMessages.erase(it);
+		// Keep the creation order if messages were queued both in the database and in memory.
+		MainDb::sortServerQueuedChatMessages(messages);
+	}
+
+	if (messages.empty())
+		return;
+
+	lInfo() << q << ": Dispatching " << messages.size() << " queued message(s) for '" << deviceAddress << "'";
+	const list<IdentityAddress> deviceAddresses{ deviceAddress };
+	for (const auto &message : messages)
+		sendMessage(message, deviceAddresses);
 }
 
 void ServerGroupChatRoomPrivate::removeParticipant (const shared_ptr<const Participant> &participant) {
@@ -419,8 +447,6 @@ void ServerGroupChatRoomPrivate::removeParticipant (const shared_ptr<const Parti
 		}
 	}
 
-	queuedMessages.erase(participant->getAddress().asString());
-
 	shared_ptr<ConferenceParticipantEvent> event = qConference->getPrivate()->eventHandler->notifyParticipantRemoved(participant->getAddress());
 	q->getCore()->getPrivate()->mainDb->addEvent(event);
 	
@@ -549,15 +575,25 @@ LinphoneReason ServerGroupChatRoomPrivate::onSipMessageReceived (SalOp *op, cons
 	}
 
 	// Do not check that we received a CPIM message because ciphered messages are not
-	shared_ptr<Message> msg = make_shared<Message>(
-		op->getFrom(),
-		ContentType(message->content_type),
-		message->text ? message->text : "",
-		op->getRecvCustomHeaders()
-	);
-
-	queueMessage(msg);
-	dispatchQueuedMessages();
+	shared_ptr<Message> msg = make_shared<Message>();
+	msg->fromAddress = fromAddr;
+	msg->content.setContentType(ContentType(message->content_type));
+	if (message->text && message->text[0] != '\0')
+		msg->content.setBodyFromUtf8(message->text);
+	msg->creationTime = time(nullptr);
+
+	const char *headersToCopy[] = {
+		"Content-Encoding",
+		"Expires",
+		"Priority"
+	};
+	for (const char *headerName : headersToCopy) {
+		const char *headerValue = sal_custom_header_find(op->getRecvCustomHeaders(), headerName);
+		if (headerValue)
+			msg->headers.emplace_back(headerName, headerValue);
+	}
+
+	dispatchMessage(msg);
 	return LinphoneReasonNone;
 }
 
@@ -691,19 +727,6 @@ void ServerGroupChatRoomPrivate::setParticipantDevices(const IdentityAddress &pa
 
 // -----------------------------------------------------------------------------
 
-void ServerGroupChatRoomPrivate::copyMessageHeaders (const shared_ptr<Message> &fromMessage, const shared_ptr<ChatMessage> &toMessage) {
-	string headersToCopy[] = {
-		"Content-Encoding",
-		"Expires",
-		"Priority"
-	};
-	for (const auto &headerName : headersToCopy) {
-		const char *headerValue = sal_custom_header_find(fromMessage->customHeaders, headerName.c_str());
-		if (headerValue)
-			toMessage->getPrivate()->addSalCustomHeader(headerName, headerValue);
-	}
-}
-
 /*
  * This method is in charge of applying the state of a participant device to the SIP session
  */
@@ -750,7 +773,10 @@ void ServerGroupChatRoomPrivate::addParticipantDevice (const shared_ptr<Particip
 	
 	if (device) {
 		// Nothing to do, but set the name because the user-agent is not known for the initiator device.
-		device->setName(deviceInfo.getName());
+		if (device->getName() != deviceInfo.getName()) {
+			device->setName(deviceInfo.getName());
+			qConference->getPrivate()->eventHandler->invalidateFullState();
+		}
 	} else if (findAuthorizedParticipant(participant->getAddress())) {
 		bool allDevLeft = !participant->getPrivate()->getDevices().empty() && allDevicesLeft(participant);
 		/*
@@ -781,17 +807,21 @@ void ServerGroupChatRoomPrivate::designateAdmin () {
 	}
 }
 
-void ServerGroupChatRoomPrivate::sendMessage (const shared_ptr<Message> &message, const IdentityAddress &deviceAddr){
+void ServerGroupChatRoomPrivate::sendMessage (const shared_ptr<Message> &message, const list<IdentityAddress> &deviceAddresses) {
 	L_Q();
-	
-	shared_ptr<ChatMessage> msg = q->createChatMessage();
-	copyMessageHeaders(message, msg);
-	msg->getPrivate()->addSalCustomHeader("Session-mode", "true"); // Special custom header to identify MESSAGE that belong to server group chatroom
-	msg->setInternalContent(message->content);
-	msg->getPrivate()->forceFromAddress(q->getConferenceAddress());
-	msg->getPrivate()->forceToAddress(deviceAddr);
-	msg->getPrivate()->setApplyModifiers(false);
-	msg->send();
+	if (deviceAddresses.empty())
+		return;
+
+	// The headers and the body are built once and shared by the MESSAGE requests sent to every device.
+	SalCustomHeader *headers = nullptr;
+	for (const auto &header : message->headers)
+		headers = sal_custom_header_append(headers, header.first.c_str(), header.second.c_str());
+	headers = sal_custom_header_append(headers, "Session-mode", "true"); // Special custom header to identify MESSAGE that belong to server group chatroom
+
+	size_t sent = q->getCore()->getPrivate()->fanOutMessage(q->getConferenceAddress(), deviceAddresses, message->content, headers);
+	sal_custom_header_free(headers);
+	if (sent != deviceAddresses.size())
+		lWarning() << q << ": Only " << sent << " of " << deviceAddresses.size() << " message(s) could be sent";
 }
 
 void ServerGroupChatRoomPrivate::finalizeCreation () {
@@ -936,31 +966,37 @@ bool ServerGroupChatRoomPrivate::isAdminLeft () const {
 	return false;
 }
 
-void ServerGroupChatRoomPrivate::queueMessage (const shared_ptr<Message> &msg) {
+void ServerGroupChatRoomPrivate::queueMessage (const shared_ptr<Message> &message, const list<IdentityAddress> &deviceAddresses) {
 	L_Q();
-	for (const auto &participant : q->getParticipants()) {
-		for (const auto &device : participant->getPrivate()->getDevices()) {
-			// Queue the message for all devices except the one that sent it
-			if (msg->fromAddr != device->getAddress()){
-				queueMessage(msg, device->getAddress());
-			}
-		}
+	if (deviceAddresses.empty())
+		return;
+
+	const unique_ptr<MainDb> &mainDb = q->getCore()->getPrivate()->mainDb;
+	if (mainDb->isInitialized() && mainDb->addServerQueuedChatMessage(q->getConferenceId(), *message, deviceAddresses))
+		return;
+
+	// The database is not available, keep the message in memory with the same limits.
+	LinphoneConfig *config = linphone_core_get_config(q->getCore()->getCCore());
+	const time_t ttl = linphone_config_get_int(config, "storage", "server_queued_message_ttl_s", 7 * 24 * 3600);
+	const size_t maxPerDevice = size_t(linphone_config_get_int(config, "storage", "server_queued_message_max_per_device", 1000));
+	for (const auto &deviceAddress : deviceAddresses) {
+		auto &deviceQueue = queuedMessages[deviceAddress];
+		// Messages are queued in creation order, the expired ones are at the front.
+		while (!deviceQueue.empty() && (
+			(ttl > 0 && deviceQueue.front()->creationTime + ttl < message->creationTime) ||
+			(maxPerDevice > 0 && deviceQueue.size() >= maxPerDevice)
+		))
+			deviceQueue.pop_front();
+		deviceQueue.push_back(message);
 	}
 }
 
-void ServerGroupChatRoomPrivate::queueMessage (const shared_ptr<Message> &msg, const IdentityAddress &deviceAddress) {
-	chrono::system_clock::time_point timestamp = chrono::system_clock::now();
-	string uri(deviceAddress.asString());
-	// Remove queued messages older than one week
-	while (!queuedMessages[uri].empty()) {
-		shared_ptr<Message> m = queuedMessages[uri].front();
-		chrono::hours age = chrono::duration_cast<chrono::hours>(timestamp - m->timestamp);
-		chrono::hours oneWeek(168);
-		if (age < oneWeek)
-			break;
-		queuedMessages[uri].pop();
-	}
-	queuedMessages[uri].push(msg);
+void ServerGroupChatRoomPrivate::deleteQueuedMessages (const IdentityAddress &deviceAddress) {
+	L_Q();
+	queuedMessages.erase(deviceAddress);
+	const unique_ptr<MainDb> &mainDb = q->getCore()->getPrivate()->mainDb;
+	if (mainDb->isInitialized())
+		mainDb->deleteServerQueuedChatMessages(q->getConferenceId(), deviceAddress);
 }
 
 /* The removal of participant device is done only when such device disapears from registration database, ie when a device unregisters explicitely
@@ -1279,7 +1315,7 @@ void ServerGroupChatRoom::onFirstNotifyReceived (const IdentityAddress &addr) {
 		for (const auto &device : participant->getPrivate()->getDevices()) {
 			if (device->getAddress() == addr) {
 				d->setParticipantDeviceState(device, ParticipantDevice::State::Present);
-				d->dispatchQueuedMessages();
+				d->dispatchQueuedMessages(device);
 				return;
 			}
 		}
@@ -20,8 +20,13 @@
 #ifndef _L_LOCAL_CONFERENCE_EVENT_HANDLER_P_H_
 #define _L_LOCAL_CONFERENCE_EVENT_HANDLER_P_H_
 
+#include <ctime>
+#include <list>
+#include <map>
+#include <mutex>
 #include <string>
 
+#include "c-wrapper/internal/c-sal.h"
 #include "conference/conference-id.h"
 #include "local-conference-event-handler.h"
 #include "object/object-p.h"
@@ -48,18 +53,89 @@ public:
 
 	inline unsigned int getLastNotify () const { return lastNotify; };
 
+	struct NotifyFanOutStats {
+		unsigned int bodiesEncoded = 0; // NOTIFY bodies built and compressed.
+		unsigned int notifiesSent = 0; // NOTIFY requests sent with one of these bodies.
+		size_t compressedBytesSaved = 0; // Body bytes not compressed again because the body was shared.
+	};
+
+	inline const NotifyFanOutStats &getFanOutStats () const { return fanOutStats; };
+
+	struct NotifyCacheStats {
+		unsigned int hits = 0; // Full states or missed notifies taken from the cache.
+		unsigned int misses = 0; // Full states or missed notifies that had to be built again.
+	};
+
+	inline const NotifyCacheStats &getCacheStats () const { return cacheStats; };
+
+	void invalidateFullState ();
+	void clearNotifyCache ();
+
+	// Size in bytes of the bodies cached by all the conferences of the process, and its limit.
+	static constexpr size_t DefaultCacheBudget = 16 * 1024 * 1024;
+	static size_t getCachedBytes ();
+	static void setCacheBudget (size_t bytes);
+
 	static void notifyResponseCb (const LinphoneEvent *ev);
 
+	~LocalConferenceEventHandlerPrivate ();
+
 private:
+	// Cached bodies of all the conferences, oldest first. The process-wide budget is enforced on this list.
+	struct CacheBudgetEntry {
+		LocalConferenceEventHandlerPrivate *handler;
+		unsigned int notifyId;
+		bool fullState;
+		size_t size;
+		time_t expiry;
+	};
+
+	struct CachedBody {
+		std::string body;
+		std::list<CacheBudgetEntry>::iterator budgetIt;
+	};
+
+	// The budget is shared by the cores of the process, which may run in different threads: cacheMutex only exists
+	// to guard it. The other cache members are only touched from the main loop of the core owning the conference.
+	static std::mutex cacheMutex;
+	static std::list<CacheBudgetEntry> cacheBudgetEntries;
+	static size_t cachedBytes;
+	static size_t cacheBudget;
+
 	ConferenceId conferenceId;
 
 	LocalConference *conf = nullptr;
 	unsigned int lastNotify = 1;
+	NotifyFanOutStats fanOutStats;
+	NotifyCacheStats cacheStats;
+
+	// Last full state document. It stays valid as long as no NOTIFY is sent, since every change of the
+	// participants or devices is followed by one.
+	struct {
+		unsigned int notifyId = 0;
+		bool oneToOne = false;
+		CachedBody cached;
+	} fullStateCache;
+
+	// Recent partial NOTIFY bodies by notify id, used to answer SUBSCRIBEs asking for missed notifies.
+	std::map<unsigned int, CachedBody> notifyCache;
+	size_t notifyCacheSize = 0;
+	int notifyCacheMaxAge = 0; // In seconds, 0 means no limit.
 
 	std::string createNotify (Xsd::ConferenceInfo::ConferenceType confInfo, int notifyId = -1, bool isFullState = false);
 	std::string createNotifySubjectChanged (const std::string &subject, int notifyId = -1);
-	void notifyParticipant (const std::string &notify, const std::shared_ptr<Participant> &participant);
+	std::string createNotifyMultipart (const std::list<std::string> &bodies) const;
+	bool getCachedNotifies (unsigned int fromNotifyId, std::list<std::string> &bodies);
+	void cacheNotify (unsigned int notifyId, const std::string &body);
+	// The functions below expect cacheMutex to be locked.
+	bool storeCachedBody (CachedBody &cached, const std::string &body, unsigned int notifyId, bool fullState);
+	void releaseCachedBody (CachedBody &cached);
+	void dropNotifyCacheEntry (std::map<unsigned int, CachedBody>::iterator it);
+	static void evictCachedBodies (time_t now);
+	SalBodyHandler *createNotifyBody (const std::string &notify, bool multipart) const;
+	void notifyDevices (const std::string &notify, const std::list<std::shared_ptr<ParticipantDevice>> &devices, bool multipart = false);
 	void notifyParticipantDevice (const std::string &notify, const std::shared_ptr<ParticipantDevice> &device, bool multipart = false);
+	void notifyParticipantDevice (const SalBodyHandler *body, const std::shared_ptr<ParticipantDevice> &device);
 
 	L_DECLARE_PUBLIC(LocalConferenceEventHandler);
 };
@@ -17,6 +17,7 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <ctime>
 
 #include "linphone/api/c-content.h"
@@ -49,23 +50,51 @@ using namespace Xsd::ConferenceInfo;
 
 // -----------------------------------------------------------------------------
 
+mutex LocalConferenceEventHandlerPrivate::cacheMutex;
+list<LocalConferenceEventHandlerPrivate::CacheBudgetEntry> LocalConferenceEventHandlerPrivate::cacheBudgetEntries;
+size_t LocalConferenceEventHandlerPrivate::cachedBytes = 0;
+size_t LocalConferenceEventHandlerPrivate::cacheBudget = LocalConferenceEventHandlerPrivate::DefaultCacheBudget;
+
+LocalConferenceEventHandlerPrivate::~LocalConferenceEventHandlerPrivate () {
+	clearNotifyCache();
+}
+
+// -----------------------------------------------------------------------------
+
 void LocalConferenceEventHandlerPrivate::notifyFullState (const string &notify, const shared_ptr<ParticipantDevice> &device) {
 	notifyParticipantDevice(notify, device);
 }
 
 void LocalConferenceEventHandlerPrivate::notifyAllExcept (const string &notify, const shared_ptr<Participant> &exceptParticipant) {
+	list<shared_ptr<ParticipantDevice>> devices;
 	for (const auto &participant : conf->getParticipants()) {
-		if (participant != exceptParticipant)
-			notifyParticipant(notify, participant);
+		if (participant != exceptParticipant) {
+			const auto &participantDevices = participant->getPrivate()->getDevices();
+			devices.insert(devices.end(), participantDevices.begin(), participantDevices.end());
+		}
 	}
+	notifyDevices(notify, devices);
 }
 
 void LocalConferenceEventHandlerPrivate::notifyAll (const string &notify) {
-	for (const auto &participant : conf->getParticipants())
-		notifyParticipant(notify, participant);
+	notifyAllExcept(notify, nullptr);
 }
 
 string LocalConferenceEventHandlerPrivate::createNotifyFullState (int notifyId, bool oneToOne) {
+	if (notifyId != -1) {
+		lock_guard<mutex> lock(cacheMutex);
+		evictCachedBodies(time(nullptr));
+		if (
+			!fullStateCache.cached.body.empty() &&
+			fullStateCache.notifyId == static_cast<unsigned int>(notifyId) &&
+			fullStateCache.oneToOne == oneToOne
+		) {
+			cacheStats.hits++;
+			return fullStateCache.cached.body;
+		}
+		cacheStats.misses++;
+	}
+
 	string entity = conf->getConferenceAddress().asString();
 	string subject = conf->getSubject();
 	ConferenceType confInfo = ConferenceType(entity);
@@ -104,19 +133,30 @@ string LocalConferenceEventHandlerPrivate::createNotifyFullState (int notifyId,
 		confInfo.getUsers()->getUser().push_back(user);
 	}
 
-	return createNotify(confInfo, notifyId, true);
+	string notify = createNotify(confInfo, notifyId, true);
+	if (notifyId != -1) {
+		lock_guard<mutex> lock(cacheMutex);
+		fullStateCache.notifyId = static_cast<unsigned int>(notifyId);
+		fullStateCache.oneToOne = oneToOne;
+		storeCachedBody(fullStateCache.cached, notify, static_cast<unsigned int>(notifyId), true);
+	}
+	return notify;
 }
 
 string LocalConferenceEventHandlerPrivate::createNotifyMultipart (int notifyId) {
+	list<string> bodies;
+	if (getCachedNotifies(static_cast<unsigned int>(notifyId), bodies)) {
+		cacheStats.hits++;
+		return createNotifyMultipart(bodies);
+	}
+	cacheStats.misses++;
+
 	list<shared_ptr<EventLog>> events = conf->getCore()->getPrivate()->mainDb->getConferenceNotifiedEvents(
 		ConferenceId(conf->getConferenceAddress(), conf->getConferenceAddress()),
 		static_cast<unsigned int>(notifyId)
 	);
 
-	list<Content> contents;
 	for (const auto &eventLog : events) {
-		Content *content = new Content();
-		content->setContentType(ContentType::ConferenceInfo);
 		string body;
 		shared_ptr<ConferenceNotifiedEvent> notifiedEvent = static_pointer_cast<ConferenceNotifiedEvent>(eventLog);
 		int eventNotifyId = static_cast<int>(notifiedEvent->getNotifyId());
@@ -186,19 +226,10 @@ string LocalConferenceEventHandlerPrivate::createNotifyMultipart (int notifyId)
 				L_ASSERT(false);
 				continue;
 		}
-		contents.emplace_back(Content());
-		contents.back().setContentType(ContentType::ConferenceInfo);
-		contents.back().setBody(body);
+		bodies.push_back(body);
 	}
 
-	if (contents.empty())
-		return Utils::getEmptyConstRefObject<string>();
-
-	list<Content *> contentPtrs;
-	for (auto &content : contents)
-		contentPtrs.push_back(&content);
-	string multipart = ContentManager::contentListToMultipart(contentPtrs).getBodyAsUtf8String();
-	return multipart;
+	return createNotifyMultipart(bodies);
 }
 
 string LocalConferenceEventHandlerPrivate::createNotifyParticipantAdded (const Address &addr, int notifyId) {
@@ -347,7 +378,8 @@ void LocalConferenceEventHandlerPrivate::notifyResponseCb (const LinphoneEvent *
 // -----------------------------------------------------------------------------
 
 string LocalConferenceEventHandlerPrivate::createNotify (ConferenceType confInfo, int notifyId, bool isFullState) {
-	confInfo.setVersion(notifyId == -1 ? ++lastNotify : static_cast<unsigned int>(notifyId));
+	unsigned int version = notifyId == -1 ? ++lastNotify : static_cast<unsigned int>(notifyId);
+	confInfo.setVersion(version);
 	confInfo.setState(isFullState ? StateType::full : StateType::partial);
 
 	if (!confInfo.getConferenceDescription()) {
@@ -362,6 +394,8 @@ string LocalConferenceEventHandlerPrivate::createNotify (ConferenceType confInfo
 	Xsd::XmlSchema::NamespaceInfomap map;
 	map[""].name = "urn:ietf:params:xml:ns:conference-info";
 	serializeConferenceInfo(notify, confInfo, map);
+	if (!isFullState)
+		cacheNotify(version, notify.str());
 	return notify.str();
 }
 
@@ -375,20 +409,7 @@ string LocalConferenceEventHandlerPrivate::createNotifySubjectChanged (const str
 	return createNotify(confInfo, notifyId);
 }
 
-void LocalConferenceEventHandlerPrivate::notifyParticipant (const string &notify, const shared_ptr<Participant> &participant) {
-	for (const auto &device : participant->getPrivate()->getDevices())
-		notifyParticipantDevice(notify, device);
-}
-
-void LocalConferenceEventHandlerPrivate::notifyParticipantDevice (const string &notify, const shared_ptr<ParticipantDevice> &device, bool multipart) {
-	if (!device->isSubscribedToConferenceEventPackage() || notify.empty())
-		return;
-
-	LinphoneEvent *ev = device->getConferenceSubscribeEvent();
-	LinphoneEventCbs *cbs = linphone_event_get_callbacks(ev);
-	linphone_event_cbs_set_user_data(cbs, this);
-	linphone_event_cbs_set_notify_response(cbs, notifyResponseCb);
-
+SalBodyHandler *LocalConferenceEventHandlerPrivate::createNotifyBody (const string &notify, bool multipart) const {
 	Content content;
 	content.setBodyFromUtf8(notify);
 	ContentType contentType;
@@ -399,10 +420,171 @@ void LocalConferenceEventHandlerPrivate::notifyParticipantDevice (const string &
 		contentType = ContentType(ContentType::ConferenceInfo);
 
 	content.setContentType(contentType);
-	if (linphone_core_content_encoding_supported(conf->getCore()->getCCore(), "deflate"))
+	LinphoneCore *lc = conf->getCore()->getCCore();
+	if (linphone_core_content_encoding_supported(lc, "deflate"))
 		content.setContentEncoding("deflate");
 	LinphoneContent *cContent = L_GET_C_BACK_PTR(&content);
-	linphone_event_notify(ev, cContent);
+	SalBodyHandler *body = sal_body_handler_ref(sal_body_handler_from_content(cContent, false));
+	lc->sal->applyContentEncoding(body);
+	return body;
+}
+
+// The body is built and compressed once, then shared by the NOTIFY requests sent to every subscribed device.
+void LocalConferenceEventHandlerPrivate::notifyDevices (const string &notify, const list<shared_ptr<ParticipantDevice>> &devices, bool multipart) {
+	if (notify.empty())
+		return;
+
+	SalBodyHandler *body = nullptr;
+	unsigned int notifiesSent = 0;
+	for (const auto &device : devices) {
+		if (!device->isSubscribedToConferenceEventPackage())
+			continue;
+		if (!body) {
+			body = createNotifyBody(notify, multipart);
+			fanOutStats.bodiesEncoded++;
+		}
+		notifyParticipantDevice(body, device);
+		notifiesSent++;
+	}
+	if (!body)
+		return;
+	sal_body_handler_unref(body);
+
+	fanOutStats.notifiesSent += notifiesSent;
+	if (notifiesSent > 1) {
+		size_t saved = (notifiesSent - 1) * notify.size();
+		fanOutStats.compressedBytesSaved += saved;
+		lDebug() << "NOTIFY of conference [" << conf->getConferenceAddress() << "] sent to " << notifiesSent <<
+			" devices, " << saved << " bytes not compressed again";
+	}
+}
+
+string LocalConferenceEventHandlerPrivate::createNotifyMultipart (const list<string> &bodies) const {
+	if (bodies.empty())
+		return Utils::getEmptyConstRefObject<string>();
+
+	list<Content> contents;
+	for (const auto &body : bodies) {
+		contents.emplace_back(Content());
+		contents.back().setContentType(ContentType::ConferenceInfo);
+		contents.back().setBody(body);
+	}
+
+	list<Content *> contentPtrs;
+	for (auto &content : contents)
+		contentPtrs.push_back(&content);
+	return ContentManager::contentListToMultipart(contentPtrs).getBodyAsUtf8String();
+}
+
+// Fill bodies only if every notify sent after fromNotifyId is still in the cache.
+bool LocalConferenceEventHandlerPrivate::getCachedNotifies (unsigned int fromNotifyId, list<string> &bodies) {
+	if (fromNotifyId >= lastNotify)
+		return false;
+
+	lock_guard<mutex> lock(cacheMutex);
+	evictCachedBodies(time(nullptr));
+	auto it = notifyCache.find(fromNotifyId + 1);
+	for (unsigned int notifyId = fromNotifyId + 1; notifyId <= lastNotify; notifyId++, it++) {
+		if (it == notifyCache.end() || it->first != notifyId)
+			return false;
+	}
+
+	bodies.clear();
+	for (it = notifyCache.find(fromNotifyId + 1); it != notifyCache.end() && it->first <= lastNotify; it++)
+		bodies.push_back(it->second.body);
+	return true;
+}
+
+void LocalConferenceEventHandlerPrivate::cacheNotify (unsigned int notifyId, const string &body) {
+	if (notifyCacheSize == 0)
+		return;
+
+	lock_guard<mutex> lock(cacheMutex);
+	auto it = notifyCache.emplace(notifyId, CachedBody()).first;
+	if (!storeCachedBody(it->second, body, notifyId, false))
+		notifyCache.erase(it);
+	while (notifyCache.size() > notifyCacheSize)
+		dropNotifyCacheEntry(notifyCache.begin());
+}
+
+bool LocalConferenceEventHandlerPrivate::storeCachedBody (CachedBody &cached, const string &body, unsigned int notifyId, bool fullState) {
+	releaseCachedBody(cached);
+	if (body.empty() || body.size() > cacheBudget)
+		return false;
+
+	time_t now = time(nullptr);
+	time_t expiry = notifyCacheMaxAge > 0 ? now + notifyCacheMaxAge : 0;
+	cached.body = body;
+	cached.budgetIt = cacheBudgetEntries.insert(cacheBudgetEntries.end(), CacheBudgetEntry{ this, notifyId, fullState, body.size(), expiry });
+	cachedBytes += body.size();
+	// The body that was just stored is the newest one and fits in the budget, it is never evicted here.
+	evictCachedBodies(now);
+	return true;
+}
+
+void LocalConferenceEventHandlerPrivate::releaseCachedBody (CachedBody &cached) {
+	if (cached.body.empty())
+		return;
+
+	cachedBytes -= cached.budgetIt->size;
+	cacheBudgetEntries.erase(cached.budgetIt);
+	string().swap(cached.body);
+}
+
+void LocalConferenceEventHandlerPrivate::dropNotifyCacheEntry (map<unsigned int, CachedBody>::iterator it) {
+	releaseCachedBody(it->second);
+	notifyCache.erase(it);
+}
+
+// Drop the oldest bodies of all the conferences until the budget is met, as well as the expired ones.
+// Since bodies are dropped oldest first, an expired body stays until the ones cached before it are dropped.
+void LocalConferenceEventHandlerPrivate::evictCachedBodies (time_t now) {
+	while (!cacheBudgetEntries.empty()) {
+		const CacheBudgetEntry &entry = cacheBudgetEntries.front();
+		if (cachedBytes <= cacheBudget && (entry.expiry == 0 || entry.expiry > now))
+			break;
+
+		LocalConferenceEventHandlerPrivate *handler = entry.handler;
+		if (entry.fullState)
+			handler->releaseCachedBody(handler->fullStateCache.cached);
+		else
+			handler->dropNotifyCacheEntry(handler->notifyCache.find(entry.notifyId));
+	}
+}
+
+void LocalConferenceEventHandlerPrivate::invalidateFullState () {
+	lock_guard<mutex> lock(cacheMutex);
+	releaseCachedBody(fullStateCache.cached);
+}
+
+void LocalConferenceEventHandlerPrivate::clearNotifyCache () {
+	lock_guard<mutex> lock(cacheMutex);
+	releaseCachedBody(fullStateCache.cached);
+	while (!notifyCache.empty())
+		dropNotifyCacheEntry(notifyCache.begin());
+}
+
+size_t LocalConferenceEventHandlerPrivate::getCachedBytes () {
+	lock_guard<mutex> lock(cacheMutex);
+	return cachedBytes;
+}
+
+void LocalConferenceEventHandlerPrivate::setCacheBudget (size_t bytes) {
+	lock_guard<mutex> lock(cacheMutex);
+	cacheBudget = bytes;
+	evictCachedBodies(time(nullptr));
+}
+
+void LocalConferenceEventHandlerPrivate::notifyParticipantDevice (const string &notify, const shared_ptr<ParticipantDevice> &device, bool multipart) {
+	notifyDevices(notify, { device }, multipart);
+}
+
+void LocalConferenceEventHandlerPrivate::notifyParticipantDevice (const SalBodyHandler *body, const shared_ptr<ParticipantDevice> &device) {
+	LinphoneEvent *ev = device->getConferenceSubscribeEvent();
+	LinphoneEventCbs *cbs = linphone_event_get_callbacks(ev);
+	linphone_event_cbs_set_user_data(cbs, this);
+	linphone_event_cbs_set_notify_response(cbs, notifyResponseCb);
+	_linphone_event_notify_body_handler(ev, body);
 }
 
 // =============================================================================
@@ -412,6 +594,9 @@ LocalConferenceEventHandler::LocalConferenceEventHandler (LocalConference *local
 	L_D();
 	d->conf = localConference;
 	d->lastNotify = notify;
+	LinphoneConfig *config = linphone_core_get_config(localConference->getCore()->getCCore());
+	d->notifyCacheSize = static_cast<size_t>(max(0, linphone_config_get_int(config, "misc", "conference_notify_cache_size", 100)));
+	d->notifyCacheMaxAge = max(0, linphone_config_get_int(config, "misc", "conference_notify_cache_max_age", 3600));
 }
 
 // -----------------------------------------------------------------------------
@@ -565,6 +750,12 @@ shared_ptr<ConferenceParticipantDeviceEvent> LocalConferenceEventHandler::notify
 void LocalConferenceEventHandler::setLastNotify (unsigned int lastNotify) {
 	L_D();
 	d->lastNotify = lastNotify;
+	d->clearNotifyCache();
+}
+
+void LocalConferenceEventHandler::invalidateFullState () {
+	L_D();
+	d->invalidateFullState();
 }
 
 void LocalConferenceEventHandler::setConferenceId (const ConferenceId &conferenceId) {
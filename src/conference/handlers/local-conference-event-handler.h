@@ -53,6 +53,8 @@ public:
 	std::shared_ptr<ConferenceParticipantDeviceEvent> notifyParticipantDeviceRemoved (const Address &addr, const Address &gruu);
 
 	void setLastNotify (unsigned int lastNotify);
+	// To be called when participants or devices change without a NOTIFY being sent.
+	void invalidateFullState ();
 	void setConferenceId (const ConferenceId &conferenceId);
 	const ConferenceId &getConferenceId () const;
 
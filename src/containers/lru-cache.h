@@ -32,22 +32,33 @@ LINPHONE_BEGIN_NAMESPACE
 template<typename Key, typename Value>
 class LruCache {
 public:
-	LruCache (int capacity = DefaultCapacity) : mCapacity(capacity) {
-		if (capacity < MinCapacity)
-			capacity = MinCapacity;
-	}
+	LruCache (int capacity = DefaultCapacity) : mCapacity(capacity < MinCapacity ? MinCapacity : capacity) {}
 
 	int getCapacity () const {
 		return mCapacity;
 	}
 
+	// Least recently used keys are evicted if the cache is shrunk.
+	void setCapacity (int capacity) {
+		mCapacity = capacity < MinCapacity ? MinCapacity : capacity;
+		while (int(mKeyToPair.size()) > mCapacity) {
+			mKeyToPair.erase(mKeys.back());
+			mKeys.pop_back();
+		}
+	}
+
 	int getSize () const {
 		return int(mKeyToPair.size());
 	}
 
 	Value *operator[] (const Key &key) {
 		auto it = mKeyToPair.find(key);
-		return it == mKeyToPair.end() ? nullptr : &it->second.second;
+		if (it == mKeyToPair.end())
+			return nullptr;
+
+		// Most recently used keys are evicted last.
+		mKeys.splice(mKeys.begin(), mKeys, it->second.first);
+		return &it->second.second;
 	}
 
 	const Value *operator[] (const Key &key) const {
@@ -96,7 +107,7 @@ public:
 private:
 	using Pair = std::pair<typename std::list<Key>::iterator, Value>;
 
-	const int mCapacity;
+	int mCapacity;
 
 	// See: https://stackoverflow.com/questions/16781886/can-we-store-unordered-maptiterator
 	// Do not store iterator key.
@@ -29,6 +29,7 @@
 #include "conference/participant.h"
 #include "core-p.h"
 #include "logger/logger.h"
+#include "sal/message-op.h"
 
 #ifdef HAVE_ADVANCED_IM
 #include "chat/chat-room/basic-to-client-group-chat-room.h"
@@ -371,6 +372,50 @@ void CorePrivate::sendDeliveryNotifications () {
 	}
 }
 
+size_t CorePrivate::fanOutMessage (
+	const IdentityAddress &from,
+	const list<IdentityAddress> &recipients,
+	const Content &content,
+	SalCustomHeader *headers
+) {
+	L_Q();
+	LinphoneCore *lc = q->getCCore();
+	if (recipients.empty())
+		return 0;
+
+	// Same default as a chat message sent on its own, SalMessageContent drops an invalid Content-Type.
+	Content defaultedContent;
+	const Content *sentContent = &content;
+	if (!content.getContentType().isValid()) {
+		defaultedContent = content;
+		defaultedContent.setContentType(ContentType::PlainText);
+		sentContent = &defaultedContent;
+	}
+
+	const SalMessageContent salContent(*sentContent);
+	const string fromStr = from.asString();
+	LinphoneAddress *local = linphone_address_new(fromStr.c_str());
+	LinphoneProxyConfig *proxy = linphone_core_lookup_proxy_by_identity(lc, local);
+	linphone_address_unref(local);
+	const bool withContact = !!linphone_config_get_int(lc->config, "sip", "chat_msg_with_contact", 0);
+
+	size_t count = 0;
+	for (const auto &recipient : recipients) {
+		LinphoneAddress *peer = linphone_address_new(recipient.asString().c_str());
+		if (!peer)
+			continue;
+		SalMessageOp *op = new SalMessageOp(lc->sal);
+		linphone_configure_op_with_proxy(lc, op, peer, headers, withContact, proxy);
+		op->setFrom(fromStr.c_str());
+		if (op->sendMessage(salContent) == 0)
+			count++;
+		// The transaction holds its own reference until it terminates.
+		op->unref();
+		linphone_address_unref(peer);
+	}
+	return count;
+}
+
 void CorePrivate::replaceChatRoom (const shared_ptr<AbstractChatRoom> &replacedChatRoom, const shared_ptr<AbstractChatRoom> &newChatRoom) {
 	const ConferenceId &replacedConferenceId = replacedChatRoom->getConferenceId();
 	const ConferenceId &newConferenceId = newChatRoom->getConferenceId();
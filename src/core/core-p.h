@@ -77,6 +77,14 @@ public:
 
 	void loadChatRooms ();
 	void sendDeliveryNotifications ();
+	// Send the same MESSAGE to several recipients. The body and the common headers are built once, the requests
+	// only differ by their To and Request-URI. Returns the number of requests sent.
+	size_t fanOutMessage (
+		const IdentityAddress &from,
+		const std::list<IdentityAddress> &recipients,
+		const Content &content,
+		SalCustomHeader *headers
+	);
 	void insertChatRoom (const std::shared_ptr<AbstractChatRoom> &chatRoom);
 	void insertChatRoomWithDb (const std::shared_ptr<AbstractChatRoom> &chatRoom, unsigned int notifyId = 0);
 	std::shared_ptr<AbstractChatRoom> createBasicChatRoom (const ConferenceId &conferenceId, AbstractChatRoom::CapabilitiesMask capabilities, const std::shared_ptr<ChatRoomParams> &params);
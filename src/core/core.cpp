@@ -23,6 +23,7 @@
 
 #include <algorithm>
 #include <iterator>
+#include <mutex>
 
 #include <mediastreamer2/mscommon.h>
 
@@ -31,6 +32,7 @@
 #endif
 
 #include "address/address-p.h"
+#include "address/identity-address-parser.h"
 #include "call/call.h"
 #include "chat/encryption/encryption-engine.h"
 #ifdef HAVE_LIME_X3DH
@@ -63,6 +65,28 @@ LINPHONE_BEGIN_NAMESPACE
 void CorePrivate::init () {
 	L_Q();
 
+	// The identity address parser is shared by all the cores of the process, only the first one configures it.
+	IdentityAddressParser *identityAddressParser = IdentityAddressParser::getInstance();
+	const int identityAddressCacheSize = linphone_config_get_int(
+		linphone_core_get_config(L_GET_C_BACK_PTR(q)), "misc", "identity_address_cache_size", IdentityAddressParser::DefaultCacheCapacity
+	);
+	const bool identityAddressFastParsing = !!linphone_config_get_int(
+		linphone_core_get_config(L_GET_C_BACK_PTR(q)), "misc", "identity_address_fast_parsing", 1
+	);
+	static once_flag identityAddressParserConfigured;
+	call_once(identityAddressParserConfigured, [identityAddressParser, identityAddressCacheSize, identityAddressFastParsing] {
+		identityAddressParser->setCacheCapacity(identityAddressCacheSize);
+		identityAddressParser->enableFastParsing(identityAddressFastParsing);
+	});
+	if (
+		identityAddressParser->getCacheCapacity() != identityAddressCacheSize ||
+		identityAddressParser->isFastParsingEnabled() != identityAddressFastParsing
+	)
+		lWarning() << "Core [" << q << "] ignores its identity_address_cache_size (" << identityAddressCacheSize <<
+			") and identity_address_fast_parsing (" << identityAddressFastParsing << ") settings, the identity address" <<
+			" parser is shared by the process and uses a cache size of " << identityAddressParser->getCacheCapacity() <<
+			" and fast parsing " << (identityAddressParser->isFastParsingEnabled() ? "enabled" : "disabled") << ".";
+
 	mainDb.reset(new MainDb(q->getSharedFromThis()));
 #ifdef HAVE_ADVANCED_IM
 	remoteListEventHandler = makeUnique<RemoteConferenceListEventHandler>(q->getSharedFromThis());
@@ -93,6 +117,9 @@ void CorePrivate::init () {
 				throw DatabaseConnectionFailure(os.str());
 			}
 
+			if (lp_config_get_int(linphone_core_get_config(L_GET_C_BACK_PTR(q)), "storage", "async_enabled", 0))
+				mainDb->startAsyncThread(backend, uri);
+
 			loadChatRooms();
 		} else lWarning() << "Database explicitely not requested, this Core is built with no database support.";
 	}
@@ -118,6 +145,13 @@ void CorePrivate::uninit () {
 
 	if (toneManager) toneManager->deleteTimer();
 
+	// Stop history retention, finish async calls and write queued chat message updates while chat rooms are still alive.
+	if (mainDb != nullptr) {
+		mainDb->stopHistoryRetention();
+		mainDb->stopAsyncThread();
+		mainDb->flushPendingUpdates();
+	}
+
 	chatRoomsById.clear();
 	noCreatedClientGroupChatRooms.clear();
 	listeners.clear();
@@ -534,26 +568,22 @@ int Core::getUnreadChatMessageCount () const {
 
 int Core::getUnreadChatMessageCount (const IdentityAddress &localAddress) const {
 	L_D();
-	int count = 0;
-	for (auto it = d->chatRoomsById.begin(); it != d->chatRoomsById.end(); it++) {
-		const auto &chatRoom = it->second;
-		if (chatRoom->getLocalAddress() == localAddress)
-			count += chatRoom->getUnreadChatMessageCount();
-	}
-	return count;
+	const auto &counts = d->mainDb->getUnreadChatMessageCountByLocalAddress();
+	auto it = counts.find(localAddress);
+	return it == counts.cend() ? 0 : it->second;
 }
 
 int Core::getUnreadChatMessageCountFromActiveLocals () const {
 	L_D();
 
+	// Iterate over the per local address counts rather than over every chat room.
 	int count = 0;
-	for (auto it = d->chatRoomsById.begin(); it != d->chatRoomsById.end(); it++) {
-		const auto &chatRoom = it->second;
+	for (const auto &entry : d->mainDb->getUnreadChatMessageCountByLocalAddress()) {
 		for (auto it = linphone_core_get_proxy_config_list(getCCore()); it != NULL; it = it->next) {
 			LinphoneProxyConfig *cfg = (LinphoneProxyConfig *)it->data;
 			const LinphoneAddress *identityAddr = linphone_proxy_config_get_identity_address(cfg);
-			if (L_GET_CPP_PTR_FROM_C_OBJECT(identityAddr)->weakEqual(chatRoom->getLocalAddress())) {
-				count += chatRoom->getUnreadChatMessageCount();
+			if (L_GET_CPP_PTR_FROM_C_OBJECT(identityAddr)->weakEqual(entry.first)) {
+				count += entry.second;
 			}
 		}
 	}
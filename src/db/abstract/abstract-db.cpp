@@ -26,6 +26,9 @@
 #endif // if (__APPLE__ || defined(__ANDROID__))
 
 #include "abstract-db-p.h"
+#ifdef HAVE_DB_STORAGE
+#include "db/internal/statements.h"
+#endif
 #include "logger/logger.h"
 
 // =============================================================================
@@ -116,6 +119,7 @@ bool AbstractDb::forceReconnect () {
 		for (int i = 0; i < retryCount; ++i) {
 			try {
 				lInfo() << "Reconnect... Try: " << i;
+				d->dbSession.getPreparedStatementCache().clear();
 				d->dbSession.getBackendSession()->reconnect(); // Equivalent to close and connect.
 				d->safeInit();
 				lInfo() << "Database reconnection successful!";
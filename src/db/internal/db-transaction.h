@@ -47,6 +47,10 @@ public:
 		}
 	}
 
+	bool isCommitted () const {
+		return mIsCommitted;
+	}
+
 	void commit () {
 		if (mIsCommitted) {
 			lError() << "Transaction " << this << " in MainDb::" << mName << " already committed!!!";
@@ -98,7 +102,9 @@ public:
 		try {
 			SmartTransaction tr(session, name);
 			mResult = exec<InternalReturnType>(tr);
+			mainDb->getPrivate()->endTransaction(tr.isCommitted());
 		} catch (const soci::soci_error &e) {
+			mainDb->getPrivate()->endTransaction(false);
 			lWarning() << "Catched exception in MainDb::" << name << "(" << e.what() << ").";
 			soci::soci_error::error_category category = e.get_error_category();
 			if (
@@ -108,7 +114,9 @@ public:
 				try {
 					SmartTransaction tr(session, name);
 					mResult = exec<InternalReturnType>(tr);
+					mainDb->getPrivate()->endTransaction(tr.isCommitted());
 				} catch (const std::exception &e) {
+					mainDb->getPrivate()->endTransaction(false);
 					lError() << "Unable to execute query after reconnect in MainDb::" << name << "(" << e.what() << ").";
 				}
 				return;
@@ -116,6 +124,7 @@ public:
 			lError() << "Unhandled [" << getErrorCategoryAsString(category) << "] exception in MainDb::" <<
 				name << ": `" << e.what() << "`.";
 		} catch (const std::exception &e) {
+			mainDb->getPrivate()->endTransaction(false);
 			lError() << "Unhandled generic exception in MainDb::" << name << ": `" << e.what() << "`.";
 		}
 	}
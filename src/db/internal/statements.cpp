@@ -17,10 +17,18 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#ifdef HAVE_DB_STORAGE
+	#include <soci/sqlite3/soci-sqlite3.h>
+#endif
+
+#include "logger/logger.h"
+
 #include "statements.h"
 
 // =============================================================================
 
+using namespace std;
+
 LINPHONE_BEGIN_NAMESPACE
 
 namespace Statements {
@@ -107,11 +115,45 @@ namespace Statements {
 			LEFT JOIN sip_address AS device_sip_address ON device_sip_address.id = device_sip_address_id
 			LEFT JOIN sip_address AS participant_sip_address ON participant_sip_address.id = participant_sip_address_id
 			WHERE chat_room_id = :1
+		)",
+
+		/* SelectConferenceEventsBefore */ R"(
+			SELECT event.id AS event_id, type, creation_time, from_sip_address.value, to_sip_address.value, time, imdn_message_id, state, direction, is_secured, notify_id, device_sip_address.value, participant_sip_address.value, subject, delivery_notification_required, display_notification_required, security_alert, faulty_device, marked_as_read, forward_info
+			FROM conference_event
+			JOIN event ON event.id = conference_event.event_id
+			LEFT JOIN conference_chat_message_event ON conference_chat_message_event.event_id = conference_event.event_id
+			LEFT JOIN conference_notified_event ON conference_notified_event.event_id = conference_event.event_id
+			LEFT JOIN conference_participant_device_event ON conference_participant_device_event.event_id = conference_event.event_id
+			LEFT JOIN conference_participant_event ON conference_participant_event.event_id = conference_event.event_id
+			LEFT JOIN conference_subject_event ON conference_subject_event.event_id = conference_event.event_id
+			LEFT JOIN conference_security_event ON conference_security_event.event_id = conference_event.event_id
+			LEFT JOIN sip_address AS from_sip_address ON from_sip_address.id = from_sip_address_id
+			LEFT JOIN sip_address AS to_sip_address ON to_sip_address.id = to_sip_address_id
+			LEFT JOIN sip_address AS device_sip_address ON device_sip_address.id = device_sip_address_id
+			LEFT JOIN sip_address AS participant_sip_address ON participant_sip_address.id = participant_sip_address_id
+			WHERE conference_event.chat_room_id = :1 AND conference_event.event_id < :2
+		)",
+
+		/* SelectConferenceChatRoomParticipants */ R"(
+			SELECT chat_room_participant.chat_room_id, chat_room_participant.id, sip_address.value, is_admin
+			FROM chat_room_participant
+			JOIN chat_room ON chat_room.id = chat_room_participant.chat_room_id
+			JOIN sip_address ON sip_address.id = chat_room_participant.participant_sip_address_id
+			WHERE (chat_room.capabilities & :1) = :1
+		)",
+
+		/* SelectConferenceChatRoomParticipantDevices */ R"(
+			SELECT chat_room_participant_device.chat_room_participant_id, sip_address.value, state, name
+			FROM chat_room_participant_device
+			JOIN chat_room_participant ON chat_room_participant.id = chat_room_participant_device.chat_room_participant_id
+			JOIN chat_room ON chat_room.id = chat_room_participant.chat_room_id
+			JOIN sip_address ON sip_address.id = chat_room_participant_device.participant_device_sip_address_id
+			WHERE (chat_room.capabilities & :1) = :1
 		)"
 	};
 
 	// ---------------------------------------------------------------------------
-	// Select statements.
+	// Insert statements.
 	// ---------------------------------------------------------------------------
 
 	constexpr AbstractStatement insert[InsertCount] = {
@@ -119,6 +161,59 @@ namespace Statements {
 			INSERT INTO one_to_one_chat_room (
 				chat_room_id, participant_a_sip_address_id, participant_b_sip_address_id
 			) VALUES (:1, :2, :3)
+		)",
+
+		/* InsertEvent */ R"(
+			INSERT INTO event (type, creation_time) VALUES (:1, :2)
+		)",
+
+		/* InsertConferenceEvent */ R"(
+			INSERT INTO conference_event (event_id, chat_room_id) VALUES (:1, :2)
+		)",
+
+		/* InsertConferenceChatMessageEvent */ R"(
+			INSERT INTO conference_chat_message_event (
+				event_id, from_sip_address_id, to_sip_address_id,
+				time, state, direction, imdn_message_id, is_secured,
+				delivery_notification_required, display_notification_required,
+				marked_as_read, forward_info
+			) VALUES (:1, :2, :3, :4, :5, :6, :7, :8, :9, :10, :11, :12)
+		)",
+
+		/* InsertChatMessageParticipant */ R"(
+			INSERT INTO chat_message_participant (
+				event_id, participant_sip_address_id, state, state_change_time
+			) VALUES (:1, :2, :3, :4)
+		)"
+	};
+
+	// ---------------------------------------------------------------------------
+	// Update statements.
+	// ---------------------------------------------------------------------------
+
+	constexpr const char *update[UpdateCount] = {
+		/* UpdateChatRoomLastUpdateTime */ R"(
+			UPDATE chat_room SET last_update_time = :1 WHERE id = :2
+		)",
+
+		/* UpdateChatRoomLastMessageId */ R"(
+			UPDATE chat_room SET last_message_id = :1 WHERE id = :2
+		)",
+
+		/* UpdateChatRoomUnreadCount */ R"(
+			UPDATE chat_room SET unread_count = unread_count + :1 WHERE id = :2
+		)",
+
+		/* UpdateConferenceChatMessageEvent */ R"(
+			UPDATE conference_chat_message_event
+			SET state = :1, imdn_message_id = :2, marked_as_read = :3
+			WHERE event_id = :4
+		)",
+
+		/* UpdateChatMessageParticipantState */ R"(
+			UPDATE chat_message_participant
+			SET state = :1, state_change_time = :2
+			WHERE event_id = :3 AND participant_sip_address_id = :4
 		)"
 	};
 
@@ -133,6 +228,86 @@ namespace Statements {
 	const char *get (Insert insertStmt, AbstractDb::Backend backend) {
 		return insertStmt >= Insert::InsertCount ? nullptr : insert[insertStmt].get(backend);
 	}
+
+	const char *get (Update updateStmt) {
+		return updateStmt >= Update::UpdateCount ? nullptr : update[updateStmt];
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Prepared statement cache.
+// -----------------------------------------------------------------------------
+
+#ifdef HAVE_DB_STORAGE
+namespace {
+	enum class StatementKind {
+		Select,
+		Insert,
+		Update
+	};
+
+	constexpr int makeStatementKey (StatementKind kind, int id, AbstractDb::Backend backend) {
+		return (int(kind) << 24) | (int(backend) << 16) | id;
+	}
+}
+
+soci::statement &PreparedStatementCache::get (
+	soci::session *session,
+	Statements::Select selectStmt,
+	AbstractDb::Backend backend
+) {
+	return get(session, makeStatementKey(StatementKind::Select, selectStmt, backend), Statements::get(selectStmt));
+}
+
+soci::statement &PreparedStatementCache::get (
+	soci::session *session,
+	Statements::Insert insertStmt,
+	AbstractDb::Backend backend
+) {
+	return get(session, makeStatementKey(StatementKind::Insert, insertStmt, backend), Statements::get(insertStmt, backend));
+}
+
+soci::statement &PreparedStatementCache::get (
+	soci::session *session,
+	Statements::Update updateStmt,
+	AbstractDb::Backend backend
+) {
+	return get(session, makeStatementKey(StatementKind::Update, updateStmt, backend), Statements::get(updateStmt));
+}
+
+void PreparedStatementCache::clear () {
+	if (mStatements.empty())
+		return;
+
+	lInfo() << "Release " << mStatements.size() << " prepared statements (hits=" << mHitCount <<
+		", misses=" << mMissCount << ").";
+	mStatements.clear();
+}
+
+soci::statement &PreparedStatementCache::get (soci::session *session, int key, const char *sql) {
+	L_ASSERT(sql);
+
+	auto it = mStatements.find(key);
+	if (it != mStatements.end()) {
+		++mHitCount;
+		return *it->second;
+	}
+
+	++mMissCount;
+	unique_ptr<soci::statement> statement(new soci::statement(*session));
+	statement->alloc();
+	statement->prepare(sql);
+	return *mStatements.emplace(key, move(statement)).first->second;
+}
+
+// A cached SELECT that was stepped but not run to completion keeps its read transaction, and the snapshot
+// of a WAL database, until it is reset. It would block checkpoints between two uses of the statement.
+PreparedStatement::~PreparedStatement () {
+	soci::sqlite3_statement_backend *backend = dynamic_cast<soci::sqlite3_statement_backend *>(mStatement.get_backend());
+	if (backend && backend->stmt_)
+		sqlite3_reset(backend->stmt_);
+	mStatement.bind_clean_up();
 }
+#endif // ifdef HAVE_DB_STORAGE
 
 LINPHONE_END_NAMESPACE
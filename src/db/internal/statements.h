@@ -20,7 +20,17 @@
 #ifndef _L_STATEMENTS_H_
 #define _L_STATEMENTS_H_
 
+#include <memory>
+#include <unordered_map>
+
+#ifdef HAVE_CONFIG_H
+	#include "config.h"
+#endif
+
 #include "db/abstract/abstract-db.h"
+#ifdef HAVE_DB_STORAGE
+	#include "db/session/db-session.h"
+#endif
 
 // =============================================================================
 
@@ -34,18 +44,90 @@ namespace Statements {
 		SelectOneToOneChatRoomId,
 		SelectConferenceEvent,
 		SelectConferenceEvents,
+		SelectConferenceEventsBefore,
+		SelectConferenceChatRoomParticipants,
+		SelectConferenceChatRoomParticipantDevices,
 		SelectCount
 	};
 
 	enum Insert {
 		InsertOneToOneChatRoom,
+		InsertEvent,
+		InsertConferenceEvent,
+		InsertConferenceChatMessageEvent,
+		InsertChatMessageParticipant,
 		InsertCount
 	};
 
+	enum Update {
+		UpdateChatRoomLastUpdateTime,
+		UpdateChatRoomLastMessageId,
+		UpdateChatRoomUnreadCount,
+		UpdateConferenceChatMessageEvent,
+		UpdateChatMessageParticipantState,
+		UpdateCount
+	};
+
 	const char *get (Select selectStmt);
 	const char *get (Insert insertStmt, AbstractDb::Backend backend);
+	const char *get (Update updateStmt);
 }
 
+#ifdef HAVE_DB_STORAGE
+
+// Cache of prepared statements owned by a db session.
+// Statements are prepared on first use and reused across transactions.
+class PreparedStatementCache {
+public:
+	soci::statement &get (soci::session *session, Statements::Select selectStmt, AbstractDb::Backend backend);
+	soci::statement &get (soci::session *session, Statements::Insert insertStmt, AbstractDb::Backend backend);
+	soci::statement &get (soci::session *session, Statements::Update updateStmt, AbstractDb::Backend backend);
+
+	// Must be called before the underlying session is closed or reconnected.
+	void clear ();
+
+	unsigned long getHitCount () const {
+		return mHitCount;
+	}
+
+	unsigned long getMissCount () const {
+		return mMissCount;
+	}
+
+private:
+	soci::statement &get (soci::session *session, int key, const char *sql);
+
+	std::unordered_map<int, std::unique_ptr<soci::statement>> mStatements;
+	unsigned long mHitCount = 0;
+	unsigned long mMissCount = 0;
+};
+
+// Binds values on a cached statement and executes it.
+// On destruction the statement is reset and its bindings are released so that it can be reused, even after an
+// exception.
+class PreparedStatement {
+public:
+	explicit PreparedStatement (soci::statement &statement) : mStatement(statement) {}
+
+	~PreparedStatement ();
+
+	template<typename... Exchanges>
+	bool execute (Exchanges &&...exchanges) {
+		int unpack[] = { 0, (mStatement.exchange(std::forward<Exchanges>(exchanges)), 0)... };
+		(void)unpack;
+
+		mStatement.define_and_bind();
+		return mStatement.execute(true);
+	}
+
+private:
+	soci::statement &mStatement;
+
+	L_DISABLE_COPY(PreparedStatement);
+};
+
+#endif // ifdef HAVE_DB_STORAGE
+
 LINPHONE_END_NAMESPACE
 
 #endif // ifndef _L_STATEMENTS_H_
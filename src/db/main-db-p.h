@@ -20,7 +20,13 @@
 #ifndef _L_MAIN_DB_P_H_
 #define _L_MAIN_DB_P_H_
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "linphone/utils/utils.h"
 
@@ -31,6 +37,8 @@
 
 // =============================================================================
 
+typedef struct belle_sip_source belle_sip_source_t;
+
 LINPHONE_BEGIN_NAMESPACE
 
 class Content;
@@ -41,19 +49,117 @@ public:
 	mutable std::unordered_map<long long, std::weak_ptr<ChatMessage>> storageIdToChatMessage;
 	mutable std::unordered_map<long long, ConferenceId> storageIdToConferenceId;
 
+	~MainDbPrivate ();
+
 private:
+	struct ChatRoomParticipantDeviceRow {
+		std::string address;
+		unsigned int state;
+		std::string name;
+	};
+
+	struct ChatRoomParticipantRow {
+		std::string address;
+		bool isAdmin;
+		std::list<ChatRoomParticipantDeviceRow> devices;
+	};
+
+	struct ChatRoomRow {
+		long long id;
+		std::string peerSipAddress;
+		std::string localSipAddress;
+		time_t creationTime;
+		time_t lastUpdateTime;
+		int capabilities;
+		std::string subject;
+		unsigned int lastNotifyId;
+		bool hasBeenLeft;
+		long long lastMessageId;
+	};
+
+	// Columns of a conference event selected with Statements::SelectConferenceEvents.
+	// Only the columns of the event type are set.
+	struct EventRow {
+		long long eventId = -1;
+		EventLog::Type type = EventLog::Type::None;
+		time_t creationTime = 0;
+		std::string fromSipAddress;
+		std::string toSipAddress;
+		time_t time = 0;
+		std::string imdnMessageId;
+		int state = 0;
+		int direction = 0;
+		bool isSecured = false;
+		unsigned int notifyId = 0;
+		std::string deviceSipAddress;
+		std::string participantSipAddress;
+		std::string subject;
+		bool deliveryNotificationRequired = false;
+		bool displayNotificationRequired = false;
+		int securityAlert = 0;
+		std::string faultyDevice;
+		bool markedAsRead = false;
+		std::string forwardInfo;
+	};
+
+	struct ChatMessageContentRow {
+		std::string contentType;
+		std::string body;
+		bool isPlainText;
+		bool isFile;
+		std::string fileName;
+		size_t fileSize;
+		std::string filePath;
+		std::unordered_map<std::string, std::string> appData;
+	};
+
+	// Values of a chat message event to insert, copied from the chat message by the main loop.
+	struct ChatMessageEventInsertRow {
+		ConferenceId conferenceId;
+		time_t creationTime;
+		std::string fromSipAddress;
+		std::string toSipAddress;
+		time_t time;
+		int state;
+		int direction;
+		std::string imdnMessageId;
+		int isSecured;
+		int deliveryNotificationRequired;
+		int displayNotificationRequired;
+		int markedAsRead;
+		std::string forwardInfo;
+		std::list<ChatMessageContentRow> contents;
+		std::list<std::string> participantSipAddresses;
+	};
+
+	// Chat room columns updated once per chat room at the end of a bulk insertion.
+	struct BulkChatRoomUpdate {
+		ConferenceId conferenceId;
+		time_t lastUpdateTime = 0;
+		long long lastMessageId = -1;
+		int unreadCount = 0;
+	};
+
 	// ---------------------------------------------------------------------------
 	// Misc helpers.
 	// ---------------------------------------------------------------------------
 
 	std::shared_ptr<AbstractChatRoom> findChatRoom (const ConferenceId &conferenceId) const;
 
+#ifdef HAVE_DB_STORAGE
+	template<typename Statement>
+	soci::statement &getPreparedStatement (Statement statement) const;
+#endif
+
 	// ---------------------------------------------------------------------------
 	// Low level API.
 	// ---------------------------------------------------------------------------
 
 	long long insertSipAddress (const std::string &sipAddress);
+	void insertSipAddresses (const std::unordered_set<std::string> &sipAddresses);
 	void insertContent (long long chatMessageId, const Content &content);
+	void insertContent (long long chatMessageId, const ChatMessageContentRow &contentRow);
+	static ChatMessageContentRow getChatMessageContentRow (const Content &content);
 	long long insertContentType (const std::string &contentType);
 	long long insertOrUpdateImportedBasicChatRoom (
 		long long peerSipAddressId,
@@ -71,6 +177,18 @@ private:
 	ConferenceId selectConferenceId (const long long chatRoomId) const;
 	long long selectChatRoomParticipantId (long long chatRoomId, long long participantSipAddressId) const;
 	long long selectOneToOneChatRoomId (long long sipAddressIdA, long long sipAddressIdB, bool encrypted) const;
+	void selectConferenceChatRoomParticipants (
+		std::unordered_map<long long, std::list<ChatRoomParticipantRow>> &participantsByChatRoomId
+	) const;
+	void selectChatRooms (
+		std::list<ChatRoomRow> &chatRoomRows,
+		std::unordered_map<long long, std::list<ChatRoomParticipantRow>> &participantsByChatRoomId
+	) const;
+
+	int selectUnreadChatMessageCount (long long chatRoomId) const;
+	void updateUnreadChatMessageCount (const ConferenceId &conferenceId, long long chatRoomId, int delta) const;
+	void updateUnreadChatMessageCountCache (const ConferenceId &conferenceId, int delta) const;
+	void loadUnreadChatMessageCountByLocalAddress () const;
 
 	void deleteContents (long long chatMessageId);
 	void deleteChatRoomParticipant (long long chatRoomId, long long participantSipAddressId);
@@ -81,20 +199,7 @@ private:
 	// ---------------------------------------------------------------------------
 
 #ifdef HAVE_DB_STORAGE
-	long long getConferenceEventIdFromRow (const soci::row &row) const {
-		return dbSession.resolveId(row, 0);
-	}
-
-	time_t getConferenceEventCreationTimeFromRow (const soci::row &row) const {
-		return Utils::getTmAsTimeT(row.get<tm>(2));
-	}
-
-	unsigned int getConferenceEventNotifyIdFromRow (const soci::row &row) const {
-		L_Q();
-		return q->getBackend() == MainDb::Backend::Mysql
-			? row.get<unsigned int>(10, 0)
-			: static_cast<unsigned int>(row.get<int>(10, 0));
-	}
+	EventRow selectEventRow (const soci::row &row) const;
 
 	std::shared_ptr<EventLog> selectGenericConferenceEvent (
 		const std::shared_ptr<AbstractChatRoom> &chatRoom,
@@ -106,53 +211,78 @@ private:
 		const soci::row &row
 	) const;
 
+	std::shared_ptr<EventLog> selectGenericConferenceEvent (
+		const std::shared_ptr<AbstractChatRoom> &chatRoom,
+		const EventRow &row
+	) const;
+
+	std::shared_ptr<EventLog> selectConferenceInfoEvent (
+		const ConferenceId &conferenceId,
+		const EventRow &row
+	) const;
+
 	std::shared_ptr<EventLog> selectConferenceEvent (
 		const ConferenceId &conferenceId,
 		EventLog::Type type,
-		const soci::row &row
+		const EventRow &row
 	) const;
 
 	std::shared_ptr<EventLog> selectConferenceCallEvent (
 		const ConferenceId &conferenceId,
 		EventLog::Type type,
-		const soci::row &row
+		const EventRow &row
 	) const;
 
 	std::shared_ptr<EventLog> selectConferenceChatMessageEvent (
 		const std::shared_ptr<AbstractChatRoom> &chatRoom,
 		EventLog::Type type,
-		const soci::row &row
+		const EventRow &row
 	) const;
 
 	std::shared_ptr<EventLog> selectConferenceParticipantEvent (
 		const ConferenceId &conferenceId,
 		EventLog::Type type,
-		const soci::row &row
+		const EventRow &row
 	) const;
 
 	std::shared_ptr<EventLog> selectConferenceParticipantDeviceEvent (
 		const ConferenceId &conferenceId,
 		EventLog::Type type,
-		const soci::row &row
+		const EventRow &row
 	) const;
 
 	std::shared_ptr<EventLog> selectConferenceSecurityEvent (
 		const ConferenceId &conferenceId,
 		EventLog::Type type,
-		const soci::row &row
+		const EventRow &row
 	) const;
 
 	std::shared_ptr<EventLog> selectConferenceSubjectEvent (
 		const ConferenceId &conferenceId,
 		EventLog::Type type,
-		const soci::row &row
+		const EventRow &row
 	) const;
 #endif
 
 	long long insertEvent (const std::shared_ptr<EventLog> &eventLog);
+	long long insertEvent (EventLog::Type type, time_t creationTime);
+	long long insertEventLog (const std::shared_ptr<EventLog> &eventLog);
 	long long insertConferenceEvent (const std::shared_ptr<EventLog> &eventLog, long long *chatRoomId = nullptr);
+	long long insertConferenceEvent (
+		EventLog::Type type,
+		time_t creationTime,
+		const ConferenceId &conferenceId,
+		long long *chatRoomId = nullptr
+	);
 	long long insertConferenceCallEvent (const std::shared_ptr<EventLog> &eventLog);
 	long long insertConferenceChatMessageEvent (const std::shared_ptr<EventLog> &eventLog);
+	long long insertConferenceChatMessageEvent (const ChatMessageEventInsertRow &chatMessageRow);
+	ChatMessageEventInsertRow getChatMessageEventInsertRow (const std::shared_ptr<EventLog> &eventLog) const;
+	void insertConferenceChatMessageEvents (
+		const std::vector<std::shared_ptr<EventLog>> &eventLogs,
+		std::unordered_map<long long, BulkChatRoomUpdate> &chatRoomUpdates,
+		std::list<std::pair<std::shared_ptr<EventLog>, long long>> &insertedEventLogs
+	);
 	void updateConferenceChatMessageEvent(const std::shared_ptr<EventLog> &eventLog);
 	long long insertConferenceNotifiedEvent (const std::shared_ptr<EventLog> &eventLog, long long *chatRoomId = nullptr);
 	long long insertConferenceParticipantEvent (const std::shared_ptr<EventLog> &eventLog, long long *chatRoomId = nullptr);
@@ -179,7 +309,27 @@ private:
 	std::shared_ptr<ChatMessage> getChatMessageFromCache (long long storageId) const;
 	ConferenceId getConferenceIdFromCache(long long storageId) const;
 
-	void invalidConferenceEventsFromQuery (const std::string &query, long long chatRoomId);
+	void invalidConferenceEvent (long long eventId);
+	void invalidConferenceEventsFromQuery (
+		const std::string &query,
+		long long chatRoomId,
+		std::list<long long> *eventIds = nullptr
+	);
+
+	void warmIdCaches () const;
+	// Called at the end of each transaction to commit or drop the changes made to the caches.
+	void endTransaction (bool committed) const;
+
+	// ---------------------------------------------------------------------------
+	// Chat rooms.
+	// ---------------------------------------------------------------------------
+
+	std::list<std::shared_ptr<AbstractChatRoom>> buildChatRooms (
+		const std::list<ChatRoomRow> &chatRoomRows,
+		std::unordered_map<long long, std::list<ChatRoomParticipantRow>> &participantsByChatRoomId
+	) const;
+
+	void cleanHistory (const ConferenceId &conferenceId, MainDb::FilterMask mask, std::list<long long> *eventIds);
 
 	// ---------------------------------------------------------------------------
 	// Versions.
@@ -188,6 +338,7 @@ private:
 	unsigned int getModuleVersion (const std::string &name);
 	void updateModuleVersion (const std::string &name, unsigned int version);
 	void updateSchema ();
+	void updateFullTextSearchIndex ();
 
 	// ---------------------------------------------------------------------------
 	// Import.
@@ -198,10 +349,169 @@ private:
 	void importLegacyHistory (DbSession &inDbSession);
 #endif
 
+	// ---------------------------------------------------------------------------
+	// Write-behind API.
+	// ---------------------------------------------------------------------------
+
+	struct PendingParticipantState {
+		IdentityAddress address;
+		ChatMessage::State state;
+		time_t stateChangeTime;
+	};
+
+	struct PendingEventUpdate {
+		std::shared_ptr<EventLog> eventLog;
+		bool updateEvent = false;
+		// Stored read state of the chat message when its update was queued.
+		ConferenceId conferenceId;
+		bool dbMarkedAsRead = true;
+		// Indexed by participant address.
+		std::unordered_map<std::string, PendingParticipantState> participantStates;
+	};
+
+	void queueEventUpdate (const std::shared_ptr<EventLog> &eventLog);
+	void queueChatMessageParticipantState (
+		const std::shared_ptr<EventLog> &eventLog,
+		const IdentityAddress &participantAddress,
+		ChatMessage::State state,
+		time_t stateChangeTime
+	);
+	void scheduleFlush ();
+	void flushPendingUpdates () const;
+
+	const PendingParticipantState *findPendingChatMessageParticipantState (
+		long long eventId,
+		const IdentityAddress &participantAddress
+	) const;
+	bool isPendingMarkedAsRead (long long eventId) const;
+	std::unordered_map<ConferenceId, int> getPendingUnreadChatMessageCountDeltas () const;
+
+	bool writeBehindEnabled = false;
+	unsigned int writeBehindDelay = 0;
+	size_t writeBehindBatchSize = 0;
+
+	// Indexed by event storage id.
+	mutable std::unordered_map<long long, PendingEventUpdate> pendingEventUpdates;
+	mutable size_t pendingUpdateCount = 0;
+	mutable belle_sip_source_t *writeBehindTimer = nullptr;
+
+	// ---------------------------------------------------------------------------
+	// Async API.
+	// ---------------------------------------------------------------------------
+
+	std::string getHistoryRangeQuery (int begin, int end, MainDb::FilterMask mask) const;
+	void runAsync (const std::function<void (MainDb &)> &task, const std::function<void ()> &completion = nullptr) const;
+	bool processAsyncCompletions () const;
+	void runAsyncLoop ();
+	void stopAsyncThread ();
+
+	// Connection used by the async thread only. Tasks are executed in order.
+	std::unique_ptr<MainDb> asyncMainDb;
+	std::thread asyncThread;
+	mutable std::mutex asyncMutex;
+	mutable std::condition_variable asyncCondition;
+	mutable std::deque<std::function<void (MainDb &)>> asyncTasks;
+	bool asyncThreadStopped = false;
+
+	// Completions of the queued tasks, only used by the main loop. They are dropped if the thread is stopped
+	// before they are run.
+	mutable std::deque<std::function<void ()>> asyncCompletions;
+	mutable unsigned int asyncDoneTaskCount = 0; // Guarded by asyncMutex.
+	mutable belle_sip_source_t *asyncCompletionTimer = nullptr;
+	static constexpr unsigned int AsyncCompletionPollInterval = 10; // In milliseconds.
+
+	// Set on the connection of the async thread. It only reads and writes plain rows, core objects are
+	// built and updated by the main loop.
+	bool isAsyncWorker = false;
+
+	// ---------------------------------------------------------------------------
+	// Retention API.
+	// ---------------------------------------------------------------------------
+
+	enum class RetentionStep {
+		Idle,
+		ExpiredEvents,
+		ChatRoomEvents,
+		SipAddresses,
+		ContentTypes,
+		Vacuum
+	};
+
+	void startRetention ();
+	void stopRetention ();
+	void startRetentionPass ();
+
+	// Run batches until the step duration is elapsed. Returns true when the pass is finished.
+	bool runRetentionStep ();
+
+	// Run one batch of the current step. Returns false when the step has nothing more to do.
+	bool runRetentionBatch ();
+
+	// Events are given with their chat room id.
+	size_t deleteConferenceEvents (const std::list<std::pair<long long, long long>> &eventIds);
+	size_t deleteOrphanSipAddresses (long long firstId, long long lastId);
+	size_t deleteOrphanContentTypes ();
+	// Returns true if free pages remain.
+	bool incrementalVacuum ();
+
+	// Limits, 0 means no limit.
+	unsigned int retentionMaxAge = 0; // In days.
+	unsigned int retentionMaxEventsPerChatRoom = 0;
+
+	unsigned int retentionBatchSize = 0;
+	unsigned int retentionStepInterval = 0; // In ms.
+	unsigned int retentionStepDuration = 0; // In ms.
+	unsigned int retentionPassInterval = 0; // In seconds.
+	unsigned int retentionVacuumPages = 0;
+	bool retentionIncrementalVacuum = false;
+
+	RetentionStep retentionStep = RetentionStep::Idle;
+	belle_sip_source_t *retentionTimer = nullptr;
+
+	// State of the current pass.
+	time_t retentionLimitTime = 0;
+	std::list<long long> retentionChatRoomIds;
+	long long retentionSipAddressCursor = 0;
+	size_t retentionDeletedEventCount = 0;
+
+	// ---------------------------------------------------------------------------
+	// Server queued messages API.
+	// ---------------------------------------------------------------------------
+
+	// Drop the oldest messages of a device above the limit. Returns true if messages were dropped.
+	bool trimServerQueuedChatMessages (long long chatRoomId, long long deviceSipAddressId);
+	// Delete the messages of a chat room which are not queued for any device anymore.
+	void deleteOrphanServerQueuedChatMessages (long long chatRoomId);
+
+	void startServerQueuedChatMessageExpiry ();
+	void stopServerQueuedChatMessageExpiry ();
+
+	unsigned int serverQueuedMessageTtl = 0; // In seconds, 0 means no expiry.
+	unsigned int serverQueuedMessageMaxPerDevice = 0; // 0 means no limit.
+	unsigned int serverQueuedMessageExpiryInterval = 0; // In seconds.
+	belle_sip_source_t *serverQueuedMessageExpiryTimer = nullptr;
+
 	// ---------------------------------------------------------------------------
 
 	mutable LruCache<ConferenceId, int> unreadChatMessageCountCache;
 
+	// Write-through caches of sip_address and content_type ids.
+	// Ids inserted by a transaction which is not committed are dropped at its end.
+	mutable LruCache<std::string, long long> sipAddressIdCache;
+	mutable LruCache<std::string, long long> contentTypeIdCache;
+	mutable bool idCachesHaveUncommittedIds = false;
+
+	// Unread count changes of the current transaction, indexed by chat room.
+	mutable std::unordered_map<ConferenceId, int> uncommittedUnreadCountDeltas;
+
+	bool fullTextSearchEnabled = false;
+
+	// Sum of the chat rooms unread counts, indexed by local address. Loaded on first use.
+	mutable std::unordered_map<IdentityAddress, int> unreadChatMessageCountByLocalAddress;
+	mutable bool unreadChatMessageCountByLocalAddressLoaded = false;
+	// Same counts including the read states queued by the write-behind mode.
+	mutable std::unordered_map<IdentityAddress, int> pendingUnreadChatMessageCountByLocalAddress;
+
 	L_DECLARE_PUBLIC(MainDb);
 };
 
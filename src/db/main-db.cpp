@@ -17,7 +17,11 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <chrono>
 #include <ctime>
+#include <limits>
+#include <sstream>
 
 #include "linphone/utils/algorithm.h"
 #include "linphone/utils/static-string.h"
@@ -54,7 +58,7 @@ LINPHONE_BEGIN_NAMESPACE
 
 #ifdef HAVE_DB_STORAGE
 namespace {
-	constexpr unsigned int ModuleVersionEvents = makeVersion(1, 0, 11);
+	constexpr unsigned int ModuleVersionEvents = makeVersion(1, 0, 15);
 	constexpr unsigned int ModuleVersionFriends = makeVersion(1, 0, 0);
 	constexpr unsigned int ModuleVersionLegacyFriendsImport = makeVersion(1, 0, 0);
 	constexpr unsigned int ModuleVersionLegacyHistoryImport = makeVersion(1, 0, 0);
@@ -246,6 +250,40 @@ static string buildSqlEventFilter (
 
 	return sql;
 }
+
+// -----------------------------------------------------------------------------
+
+// SQLite versions prior to 3.32 accept at most 999 bound parameters per statement.
+static constexpr size_t BulkMaxParameterCount = 999;
+
+// Insert rows with multi-row INSERT statements, each one binding at most BulkMaxParameterCount values.
+template<typename Row, typename Binder>
+static void insertRows (
+	soci::session &session,
+	const string &table,
+	const vector<string> &columns,
+	const vector<Row> &rows,
+	Binder bind
+) {
+	const size_t rowsPerStatement = max(size_t(1), BulkMaxParameterCount / columns.size());
+	for (size_t begin = 0; begin < rows.size(); begin += rowsPerStatement) {
+		const size_t end = min(rows.size(), begin + rowsPerStatement);
+
+		ostringstream query;
+		query << "INSERT INTO " << table << " (" << Utils::join(columns, ", ") << ") VALUES ";
+		for (size_t i = begin; i < end; ++i) {
+			query << (i == begin ? "(" : ", (");
+			for (size_t j = 0; j < columns.size(); ++j)
+				query << (j == 0 ? ":" : ", :") << "v" << (i - begin) << "_" << j;
+			query << ")";
+		}
+
+		soci::details::prepare_temp_type statement = (session.prepare << query.str());
+		for (size_t i = begin; i < end; ++i)
+			bind(statement, rows[i]);
+		soci::statement(statement).execute(true);
+	}
+}
 #endif
 
 // -----------------------------------------------------------------------------
@@ -254,12 +292,22 @@ static string buildSqlEventFilter (
 
 shared_ptr<AbstractChatRoom> MainDbPrivate::findChatRoom (const ConferenceId &conferenceId) const {
 	L_Q();
-	shared_ptr<AbstractChatRoom> chatRoom = q->getCore()->findChatRoom(conferenceId);
+	shared_ptr<AbstractChatRoom> chatRoom;
+	if (!isAsyncWorker)
+		chatRoom = q->getCore()->findChatRoom(conferenceId);
 	if (!chatRoom)
 		lError() << "Unable to find chat room: " << conferenceId << ".";
 	return chatRoom;
 }
 
+#ifdef HAVE_DB_STORAGE
+template<typename Statement>
+soci::statement &MainDbPrivate::getPreparedStatement (Statement statement) const {
+	L_Q();
+	return dbSession.getPreparedStatementCache().get(dbSession.getBackendSession(), statement, q->getBackend());
+}
+#endif
+
 // -----------------------------------------------------------------------------
 // Low level API.
 // -----------------------------------------------------------------------------
@@ -272,34 +320,127 @@ long long MainDbPrivate::insertSipAddress (const string &sipAddress) {
 
 	lInfo() << "Insert new sip address in database: `" << sipAddress << "`.";
 	*dbSession.getBackendSession() << "INSERT INTO sip_address (value) VALUES (:sipAddress)", soci::use(sipAddress);
-	return dbSession.getLastInsertId();
+	sipAddressId = dbSession.getLastInsertId();
+	sipAddressIdCache.insert(sipAddress, sipAddressId);
+	idCachesHaveUncommittedIds = true;
+	return sipAddressId;
 #else
 	return -1;
 #endif
 }
 
+void MainDbPrivate::insertSipAddresses (const unordered_set<string> &sipAddresses) {
+#ifdef HAVE_DB_STORAGE
+	soci::session *session = dbSession.getBackendSession();
+
+	// Fetch ids by groups of BulkMaxParameterCount addresses. Returns the addresses found.
+	const auto selectSipAddressIds = [this, session](const vector<string> &values) {
+		unordered_set<string> found;
+		for (size_t begin = 0; begin < values.size(); begin += BulkMaxParameterCount) {
+			const size_t end = min(values.size(), begin + BulkMaxParameterCount);
+
+			ostringstream query;
+			query << "SELECT id, value FROM sip_address WHERE value IN (";
+			for (size_t i = begin; i < end; ++i)
+				query << (i == begin ? ":v" : ", :v") << (i - begin);
+			query << ")";
+
+			soci::details::prepare_temp_type statement = (session->prepare << query.str());
+			for (size_t i = begin; i < end; ++i)
+				statement, soci::use(values[i]);
+
+			soci::rowset<soci::row> rows(statement);
+			for (const auto &row : rows) {
+				const string &value = row.get<string>(1);
+				sipAddressIdCache.insert(value, dbSession.resolveId(row, 0));
+				found.insert(value);
+			}
+		}
+		return found;
+	};
+
+	// 1. Resolve ids of addresses which are not cached.
+	vector<string> uncachedSipAddresses;
+	for (const auto &sipAddress : sipAddresses) {
+		if (!sipAddressIdCache[sipAddress])
+			uncachedSipAddresses.push_back(sipAddress);
+	}
+	if (uncachedSipAddresses.empty())
+		return;
+
+	const unordered_set<string> &existingSipAddresses = selectSipAddressIds(uncachedSipAddresses);
+
+	// 2. Insert the unknown ones at once and fetch their new ids.
+	vector<string> newSipAddresses;
+	for (const auto &sipAddress : uncachedSipAddresses) {
+		if (existingSipAddresses.find(sipAddress) == existingSipAddresses.cend())
+			newSipAddresses.push_back(sipAddress);
+	}
+	if (newSipAddresses.empty())
+		return;
+
+	lInfo() << "Insert " << newSipAddresses.size() << " new sip addresses in database.";
+	insertRows(*session, "sip_address", { "value" }, newSipAddresses,
+		[](soci::details::prepare_temp_type &statement, const string &sipAddress) {
+			statement, soci::use(sipAddress);
+		}
+	);
+	selectSipAddressIds(newSipAddresses);
+	idCachesHaveUncommittedIds = true;
+#endif
+}
+
+MainDbPrivate::ChatMessageContentRow MainDbPrivate::getChatMessageContentRow (const Content &content) {
+	ChatMessageContentRow contentRow;
+	contentRow.contentType = content.getContentType().getMediaType();
+	contentRow.body = content.getBodyAsString();
+	contentRow.isPlainText = content.getContentType() == ContentType::PlainText;
+	contentRow.isFile = content.isFile();
+	contentRow.fileSize = 0;
+	if (contentRow.isFile) {
+		const FileContent &fileContent = static_cast<const FileContent &>(content);
+		contentRow.fileName = fileContent.getFileName();
+		contentRow.fileSize = fileContent.getFileSize();
+		contentRow.filePath = fileContent.getFilePath();
+	}
+	contentRow.appData = content.getAppDataMap();
+	return contentRow;
+}
+
 void MainDbPrivate::insertContent (long long chatMessageId, const Content &content) {
+	insertContent(chatMessageId, getChatMessageContentRow(content));
+}
+
+void MainDbPrivate::insertContent (long long chatMessageId, const ChatMessageContentRow &contentRow) {
 #ifdef HAVE_DB_STORAGE
+	L_Q();
 	soci::session *session = dbSession.getBackendSession();
 
-	const long long &contentTypeId = insertContentType(content.getContentType().getMediaType());
-	const string &body = content.getBodyAsString();
+	const long long &contentTypeId = insertContentType(contentRow.contentType);
+	const string &body = contentRow.body;
 	*session << "INSERT INTO chat_message_content (event_id, content_type_id, body) VALUES"
 		" (:chatMessageId, :contentTypeId, :body)", soci::use(chatMessageId), soci::use(contentTypeId),
 		soci::use(body);
 
 	const long long &chatMessageContentId = dbSession.getLastInsertId();
-	if (content.isFile()) {
-		const FileContent &fileContent = static_cast<const FileContent &>(content);
-		const string &name = fileContent.getFileName();
-		const size_t &size = fileContent.getFileSize();
-		const string &path = fileContent.getFilePath();
+	if (
+		fullTextSearchEnabled &&
+		q->getBackend() == MainDb::Backend::Sqlite3 &&
+		contentRow.isPlainText
+	)
+		*session << "INSERT INTO chat_message_content_fts (rowid, body) VALUES (:chatMessageContentId, :body)",
+			soci::use(chatMessageContentId), soci::use(body);
+
+	if (contentRow.isFile) {
+		const string &name = contentRow.fileName;
+		const size_t &size = contentRow.fileSize;
+		const string &path = contentRow.filePath;
 		*session << "INSERT INTO chat_message_file_content (chat_message_content_id, name, size, path) VALUES"
 			" (:chatMessageContentId, :name, :size, :path)",
 			soci::use(chatMessageContentId), soci::use(name), soci::use(size), soci::use(path);
 	}
 
-	for (const auto &appData : content.getAppDataMap())
+	for (const auto &appData : contentRow.appData)
 		*session << "INSERT INTO chat_message_content_app_data (chat_message_content_id, name, data) VALUES"
 			" (:chatMessageContentId, :name, :data)",
 			soci::use(chatMessageContentId), soci::use(appData.first), soci::use(appData.second);
@@ -308,16 +449,23 @@ void MainDbPrivate::insertContent (long long chatMessageId, const Content &conte
 
 long long MainDbPrivate::insertContentType (const string &contentType) {
 #ifdef HAVE_DB_STORAGE
+	const long long *cachedId = contentTypeIdCache[contentType];
+	if (cachedId)
+		return *cachedId;
+
 	soci::session *session = dbSession.getBackendSession();
 
 	long long contentTypeId;
 	*session << "SELECT id FROM content_type WHERE value = :contentType", soci::use(contentType), soci::into(contentTypeId);
-	if (session->got_data())
-		return contentTypeId;
+	if (!session->got_data()) {
+		lInfo() << "Insert new content type in database: `" << contentType << "`.";
+		*session << "INSERT INTO content_type (value) VALUES (:contentType)", soci::use(contentType);
+		contentTypeId = dbSession.getLastInsertId();
+		idCachesHaveUncommittedIds = true;
+	}
 
-	lInfo() << "Insert new content type in database: `" << contentType << "`.";
-	*session << "INSERT INTO content_type (value) VALUES (:contentType)", soci::use(contentType);
-	return dbSession.getLastInsertId();
+	contentTypeIdCache.insert(contentType, contentTypeId);
+	return contentTypeId;
 #else
 	return -1;
 #endif
@@ -468,10 +616,8 @@ void MainDbPrivate::insertChatRoomParticipantDevice (
 void MainDbPrivate::insertChatMessageParticipant (long long chatMessageId, long long sipAddressId, int state, time_t stateChangeTime) {
 #ifdef HAVE_DB_STORAGE
 	const tm &stateChangeTm = Utils::getTimeTAsTm(stateChangeTime);
-	*dbSession.getBackendSession() <<
-		"INSERT INTO chat_message_participant (event_id, participant_sip_address_id, state, state_change_time)"
-		" VALUES (:chatMessageId, :sipAddressId, :state, :stateChangeTm)",
-		soci::use(chatMessageId), soci::use(sipAddressId), soci::use(state), soci::use(stateChangeTm);
+	PreparedStatement statement(getPreparedStatement(Statements::InsertChatMessageParticipant));
+	statement.execute(soci::use(chatMessageId), soci::use(sipAddressId), soci::use(state), soci::use(stateChangeTm));
 #endif
 }
 
@@ -479,13 +625,19 @@ void MainDbPrivate::insertChatMessageParticipant (long long chatMessageId, long
 
 long long MainDbPrivate::selectSipAddressId (const string &sipAddress) const {
 #ifdef HAVE_DB_STORAGE
-	long long sipAddressId;
+	const long long *cachedId = sipAddressIdCache[sipAddress];
+	if (cachedId)
+		return *cachedId;
 
-	soci::session *session = dbSession.getBackendSession();
-	*session << Statements::get(Statements::SelectSipAddressId),
-		soci::use(sipAddress), soci::into(sipAddressId);
+	long long sipAddressId;
+	{
+		PreparedStatement statement(getPreparedStatement(Statements::SelectSipAddressId));
+		if (!statement.execute(soci::use(sipAddress), soci::into(sipAddressId)))
+			return -1;
+	}
 
-	return session->got_data() ? sipAddressId : -1;
+	sipAddressIdCache.insert(sipAddress, sipAddressId);
+	return sipAddressId;
 #else
 	return -1;
 #endif
@@ -495,11 +647,10 @@ long long MainDbPrivate::selectChatRoomId (long long peerSipAddressId, long long
 #ifdef HAVE_DB_STORAGE
 	long long chatRoomId;
 
-	soci::session *session = dbSession.getBackendSession();
-	*session << Statements::get(Statements::SelectChatRoomId),
-		soci::use(peerSipAddressId), soci::use(localSipAddressId), soci::into(chatRoomId);
-
-	return session->got_data() ? chatRoomId : -1;
+	PreparedStatement statement(getPreparedStatement(Statements::SelectChatRoomId));
+	return statement.execute(soci::use(peerSipAddressId), soci::use(localSipAddressId), soci::into(chatRoomId))
+		? chatRoomId
+		: -1;
 #else
 	return -1;
 #endif
@@ -531,7 +682,10 @@ ConferenceId MainDbPrivate::selectConferenceId (const long long chatRoomId) cons
 	string peerSipAddress;
 	string localSipAddress;
 
-	string query = "SELECT peer_sip_address_id, local_sip_address_id FROM chat_room WHERE id = :1";
+	string query = "SELECT peer_sip_address.value, local_sip_address.value"
+		" FROM chat_room, sip_address AS peer_sip_address, sip_address AS local_sip_address"
+		" WHERE chat_room.id = :1"
+		" AND peer_sip_address.id = chat_room.peer_sip_address_id AND local_sip_address.id = chat_room.local_sip_address_id";
 	soci::session *session = dbSession.getBackendSession();
 	*session << query, soci::use(chatRoomId), soci::into(peerSipAddress), soci::into(localSipAddress);
 
@@ -582,6 +736,258 @@ long long MainDbPrivate::selectOneToOneChatRoomId (long long sipAddressIdA, long
 #endif
 }
 
+void MainDbPrivate::selectConferenceChatRoomParticipants (
+	unordered_map<long long, list<ChatRoomParticipantRow>> &participantsByChatRoomId
+) const {
+#ifdef HAVE_DB_STORAGE
+	soci::session *session = dbSession.getBackendSession();
+	const int conferenceCapability = int(ChatRoom::Capabilities::Conference);
+
+	// 1. Fetch devices of all conference participants, indexed by participant id.
+	unordered_map<long long, list<ChatRoomParticipantDeviceRow>> devicesByParticipantId;
+	{
+		soci::rowset<soci::row> rows = (session->prepare << Statements::get(Statements::SelectConferenceChatRoomParticipantDevices),
+			soci::use(conferenceCapability, "1"));
+		for (const auto &row : rows)
+			devicesByParticipantId[dbSession.resolveId(row, 0)].push_back({
+				row.get<string>(1),
+				static_cast<unsigned int>(row.get<int>(2, 0)),
+				row.get<string>(3, "")
+			});
+	}
+
+	// 2. Fetch participants and attach their devices.
+	soci::rowset<soci::row> rows = (session->prepare << Statements::get(Statements::SelectConferenceChatRoomParticipants),
+		soci::use(conferenceCapability, "1"));
+	for (const auto &row : rows) {
+		ChatRoomParticipantRow participant{ row.get<string>(2), !!row.get<int>(3), {} };
+
+		auto it = devicesByParticipantId.find(dbSession.resolveId(row, 1));
+		if (it != devicesByParticipantId.end())
+			participant.devices = move(it->second);
+
+		participantsByChatRoomId[dbSession.resolveId(row, 0)].push_back(move(participant));
+	}
+#endif
+}
+
+void MainDbPrivate::selectChatRooms (
+	list<ChatRoomRow> &chatRoomRows,
+	unordered_map<long long, list<ChatRoomParticipantRow>> &participantsByChatRoomId
+) const {
+#ifdef HAVE_DB_STORAGE
+	L_Q();
+
+	static const string query = "SELECT chat_room.id, peer_sip_address.value, local_sip_address.value,"
+		" creation_time, last_update_time, capabilities, subject, last_notify_id, flags, last_message_id"
+		" FROM chat_room, sip_address AS peer_sip_address, sip_address AS local_sip_address"
+		" WHERE chat_room.peer_sip_address_id = peer_sip_address.id AND chat_room.local_sip_address_id = local_sip_address.id"
+		" ORDER BY last_update_time DESC";
+
+#ifdef HAVE_ADVANCED_IM
+	// Fetch participants and devices of all conference chat rooms at once instead of
+	// running one query per chat room and one per participant.
+	selectConferenceChatRoomParticipants(participantsByChatRoomId);
+#endif
+
+	soci::rowset<soci::row> rows = (dbSession.getBackendSession()->prepare << query);
+	for (const auto &row : rows) {
+		ChatRoomRow chatRoomRow;
+		chatRoomRow.id = dbSession.resolveId(row, 0);
+		chatRoomRow.peerSipAddress = row.get<string>(1);
+		chatRoomRow.localSipAddress = row.get<string>(2);
+		chatRoomRow.creationTime = dbSession.getTime(row, 3);
+		chatRoomRow.lastUpdateTime = dbSession.getTime(row, 4);
+		chatRoomRow.capabilities = row.get<int>(5);
+		chatRoomRow.subject = row.get<string>(6, "");
+		chatRoomRow.lastNotifyId = q->getBackend() == MainDb::Backend::Mysql
+			? row.get<unsigned int>(7, 0)
+			: static_cast<unsigned int>(row.get<int>(7, 0));
+		chatRoomRow.hasBeenLeft = !!row.get<int>(8, 0);
+		chatRoomRow.lastMessageId = dbSession.resolveId(row, 9);
+		chatRoomRows.push_back(move(chatRoomRow));
+	}
+#endif
+}
+
+list<shared_ptr<AbstractChatRoom>> MainDbPrivate::buildChatRooms (
+	const list<ChatRoomRow> &chatRoomRows,
+	unordered_map<long long, list<ChatRoomParticipantRow>> &participantsByChatRoomId
+) const {
+#ifdef HAVE_DB_STORAGE
+	L_Q();
+
+	list<shared_ptr<AbstractChatRoom>> chatRooms;
+	shared_ptr<Core> core = q->getCore();
+
+	for (const auto &chatRoomRow : chatRoomRows) {
+		ConferenceId conferenceId = ConferenceId(
+			IdentityAddress(chatRoomRow.peerSipAddress),
+			IdentityAddress(chatRoomRow.localSipAddress)
+		);
+
+		shared_ptr<AbstractChatRoom> chatRoom = core->findChatRoom(conferenceId, false);
+		if (chatRoom) {
+			chatRooms.push_back(chatRoom);
+			continue;
+		}
+
+		const long long &dbChatRoomId = chatRoomRow.id;
+		cache(conferenceId, dbChatRoomId);
+
+		const int &capabilities = chatRoomRow.capabilities;
+		const string &subject = chatRoomRow.subject;
+
+		shared_ptr<ChatRoomParams> params = ChatRoomParams::fromCapabilities(capabilities);
+		if (capabilities & ChatRoom::CapabilitiesMask(ChatRoom::Capabilities::Basic)) {
+			chatRoom = core->getPrivate()->createBasicChatRoom(conferenceId, capabilities, params);
+			chatRoom->setSubject(subject);
+		} else if (capabilities & ChatRoom::CapabilitiesMask(ChatRoom::Capabilities::Conference)) {
+#ifdef HAVE_ADVANCED_IM
+			list<shared_ptr<Participant>> participants;
+
+			const unsigned int &lastNotifyId = chatRoomRow.lastNotifyId;
+
+			// Build participants from prefetched rows.
+			shared_ptr<Participant> me;
+			for (const auto &participantRow : participantsByChatRoomId[dbChatRoomId]) {
+				shared_ptr<Participant> participant = make_shared<Participant>(nullptr, IdentityAddress(participantRow.address));
+				ParticipantPrivate *dParticipant = participant->getPrivate();
+				dParticipant->setAdmin(participantRow.isAdmin);
+
+				for (const auto &deviceRow : participantRow.devices) {
+					shared_ptr<ParticipantDevice> device = dParticipant->addDevice(IdentityAddress(deviceRow.address), deviceRow.name);
+					device->setState(ParticipantDevice::State(deviceRow.state));
+				}
+
+				if (participant->getAddress() == conferenceId.getLocalAddress().getAddressWithoutGruu())
+					me = participant;
+				else
+					participants.push_back(participant);
+			}
+
+			Conference *conference = nullptr;
+			if (!linphone_core_conference_server_enabled(core->getCCore())) {
+				const bool &hasBeenLeft = chatRoomRow.hasBeenLeft;
+				if (!me) {
+					lError() << "Unable to find me in: (peer=" + conferenceId.getPeerAddress().asString() +
+						", local=" + conferenceId.getLocalAddress().asString() + ").";
+					continue;
+				}
+				shared_ptr<ClientGroupChatRoom> clientGroupChatRoom(new ClientGroupChatRoom(
+					core,
+					conferenceId,
+					me,
+					capabilities,
+					params,
+					subject,
+					move(participants),
+					lastNotifyId,
+					hasBeenLeft
+				));
+				chatRoom = clientGroupChatRoom;
+				conference = clientGroupChatRoom.get();
+				AbstractChatRoomPrivate *dChatRoom = chatRoom->getPrivate();
+				dChatRoom->setState(ChatRoom::State::Instantiated);
+				dChatRoom->setState(hasBeenLeft
+					? ChatRoom::State::Terminated
+					: ChatRoom::State::Created
+				);
+			} else {
+				auto serverGroupChatRoom = std::make_shared<ServerGroupChatRoom>(
+					core,
+					conferenceId.getPeerAddress(),
+					capabilities,
+					params,
+					subject,
+					move(participants),
+					lastNotifyId
+				);
+				chatRoom = serverGroupChatRoom;
+				conference = serverGroupChatRoom.get();
+				AbstractChatRoomPrivate *dChatRoom = chatRoom->getPrivate();
+				dChatRoom->setState(ChatRoom::State::Instantiated);
+				dChatRoom->setState(ChatRoom::State::Created);
+			}
+			for (auto participant : chatRoom->getParticipants())
+				participant->getPrivate()->setConference(conference);
+#else
+			lWarning() << "Advanced IM such as group chat is disabled!";
+#endif
+		}
+
+		if (!chatRoom)
+			continue; // Not fetched.
+
+		AbstractChatRoomPrivate *dChatRoom = chatRoom->getPrivate();
+		dChatRoom->setCreationTime(chatRoomRow.creationTime);
+		dChatRoom->setLastUpdateTime(chatRoomRow.lastUpdateTime);
+		dChatRoom->setIsEmpty(chatRoomRow.lastMessageId == 0);
+
+		lDebug() << "Found chat room in DB: (peer=" <<
+			conferenceId.getPeerAddress().asString() << ", local=" << conferenceId.getLocalAddress().asString() << ").";
+
+		chatRooms.push_back(chatRoom);
+	}
+
+	return chatRooms;
+#else
+	return list<shared_ptr<AbstractChatRoom>>();
+#endif
+}
+
+int MainDbPrivate::selectUnreadChatMessageCount (long long chatRoomId) const {
+#ifdef HAVE_DB_STORAGE
+	int count = 0;
+	*dbSession.getBackendSession() << "SELECT unread_count FROM chat_room WHERE id = :chatRoomId",
+		soci::into(count), soci::use(chatRoomId);
+	return count;
+#else
+	return 0;
+#endif
+}
+
+void MainDbPrivate::updateUnreadChatMessageCount (const ConferenceId &conferenceId, long long chatRoomId, int delta) const {
+#ifdef HAVE_DB_STORAGE
+	if (delta == 0)
+		return;
+
+	{
+		PreparedStatement statement(getPreparedStatement(Statements::UpdateChatRoomUnreadCount));
+		statement.execute(soci::use(delta), soci::use(chatRoomId));
+	}
+
+	// Cached counts are updated once the transaction is committed.
+	uncommittedUnreadCountDeltas[conferenceId] += delta;
+#endif
+}
+
+void MainDbPrivate::updateUnreadChatMessageCountCache (const ConferenceId &conferenceId, int delta) const {
+	int *count = unreadChatMessageCountCache[conferenceId];
+	if (count)
+		*count += delta;
+
+	if (unreadChatMessageCountByLocalAddressLoaded)
+		unreadChatMessageCountByLocalAddress[conferenceId.getLocalAddress()] += delta;
+}
+
+void MainDbPrivate::loadUnreadChatMessageCountByLocalAddress () const {
+#ifdef HAVE_DB_STORAGE
+	if (unreadChatMessageCountByLocalAddressLoaded)
+		return;
+
+	static const string query = "SELECT sip_address.value, unread_count FROM chat_room"
+		"  JOIN sip_address ON sip_address.id = local_sip_address_id"
+		"  WHERE unread_count > 0";
+
+	unreadChatMessageCountByLocalAddress.clear();
+	soci::rowset<soci::row> rows = (dbSession.getBackendSession()->prepare << query);
+	for (const auto &row : rows)
+		unreadChatMessageCountByLocalAddress[IdentityAddress(row.get<string>(0))] += row.get<int>(1);
+	unreadChatMessageCountByLocalAddressLoaded = true;
+#endif
+}
+
 // -----------------------------------------------------------------------------
 
 void MainDbPrivate::deleteContents (long long chatMessageId) {
@@ -615,19 +1021,98 @@ void MainDbPrivate::deleteChatRoomParticipantDevice (
 // Events API.
 // -----------------------------------------------------------------------------
 #ifdef HAVE_DB_STORAGE
+MainDbPrivate::EventRow MainDbPrivate::selectEventRow (const soci::row &row) const {
+	L_Q();
+
+	EventRow eventRow;
+	eventRow.eventId = dbSession.resolveId(row, 0);
+	eventRow.type = EventLog::Type(row.get<int>(1));
+	eventRow.creationTime = Utils::getTmAsTimeT(row.get<tm>(2));
+
+	const auto getNotifyId = [&row, q] {
+		return q->getBackend() == MainDb::Backend::Mysql
+			? row.get<unsigned int>(10, 0)
+			: static_cast<unsigned int>(row.get<int>(10, 0));
+	};
+
+	switch (eventRow.type) {
+		case EventLog::Type::None:
+		case EventLog::Type::ConferenceCreated:
+		case EventLog::Type::ConferenceTerminated:
+		case EventLog::Type::ConferenceCallStart:
+		case EventLog::Type::ConferenceCallEnd:
+			break;
+
+		case EventLog::Type::ConferenceChatMessage:
+			eventRow.fromSipAddress = row.get<string>(3);
+			eventRow.toSipAddress = row.get<string>(4);
+			eventRow.time = dbSession.getTime(row, 5);
+			eventRow.imdnMessageId = row.get<string>(6);
+			eventRow.state = row.get<int>(7);
+			eventRow.direction = row.get<int>(8);
+			eventRow.isSecured = !!row.get<int>(9);
+			eventRow.deliveryNotificationRequired = !!row.get<int>(14);
+			eventRow.displayNotificationRequired = !!row.get<int>(15);
+			eventRow.markedAsRead = !!row.get<int>(18);
+			eventRow.forwardInfo = row.get<string>(19);
+			break;
+
+		case EventLog::Type::ConferenceParticipantAdded:
+		case EventLog::Type::ConferenceParticipantRemoved:
+		case EventLog::Type::ConferenceParticipantSetAdmin:
+		case EventLog::Type::ConferenceParticipantUnsetAdmin:
+			eventRow.notifyId = getNotifyId();
+			eventRow.participantSipAddress = row.get<string>(12);
+			break;
+
+		case EventLog::Type::ConferenceParticipantDeviceAdded:
+		case EventLog::Type::ConferenceParticipantDeviceRemoved:
+			eventRow.notifyId = getNotifyId();
+			eventRow.deviceSipAddress = row.get<string>(11);
+			eventRow.participantSipAddress = row.get<string>(12);
+			break;
+
+		case EventLog::Type::ConferenceSubjectChanged:
+			eventRow.notifyId = getNotifyId();
+			eventRow.subject = row.get<string>(13);
+			break;
+
+		case EventLog::Type::ConferenceSecurityEvent:
+			eventRow.securityAlert = row.get<int>(16);
+			eventRow.faultyDevice = row.get<string>(17);
+			break;
+	}
+
+	return eventRow;
+}
+
 shared_ptr<EventLog> MainDbPrivate::selectGenericConferenceEvent (
 	const shared_ptr<AbstractChatRoom> &chatRoom,
 	const soci::row &row
+) const {
+	shared_ptr<EventLog> eventLog = getEventFromCache(dbSession.resolveId(row, 0));
+	return eventLog ? eventLog : selectGenericConferenceEvent(chatRoom, selectEventRow(row));
+}
+
+shared_ptr<EventLog> MainDbPrivate::selectConferenceInfoEvent (
+	const ConferenceId &conferenceId,
+	const soci::row &row
+) const {
+	shared_ptr<EventLog> eventLog = getEventFromCache(dbSession.resolveId(row, 0));
+	return eventLog ? eventLog : selectConferenceInfoEvent(conferenceId, selectEventRow(row));
+}
+
+shared_ptr<EventLog> MainDbPrivate::selectGenericConferenceEvent (
+	const shared_ptr<AbstractChatRoom> &chatRoom,
+	const EventRow &row
 ) const {
 	L_ASSERT(chatRoom);
-	EventLog::Type type = EventLog::Type(row.get<int>(1));
-	if (type == EventLog::Type::ConferenceChatMessage) {
-		long long eventId = getConferenceEventIdFromRow(row);
-		shared_ptr<EventLog> eventLog = getEventFromCache(eventId);
+	if (row.type == EventLog::Type::ConferenceChatMessage) {
+		shared_ptr<EventLog> eventLog = getEventFromCache(row.eventId);
 		if (!eventLog) {
-			eventLog = selectConferenceChatMessageEvent(chatRoom, type, row);
+			eventLog = selectConferenceChatMessageEvent(chatRoom, row.type, row);
 			if (eventLog)
-				cache(eventLog, eventId);
+				cache(eventLog, row.eventId);
 		}
 		return eventLog;
 	}
@@ -637,52 +1122,50 @@ shared_ptr<EventLog> MainDbPrivate::selectGenericConferenceEvent (
 
 shared_ptr<EventLog> MainDbPrivate::selectConferenceInfoEvent (
 	const ConferenceId &conferenceId,
-	const soci::row &row
+	const EventRow &row
 ) const {
-	long long eventId = getConferenceEventIdFromRow(row);
-	shared_ptr<EventLog> eventLog = getEventFromCache(eventId);
+	shared_ptr<EventLog> eventLog = getEventFromCache(row.eventId);
 	if (eventLog)
 		return eventLog;
 
-	EventLog::Type type = EventLog::Type(row.get<int>(1));
-	switch (type) {
+	switch (row.type) {
 		case EventLog::Type::None:
 		case EventLog::Type::ConferenceChatMessage:
 			return nullptr;
 
 		case EventLog::Type::ConferenceCreated:
 		case EventLog::Type::ConferenceTerminated:
-			eventLog = selectConferenceEvent(conferenceId, type, row);
+			eventLog = selectConferenceEvent(conferenceId, row.type, row);
 			break;
 
 		case EventLog::Type::ConferenceCallStart:
 		case EventLog::Type::ConferenceCallEnd:
-			eventLog = selectConferenceCallEvent(conferenceId, type, row);
+			eventLog = selectConferenceCallEvent(conferenceId, row.type, row);
 			break;
 
 		case EventLog::Type::ConferenceParticipantAdded:
 		case EventLog::Type::ConferenceParticipantRemoved:
 		case EventLog::Type::ConferenceParticipantSetAdmin:
 		case EventLog::Type::ConferenceParticipantUnsetAdmin:
-			eventLog = selectConferenceParticipantEvent(conferenceId, type, row);
+			eventLog = selectConferenceParticipantEvent(conferenceId, row.type, row);
 			break;
 
 		case EventLog::Type::ConferenceParticipantDeviceAdded:
 		case EventLog::Type::ConferenceParticipantDeviceRemoved:
-			eventLog = selectConferenceParticipantDeviceEvent(conferenceId, type, row);
+			eventLog = selectConferenceParticipantDeviceEvent(conferenceId, row.type, row);
 			break;
 
 		case EventLog::Type::ConferenceSubjectChanged:
-			eventLog = selectConferenceSubjectEvent(conferenceId, type, row);
+			eventLog = selectConferenceSubjectEvent(conferenceId, row.type, row);
 			break;
 
 		case EventLog::Type::ConferenceSecurityEvent:
-			eventLog = selectConferenceSecurityEvent(conferenceId, type, row);
+			eventLog = selectConferenceSecurityEvent(conferenceId, row.type, row);
 			break;
 	}
 
 	if (eventLog)
-		cache(eventLog, eventId);
+		cache(eventLog, row.eventId);
 
 	return eventLog;
 }
@@ -690,11 +1173,11 @@ shared_ptr<EventLog> MainDbPrivate::selectConferenceInfoEvent (
 shared_ptr<EventLog> MainDbPrivate::selectConferenceEvent (
 	const ConferenceId &conferenceId,
 	EventLog::Type type,
-	const soci::row &row
+	const EventRow &row
 ) const {
 	return make_shared<ConferenceEvent>(
 		type,
-		getConferenceEventCreationTimeFromRow(row),
+		row.creationTime,
 		conferenceId
 	);
 }
@@ -702,7 +1185,7 @@ shared_ptr<EventLog> MainDbPrivate::selectConferenceEvent (
 shared_ptr<EventLog> MainDbPrivate::selectConferenceCallEvent (
 	const ConferenceId &conferenceId,
 	EventLog::Type type,
-	const soci::row &row
+	const EventRow &row
 ) const {
 	// TODO.
 	return nullptr;
@@ -711,19 +1194,18 @@ shared_ptr<EventLog> MainDbPrivate::selectConferenceCallEvent (
 shared_ptr<EventLog> MainDbPrivate::selectConferenceChatMessageEvent (
 	const shared_ptr<AbstractChatRoom> &chatRoom,
 	EventLog::Type type,
-	const soci::row &row
+	const EventRow &row
 ) const {
-	long long eventId = getConferenceEventIdFromRow(row);
-	shared_ptr<ChatMessage> chatMessage = getChatMessageFromCache(eventId);
+	shared_ptr<ChatMessage> chatMessage = getChatMessageFromCache(row.eventId);
 	if (!chatMessage) {
 		chatMessage = shared_ptr<ChatMessage>(new ChatMessage(
 			chatRoom,
-			ChatMessage::Direction(row.get<int>(8))
+			ChatMessage::Direction(row.direction)
 		));
-		chatMessage->setIsSecured(!!row.get<int>(9));
+		chatMessage->setIsSecured(row.isSecured);
 
 		ChatMessagePrivate *dChatMessage = chatMessage->getPrivate();
-		ChatMessage::State messageState = ChatMessage::State(row.get<int>(7));
+		ChatMessage::State messageState = ChatMessage::State(row.state);
 		// This is necessary if linphone has crashed while sending a message. It will set the correct state so the user can resend it.
 		if (messageState == ChatMessage::State::Idle 
 			|| messageState == ChatMessage::State::InProgress 
@@ -732,27 +1214,28 @@ shared_ptr<EventLog> MainDbPrivate::selectConferenceChatMessageEvent (
 		}
 		dChatMessage->forceState(messageState);
 
-		dChatMessage->forceFromAddress(IdentityAddress(row.get<string>(3)));
-		dChatMessage->forceToAddress(IdentityAddress(row.get<string>(4)));
+		dChatMessage->forceFromAddress(IdentityAddress(row.fromSipAddress));
+		dChatMessage->forceToAddress(IdentityAddress(row.toSipAddress));
 
-		dChatMessage->setTime(dbSession.getTime(row, 5));
-		dChatMessage->setImdnMessageId(row.get<string>(6));
-		dChatMessage->setPositiveDeliveryNotificationRequired(!!row.get<int>(14));
-		dChatMessage->setDisplayNotificationRequired(!!row.get<int>(15));
+		dChatMessage->setTime(row.time);
+		dChatMessage->setImdnMessageId(row.imdnMessageId);
+		dChatMessage->setPositiveDeliveryNotificationRequired(row.deliveryNotificationRequired);
+		dChatMessage->setDisplayNotificationRequired(row.displayNotificationRequired);
 
 		dChatMessage->markContentsAsNotLoaded();
 		dChatMessage->setIsReadOnly(true);
 
-		if (!!row.get<int>(18)) {
+		if (row.markedAsRead) {
 			dChatMessage->markAsRead();
 		}
-		dChatMessage->setForwardInfo(row.get<string>(19));
+		dChatMessage->dbMarkedAsRead = row.markedAsRead;
+		dChatMessage->setForwardInfo(row.forwardInfo);
 		
-		cache(chatMessage, eventId);
+		cache(chatMessage, row.eventId);
 	}
 
 	return make_shared<ConferenceChatMessageEvent>(
-		getConferenceEventCreationTimeFromRow(row),
+		row.creationTime,
 		chatMessage
 	);
 }
@@ -760,55 +1243,55 @@ shared_ptr<EventLog> MainDbPrivate::selectConferenceChatMessageEvent (
 shared_ptr<EventLog> MainDbPrivate::selectConferenceParticipantEvent (
 	const ConferenceId &conferenceId,
 	EventLog::Type type,
-	const soci::row &row
+	const EventRow &row
 ) const {
 	return make_shared<ConferenceParticipantEvent>(
 		type,
-		getConferenceEventCreationTimeFromRow(row),
+		row.creationTime,
 		conferenceId,
-		getConferenceEventNotifyIdFromRow(row),
-		IdentityAddress(row.get<string>(12))
+		row.notifyId,
+		IdentityAddress(row.participantSipAddress)
 	);
 }
 
 shared_ptr<EventLog> MainDbPrivate::selectConferenceParticipantDeviceEvent (
 	const ConferenceId &conferenceId,
 	EventLog::Type type,
-	const soci::row &row
+	const EventRow &row
 ) const {
 	return make_shared<ConferenceParticipantDeviceEvent>(
 		type,
-		getConferenceEventCreationTimeFromRow(row),
+		row.creationTime,
 		conferenceId,
-		getConferenceEventNotifyIdFromRow(row),
-		IdentityAddress(row.get<string>(12)),
-		IdentityAddress(row.get<string>(11))
+		row.notifyId,
+		IdentityAddress(row.participantSipAddress),
+		IdentityAddress(row.deviceSipAddress)
 	);
 }
 
 shared_ptr<EventLog> MainDbPrivate::selectConferenceSecurityEvent (
 	const ConferenceId &conferenceId,
 	EventLog::Type type,
-	const soci::row &row
+	const EventRow &row
 ) const {
 	return make_shared<ConferenceSecurityEvent>(
-		getConferenceEventCreationTimeFromRow(row),
+		row.creationTime,
 		conferenceId,
-		static_cast<ConferenceSecurityEvent::SecurityEventType>(row.get<int>(16)),
-		IdentityAddress(row.get<string>(17))
+		static_cast<ConferenceSecurityEvent::SecurityEventType>(row.securityAlert),
+		IdentityAddress(row.faultyDevice)
 	);
 }
 
 shared_ptr<EventLog> MainDbPrivate::selectConferenceSubjectEvent (
 	const ConferenceId &conferenceId,
 	EventLog::Type type,
-	const soci::row &row
+	const EventRow &row
 ) const {
 	return make_shared<ConferenceSubjectEvent>(
-		getConferenceEventCreationTimeFromRow(row),
+		row.creationTime,
 		conferenceId,
-		getConferenceEventNotifyIdFromRow(row),
-		row.get<string>(13)
+		row.notifyId,
+		row.subject
 	);
 }
 #endif
@@ -816,11 +1299,17 @@ shared_ptr<EventLog> MainDbPrivate::selectConferenceSubjectEvent (
 // -----------------------------------------------------------------------------
 
 long long MainDbPrivate::insertEvent (const shared_ptr<EventLog> &eventLog) {
+	return insertEvent(eventLog->getType(), eventLog->getCreationTime());
+}
+
+long long MainDbPrivate::insertEvent (EventLog::Type type, time_t creationTime) {
 #ifdef HAVE_DB_STORAGE
-	const int &type = int(eventLog->getType());
-	const tm &creationTime = Utils::getTimeTAsTm(eventLog->getCreationTime());
-	*dbSession.getBackendSession() << "INSERT INTO event (type, creation_time) VALUES (:type, :creationTime)",
-		soci::use(type), soci::use(creationTime);
+	const int &intType = int(type);
+	const tm &creationTm = Utils::getTimeTAsTm(creationTime);
+	{
+		PreparedStatement statement(getPreparedStatement(Statements::InsertEvent));
+		statement.execute(soci::use(intType), soci::use(creationTm));
+	}
 
 	return dbSession.getLastInsertId();
 #else
@@ -828,37 +1317,47 @@ long long MainDbPrivate::insertEvent (const shared_ptr<EventLog> &eventLog) {
 #endif
 }
 
-long long MainDbPrivate::insertConferenceEvent (const shared_ptr<EventLog> &eventLog, long long *chatRoomId) {
+long long MainDbPrivate::insertEventLog (const shared_ptr<EventLog> &eventLog) {
 #ifdef HAVE_DB_STORAGE
-	shared_ptr<ConferenceEvent> conferenceEvent = static_pointer_cast<ConferenceEvent>(eventLog);
-
 	long long eventId = -1;
-	const ConferenceId &conferenceId = conferenceEvent->getConferenceId();
-	const long long &curChatRoomId = selectChatRoomId(conferenceId);
-	if (curChatRoomId < 0) {
-		// A conference event can be inserted in database only if chat room exists.
-		// Otherwise it's an error.
-		lError() << "Unable to find chat room storage id of: " << conferenceId << ".";
-	} else {
-		eventId = insertEvent(eventLog);
+	switch (eventLog->getType()) {
+		case EventLog::Type::None:
+			return -1;
 
-		soci::session *session = dbSession.getBackendSession();
-		*session << "INSERT INTO conference_event (event_id, chat_room_id)"
-			" VALUES (:eventId, :chatRoomId)", soci::use(eventId), soci::use(curChatRoomId);
+		case EventLog::Type::ConferenceCreated:
+		case EventLog::Type::ConferenceTerminated:
+			eventId = insertConferenceEvent(eventLog);
+			break;
 
-		const tm &lastUpdateTime = Utils::getTimeTAsTm(eventLog->getCreationTime());
-		*session << "UPDATE chat_room SET last_update_time = :lastUpdateTime"
-			" WHERE id = :chatRoomId", soci::use(lastUpdateTime),
-			soci::use(curChatRoomId);
+		case EventLog::Type::ConferenceCallStart:
+		case EventLog::Type::ConferenceCallEnd:
+			eventId = insertConferenceCallEvent(eventLog);
+			break;
 
-		if (eventLog->getType() == EventLog::Type::ConferenceTerminated)
-			*session << "UPDATE chat_room SET flags = 1, last_notify_id = 0 WHERE id = :chatRoomId", soci::use(curChatRoomId);
-		else if (eventLog->getType() == EventLog::Type::ConferenceCreated)
-			*session << "UPDATE chat_room SET flags = 0 WHERE id = :chatRoomId", soci::use(curChatRoomId);
-	}
+		case EventLog::Type::ConferenceChatMessage:
+			eventId = insertConferenceChatMessageEvent(eventLog);
+			break;
 
-	if (chatRoomId)
-		*chatRoomId = curChatRoomId;
+		case EventLog::Type::ConferenceParticipantAdded:
+		case EventLog::Type::ConferenceParticipantRemoved:
+		case EventLog::Type::ConferenceParticipantSetAdmin:
+		case EventLog::Type::ConferenceParticipantUnsetAdmin:
+			eventId = insertConferenceParticipantEvent(eventLog);
+			break;
+
+		case EventLog::Type::ConferenceParticipantDeviceAdded:
+		case EventLog::Type::ConferenceParticipantDeviceRemoved:
+			eventId = insertConferenceParticipantDeviceEvent(eventLog);
+			break;
+
+		case EventLog::Type::ConferenceSecurityEvent:
+			eventId = insertConferenceSecurityEvent(eventLog);
+			break;
+
+		case EventLog::Type::ConferenceSubjectChanged:
+			eventId = insertConferenceSubjectEvent(eventLog);
+			break;
+	}
 
 	return eventId;
 #else
@@ -866,70 +1365,270 @@ long long MainDbPrivate::insertConferenceEvent (const shared_ptr<EventLog> &even
 #endif
 }
 
-long long MainDbPrivate::insertConferenceCallEvent (const shared_ptr<EventLog> &eventLog) {
-	// TODO.
-	return 0;
+long long MainDbPrivate::insertConferenceEvent (const shared_ptr<EventLog> &eventLog, long long *chatRoomId) {
+	return insertConferenceEvent(
+		eventLog->getType(),
+		eventLog->getCreationTime(),
+		static_pointer_cast<ConferenceEvent>(eventLog)->getConferenceId(),
+		chatRoomId
+	);
 }
 
-long long MainDbPrivate::insertConferenceChatMessageEvent (const shared_ptr<EventLog> &eventLog) {
+long long MainDbPrivate::insertConferenceEvent (
+	EventLog::Type type,
+	time_t creationTime,
+	const ConferenceId &conferenceId,
+	long long *chatRoomId
+) {
 #ifdef HAVE_DB_STORAGE
-	const long long &eventId = insertConferenceEvent(eventLog);
-	if (eventId < 0)
-		return -1;
+	long long eventId = -1;
+	const long long &curChatRoomId = selectChatRoomId(conferenceId);
+	if (curChatRoomId < 0) {
+		// A conference event can be inserted in database only if chat room exists.
+		// Otherwise it's an error.
+		lError() << "Unable to find chat room storage id of: " << conferenceId << ".";
+	} else {
+		eventId = insertEvent(type, creationTime);
+
+		{
+			PreparedStatement statement(getPreparedStatement(Statements::InsertConferenceEvent));
+			statement.execute(soci::use(eventId), soci::use(curChatRoomId));
+		}
+
+		const tm &lastUpdateTime = Utils::getTimeTAsTm(creationTime);
+		{
+			PreparedStatement statement(getPreparedStatement(Statements::UpdateChatRoomLastUpdateTime));
+			statement.execute(soci::use(lastUpdateTime), soci::use(curChatRoomId));
+		}
+
+		soci::session *session = dbSession.getBackendSession();
+
+		if (type == EventLog::Type::ConferenceTerminated)
+			*session << "UPDATE chat_room SET flags = 1, last_notify_id = 0 WHERE id = :chatRoomId", soci::use(curChatRoomId);
+		else if (type == EventLog::Type::ConferenceCreated)
+			*session << "UPDATE chat_room SET flags = 0 WHERE id = :chatRoomId", soci::use(curChatRoomId);
+	}
+
+	if (chatRoomId)
+		*chatRoomId = curChatRoomId;
+
+	return eventId;
+#else
+	return -1;
+#endif
+}
+
+long long MainDbPrivate::insertConferenceCallEvent (const shared_ptr<EventLog> &eventLog) {
+	// TODO.
+	return 0;
+}
+
+long long MainDbPrivate::insertConferenceChatMessageEvent (const shared_ptr<EventLog> &eventLog) {
+	return insertConferenceChatMessageEvent(getChatMessageEventInsertRow(eventLog));
+}
 
+MainDbPrivate::ChatMessageEventInsertRow MainDbPrivate::getChatMessageEventInsertRow (
+	const shared_ptr<EventLog> &eventLog
+) const {
 	shared_ptr<ChatMessage> chatMessage = static_pointer_cast<ConferenceChatMessageEvent>(eventLog)->getChatMessage();
-	const long long &fromSipAddressId = insertSipAddress(chatMessage->getFromAddress().asString());
-	const long long &toSipAddressId = insertSipAddress(chatMessage->getToAddress().asString());
-	const string &forwardInfo = chatMessage->getForwardInfo();
-	const tm &messageTime = Utils::getTimeTAsTm(chatMessage->getTime());
-	const int &state = int(chatMessage->getState());
-	const int &direction = int(chatMessage->getDirection());
-	const string &imdnMessageId = chatMessage->getImdnMessageId();
-	const int &isSecured = chatMessage->isSecured() ? 1 : 0;
-	const int &deliveryNotificationRequired = chatMessage->getPrivate()->getPositiveDeliveryNotificationRequired();
-	const int &displayNotificationRequired = chatMessage->getPrivate()->getDisplayNotificationRequired();
-	const int &markedAsRead = chatMessage->getPrivate()->isMarkedAsRead() ? 1 : 0;
-
-	*dbSession.getBackendSession() << "INSERT INTO conference_chat_message_event ("
-		"  event_id, from_sip_address_id, to_sip_address_id,"
-		"  time, state, direction, imdn_message_id, is_secured,"
-		"  delivery_notification_required, display_notification_required,"
-		"  marked_as_read, forward_info"
-		") VALUES ("
-		"  :eventId, :localSipaddressId, :remoteSipaddressId,"
-		"  :time, :state, :direction, :imdnMessageId, :isSecured,"
-		"  :deliveryNotificationRequired, :displayNotificationRequired,"
-		"  :markedAsRead, :forwardInfo"
-		")", soci::use(eventId), soci::use(fromSipAddressId), soci::use(toSipAddressId),
-		soci::use(messageTime), soci::use(state), soci::use(direction),
-		soci::use(imdnMessageId), soci::use(isSecured),
-		soci::use(deliveryNotificationRequired), soci::use(displayNotificationRequired),
-		soci::use(markedAsRead), soci::use(forwardInfo);
+	shared_ptr<AbstractChatRoom> chatRoom(chatMessage->getChatRoom());
+
+	ChatMessageEventInsertRow chatMessageRow;
+	chatMessageRow.conferenceId = chatRoom->getConferenceId();
+	chatMessageRow.creationTime = eventLog->getCreationTime();
+	chatMessageRow.fromSipAddress = chatMessage->getFromAddress().asString();
+	chatMessageRow.toSipAddress = chatMessage->getToAddress().asString();
+	chatMessageRow.time = chatMessage->getTime();
+	chatMessageRow.state = int(chatMessage->getState());
+	chatMessageRow.direction = int(chatMessage->getDirection());
+	chatMessageRow.imdnMessageId = chatMessage->getImdnMessageId();
+	chatMessageRow.isSecured = chatMessage->isSecured() ? 1 : 0;
+	chatMessageRow.deliveryNotificationRequired = chatMessage->getPrivate()->getPositiveDeliveryNotificationRequired();
+	chatMessageRow.displayNotificationRequired = chatMessage->getPrivate()->getDisplayNotificationRequired();
+	chatMessageRow.markedAsRead = chatMessage->getPrivate()->isMarkedAsRead() ? 1 : 0;
+	chatMessageRow.forwardInfo = chatMessage->getForwardInfo();
+	chatMessage->getPrivate()->dbMarkedAsRead = !!chatMessageRow.markedAsRead;
 
 	for (const Content *content : chatMessage->getContents())
-		insertContent(eventId, *content);
+		chatMessageRow.contents.push_back(getChatMessageContentRow(*content));
+	for (const auto &participant : chatRoom->getParticipants())
+		chatMessageRow.participantSipAddresses.push_back(participant->getAddress().asString());
 
-	shared_ptr<AbstractChatRoom> chatRoom(chatMessage->getChatRoom());
-	for (const auto &participant : chatRoom->getParticipants()) {
-		const long long &participantSipAddressId = selectSipAddressId(participant->getAddress().asString());
-		insertChatMessageParticipant(eventId, participantSipAddressId, state, chatMessage->getTime());
+	return chatMessageRow;
+}
+
+long long MainDbPrivate::insertConferenceChatMessageEvent (const ChatMessageEventInsertRow &chatMessageRow) {
+#ifdef HAVE_DB_STORAGE
+	const long long &eventId = insertConferenceEvent(
+		EventLog::Type::ConferenceChatMessage, chatMessageRow.creationTime, chatMessageRow.conferenceId
+	);
+	if (eventId < 0)
+		return -1;
+
+	const long long &fromSipAddressId = insertSipAddress(chatMessageRow.fromSipAddress);
+	const long long &toSipAddressId = insertSipAddress(chatMessageRow.toSipAddress);
+	const tm &messageTime = Utils::getTimeTAsTm(chatMessageRow.time);
+
+	{
+		PreparedStatement statement(getPreparedStatement(Statements::InsertConferenceChatMessageEvent));
+		statement.execute(
+			soci::use(eventId), soci::use(fromSipAddressId), soci::use(toSipAddressId),
+			soci::use(messageTime), soci::use(chatMessageRow.state), soci::use(chatMessageRow.direction),
+			soci::use(chatMessageRow.imdnMessageId), soci::use(chatMessageRow.isSecured),
+			soci::use(chatMessageRow.deliveryNotificationRequired), soci::use(chatMessageRow.displayNotificationRequired),
+			soci::use(chatMessageRow.markedAsRead), soci::use(chatMessageRow.forwardInfo)
+		);
 	}
 
-	const long long &dbChatRoomId = selectChatRoomId(chatRoom->getConferenceId());
-	*dbSession.getBackendSession() << "UPDATE chat_room SET last_message_id = :1 WHERE id = :2", soci::use(eventId), soci::use(dbChatRoomId);
+	for (const auto &contentRow : chatMessageRow.contents)
+		insertContent(eventId, contentRow);
+
+	for (const auto &participantSipAddress : chatMessageRow.participantSipAddresses) {
+		const long long &participantSipAddressId = selectSipAddressId(participantSipAddress);
+		insertChatMessageParticipant(eventId, participantSipAddressId, chatMessageRow.state, chatMessageRow.time);
+	}
 
-	if (direction == int(ChatMessage::Direction::Incoming) && !markedAsRead) {
-		int *count = unreadChatMessageCountCache[chatRoom->getConferenceId()];
-		if (count)
-			++*count;
+	const long long &dbChatRoomId = selectChatRoomId(chatMessageRow.conferenceId);
+	{
+		PreparedStatement statement(getPreparedStatement(Statements::UpdateChatRoomLastMessageId));
+		statement.execute(soci::use(eventId), soci::use(dbChatRoomId));
 	}
 
+	if (!chatMessageRow.markedAsRead)
+		updateUnreadChatMessageCount(chatMessageRow.conferenceId, dbChatRoomId, 1);
+
 	return eventId;
 #else
 	return -1;
 #endif
 }
 
+void MainDbPrivate::insertConferenceChatMessageEvents (
+	const vector<shared_ptr<EventLog>> &eventLogs,
+	unordered_map<long long, BulkChatRoomUpdate> &chatRoomUpdates,
+	list<pair<shared_ptr<EventLog>, long long>> &insertedEventLogs
+) {
+#ifdef HAVE_DB_STORAGE
+	struct ConferenceEventRow {
+		long long eventId;
+		long long chatRoomId;
+	};
+
+	struct ChatMessageEventRow {
+		long long eventId;
+		long long fromSipAddressId;
+		long long toSipAddressId;
+		tm time;
+		int state;
+		int direction;
+		string imdnMessageId;
+		int isSecured;
+		int deliveryNotificationRequired;
+		int displayNotificationRequired;
+		int markedAsRead;
+		string forwardInfo;
+	};
+
+	struct ChatMessageParticipantRow {
+		long long eventId;
+		long long sipAddressId;
+		int state;
+		tm stateChangeTime;
+	};
+
+	vector<ConferenceEventRow> conferenceEventRows;
+	vector<ChatMessageEventRow> chatMessageEventRows;
+	vector<ChatMessageParticipantRow> chatMessageParticipantRows;
+	vector<pair<shared_ptr<ChatMessage>, long long>> chatMessages;
+
+	// 1. Insert events one by one, their ids are used as keys by all other rows.
+	for (const auto &eventLog : eventLogs) {
+		const ConferenceId &conferenceId = static_pointer_cast<ConferenceEvent>(eventLog)->getConferenceId();
+		const long long &chatRoomId = selectChatRoomId(conferenceId);
+		if (chatRoomId < 0) {
+			lError() << "Unable to find chat room storage id of: " << conferenceId << ".";
+			continue;
+		}
+
+		const long long &eventId = insertEvent(eventLog);
+		conferenceEventRows.push_back({ eventId, chatRoomId });
+
+		shared_ptr<ChatMessage> chatMessage = static_pointer_cast<ConferenceChatMessageEvent>(eventLog)->getChatMessage();
+		const tm &messageTime = Utils::getTimeTAsTm(chatMessage->getTime());
+		const int &state = int(chatMessage->getState());
+		const int &markedAsRead = chatMessage->getPrivate()->isMarkedAsRead() ? 1 : 0;
+		chatMessage->getPrivate()->dbMarkedAsRead = !!markedAsRead;
+		chatMessageEventRows.push_back({
+			eventId,
+			insertSipAddress(chatMessage->getFromAddress().asString()),
+			insertSipAddress(chatMessage->getToAddress().asString()),
+			messageTime,
+			state,
+			int(chatMessage->getDirection()),
+			chatMessage->getImdnMessageId(),
+			chatMessage->isSecured() ? 1 : 0,
+			chatMessage->getPrivate()->getPositiveDeliveryNotificationRequired(),
+			chatMessage->getPrivate()->getDisplayNotificationRequired(),
+			markedAsRead,
+			chatMessage->getForwardInfo()
+		});
+
+		for (const auto &participant : chatMessage->getChatRoom()->getParticipants()) {
+			const long long &participantSipAddressId = selectSipAddressId(participant->getAddress().asString());
+			chatMessageParticipantRows.push_back({ eventId, participantSipAddressId, state, messageTime });
+		}
+
+		BulkChatRoomUpdate &chatRoomUpdate = chatRoomUpdates[chatRoomId];
+		chatRoomUpdate.conferenceId = conferenceId;
+		chatRoomUpdate.lastUpdateTime = eventLog->getCreationTime();
+		chatRoomUpdate.lastMessageId = eventId;
+		if (!markedAsRead)
+			chatRoomUpdate.unreadCount++;
+
+		chatMessages.emplace_back(chatMessage, eventId);
+		insertedEventLogs.emplace_back(eventLog, eventId);
+	}
+
+	// 2. Insert dependent rows with multi-row statements, in foreign keys order.
+	soci::session *session = dbSession.getBackendSession();
+	insertRows(*session, "conference_event", { "event_id", "chat_room_id" }, conferenceEventRows,
+		[](soci::details::prepare_temp_type &statement, const ConferenceEventRow &row) {
+			statement, soci::use(row.eventId), soci::use(row.chatRoomId);
+		}
+	);
+
+	insertRows(*session, "conference_chat_message_event", {
+		"event_id", "from_sip_address_id", "to_sip_address_id",
+		"time", "state", "direction", "imdn_message_id", "is_secured",
+		"delivery_notification_required", "display_notification_required",
+		"marked_as_read", "forward_info"
+	}, chatMessageEventRows,
+		[](soci::details::prepare_temp_type &statement, const ChatMessageEventRow &row) {
+			statement, soci::use(row.eventId), soci::use(row.fromSipAddressId), soci::use(row.toSipAddressId),
+				soci::use(row.time), soci::use(row.state), soci::use(row.direction),
+				soci::use(row.imdnMessageId), soci::use(row.isSecured),
+				soci::use(row.deliveryNotificationRequired), soci::use(row.displayNotificationRequired),
+				soci::use(row.markedAsRead), soci::use(row.forwardInfo);
+		}
+	);
+
+	// Contents carry their own app data and full text search rows, they are not batched.
+	for (const auto &chatMessage : chatMessages) {
+		for (const Content *content : chatMessage.first->getContents())
+			insertContent(chatMessage.second, *content);
+	}
+
+	insertRows(*session, "chat_message_participant", {
+		"event_id", "participant_sip_address_id", "state", "state_change_time"
+	}, chatMessageParticipantRows,
+		[](soci::details::prepare_temp_type &statement, const ChatMessageParticipantRow &row) {
+			statement, soci::use(row.eventId), soci::use(row.sipAddressId), soci::use(row.state),
+				soci::use(row.stateChangeTime);
+		}
+	);
+#endif
+}
+
 void MainDbPrivate::updateConferenceChatMessageEvent (const shared_ptr<EventLog> &eventLog) {
 #ifdef HAVE_DB_STORAGE
 	shared_ptr<ChatMessage> chatMessage = static_pointer_cast<ConferenceChatMessageEvent>(eventLog)->getChatMessage();
@@ -955,12 +1654,9 @@ void MainDbPrivate::updateConferenceChatMessageEvent (const shared_ptr<EventLog>
 	// 2. Update unread chat message count if necessary.
 	const bool isOutgoing = chatMessage->getDirection() == ChatMessage::Direction::Outgoing;
 	shared_ptr<AbstractChatRoom> chatRoom(chatMessage->getChatRoom());
-	if (!isOutgoing && markedAsRead) {
-		int *count = unreadChatMessageCountCache[chatRoom->getConferenceId()];
-		if (count && !dbMarkedAsRead) {
-			L_ASSERT(*count > 0);
-			--*count;
-		}
+	if (markedAsRead != dbMarkedAsRead) {
+		const ConferenceId &conferenceId = chatRoom->getConferenceId();
+		updateUnreadChatMessageCount(conferenceId, selectChatRoomId(conferenceId), markedAsRead ? -1 : 1);
 	}
 
 	// 3. Update chat message event.
@@ -977,9 +1673,9 @@ void MainDbPrivate::updateConferenceChatMessageEvent (const shared_ptr<EventLog>
 		);
 		const int markedAsReadInt = markedAsRead ? 1 : 0;
 
-		*dbSession.getBackendSession() << "UPDATE conference_chat_message_event SET state = :state, imdn_message_id = :imdnMessageId, marked_as_read = :markedAsRead"
-			" WHERE event_id = :eventId",
-			soci::use(stateInt), soci::use(imdnMessageId), soci::use(markedAsReadInt), soci::use(eventId);
+		PreparedStatement statement(getPreparedStatement(Statements::UpdateConferenceChatMessageEvent));
+		statement.execute(soci::use(stateInt), soci::use(imdnMessageId), soci::use(markedAsReadInt), soci::use(eventId));
+		chatMessage->getPrivate()->dbMarkedAsRead = markedAsRead;
 	}
 
 	// 4. Update contents.
@@ -1168,10 +1864,8 @@ void MainDbPrivate::setChatMessageParticipantState (
 	int stateInt = int(state);
 	const tm &stateChangeTm = Utils::getTimeTAsTm(stateChangeTime);
 
-	*dbSession.getBackendSession() << "UPDATE chat_message_participant SET state = :state,"
-		" state_change_time = :stateChangeTm"
-		" WHERE event_id = :eventId AND participant_sip_address_id = :participantSipAddressId",
-		soci::use(stateInt), soci::use(stateChangeTm), soci::use(eventId), soci::use(participantSipAddressId);
+	PreparedStatement statement(getPreparedStatement(Statements::UpdateChatMessageParticipantState));
+	statement.execute(soci::use(stateInt), soci::use(stateChangeTm), soci::use(eventId), soci::use(participantSipAddressId));
 #endif
 }
 
@@ -1251,24 +1945,892 @@ void MainDbPrivate::cache (const ConferenceId &conferenceId, long long storageId
 #endif
 }
 
-void MainDbPrivate::invalidConferenceEventsFromQuery (const string &query, long long chatRoomId) {
+void MainDbPrivate::invalidConferenceEvent (long long eventId) {
+#ifdef HAVE_DB_STORAGE
+	shared_ptr<EventLog> eventLog = getEventFromCache(eventId);
+	if (eventLog) {
+		const EventLogPrivate *dEventLog = eventLog->getPrivate();
+		L_ASSERT(dEventLog->dbKey.isValid());
+		dEventLog->dbKey = MainDbEventKey();
+	}
+	shared_ptr<ChatMessage> chatMessage = getChatMessageFromCache(eventId);
+	if (chatMessage) {
+		const ChatMessagePrivate *dChatMessage = chatMessage->getPrivate();
+		L_ASSERT(dChatMessage->dbKey.isValid());
+		dChatMessage->dbKey = MainDbChatMessageKey();
+	}
+#endif
+}
+
+void MainDbPrivate::invalidConferenceEventsFromQuery (const string &query, long long chatRoomId, list<long long> *eventIds) {
 #ifdef HAVE_DB_STORAGE
 	soci::rowset<soci::row> rows = (dbSession.getBackendSession()->prepare << query, soci::use(chatRoomId));
 	for (const auto &row : rows) {
-		long long eventId = dbSession.resolveId(row, 0);
-		shared_ptr<EventLog> eventLog = getEventFromCache(eventId);
-		if (eventLog) {
-			const EventLogPrivate *dEventLog = eventLog->getPrivate();
-			L_ASSERT(dEventLog->dbKey.isValid());
-			dEventLog->dbKey = MainDbEventKey();
+		const long long &eventId = dbSession.resolveId(row, 0);
+		invalidConferenceEvent(eventId);
+		if (eventIds)
+			eventIds->push_back(eventId);
+	}
+#endif
+}
+
+// Registers events fetched by the async thread, events and chat messages already cached are reused.
+void MainDbPrivate::warmIdCaches () const {
+#ifdef HAVE_DB_STORAGE
+	soci::session *session = dbSession.getBackendSession();
+
+	// Addresses of chat rooms and participants are the ones touched by new events.
+	const string sipAddressesQuery = "SELECT id, value FROM sip_address WHERE id IN ("
+		"  SELECT peer_sip_address_id FROM chat_room"
+		"  UNION SELECT local_sip_address_id FROM chat_room"
+		"  UNION SELECT participant_sip_address_id FROM chat_room_participant"
+		"  UNION SELECT participant_device_sip_address_id FROM chat_room_participant_device"
+		") LIMIT " + Utils::toString(sipAddressIdCache.getCapacity());
+	soci::rowset<soci::row> sipAddresses = (session->prepare << sipAddressesQuery);
+	for (const auto &row : sipAddresses)
+		sipAddressIdCache.insert(row.get<string>(1), dbSession.resolveId(row, 0));
+
+	const string contentTypesQuery = "SELECT id, value FROM content_type LIMIT " +
+		Utils::toString(contentTypeIdCache.getCapacity());
+	soci::rowset<soci::row> contentTypes = (session->prepare << contentTypesQuery);
+	for (const auto &row : contentTypes)
+		contentTypeIdCache.insert(row.get<string>(1), dbSession.resolveId(row, 0));
+
+	lInfo() << "Id caches warmed with " << sipAddressIdCache.getSize() << " sip addresses and " <<
+		contentTypeIdCache.getSize() << " content types.";
+#endif
+}
+
+void MainDbPrivate::endTransaction (bool committed) const {
+	if (committed)
+		for (const auto &delta : uncommittedUnreadCountDeltas)
+			updateUnreadChatMessageCountCache(delta.first, delta.second);
+	uncommittedUnreadCountDeltas.clear();
+
+	if (!idCachesHaveUncommittedIds)
+		return;
+
+	idCachesHaveUncommittedIds = false;
+	if (committed)
+		return;
+
+	// Rows inserted by the transaction were rolled back, their ids may be reused.
+	lInfo() << "Transaction not committed, clear id caches.";
+	sipAddressIdCache.clear();
+	contentTypeIdCache.clear();
+}
+
+// -----------------------------------------------------------------------------
+// Write-behind API.
+// -----------------------------------------------------------------------------
+
+void MainDbPrivate::queueEventUpdate (const shared_ptr<EventLog> &eventLog) {
+#ifdef HAVE_DB_STORAGE
+	const long long &eventId = static_cast<MainDbKey &>(eventLog->getPrivate()->dbKey).getPrivate()->storageId;
+	PendingEventUpdate &pending = pendingEventUpdates[eventId];
+	pending.eventLog = eventLog;
+	if (!pending.updateEvent) {
+		// Keep the stored read state to fold the queued one into the unread counts.
+		shared_ptr<ChatMessage> chatMessage = static_pointer_cast<ConferenceChatMessageEvent>(eventLog)->getChatMessage();
+		pending.conferenceId = chatMessage->getChatRoom()->getConferenceId();
+		pending.dbMarkedAsRead = chatMessage->getPrivate()->dbMarkedAsRead;
+		pending.updateEvent = true;
+		++pendingUpdateCount;
+	}
+	scheduleFlush();
+#endif
+}
+
+void MainDbPrivate::queueChatMessageParticipantState (
+	const shared_ptr<EventLog> &eventLog,
+	const IdentityAddress &participantAddress,
+	ChatMessage::State state,
+	time_t stateChangeTime
+) {
+#ifdef HAVE_DB_STORAGE
+	const long long &eventId = static_cast<MainDbKey &>(eventLog->getPrivate()->dbKey).getPrivate()->storageId;
+	PendingEventUpdate &pending = pendingEventUpdates[eventId];
+	pending.eventLog = eventLog;
+
+	const string &address = participantAddress.asString();
+	auto it = pending.participantStates.find(address);
+	if (it == pending.participantStates.end()) {
+		pending.participantStates.emplace(address, PendingParticipantState{ participantAddress, state, stateChangeTime });
+		++pendingUpdateCount;
+	} else {
+		// Only the latest state of a participant is written.
+		it->second.state = state;
+		it->second.stateChangeTime = stateChangeTime;
+	}
+	scheduleFlush();
+#endif
+}
+
+void MainDbPrivate::scheduleFlush () {
+#ifdef HAVE_DB_STORAGE
+	L_Q();
+
+	if (pendingUpdateCount >= writeBehindBatchSize) {
+		flushPendingUpdates();
+		return;
+	}
+
+	if (!writeBehindTimer)
+		writeBehindTimer = q->getCore()->createTimer([this] () -> bool {
+			flushPendingUpdates();
+			return false;
+		}, writeBehindDelay);
+#endif
+}
+
+void MainDbPrivate::flushPendingUpdates () const {
+#ifdef HAVE_DB_STORAGE
+	L_Q();
+
+	if (writeBehindTimer) {
+		q->getCore()->destroyTimer(writeBehindTimer);
+		writeBehindTimer = nullptr;
+	}
+
+	if (pendingEventUpdates.empty())
+		return;
+
+	unordered_map<long long, PendingEventUpdate> updates;
+	updates.swap(pendingEventUpdates);
+	const size_t updateCount = pendingUpdateCount;
+	pendingUpdateCount = 0;
+
+	MainDbPrivate *d = const_cast<MainDbPrivate *>(this);
+	const bool flushed = L_DB_TRANSACTION_C(q) {
+		for (const auto &entry : updates) {
+			const PendingEventUpdate &pending = entry.second;
+
+			// Event deleted since the update was queued.
+			if (!pending.eventLog->getPrivate()->dbKey.isValid())
+				continue;
+
+			if (pending.updateEvent)
+				d->updateConferenceChatMessageEvent(pending.eventLog);
+			for (const auto &participantState : pending.participantStates) {
+				const PendingParticipantState &state = participantState.second;
+				d->setChatMessageParticipantState(pending.eventLog, state.address, state.state, state.stateChangeTime);
+			}
+		}
+
+		tr.commit();
+		lDebug() << "Flushed " << updateCount << " pending updates of " << updates.size() << " events.";
+	};
+	if (flushed)
+		return;
+
+	// Nothing was written, keep the updates for the next flush.
+	lWarning() << "Unable to flush " << updateCount << " pending updates, retry later.";
+	for (const auto &entry : updates) {
+		if (entry.second.updateEvent)
+			static_pointer_cast<ConferenceChatMessageEvent>(entry.second.eventLog)->getChatMessage()->getPrivate()->dbMarkedAsRead =
+				entry.second.dbMarkedAsRead;
+	}
+	pendingEventUpdates.swap(updates);
+	pendingUpdateCount = updateCount;
+	writeBehindTimer = q->getCore()->createTimer([this] () -> bool {
+		flushPendingUpdates();
+		return false;
+	}, writeBehindDelay);
+#endif
+}
+
+const MainDbPrivate::PendingParticipantState *MainDbPrivate::findPendingChatMessageParticipantState (
+	long long eventId,
+	const IdentityAddress &participantAddress
+) const {
+	auto it = pendingEventUpdates.find(eventId);
+	if (it == pendingEventUpdates.cend())
+		return nullptr;
+
+	auto stateIt = it->second.participantStates.find(participantAddress.asString());
+	return stateIt == it->second.participantStates.cend() ? nullptr : &stateIt->second;
+}
+
+bool MainDbPrivate::isPendingMarkedAsRead (long long eventId) const {
+	auto it = pendingEventUpdates.find(eventId);
+	if (it == pendingEventUpdates.cend() || !it->second.updateEvent)
+		return false;
+
+	shared_ptr<ChatMessage> chatMessage = static_pointer_cast<ConferenceChatMessageEvent>(it->second.eventLog)->getChatMessage();
+	return chatMessage->getPrivate()->isMarkedAsRead();
+}
+
+unordered_map<ConferenceId, int> MainDbPrivate::getPendingUnreadChatMessageCountDeltas () const {
+	unordered_map<ConferenceId, int> deltas;
+	for (const auto &entry : pendingEventUpdates) {
+		const PendingEventUpdate &pending = entry.second;
+		if (!pending.updateEvent)
+			continue;
+
+		shared_ptr<ChatMessage> chatMessage = static_pointer_cast<ConferenceChatMessageEvent>(pending.eventLog)->getChatMessage();
+		const bool markedAsRead = chatMessage->getPrivate()->isMarkedAsRead();
+		if (markedAsRead != pending.dbMarkedAsRead)
+			deltas[pending.conferenceId] += markedAsRead ? -1 : 1;
+	}
+	return deltas;
+}
+
+// -----------------------------------------------------------------------------
+// Async API.
+// -----------------------------------------------------------------------------
+
+string MainDbPrivate::getHistoryRangeQuery (int begin, int end, MainDb::FilterMask mask) const {
+#ifdef HAVE_DB_STORAGE
+	string query = Statements::get(Statements::SelectConferenceEvents) + buildSqlEventFilter({
+		MainDb::ConferenceCallFilter, MainDb::ConferenceChatMessageFilter,
+		MainDb::ConferenceInfoFilter, MainDb::ConferenceInfoNoDeviceFilter
+	}, mask, "AND");
+	query += " ORDER BY event_id DESC";
+
+	if (end > 0)
+		query += " LIMIT " + Utils::toString(end - begin);
+	else
+		query += " LIMIT " + dbSession.noLimitValue();
+
+	if (begin > 0)
+		query += " OFFSET " + Utils::toString(begin);
+
+	return query;
+#else
+	return "";
+#endif
+}
+
+MainDbPrivate::~MainDbPrivate () {
+	stopAsyncThread();
+}
+
+// The task is run by the async thread and must only use plain values. The completion is run by the main loop
+// once the task is done, tasks being executed in order.
+void MainDbPrivate::runAsync (const function<void (MainDb &)> &task, const function<void ()> &completion) const {
+	L_Q();
+
+	{
+		lock_guard<mutex> lock(asyncMutex);
+		asyncTasks.push_back(task);
+	}
+	asyncCondition.notify_one();
+
+	// The main loop is not thread safe, the async thread only counts the done tasks and they are polled here.
+	asyncCompletions.push_back(completion);
+	if (!asyncCompletionTimer)
+		asyncCompletionTimer = q->getCore()->createTimer([this] () -> bool {
+			return processAsyncCompletions();
+		}, AsyncCompletionPollInterval);
+}
+
+bool MainDbPrivate::processAsyncCompletions () const {
+	L_Q();
+
+	unsigned int doneTaskCount;
+	{
+		lock_guard<mutex> lock(asyncMutex);
+		doneTaskCount = asyncDoneTaskCount;
+		asyncDoneTaskCount = 0;
+	}
+	for (; doneTaskCount > 0 && !asyncCompletions.empty(); doneTaskCount--) {
+		function<void ()> completion = move(asyncCompletions.front());
+		asyncCompletions.pop_front();
+		if (completion)
+			completion();
+	}
+
+	if (!asyncCompletions.empty())
+		return true;
+
+	q->getCore()->destroyTimer(asyncCompletionTimer);
+	asyncCompletionTimer = nullptr;
+	return false;
+}
+
+void MainDbPrivate::runAsyncLoop () {
+	for (;;) {
+		function<void (MainDb &)> task;
+		{
+			unique_lock<mutex> lock(asyncMutex);
+			asyncCondition.wait(lock, [this] { return asyncThreadStopped || !asyncTasks.empty(); });
+
+			// Queued tasks are executed before stopping.
+			if (asyncTasks.empty())
+				return;
+
+			task = move(asyncTasks.front());
+			asyncTasks.pop_front();
+		}
+		task(*asyncMainDb);
+		task = nullptr;
+
+		lock_guard<mutex> lock(asyncMutex);
+		asyncDoneTaskCount++;
+	}
+}
+
+void MainDbPrivate::stopAsyncThread () {
+	if (!asyncThread.joinable())
+		return;
+
+	{
+		lock_guard<mutex> lock(asyncMutex);
+		asyncThreadStopped = true;
+	}
+	asyncCondition.notify_one();
+	asyncThread.join();
+
+	asyncMainDb->disconnect();
+	asyncMainDb = nullptr;
+
+	// Completions not run yet are dropped, their callbacks are never called.
+	if (!asyncCompletions.empty())
+		lWarning() << "Drop " << asyncCompletions.size() << " completions of MainDb async calls.";
+	asyncCompletions.clear();
+	asyncDoneTaskCount = 0;
+	if (asyncCompletionTimer) {
+		L_Q();
+		q->getCore()->destroyTimer(asyncCompletionTimer);
+		asyncCompletionTimer = nullptr;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Retention API.
+// -----------------------------------------------------------------------------
+
+void MainDbPrivate::startRetention () {
+#ifdef HAVE_DB_STORAGE
+	L_Q();
+
+	if (retentionTimer || (!retentionMaxAge && !retentionMaxEventsPerChatRoom))
+		return;
+
+	// Databases created without incremental auto vacuum keep their free pages, a blocking full VACUUM
+	// would be required to switch them.
+	retentionIncrementalVacuum = false;
+	if (q->getBackend() == MainDb::Backend::Sqlite3) {
+		try {
+			int autoVacuum = 0;
+			*dbSession.getBackendSession() << "PRAGMA auto_vacuum", soci::into(autoVacuum);
+			retentionIncrementalVacuum = autoVacuum == 2;
+		} catch (const soci::soci_error &e) {
+			lWarning() << "Unable to get auto vacuum mode (" << e.what() << ").";
+		}
+		if (!retentionIncrementalVacuum)
+			lInfo() << "Incremental vacuum is not enabled on this database, free pages are not released.";
+	}
+
+	retentionStep = RetentionStep::Idle;
+	retentionTimer = q->getCore()->createTimer([this] () -> bool {
+		const bool finished = runRetentionStep();
+		belle_sip_source_set_timeout(retentionTimer, finished ? retentionPassInterval * 1000 : retentionStepInterval);
+		return true;
+	}, retentionStepInterval);
+#endif
+}
+
+void MainDbPrivate::stopRetention () {
+#ifdef HAVE_DB_STORAGE
+	L_Q();
+
+	if (!retentionTimer)
+		return;
+
+	q->getCore()->destroyTimer(retentionTimer);
+	retentionTimer = nullptr;
+	retentionStep = RetentionStep::Idle;
+	retentionChatRoomIds.clear();
+#endif
+}
+
+void MainDbPrivate::startRetentionPass () {
+#ifdef HAVE_DB_STORAGE
+	L_Q();
+
+	retentionLimitTime = retentionMaxAge ? time(nullptr) - time_t(retentionMaxAge) * 24 * 3600 : 0;
+	retentionSipAddressCursor = 0;
+	retentionDeletedEventCount = 0;
+
+	retentionChatRoomIds.clear();
+	if (retentionMaxEventsPerChatRoom) {
+		L_DB_TRANSACTION_C(q) {
+			soci::rowset<soci::row> rows = (dbSession.getBackendSession()->prepare << "SELECT id FROM chat_room");
+			for (const auto &row : rows)
+				retentionChatRoomIds.push_back(dbSession.resolveId(row, 0));
+			tr.commit();
+		};
+	}
+
+	lInfo() << "Start history retention pass.";
+	retentionStep = RetentionStep::ExpiredEvents;
+#endif
+}
+
+bool MainDbPrivate::runRetentionStep () {
+#ifdef HAVE_DB_STORAGE
+	L_Q();
+
+	if (retentionStep == RetentionStep::Idle)
+		startRetentionPass();
+
+	const chrono::steady_clock::time_point end = chrono::steady_clock::now() +
+		chrono::milliseconds(retentionStepDuration);
+	do {
+		if (runRetentionBatch())
+			continue;
+
+		switch (retentionStep) {
+			case RetentionStep::Idle:
+				break;
+			case RetentionStep::ExpiredEvents:
+				retentionStep = RetentionStep::ChatRoomEvents;
+				break;
+			case RetentionStep::ChatRoomEvents:
+				retentionStep = RetentionStep::SipAddresses;
+				break;
+			case RetentionStep::SipAddresses:
+				retentionStep = RetentionStep::ContentTypes;
+				break;
+			case RetentionStep::ContentTypes:
+				retentionStep = retentionIncrementalVacuum ? RetentionStep::Vacuum : RetentionStep::Idle;
+				break;
+			case RetentionStep::Vacuum:
+				retentionStep = RetentionStep::Idle;
+				break;
+		}
+	} while (retentionStep != RetentionStep::Idle && chrono::steady_clock::now() < end);
+
+	if (retentionStep != RetentionStep::Idle)
+		return false;
+
+	lInfo() << "History retention pass finished, " << retentionDeletedEventCount << " events deleted.";
+	return true;
+#else
+	return true;
+#endif
+}
+
+bool MainDbPrivate::runRetentionBatch () {
+#ifdef HAVE_DB_STORAGE
+	L_Q();
+
+	soci::session *session = dbSession.getBackendSession();
+	const unsigned int batchSize = max(retentionBatchSize, 1u);
+	const string limit = " LIMIT " + Utils::toString(batchSize);
+
+	switch (retentionStep) {
+		case RetentionStep::Idle:
+			return false;
+
+		case RetentionStep::ExpiredEvents: {
+			if (!retentionMaxAge)
+				return false;
+
+			const string query = "SELECT conference_event.event_id, conference_event.chat_room_id"
+				"  FROM conference_event, event"
+				"  WHERE event.id = conference_event.event_id AND event.creation_time < :limitTime" + limit;
+			const tm &limitTime = Utils::getTimeTAsTm(retentionLimitTime);
+
+			return L_DB_TRANSACTION_C(q) {
+				list<pair<long long, long long>> eventIds;
+				soci::rowset<soci::row> rows = (session->prepare << query, soci::use(limitTime));
+				for (const auto &row : rows)
+					eventIds.emplace_back(dbSession.resolveId(row, 0), dbSession.resolveId(row, 1));
+
+				const size_t count = deleteConferenceEvents(eventIds);
+				tr.commit();
+				retentionDeletedEventCount += count;
+				return count >= batchSize;
+			};
+		}
+
+		case RetentionStep::ChatRoomEvents: {
+			if (retentionChatRoomIds.empty())
+				return false;
+
+			// Events older than the last kept one are deleted, oldest first.
+			const string lastEventQuery = "SELECT event_id FROM conference_event WHERE chat_room_id = :chatRoomId"
+				"  ORDER BY event_id DESC LIMIT 1 OFFSET " + Utils::toString(retentionMaxEventsPerChatRoom);
+			const string query = "SELECT event_id, chat_room_id FROM conference_event"
+				"  WHERE chat_room_id = :chatRoomId AND event_id <= :lastEventId"
+				"  ORDER BY event_id" + limit;
+			const long long chatRoomId = retentionChatRoomIds.front();
+
+			// On error, the chat room is skipped until the next pass.
+			const bool chatRoomHasMoreEvents = L_DB_TRANSACTION_C(q) {
+				long long lastEventId;
+				*session << lastEventQuery, soci::into(lastEventId), soci::use(chatRoomId);
+				if (!session->got_data()) {
+					tr.commit();
+					return false;
+				}
+
+				list<pair<long long, long long>> eventIds;
+				soci::rowset<soci::row> rows = (session->prepare << query, soci::use(chatRoomId), soci::use(lastEventId));
+				for (const auto &row : rows)
+					eventIds.emplace_back(dbSession.resolveId(row, 0), dbSession.resolveId(row, 1));
+
+				const size_t count = deleteConferenceEvents(eventIds);
+				tr.commit();
+				retentionDeletedEventCount += count;
+				return count >= batchSize;
+			};
+			if (!chatRoomHasMoreEvents)
+				retentionChatRoomIds.pop_front();
+			return true;
 		}
-		shared_ptr<ChatMessage> chatMessage = getChatMessageFromCache(eventId);
-		if (chatMessage) {
-			const ChatMessagePrivate *dChatMessage = chatMessage->getPrivate();
-			L_ASSERT(dChatMessage->dbKey.isValid());
-			dChatMessage->dbKey = MainDbChatMessageKey();
+
+		case RetentionStep::SipAddresses: {
+			const string query = "SELECT id FROM sip_address WHERE id > :cursor ORDER BY id" + limit;
+
+			return L_DB_TRANSACTION_C(q) {
+				long long lastId = -1;
+				soci::rowset<soci::row> rows = (session->prepare << query, soci::use(retentionSipAddressCursor));
+				for (const auto &row : rows)
+					lastId = dbSession.resolveId(row, 0);
+				if (lastId < 0)
+					return false;
+
+				deleteOrphanSipAddresses(retentionSipAddressCursor, lastId);
+				tr.commit();
+				retentionSipAddressCursor = lastId;
+				return true;
+			};
 		}
+
+		case RetentionStep::ContentTypes:
+			L_DB_TRANSACTION_C(q) {
+				deleteOrphanContentTypes();
+				tr.commit();
+			};
+			return false;
+
+		case RetentionStep::Vacuum:
+			return L_DB_TRANSACTION_C(q) {
+				const bool freePagesRemain = incrementalVacuum();
+				tr.commit();
+				return freePagesRemain;
+			};
+	}
+
+	return false;
+#else
+	return false;
+#endif
+}
+
+size_t MainDbPrivate::deleteConferenceEvents (const list<pair<long long, long long>> &eventIds) {
+#ifdef HAVE_DB_STORAGE
+	if (eventIds.empty())
+		return 0;
+
+	soci::session *session = dbSession.getBackendSession();
+
+	vector<string> ids;
+	unordered_set<long long> chatRoomIds;
+	for (const auto &eventId : eventIds) {
+		invalidConferenceEvent(eventId.first);
+		ids.push_back(Utils::toString(eventId.first));
+		chatRoomIds.insert(eventId.second);
 	}
+	const string idList = Utils::join(ids, ",");
+
+	// Deleted messages must not be counted as unread anymore.
+	for (const auto &chatRoomId : chatRoomIds) {
+		int unreadCount = 0;
+		*session << "SELECT COUNT(*) FROM conference_chat_message_event, conference_event"
+			"  WHERE conference_chat_message_event.event_id = conference_event.event_id"
+			"  AND conference_event.chat_room_id = :chatRoomId AND marked_as_read = 0"
+			"  AND conference_event.event_id IN (" + idList + ")",
+			soci::into(unreadCount), soci::use(chatRoomId);
+		if (unreadCount > 0)
+			updateUnreadChatMessageCount(selectConferenceId(chatRoomId), chatRoomId, -unreadCount);
+	}
+
+	*session << "DELETE FROM event WHERE id IN (" + idList + ")";
+	*session << "UPDATE chat_room SET last_message_id = IFNULL((SELECT id FROM conference_event_simple_view"
+		"  WHERE chat_room_id = chat_room.id AND type = " << mapEventFilterToSql(MainDb::ConferenceChatMessageFilter) <<
+		"  ORDER BY id DESC LIMIT 1), 0)"
+		"  WHERE last_message_id IN (" + idList + ")";
+
+	return eventIds.size();
+#else
+	return 0;
+#endif
+}
+
+// Every subquery is covered by an index leading with its sip address column, see the 1.0.14 schema update.
+size_t MainDbPrivate::deleteOrphanSipAddresses (long long firstId, long long lastId) {
+#ifdef HAVE_DB_STORAGE
+	static const string query = "DELETE FROM sip_address WHERE id > :firstId AND id <= :lastId"
+		"  AND NOT EXISTS (SELECT 1 FROM chat_room WHERE peer_sip_address_id = sip_address.id)"
+		"  AND NOT EXISTS (SELECT 1 FROM chat_room WHERE local_sip_address_id = sip_address.id)"
+		"  AND NOT EXISTS (SELECT 1 FROM one_to_one_chat_room WHERE participant_a_sip_address_id = sip_address.id)"
+		"  AND NOT EXISTS (SELECT 1 FROM one_to_one_chat_room WHERE participant_b_sip_address_id = sip_address.id)"
+		"  AND NOT EXISTS (SELECT 1 FROM chat_room_participant WHERE participant_sip_address_id = sip_address.id)"
+		"  AND NOT EXISTS ("
+		"    SELECT 1 FROM chat_room_participant_device WHERE participant_device_sip_address_id = sip_address.id"
+		"  )"
+		"  AND NOT EXISTS (SELECT 1 FROM conference_participant_event WHERE participant_sip_address_id = sip_address.id)"
+		"  AND NOT EXISTS (SELECT 1 FROM conference_participant_device_event WHERE device_sip_address_id = sip_address.id)"
+		"  AND NOT EXISTS (SELECT 1 FROM conference_chat_message_event WHERE from_sip_address_id = sip_address.id)"
+		"  AND NOT EXISTS (SELECT 1 FROM conference_chat_message_event WHERE to_sip_address_id = sip_address.id)"
+		"  AND NOT EXISTS (SELECT 1 FROM chat_message_participant WHERE participant_sip_address_id = sip_address.id)"
+		"  AND NOT EXISTS (SELECT 1 FROM friend WHERE sip_address_id = sip_address.id)"
+		"  AND NOT EXISTS (SELECT 1 FROM server_queued_chat_message WHERE from_sip_address_id = sip_address.id)"
+		"  AND NOT EXISTS ("
+		"    SELECT 1 FROM server_queued_chat_message_device WHERE device_sip_address_id = sip_address.id"
+		"  )";
+
+	soci::statement statement = (
+		dbSession.getBackendSession()->prepare << query, soci::use(firstId), soci::use(lastId)
+	);
+	statement.execute(true);
+	const size_t count = size_t(statement.get_affected_rows());
+	if (count == 0)
+		return 0;
+
+	// Ids of deleted rows may be reused. An insertion using a stale id of the async thread fails and clears its caches.
+	sipAddressIdCache.clear();
+	if (asyncMainDb)
+		runAsync([](MainDb &mainDb) {
+			mainDb.getPrivate()->sipAddressIdCache.clear();
+		});
+
+	lDebug() << "Deleted " << count << " orphan sip addresses.";
+	return count;
+#else
+	return 0;
+#endif
+}
+
+size_t MainDbPrivate::deleteOrphanContentTypes () {
+#ifdef HAVE_DB_STORAGE
+	static const string query = "DELETE FROM content_type"
+		"  WHERE NOT EXISTS (SELECT 1 FROM chat_message_content WHERE content_type_id = content_type.id)"
+		"  AND NOT EXISTS (SELECT 1 FROM server_queued_chat_message WHERE content_type_id = content_type.id)";
+
+	soci::statement statement = (dbSession.getBackendSession()->prepare << query);
+	statement.execute(true);
+	const size_t count = size_t(statement.get_affected_rows());
+	if (count == 0)
+		return 0;
+
+	contentTypeIdCache.clear();
+	if (asyncMainDb)
+		runAsync([](MainDb &mainDb) {
+			mainDb.getPrivate()->contentTypeIdCache.clear();
+		});
+
+	lDebug() << "Deleted " << count << " orphan content types.";
+	return count;
+#else
+	return 0;
+#endif
+}
+
+bool MainDbPrivate::incrementalVacuum () {
+#ifdef HAVE_DB_STORAGE
+	if (!retentionIncrementalVacuum)
+		return false;
+
+	soci::session *session = dbSession.getBackendSession();
+
+	int freePageCount = 0;
+	*session << "PRAGMA freelist_count", soci::into(freePageCount);
+	if (freePageCount <= 0)
+		return false;
+
+	// One page is released by each execution, the step duration is checked between batches.
+	const int pageCount = min(freePageCount, int(max(retentionVacuumPages, 1u)));
+	soci::statement statement = (session->prepare << "PRAGMA incremental_vacuum(1)");
+	for (int i = 0; i < pageCount; ++i)
+		statement.execute(true);
+
+	return freePageCount > pageCount;
+#else
+	return false;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// Server queued messages.
+// -----------------------------------------------------------------------------
+
+#ifdef HAVE_DB_STORAGE
+static string serializeServerQueuedChatMessageHeaders (const list<pair<string, string>> &headers) {
+	string result;
+	for (const auto &header : headers)
+		result += header.first + ": " + header.second + "\n";
+	return result;
+}
+
+static list<pair<string, string>> parseServerQueuedChatMessageHeaders (const string &headers) {
+	list<pair<string, string>> result;
+	istringstream stream(headers);
+	string line;
+	while (getline(stream, line)) {
+		const size_t separator = line.find(": ");
+		if (separator != string::npos)
+			result.emplace_back(line.substr(0, separator), line.substr(separator + 2));
+	}
+	return result;
+}
+
+template<typename T>
+static void insertServerQueuedChatMessage (
+	soci::session *session,
+	long long chatRoomId,
+	long long fromSipAddressId,
+	long long contentTypeId,
+	T &body,
+	const string &headers,
+	const tm &creationTime
+) {
+	*session << "INSERT INTO server_queued_chat_message"
+		"  (chat_room_id, from_sip_address_id, content_type_id, body, headers, creation_time) VALUES"
+		"  (:chatRoomId, :fromSipAddressId, :contentTypeId, :body, :headers, :creationTime)",
+		soci::use(chatRoomId), soci::use(fromSipAddressId), soci::use(contentTypeId),
+		soci::use(body), soci::use(headers), soci::use(creationTime);
+}
+
+template<typename T>
+static list<MainDb::ServerQueuedChatMessage> fetchServerQueuedChatMessages (
+	soci::session *session,
+	const string &query,
+	long long chatRoomId,
+	long long deviceSipAddressId,
+	const tm &limitTime,
+	T &body
+) {
+	list<MainDb::ServerQueuedChatMessage> messages;
+
+	string fromAddress, contentType, headers;
+	tm creationTime;
+	soci::statement statement = (session->prepare << query,
+		soci::use(chatRoomId), soci::use(deviceSipAddressId), soci::use(limitTime),
+		soci::into(fromAddress), soci::into(contentType), soci::into(body), soci::into(headers), soci::into(creationTime)
+	);
+	statement.execute();
+	while (statement.fetch()) {
+		MainDb::ServerQueuedChatMessage message;
+		message.fromAddress = IdentityAddress(fromAddress);
+		message.content.setContentType(ContentType(contentType));
+		message.content.setBody(blobToString(body));
+		message.headers = parseServerQueuedChatMessageHeaders(headers);
+		message.creationTime = Utils::getTmAsTimeT(creationTime);
+		messages.push_back(move(message));
+	}
+	return messages;
+}
+#endif
+
+bool MainDbPrivate::trimServerQueuedChatMessages (long long chatRoomId, long long deviceSipAddressId) {
+#ifdef HAVE_DB_STORAGE
+	if (!serverQueuedMessageMaxPerDevice)
+		return false;
+
+	soci::session *session = dbSession.getBackendSession();
+
+	long long firstDroppedMessageId;
+	*session << "SELECT message_id FROM server_queued_chat_message_device"
+		"  WHERE chat_room_id = :chatRoomId AND device_sip_address_id = :deviceSipAddressId"
+		"  ORDER BY message_id DESC LIMIT 1 OFFSET " + Utils::toString(serverQueuedMessageMaxPerDevice),
+		soci::use(chatRoomId), soci::use(deviceSipAddressId), soci::into(firstDroppedMessageId);
+	if (!session->got_data())
+		return false;
+
+	*session << "DELETE FROM server_queued_chat_message_device"
+		"  WHERE chat_room_id = :chatRoomId AND device_sip_address_id = :deviceSipAddressId"
+		"  AND message_id <= :firstDroppedMessageId",
+		soci::use(chatRoomId), soci::use(deviceSipAddressId), soci::use(firstDroppedMessageId);
+	return true;
+#else
+	return false;
+#endif
+}
+
+void MainDbPrivate::deleteOrphanServerQueuedChatMessages (long long chatRoomId) {
+#ifdef HAVE_DB_STORAGE
+	*dbSession.getBackendSession() << "DELETE FROM server_queued_chat_message WHERE chat_room_id = :chatRoomId"
+		"  AND NOT EXISTS ("
+		"    SELECT 1 FROM server_queued_chat_message_device"
+		"    WHERE message_id = server_queued_chat_message.id"
+		"  )", soci::use(chatRoomId);
+#endif
+}
+
+void MainDbPrivate::startServerQueuedChatMessageExpiry () {
+#ifdef HAVE_DB_STORAGE
+	L_Q();
+
+	if (serverQueuedMessageExpiryTimer || !serverQueuedMessageTtl)
+		return;
+
+	// The first pass runs shortly after startup to drop the messages which expired while the server was down.
+	serverQueuedMessageExpiryTimer = q->getCore()->createTimer([this] () -> bool {
+		L_Q();
+		const bool finished = q->deleteExpiredServerQueuedChatMessages() < int(max(retentionBatchSize, 1u));
+		belle_sip_source_set_timeout(
+			serverQueuedMessageExpiryTimer,
+			finished ? max(serverQueuedMessageExpiryInterval, 1u) * 1000 : retentionStepInterval
+		);
+		return true;
+	}, retentionStepInterval);
+#endif
+}
+
+void MainDbPrivate::stopServerQueuedChatMessageExpiry () {
+#ifdef HAVE_DB_STORAGE
+	L_Q();
+
+	if (!serverQueuedMessageExpiryTimer)
+		return;
+
+	q->getCore()->destroyTimer(serverQueuedMessageExpiryTimer);
+	serverQueuedMessageExpiryTimer = nullptr;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// Chat rooms.
+// -----------------------------------------------------------------------------
+
+void MainDbPrivate::cleanHistory (const ConferenceId &conferenceId, MainDb::FilterMask mask, list<long long> *eventIds) {
+#ifdef HAVE_DB_STORAGE
+	L_Q();
+
+	const string query = "SELECT event_id FROM conference_event WHERE chat_room_id = :chatRoomId" +
+		buildSqlEventFilter({
+			MainDb::ConferenceCallFilter, MainDb::ConferenceChatMessageFilter,
+			MainDb::ConferenceInfoFilter, MainDb::ConferenceInfoNoDeviceFilter
+		}, mask);
+
+	const string query2 = "UPDATE chat_room SET last_message_id = 0 WHERE id = :1";
+
+	/*
+	DurationLogger durationLogger(
+		"Clean history of: (peer=" + conferenceId.getPeerAddress().asString() +
+		", local=" + conferenceId.getLocalAddress().asString() +
+		", mask=" + Utils::toString(mask) + ")."
+	);
+	*/
+
+	L_DB_TRANSACTION_C(q) {
+		if (eventIds)
+			eventIds->clear();
+
+		const long long &dbChatRoomId = selectChatRoomId(conferenceId);
+
+		invalidConferenceEventsFromQuery(query, dbChatRoomId, eventIds);
+		*dbSession.getBackendSession() << "DELETE FROM event WHERE id IN (" + query + ")", soci::use(dbChatRoomId);
+		*dbSession.getBackendSession() << query2, soci::use(dbChatRoomId);
+		if (!mask || (mask & MainDb::ConferenceChatMessageFilter))
+			updateUnreadChatMessageCount(conferenceId, dbChatRoomId, -selectUnreadChatMessageCount(dbChatRoomId));
+		tr.commit();
+	};
 #endif
 }
 
@@ -1405,6 +2967,101 @@ void MainDbPrivate::updateSchema () {
 		*session << "ALTER TABLE chat_room ADD COLUMN last_message_id " + dbSession.primaryKeyRefStr("BIGINT UNSIGNED") + " NOT NULL DEFAULT 0";
 		*session << "UPDATE chat_room SET last_message_id = IFNULL((SELECT id FROM conference_event_simple_view WHERE chat_room_id = chat_room.id AND type = 5 ORDER BY id DESC LIMIT 1), 0)";
 	}
+
+	if (version < makeVersion(1, 0, 12))
+		*session << "CREATE INDEX conference_event_chat_room_index ON conference_event (chat_room_id, event_id)";
+
+	if (version < makeVersion(1, 0, 13)) {
+		*session << "ALTER TABLE chat_room ADD COLUMN unread_count INT NOT NULL DEFAULT 0";
+		*session << "UPDATE chat_room SET unread_count = ("
+			"  SELECT COUNT(*) FROM conference_event"
+			"  JOIN conference_chat_message_event ON conference_chat_message_event.event_id = conference_event.event_id"
+			"  WHERE conference_event.chat_room_id = chat_room.id AND marked_as_read = 0"
+			")";
+	}
+
+	if (version < makeVersion(1, 0, 14)) {
+		*session << "CREATE INDEX event_creation_time_index ON event (creation_time)";
+
+		// Used to find orphaned sip addresses and content types. MySQL indexes foreign keys itself.
+		if (q->getBackend() == MainDb::Backend::Sqlite3) {
+			*session << "CREATE INDEX conference_chat_message_event_from_index ON conference_chat_message_event (from_sip_address_id)";
+			*session << "CREATE INDEX conference_chat_message_event_to_index ON conference_chat_message_event (to_sip_address_id)";
+			*session << "CREATE INDEX chat_message_participant_sip_address_index ON chat_message_participant (participant_sip_address_id)";
+			*session << "CREATE INDEX chat_message_content_content_type_index ON chat_message_content (content_type_id)";
+			*session << "CREATE INDEX conference_participant_event_sip_address_index ON conference_participant_event (participant_sip_address_id)";
+			*session << "CREATE INDEX conference_participant_device_event_sip_address_index ON conference_participant_device_event (device_sip_address_id)";
+			*session << "CREATE INDEX chat_room_local_sip_address_index ON chat_room (local_sip_address_id)";
+			*session << "CREATE INDEX one_to_one_chat_room_participant_a_index ON one_to_one_chat_room (participant_a_sip_address_id)";
+			*session << "CREATE INDEX one_to_one_chat_room_participant_b_index ON one_to_one_chat_room (participant_b_sip_address_id)";
+			*session << "CREATE INDEX chat_room_participant_sip_address_index ON chat_room_participant (participant_sip_address_id)";
+			*session << "CREATE INDEX chat_room_participant_device_sip_address_index ON chat_room_participant_device (participant_device_sip_address_id)";
+			*session << "CREATE INDEX friend_sip_address_index ON friend (sip_address_id)";
+		}
+	}
+
+	if (version < makeVersion(1, 0, 15)) {
+		*session << "CREATE INDEX server_queued_chat_message_creation_time_index ON server_queued_chat_message (creation_time)";
+
+		if (q->getBackend() == MainDb::Backend::Sqlite3) {
+			*session << "CREATE INDEX server_queued_chat_message_chat_room_index ON server_queued_chat_message (chat_room_id)";
+			*session << "CREATE INDEX server_queued_chat_message_from_index ON server_queued_chat_message (from_sip_address_id)";
+			*session << "CREATE INDEX server_queued_chat_message_content_type_index ON server_queued_chat_message (content_type_id)";
+			*session << "CREATE INDEX server_queued_chat_message_device_sip_address_index ON server_queued_chat_message_device (device_sip_address_id)";
+			*session << "CREATE INDEX server_queued_chat_message_device_message_index ON server_queued_chat_message_device (message_id)";
+		}
+	}
+#endif
+}
+
+void MainDbPrivate::updateFullTextSearchIndex () {
+#ifdef HAVE_DB_STORAGE
+	L_Q();
+
+	soci::session *session = dbSession.getBackendSession();
+
+	int count = 0;
+	if (q->getBackend() == MainDb::Backend::Mysql) {
+		*session << "SELECT COUNT(*) FROM information_schema.statistics"
+			"  WHERE table_schema = DATABASE() AND table_name = 'chat_message_content'"
+			"  AND index_name = 'chat_message_content_body_index'", soci::into(count);
+
+		// The FULLTEXT index is maintained by the server itself.
+		if (fullTextSearchEnabled && count == 0)
+			*session << "ALTER TABLE chat_message_content ADD FULLTEXT INDEX chat_message_content_body_index (body)";
+		else if (!fullTextSearchEnabled && count > 0)
+			*session << "ALTER TABLE chat_message_content DROP INDEX chat_message_content_body_index";
+		return;
+	}
+
+	*session << "SELECT COUNT(*) FROM sqlite_master WHERE type = 'table' AND name = 'chat_message_content_fts'",
+		soci::into(count);
+
+	// Drop the index when disabled, it would not be maintained anymore.
+	if (!fullTextSearchEnabled) {
+		if (count > 0) {
+			*session << "DROP TRIGGER IF EXISTS chat_message_content_fts_delete";
+			*session << "DROP TABLE chat_message_content_fts";
+		}
+		return;
+	}
+
+	if (count > 0)
+		return;
+
+	// Rows are inserted by insertContent, the trigger handles deletions cascaded from events.
+	*session << "CREATE VIRTUAL TABLE chat_message_content_fts USING fts5(body)";
+	*session << "CREATE TRIGGER IF NOT EXISTS chat_message_content_fts_delete"
+		"  AFTER DELETE ON chat_message_content"
+		"  BEGIN"
+		"    DELETE FROM chat_message_content_fts WHERE rowid = old.id;"
+		"  END";
+
+	const string &contentType = ContentType::PlainText.getMediaType();
+	*session << "INSERT INTO chat_message_content_fts (rowid, body)"
+		"  SELECT chat_message_content.id, body FROM chat_message_content"
+		"  JOIN content_type ON content_type.id = content_type_id"
+		"  WHERE content_type.value = :contentType", soci::use(contentType);
 #endif
 }
 
@@ -1676,11 +3333,25 @@ void MainDb::init () {
 #ifdef HAVE_DB_STORAGE
 	L_D();
 
+	// The connection of the async thread uses the schema created by the main one.
+	if (d->isAsyncWorker) {
+		d->warmIdCaches();
+		return;
+	}
+
 	Backend backend = getBackend();
 
 	const string charset = backend == Mysql ? "DEFAULT CHARSET=utf8mb4" : "";
 	soci::session *session = d->dbSession.getBackendSession();
 
+	// Schema may change below, drop statements prepared against the previous one.
+	d->dbSession.getPreparedStatementCache().clear();
+
+	// Free pages of a new database are released by the retention incremental vacuum.
+	// The mode is only applied if it is set before the first table is created.
+	if (backend == Sqlite3)
+		*session << "PRAGMA auto_vacuum = INCREMENTAL";
+
 	using namespace placeholders;
 	auto primaryKeyRefStr = bind(&DbSession::primaryKeyRefStr, &d->dbSession, _1);
 	auto primaryKeyStr = bind(&DbSession::primaryKeyStr, &d->dbSession, _1);
@@ -2009,9 +3680,57 @@ void MainDb::init () {
 		"  name VARCHAR(191)," //191 = max indexable (KEY or UNIQUE) varchar size for mysql < 5.7 with charset utf8mb4
 		"  data BLOB NOT NULL,"
 
-		"  PRIMARY KEY (friend_id, name),"
-		"  FOREIGN KEY (friend_id)"
-		"    REFERENCES friend(id)"
+		"  PRIMARY KEY (friend_id, name),"
+		"  FOREIGN KEY (friend_id)"
+		"    REFERENCES friend(id)"
+		"    ON DELETE CASCADE"
+		") " + charset;
+
+	// Messages of server group chat rooms waiting for offline devices. A message is stored once and
+	// referenced by each device it is queued for.
+	*session <<
+		"CREATE TABLE IF NOT EXISTS server_queued_chat_message ("
+		"  id" + primaryKeyStr("BIGINT UNSIGNED") + ","
+
+		"  chat_room_id" + primaryKeyRefStr("BIGINT UNSIGNED") + " NOT NULL,"
+		"  from_sip_address_id" + primaryKeyRefStr("BIGINT UNSIGNED") + " NOT NULL,"
+		"  content_type_id" + primaryKeyRefStr("SMALLINT UNSIGNED") + " NOT NULL,"
+
+		// Raw bytes, the body may be binary or encrypted.
+		"  body BLOB NOT NULL,"
+
+		// Forwarded custom headers, one "name: value" per line.
+		"  headers TEXT NOT NULL,"
+
+		"  creation_time" + timestampType() + " NOT NULL,"
+
+		"  FOREIGN KEY (chat_room_id)"
+		"    REFERENCES chat_room(id)"
+		"    ON DELETE CASCADE,"
+		"  FOREIGN KEY (from_sip_address_id)"
+		"    REFERENCES sip_address(id)"
+		"    ON DELETE CASCADE,"
+		"  FOREIGN KEY (content_type_id)"
+		"    REFERENCES content_type(id)"
+		"    ON DELETE CASCADE"
+		") " + charset;
+
+	*session <<
+		"CREATE TABLE IF NOT EXISTS server_queued_chat_message_device ("
+		"  chat_room_id" + primaryKeyRefStr("BIGINT UNSIGNED") + ","
+		"  device_sip_address_id" + primaryKeyRefStr("BIGINT UNSIGNED") + ","
+		"  message_id" + primaryKeyRefStr("BIGINT UNSIGNED") + ","
+
+		"  PRIMARY KEY (chat_room_id, device_sip_address_id, message_id),"
+
+		"  FOREIGN KEY (chat_room_id)"
+		"    REFERENCES chat_room(id)"
+		"    ON DELETE CASCADE,"
+		"  FOREIGN KEY (device_sip_address_id)"
+		"    REFERENCES sip_address(id)"
+		"    ON DELETE CASCADE,"
+		"  FOREIGN KEY (message_id)"
+		"    REFERENCES server_queued_chat_message(id)"
 		"    ON DELETE CASCADE"
 		") " + charset;
 
@@ -2021,10 +3740,39 @@ void MainDb::init () {
 		"  version INT UNSIGNED NOT NULL"
 		") " + charset;
 
+	LinphoneConfig *config = linphone_core_get_config(getCore()->getCCore());
+	d->writeBehindEnabled = !!linphone_config_get_bool(config, "storage", "write_behind_enabled", FALSE);
+	d->writeBehindDelay = (unsigned int)linphone_config_get_int(config, "storage", "write_behind_delay_ms", 200);
+	d->writeBehindBatchSize = (size_t)linphone_config_get_int(config, "storage", "write_behind_batch_size", 100);
+	d->retentionMaxAge = (unsigned int)linphone_config_get_int(config, "storage", "retention_max_age_days", 0);
+	d->retentionMaxEventsPerChatRoom = (unsigned int)linphone_config_get_int(config, "storage", "retention_max_events_per_chat_room", 0);
+	d->retentionBatchSize = (unsigned int)linphone_config_get_int(config, "storage", "retention_batch_size", 100);
+	d->retentionStepInterval = (unsigned int)linphone_config_get_int(config, "storage", "retention_step_interval_ms", 100);
+	d->retentionStepDuration = (unsigned int)linphone_config_get_int(config, "storage", "retention_step_duration_ms", 5);
+	d->retentionPassInterval = (unsigned int)linphone_config_get_int(config, "storage", "retention_pass_interval_s", 3600);
+	d->retentionVacuumPages = (unsigned int)linphone_config_get_int(config, "storage", "retention_vacuum_pages", 128);
+	d->serverQueuedMessageTtl = (unsigned int)linphone_config_get_int(config, "storage", "server_queued_message_ttl_s", 7 * 24 * 3600);
+	d->serverQueuedMessageMaxPerDevice = (unsigned int)linphone_config_get_int(config, "storage", "server_queued_message_max_per_device", 1000);
+	d->serverQueuedMessageExpiryInterval = (unsigned int)linphone_config_get_int(config, "storage", "server_queued_message_expiry_interval_s", 3600);
+
 	d->updateSchema();
 
+	d->warmIdCaches();
+
+	d->fullTextSearchEnabled = !!linphone_config_get_bool(config, "storage", "full_text_search_enabled", FALSE);
+	try {
+		d->updateFullTextSearchIndex();
+	} catch (const soci::soci_error &e) {
+		lWarning() << "Unable to update full text search index, search is disabled (" << e.what() << ").";
+		d->fullTextSearchEnabled = false;
+	}
+
 	d->updateModuleVersion("events", ModuleVersionEvents);
 	d->updateModuleVersion("friends", ModuleVersionFriends);
+
+	d->startRetention();
+	if (linphone_core_conference_server_enabled(getCore()->getCCore()))
+		d->startServerQueuedChatMessageExpiry();
 #endif
 }
 
@@ -2038,48 +3786,9 @@ bool MainDb::addEvent (const shared_ptr<EventLog> &eventLog) {
 	return L_DB_TRANSACTION {
 		L_D();
 
-		long long eventId = -1;
-
 		EventLog::Type type = eventLog->getType();
 		lInfo() << "MainDb::addEvent() of type " << static_cast<int>(type);
-		switch (type) {
-			case EventLog::Type::None:
-				return false;
-
-			case EventLog::Type::ConferenceCreated:
-			case EventLog::Type::ConferenceTerminated:
-				eventId = d->insertConferenceEvent(eventLog);
-				break;
-
-			case EventLog::Type::ConferenceCallStart:
-			case EventLog::Type::ConferenceCallEnd:
-				eventId = d->insertConferenceCallEvent(eventLog);
-				break;
-
-			case EventLog::Type::ConferenceChatMessage:
-				eventId = d->insertConferenceChatMessageEvent(eventLog);
-				break;
-
-			case EventLog::Type::ConferenceParticipantAdded:
-			case EventLog::Type::ConferenceParticipantRemoved:
-			case EventLog::Type::ConferenceParticipantSetAdmin:
-			case EventLog::Type::ConferenceParticipantUnsetAdmin:
-				eventId = d->insertConferenceParticipantEvent(eventLog);
-				break;
-
-			case EventLog::Type::ConferenceParticipantDeviceAdded:
-			case EventLog::Type::ConferenceParticipantDeviceRemoved:
-				eventId = d->insertConferenceParticipantDeviceEvent(eventLog);
-				break;
-
-			case EventLog::Type::ConferenceSecurityEvent:
-				eventId = d->insertConferenceSecurityEvent(eventLog);
-				break;
-
-			case EventLog::Type::ConferenceSubjectChanged:
-				eventId = d->insertConferenceSubjectEvent(eventLog);
-				break;
-		}
+		const long long &eventId = d->insertEventLog(eventLog);
 
 		if (eventId >= 0) {
 			tr.commit();
@@ -2098,6 +3807,105 @@ bool MainDb::addEvent (const shared_ptr<EventLog> &eventLog) {
 #endif
 }
 
+bool MainDb::addEvents (const list<shared_ptr<EventLog>> &eventLogs) {
+#ifdef HAVE_DB_STORAGE
+	// Number of chat messages inserted by each group of multi-row statements.
+	static constexpr size_t ChatMessageEventBatchSize = 100;
+
+	DurationLogger durationLogger("Add " + Utils::toString(eventLogs.size()) + " events.");
+
+	return L_DB_TRANSACTION {
+		L_D();
+
+		// 1. Resolve the sip addresses of all chat messages at once.
+		unordered_set<string> sipAddresses;
+		for (const auto &eventLog : eventLogs) {
+			if (eventLog->getType() != EventLog::Type::ConferenceChatMessage || eventLog->getPrivate()->dbKey.isValid())
+				continue;
+
+			shared_ptr<ChatMessage> chatMessage = static_pointer_cast<ConferenceChatMessageEvent>(eventLog)->getChatMessage();
+			sipAddresses.insert(chatMessage->getFromAddress().asString());
+			sipAddresses.insert(chatMessage->getToAddress().asString());
+			for (const auto &participant : chatMessage->getChatRoom()->getParticipants())
+				sipAddresses.insert(participant->getAddress().asString());
+		}
+		d->insertSipAddresses(sipAddresses);
+
+		// 2. Insert events in order. Consecutive chat messages are grouped.
+		unordered_map<long long, MainDbPrivate::BulkChatRoomUpdate> chatRoomUpdates;
+		list<pair<shared_ptr<EventLog>, long long>> insertedEventLogs;
+		vector<shared_ptr<EventLog>> chatMessageEventLogs;
+		const auto flushChatMessageEventLogs = [&] {
+			if (chatMessageEventLogs.empty())
+				return;
+			d->insertConferenceChatMessageEvents(chatMessageEventLogs, chatRoomUpdates, insertedEventLogs);
+			chatMessageEventLogs.clear();
+		};
+
+		for (const auto &eventLog : eventLogs) {
+			if (eventLog->getPrivate()->dbKey.isValid()) {
+				lWarning() << "Unable to add an event twice!!!";
+				continue;
+			}
+
+			if (eventLog->getType() == EventLog::Type::ConferenceChatMessage) {
+				chatMessageEventLogs.push_back(eventLog);
+				if (chatMessageEventLogs.size() == ChatMessageEventBatchSize)
+					flushChatMessageEventLogs();
+				continue;
+			}
+
+			flushChatMessageEventLogs();
+			const long long &eventId = d->insertEventLog(eventLog);
+			if (eventId < 0)
+				continue;
+			insertedEventLogs.emplace_back(eventLog, eventId);
+
+			// This event already updated the last update time of its chat room, keep it.
+			shared_ptr<ConferenceEvent> conferenceEvent = dynamic_pointer_cast<ConferenceEvent>(eventLog);
+			if (conferenceEvent) {
+				auto it = chatRoomUpdates.find(d->selectChatRoomId(conferenceEvent->getConferenceId()));
+				if (it != chatRoomUpdates.end())
+					it->second.lastUpdateTime = eventLog->getCreationTime();
+			}
+		}
+		flushChatMessageEventLogs();
+
+		// 3. Update each chat room once.
+		soci::session *session = d->dbSession.getBackendSession();
+		for (const auto &chatRoomUpdate : chatRoomUpdates) {
+			const long long &chatRoomId = chatRoomUpdate.first;
+			const tm &lastUpdateTime = Utils::getTimeTAsTm(chatRoomUpdate.second.lastUpdateTime);
+			*session << "UPDATE chat_room SET last_update_time = :lastUpdateTime, last_message_id = :lastMessageId"
+				" WHERE id = :chatRoomId", soci::use(lastUpdateTime), soci::use(chatRoomUpdate.second.lastMessageId),
+				soci::use(chatRoomId);
+
+			if (chatRoomUpdate.second.unreadCount > 0)
+				d->updateUnreadChatMessageCount(
+					chatRoomUpdate.second.conferenceId, chatRoomId, chatRoomUpdate.second.unreadCount
+				);
+		}
+
+		tr.commit();
+
+		for (const auto &insertedEventLog : insertedEventLogs) {
+			const shared_ptr<EventLog> &eventLog = insertedEventLog.first;
+			d->cache(eventLog, insertedEventLog.second);
+			if (eventLog->getType() == EventLog::Type::ConferenceChatMessage)
+				d->cache(static_pointer_cast<ConferenceChatMessageEvent>(eventLog)->getChatMessage(), insertedEventLog.second);
+		}
+
+		if (insertedEventLogs.size() != eventLogs.size()) {
+			lError() << "MainDb::addEvents() failed to add " << eventLogs.size() - insertedEventLogs.size() << " events.";
+			return false;
+		}
+		return true;
+	};
+#else
+	return false;
+#endif
+}
+
 bool MainDb::updateEvent (const shared_ptr<EventLog> &eventLog) {
 #ifdef HAVE_DB_STORAGE
 	if (!eventLog->getPrivate()->dbKey.isValid()) {
@@ -2105,6 +3913,12 @@ bool MainDb::updateEvent (const shared_ptr<EventLog> &eventLog) {
 		return false;
 	}
 
+	L_D();
+	if (d->writeBehindEnabled && eventLog->getType() == EventLog::Type::ConferenceChatMessage) {
+		d->queueEventUpdate(eventLog);
+		return true;
+	}
+
 	return L_DB_TRANSACTION {
 		L_D();
 
@@ -2154,9 +3968,25 @@ bool MainDb::deleteEvent (const shared_ptr<const EventLog> &eventLog) {
 
 	MainDb &mainDb = *core->getPrivate()->mainDb.get();
 
+	// Pending updates of a deleted event are useless.
+	{
+		MainDbPrivate *const d = mainDb.getPrivate();
+		auto it = d->pendingEventUpdates.find(dEventKey->storageId);
+		if (it != d->pendingEventUpdates.end()) {
+			d->pendingUpdateCount -= (it->second.updateEvent ? 1 : 0) + it->second.participantStates.size();
+			d->pendingEventUpdates.erase(it);
+		}
+	}
+
 	return L_DB_TRANSACTION_C(&mainDb) {
 		MainDbPrivate *const d = mainDb.getPrivate();
 		soci::session *session = d->dbSession.getBackendSession();
+
+		int dbMarkedAsRead = 1;
+		if (eventLog->getType() == EventLog::Type::ConferenceChatMessage)
+			*session << "SELECT marked_as_read FROM conference_chat_message_event WHERE event_id = :eventId",
+				soci::into(dbMarkedAsRead), soci::use(dEventKey->storageId);
+
 		*session << "DELETE FROM event WHERE id = :id", soci::use(dEventKey->storageId);
 		
 		if (eventLog->getType() == EventLog::Type::ConferenceChatMessage) {
@@ -2164,6 +3994,8 @@ bool MainDb::deleteEvent (const shared_ptr<const EventLog> &eventLog) {
 			shared_ptr<AbstractChatRoom> chatRoom(chatMessage->getChatRoom());
 			const long long &dbChatRoomId = d->selectChatRoomId(chatRoom->getConferenceId());
 			*session << "UPDATE chat_room SET last_message_id = IFNULL((SELECT id FROM conference_event_simple_view WHERE chat_room_id = chat_room.id AND type = " << mapEventFilterToSql(ConferenceChatMessageFilter) << " ORDER BY id DESC LIMIT 1), 0) WHERE id = :1", soci::use(dbChatRoomId);
+			if (!dbMarkedAsRead)
+				d->updateUnreadChatMessageCount(chatRoom->getConferenceId(), dbChatRoomId, -1);
 		}
 
 		tr.commit();
@@ -2172,11 +4004,6 @@ bool MainDb::deleteEvent (const shared_ptr<const EventLog> &eventLog) {
 
 		if (eventLog->getType() == EventLog::Type::ConferenceChatMessage) {
 			shared_ptr<ChatMessage> chatMessage(static_pointer_cast<const ConferenceChatMessageEvent>(eventLog)->getChatMessage());
-			if (chatMessage->getDirection() == ChatMessage::Direction::Incoming && !chatMessage->getPrivate()->isMarkedAsRead()) {
-				int *count = d->unreadChatMessageCountCache[chatMessage->getChatRoom()->getConferenceId()];
-				if (count)
-					--*count;
-			}
 			chatMessage->getPrivate()->dbKey = MainDbChatMessageKey();
 		}
 
@@ -2316,50 +4143,65 @@ int MainDb::getUnreadChatMessageCount (const ConferenceId &conferenceId) const {
 #ifdef HAVE_DB_STORAGE
 	L_D();
 
-	if (conferenceId.isValid()) {
-		const int *count = d->unreadChatMessageCountCache[conferenceId];
-		if (count)
-			return *count;
+	if (!conferenceId.isValid()) {
+		int count = 0;
+		for (const auto &entry : getUnreadChatMessageCountByLocalAddress())
+			count += entry.second;
+		return count;
 	}
 
-	string query = "SELECT COUNT(*) FROM conference_chat_message_event WHERE";
-	if (conferenceId.isValid())
-		query += " event_id IN ("
-			"  SELECT event_id FROM conference_event WHERE chat_room_id = :chatRoomId"
-			") AND";
-
-	query += " marked_as_read == 0 ";
+	// Queued updates may mark messages as read.
+	int pendingDelta = 0;
+	if (!d->pendingEventUpdates.empty()) {
+		const unordered_map<ConferenceId, int> deltas = d->getPendingUnreadChatMessageCountDeltas();
+		auto it = deltas.find(conferenceId);
+		if (it != deltas.cend())
+			pendingDelta = it->second;
+	}
 
-	/*
-	DurationLogger durationLogger(
-		"Get unread chat messages count of: (peer=" + conferenceId.getPeerAddress().asString() +
-		", local=" + conferenceId.getLocalAddress().asString() + ")."
-	);
-	*/
+	const int *count = d->unreadChatMessageCountCache[conferenceId];
+	if (count)
+		return *count + pendingDelta;
 
 	return L_DB_TRANSACTION {
-		int count = 0;
-
-		soci::session *session = d->dbSession.getBackendSession();
-
-		if (!conferenceId.isValid())
-			*session << query, soci::into(count);
-		else {
-			const long long &dbChatRoomId = d->selectChatRoomId(conferenceId);
-			*session << query, soci::use(dbChatRoomId), soci::into(count);
-		}
-
-		d->unreadChatMessageCountCache.insert(conferenceId, count);
-		return count;
+		const int unreadCount = d->selectUnreadChatMessageCount(d->selectChatRoomId(conferenceId));
+		d->unreadChatMessageCountCache.insert(conferenceId, unreadCount);
+		return unreadCount + pendingDelta;
 	};
 #else
 	return 0;
 #endif
 }
 
+const unordered_map<IdentityAddress, int> &MainDb::getUnreadChatMessageCountByLocalAddress () const {
+	L_D();
+
+#ifdef HAVE_DB_STORAGE
+	if (!d->unreadChatMessageCountByLocalAddressLoaded)
+		L_DB_TRANSACTION {
+			d->loadUnreadChatMessageCountByLocalAddress();
+		};
+
+	// Queued updates may mark messages as read.
+	if (!d->pendingEventUpdates.empty()) {
+		d->pendingUnreadChatMessageCountByLocalAddress = d->unreadChatMessageCountByLocalAddress;
+		for (const auto &delta : d->getPendingUnreadChatMessageCountDeltas())
+			d->pendingUnreadChatMessageCountByLocalAddress[delta.first.getLocalAddress()] += delta.second;
+		return d->pendingUnreadChatMessageCountByLocalAddress;
+	}
+#endif
+
+	return d->unreadChatMessageCountByLocalAddress;
+}
+
 void MainDb::markChatMessagesAsRead (const ConferenceId &conferenceId) const {
 #ifdef HAVE_DB_STORAGE
-	if (getUnreadChatMessageCount(conferenceId) == 0)
+	// The stored read states of the queued updates are about to change.
+	L_D();
+	d->flushPendingUpdates();
+
+	const int count = getUnreadChatMessageCount(conferenceId);
+	if (count == 0)
 		return;
 
 	static const string query = "UPDATE conference_chat_message_event"
@@ -2381,9 +4223,9 @@ void MainDb::markChatMessagesAsRead (const ConferenceId &conferenceId) const {
 
 		const long long &dbChatRoomId = d->selectChatRoomId(conferenceId);
 		*d->dbSession.getBackendSession() << query, soci::use(dbChatRoomId);
+		d->updateUnreadChatMessageCount(conferenceId, dbChatRoomId, -count);
 
 		tr.commit();
-		d->unreadChatMessageCountCache.insert(conferenceId, 0);
 	};
 #endif
 }
@@ -2412,6 +4254,10 @@ list<shared_ptr<ChatMessage>> MainDb::getUnreadChatMessages (const ConferenceId
 
 		soci::rowset<soci::row> rows = (session->prepare << query, soci::use(dbChatRoomId));
 		for (const auto &row : rows) {
+			// Marked as read by a queued update.
+			if (d->isPendingMarkedAsRead(d->dbSession.resolveId(row, 0)))
+				continue;
+
 			shared_ptr<EventLog> event = d->selectGenericConferenceEvent(
 				chatRoom,
 				row
@@ -2441,6 +4287,28 @@ list<MainDb::ParticipantState> MainDb::getChatMessageParticipantsByImdnState (
 		const long long &eventId = dEventKey->storageId;
 		int stateInt = int(state);
 
+		list<MainDb::ParticipantState> result;
+
+		auto it = d->pendingEventUpdates.find(eventId);
+		if (it != d->pendingEventUpdates.cend() && !it->second.participantStates.empty()) {
+			// Merge queued states with stored ones.
+			static const string query = "SELECT sip_address.value, chat_message_participant.state, chat_message_participant.state_change_time"
+				" FROM sip_address, chat_message_participant"
+				" WHERE event_id = :eventId"
+				" AND sip_address.id = chat_message_participant.participant_sip_address_id";
+			soci::rowset<soci::row> rows = (d->dbSession.getBackendSession()->prepare << query, soci::use(eventId));
+			for (const auto &row : rows) {
+				const string &address = row.get<string>(0);
+				auto stateIt = it->second.participantStates.find(address);
+				if (stateIt != it->second.participantStates.cend()) {
+					if (stateIt->second.state == state)
+						result.emplace_back(stateIt->second.address, state, stateIt->second.stateChangeTime);
+				} else if (row.get<int>(1) == stateInt)
+					result.emplace_back(IdentityAddress(address), state, d->dbSession.getTime(row, 2));
+			}
+			return result;
+		}
+
 		static const string query = "SELECT sip_address.value, chat_message_participant.state_change_time"
 					" FROM sip_address, chat_message_participant"
 					" WHERE event_id = :eventId AND state = :state"
@@ -2449,7 +4317,6 @@ list<MainDb::ParticipantState> MainDb::getChatMessageParticipantsByImdnState (
 			soci::use(eventId), soci::use(stateInt)
 		);
 
-		list<MainDb::ParticipantState> result;
 		for (const auto &row : rows)
 			result.emplace_back(IdentityAddress(row.get<string>(0)), state, d->dbSession.getTime(row, 1));
 		return result;
@@ -2468,6 +4335,24 @@ list<ChatMessage::State> MainDb::getChatMessageParticipantStates (const shared_p
 		MainDbKeyPrivate *dEventKey = static_cast<MainDbKey &>(dEventLog->dbKey).getPrivate();
 		const long long &eventId = dEventKey->storageId;
 
+		list<ChatMessage::State> states;
+
+		auto it = d->pendingEventUpdates.find(eventId);
+		if (it != d->pendingEventUpdates.cend() && !it->second.participantStates.empty()) {
+			// Merge queued states with stored ones.
+			static const string query = "SELECT sip_address.value, state FROM chat_message_participant, sip_address"
+				" WHERE event_id = :eventId AND sip_address.id = participant_sip_address_id";
+			soci::rowset<soci::row> rows = (d->dbSession.getBackendSession()->prepare << query, soci::use(eventId));
+			for (const auto &row : rows) {
+				auto stateIt = it->second.participantStates.find(row.get<string>(0));
+				states.push_back(stateIt != it->second.participantStates.cend()
+					? stateIt->second.state
+					: ChatMessage::State(row.get<int>(1))
+				);
+			}
+			return states;
+		}
+
 		unsigned int state;
 		soci::statement statement = (
 			d->dbSession.getBackendSession()->prepare << "SELECT state FROM chat_message_participant WHERE event_id = :eventId",
@@ -2475,7 +4360,6 @@ list<ChatMessage::State> MainDb::getChatMessageParticipantStates (const shared_p
 		);
 		statement.execute();
 
-		list<ChatMessage::State> states;
 		while (statement.fetch())
 			states.push_back(ChatMessage::State(state));
 
@@ -2497,6 +4381,14 @@ ChatMessage::State MainDb::getChatMessageParticipantState (
 		const EventLogPrivate *dEventLog = eventLog->getPrivate();
 		MainDbKeyPrivate *dEventKey = static_cast<MainDbKey &>(dEventLog->dbKey).getPrivate();
 		const long long &eventId = dEventKey->storageId;
+
+		const MainDbPrivate::PendingParticipantState *pendingState = d->findPendingChatMessageParticipantState(
+			eventId,
+			participantAddress
+		);
+		if (pendingState)
+			return pendingState->state;
+
 		const long long &participantSipAddressId = d->selectSipAddressId(participantAddress.asString());
 
 		unsigned int state;
@@ -2518,6 +4410,12 @@ void MainDb::setChatMessageParticipantState (
 	time_t stateChangeTime
 ) {
 #ifdef HAVE_DB_STORAGE
+	L_D();
+	if (d->writeBehindEnabled) {
+		d->queueChatMessageParticipantState(eventLog, participantAddress, state, stateChangeTime);
+		return;
+	}
+
 	L_DB_TRANSACTION {
 		L_D();
 		d->setChatMessageParticipantState(eventLog, participantAddress, state, stateChangeTime);
@@ -2526,6 +4424,21 @@ void MainDb::setChatMessageParticipantState (
 #endif
 }
 
+void MainDb::flushPendingUpdates () {
+#ifdef HAVE_DB_STORAGE
+	L_D();
+	d->flushPendingUpdates();
+#endif
+}
+
+void MainDb::stopHistoryRetention () {
+#ifdef HAVE_DB_STORAGE
+	L_D();
+	d->stopRetention();
+	d->stopServerQueuedChatMessageExpiry();
+#endif
+}
+
 bool MainDb::isChatRoomEmpty (const ConferenceId &conferenceId) const {
 #ifdef HAVE_DB_STORAGE
 	static const string query = "SELECT last_message_id FROM chat_room WHERE id = :1";
@@ -2601,6 +4514,11 @@ list<shared_ptr<ChatMessage>> MainDb::findChatMessages (
 		", local=" + conferenceId.getLocalAddress().asString() + ")."
 	);
 	*/
+
+	// Queued updates may change imdn message ids.
+	L_D();
+	d->flushPendingUpdates();
+
 	return L_DB_TRANSACTION {
 		L_D();
 
@@ -2682,6 +4600,135 @@ list<shared_ptr<ChatMessage>> MainDb::findChatMessagesToBeNotifiedAsDelivered ()
 #endif
 }
 
+bool MainDb::isFullTextSearchEnabled () const {
+#ifdef HAVE_DB_STORAGE
+	L_D();
+	return d->fullTextSearchEnabled;
+#else
+	return false;
+#endif
+}
+
+list<shared_ptr<ChatMessage>> MainDb::searchChatMessages (
+	const string &text,
+	const ConferenceId &conferenceId,
+	int count,
+	int cursor,
+	int *nextCursor
+) const {
+	if (nextCursor)
+		*nextCursor = 0;
+
+#ifdef HAVE_DB_STORAGE
+	L_D();
+
+	list<shared_ptr<ChatMessage>> chatMessages;
+	if (!d->fullTextSearchEnabled) {
+		lWarning() << "Unable to search chat messages, full text search is disabled.";
+		return chatMessages;
+	}
+
+	if (text.empty() || count <= 0)
+		return chatMessages;
+
+	if (cursor < 0)
+		cursor = 0;
+
+	const bool isMysql = getBackend() == Mysql;
+
+	// One row per matching chat message, with its best score.
+	string matchQuery;
+	string searchText;
+	if (isMysql) {
+		matchQuery = "SELECT chat_message_content.event_id, MAX(MATCH (body) AGAINST (:text1)) AS score"
+			"  FROM chat_message_content"
+			"  JOIN content_type ON content_type.id = content_type_id"
+			"  WHERE MATCH (body) AGAINST (:text2) AND content_type.value = 'text/plain'"
+			"  GROUP BY chat_message_content.event_id";
+		searchText = text;
+	} else {
+		// Lower is better with bm25.
+		matchQuery = "SELECT chat_message_content.event_id, -MIN(chat_message_content_fts.rank) AS score"
+			"  FROM chat_message_content_fts"
+			"  JOIN chat_message_content ON chat_message_content.id = chat_message_content_fts.rowid"
+			"  WHERE chat_message_content_fts MATCH :text"
+			"  GROUP BY chat_message_content.event_id";
+
+		// Quote each word so the user input is never parsed as FTS5 query syntax.
+		istringstream stream(text);
+		string word;
+		while (stream >> word) {
+			if (!searchText.empty())
+				searchText += ' ';
+			searchText += '"';
+			for (char c : word) {
+				if (c == '"')
+					searchText += '"';
+				searchText += c;
+			}
+			searchText += '"';
+		}
+		if (searchText.empty())
+			return chatMessages;
+	}
+
+	// chat_room_id must be the last element !
+	const string query = "SELECT conference_event_view.id AS event_id, type, creation_time, from_sip_address.value, to_sip_address.value, time, imdn_message_id, state, direction, is_secured, notify_id, device_sip_address.value, participant_sip_address.value, subject, delivery_notification_required, display_notification_required, security_alert, faulty_device, marked_as_read, forward_info, chat_room_id"
+		" FROM (" + matchQuery + ") AS matches"
+		" JOIN conference_event_view ON conference_event_view.id = matches.event_id"
+		" LEFT JOIN sip_address AS from_sip_address ON from_sip_address.id = from_sip_address_id"
+		" LEFT JOIN sip_address AS to_sip_address ON to_sip_address.id = to_sip_address_id"
+		" LEFT JOIN sip_address AS device_sip_address ON device_sip_address.id = device_sip_address_id"
+		" LEFT JOIN sip_address AS participant_sip_address ON participant_sip_address.id = participant_sip_address_id"
+		" WHERE (:chatRoomId1 < 0 OR chat_room_id = :chatRoomId2)"
+		" ORDER BY matches.score DESC, conference_event_view.id DESC"
+		" LIMIT " + Utils::toString(count) + " OFFSET " + Utils::toString(cursor);
+
+	DurationLogger durationLogger("Search chat messages.");
+
+	return L_DB_TRANSACTION {
+		L_D();
+
+		soci::session *session = d->dbSession.getBackendSession();
+
+		const long long dbChatRoomId = conferenceId.isValid() ? d->selectChatRoomId(conferenceId) : -1;
+		soci::rowset<soci::row> rows = isMysql
+			? soci::rowset<soci::row>(session->prepare << query,
+				soci::use(searchText), soci::use(searchText), soci::use(dbChatRoomId), soci::use(dbChatRoomId))
+			: soci::rowset<soci::row>(session->prepare << query,
+				soci::use(searchText), soci::use(dbChatRoomId), soci::use(dbChatRoomId));
+
+		int nRows = 0;
+		for (const auto &row : rows) {
+			++nRows;
+
+			// chat_room_id is the last element of row
+			const long long &dbRowChatRoomId = d->dbSession.resolveId(row, (int)row.size()-1);
+			ConferenceId rowConferenceId = d->getConferenceIdFromCache(dbRowChatRoomId);
+			if (!rowConferenceId.isValid())
+				rowConferenceId = d->selectConferenceId(dbRowChatRoomId);
+
+			shared_ptr<AbstractChatRoom> chatRoom = rowConferenceId.isValid() ? d->findChatRoom(rowConferenceId) : nullptr;
+			if (!chatRoom)
+				continue;
+
+			shared_ptr<EventLog> event = d->selectGenericConferenceEvent(chatRoom, row);
+			if (event) {
+				L_ASSERT(event->getType() == EventLog::Type::ConferenceChatMessage);
+				chatMessages.push_back(static_pointer_cast<ConferenceChatMessageEvent>(event)->getChatMessage());
+			}
+		}
+
+		if (nextCursor && nRows == count)
+			*nextCursor = cursor + count;
+
+		return chatMessages;
+	};
+#else
+	return list<shared_ptr<ChatMessage>>();
+#endif
+}
+
 list<shared_ptr<EventLog>> MainDb::getHistory (const ConferenceId &conferenceId, int nLast, FilterMask mask) const {
 #ifdef HAVE_DB_STORAGE
 	return getHistoryRange(conferenceId, 0, nLast, mask);
@@ -2708,18 +4755,7 @@ list<shared_ptr<EventLog>> MainDb::getHistoryRange (
 		return events;
 	}
 
-	string query = Statements::get(Statements::SelectConferenceEvents) + buildSqlEventFilter({
-		ConferenceCallFilter, ConferenceChatMessageFilter, ConferenceInfoFilter, ConferenceInfoNoDeviceFilter
-	}, mask, "AND");
-	query += " ORDER BY event_id DESC";
-
-	if (end > 0)
-		query += " LIMIT " + Utils::toString(end - begin);
-	else
-		query += " LIMIT " + d->dbSession.noLimitValue();
-
-	if (begin > 0)
-		query += " OFFSET " + Utils::toString(begin);
+	const string query = d->getHistoryRangeQuery(begin, end, mask);
 
 	/*
 	DurationLogger durationLogger(
@@ -2737,8 +4773,71 @@ list<shared_ptr<EventLog>> MainDb::getHistoryRange (
 			return events;
 
 		const long long &dbChatRoomId = d->selectChatRoomId(conferenceId);
-		soci::rowset<soci::row> rows = (d->dbSession.getBackendSession()->prepare << query, soci::use(dbChatRoomId));
+		soci::rowset<soci::row> rows = (d->dbSession.getBackendSession()->prepare << query, soci::use(dbChatRoomId));
+		for (const auto &row : rows) {
+			shared_ptr<EventLog> event = d->selectGenericConferenceEvent(chatRoom, row);
+			if (event)
+				events.push_front(event);
+		}
+
+		return events;
+	};
+#else
+	return list<shared_ptr<EventLog>>();
+#endif
+}
+
+list<shared_ptr<EventLog>> MainDb::getHistoryBefore (
+	const ConferenceId &conferenceId,
+	long long beforeEventId,
+	int count,
+	FilterMask mask,
+	long long *nextEventId
+) const {
+	if (nextEventId)
+		*nextEventId = 0;
+
+#ifdef HAVE_DB_STORAGE
+	list<shared_ptr<EventLog>> events;
+	if (count <= 0) {
+		lWarning() << "Unable to get history. Invalid page size.";
+		return events;
+	}
+
+	// Seek on the (chat_room_id, event_id) index instead of skipping rows with an OFFSET,
+	// so each page has the same cost whatever its depth in the history.
+	if (beforeEventId <= 0)
+		beforeEventId = numeric_limits<long long>::max();
+
+	string query = Statements::get(Statements::SelectConferenceEventsBefore) + buildSqlEventFilter({
+		ConferenceCallFilter, ConferenceChatMessageFilter, ConferenceInfoFilter, ConferenceInfoNoDeviceFilter
+	}, mask, "AND");
+	// One more row than requested tells whether there is a next page.
+	query += " ORDER BY conference_event.event_id DESC LIMIT " + Utils::toString(count + 1);
+
+	return L_DB_TRANSACTION {
+		L_D();
+
+		shared_ptr<AbstractChatRoom> chatRoom = d->findChatRoom(conferenceId);
+		if (!chatRoom)
+			return events;
+
+		const long long &dbChatRoomId = d->selectChatRoomId(conferenceId);
+		soci::rowset<soci::row> rows = (d->dbSession.getBackendSession()->prepare << query,
+			soci::use(dbChatRoomId), soci::use(beforeEventId)
+		);
+
+		int nRows = 0;
+		long long lastEventId = 0;
 		for (const auto &row : rows) {
+			if (nRows == count) {
+				// The extra row is not returned, it only means the beginning of the history is not reached yet.
+				if (nextEventId)
+					*nextEventId = lastEventId;
+				break;
+			}
+			++nRows;
+			lastEventId = d->dbSession.resolveId(row, 0);
 			shared_ptr<EventLog> event = d->selectGenericConferenceEvent(chatRoom, row);
 			if (event)
 				events.push_front(event);
@@ -2775,36 +4874,8 @@ int MainDb::getHistorySize (const ConferenceId &conferenceId, FilterMask mask) c
 
 
 void MainDb::cleanHistory (const ConferenceId &conferenceId, FilterMask mask) {
-#ifdef HAVE_DB_STORAGE
-	const string query = "SELECT event_id FROM conference_event WHERE chat_room_id = :chatRoomId" +
-		buildSqlEventFilter({
-			ConferenceCallFilter, ConferenceChatMessageFilter, ConferenceInfoFilter, ConferenceInfoNoDeviceFilter
-		}, mask);
-
-	const string query2 = "UPDATE chat_room SET last_message_id = 0 WHERE id = :1";
-
-	/*
-	DurationLogger durationLogger(
-		"Clean history of: (peer=" + conferenceId.getPeerAddress().asString() +
-		", local=" + conferenceId.getLocalAddress().asString() +
-		", mask=" + Utils::toString(mask) + ")."
-	);
-	*/
-
-	L_DB_TRANSACTION {
-		L_D();
-
-		const long long &dbChatRoomId = d->selectChatRoomId(conferenceId);
-
-		d->invalidConferenceEventsFromQuery(query, dbChatRoomId);
-		*d->dbSession.getBackendSession() << "DELETE FROM event WHERE id IN (" + query + ")", soci::use(dbChatRoomId);
-		*d->dbSession.getBackendSession() << query2, soci::use(dbChatRoomId);
-		tr.commit();
-
-		if (!mask || (mask & ConferenceChatMessageFilter))
-			d->unreadChatMessageCountCache.insert(conferenceId, 0);
-	};
-#endif
+	L_D();
+	d->cleanHistory(conferenceId, mask, nullptr);
 }
 
 // -----------------------------------------------------------------------------
@@ -2924,152 +4995,15 @@ void MainDb::disableDisplayNotificationRequired (const std::shared_ptr<const Eve
 
 list<shared_ptr<AbstractChatRoom>> MainDb::getChatRooms () const {
 #ifdef HAVE_DB_STORAGE
-	static const string query = "SELECT chat_room.id, peer_sip_address.value, local_sip_address.value,"
-		" creation_time, last_update_time, capabilities, subject, last_notify_id, flags, last_message_id"
-		" FROM chat_room, sip_address AS peer_sip_address, sip_address AS local_sip_address"
-		" WHERE chat_room.peer_sip_address_id = peer_sip_address.id AND chat_room.local_sip_address_id = local_sip_address.id"
-		" ORDER BY last_update_time DESC";
-
 	DurationLogger durationLogger("Get chat rooms.");
 
 	return L_DB_TRANSACTION {
 		L_D();
 
-		list<shared_ptr<AbstractChatRoom>> chatRooms;
-		shared_ptr<Core> core = getCore();
-
-		soci::session *session = d->dbSession.getBackendSession();
-
-		soci::rowset<soci::row> rows = (session->prepare << query);
-		for (const auto &row : rows) {
-			ConferenceId conferenceId = ConferenceId(
-				IdentityAddress(row.get<string>(1)),
-				IdentityAddress(row.get<string>(2))
-			);
-			
-			shared_ptr<AbstractChatRoom> chatRoom = core->findChatRoom(conferenceId, false);
-			if (chatRoom) {
-				chatRooms.push_back(chatRoom);
-				continue;
-			}
-
-			const long long &dbChatRoomId = d->dbSession.resolveId(row, 0);
-			d->cache(conferenceId, dbChatRoomId);
-
-			time_t creationTime = d->dbSession.getTime(row, 3);
-			time_t lastUpdateTime = d->dbSession.getTime(row, 4);
-			int capabilities = row.get<int>(5);
-			string subject = row.get<string>(6, "");
-			const long long &lastMessageId = d->dbSession.resolveId(row, 9);
-
-			shared_ptr<ChatRoomParams> params = ChatRoomParams::fromCapabilities(capabilities);
-			if (capabilities & ChatRoom::CapabilitiesMask(ChatRoom::Capabilities::Basic)) {
-				chatRoom = core->getPrivate()->createBasicChatRoom(conferenceId, capabilities, params);
-				chatRoom->setSubject(subject);
-			} else if (capabilities & ChatRoom::CapabilitiesMask(ChatRoom::Capabilities::Conference)) {
-#ifdef HAVE_ADVANCED_IM
-				list<shared_ptr<Participant>> participants;
-
-				static const string query = "SELECT chat_room_participant.id, sip_address.value, is_admin"
-					" FROM sip_address, chat_room, chat_room_participant"
-					" WHERE chat_room.id = :chatRoomId"
-					" AND sip_address.id = chat_room_participant.participant_sip_address_id"
-					" AND chat_room_participant.chat_room_id = chat_room.id";
-
-				// Fetch participants.
-				unsigned int lastNotifyId = getBackend() == Backend::Mysql
-					? row.get<unsigned int>(7, 0)
-					: static_cast<unsigned int>(row.get<int>(7, 0));
-				soci::rowset<soci::row> rows = (session->prepare << query, soci::use(dbChatRoomId));
-				shared_ptr<Participant> me;
-				for (const auto &row : rows) {
-					shared_ptr<Participant> participant = make_shared<Participant>(nullptr, IdentityAddress(row.get<string>(1)));
-					ParticipantPrivate *dParticipant = participant->getPrivate();
-					dParticipant->setAdmin(!!row.get<int>(2));
-
-					// Fetch devices.
-					{
-						const long long &participantId = d->dbSession.resolveId(row, 0);
-						static const string query = "SELECT sip_address.value, state, name FROM chat_room_participant_device, sip_address"
-							" WHERE chat_room_participant_id = :participantId"
-							" AND participant_device_sip_address_id = sip_address.id";
-
-						soci::rowset<soci::row> rows = (session->prepare << query, soci::use(participantId));
-						for (const auto &row : rows) {
-							shared_ptr<ParticipantDevice> device = dParticipant->addDevice(IdentityAddress(row.get<string>(0)), row.get<string>(2, ""));
-							device->setState(ParticipantDevice::State(static_cast<unsigned int>(row.get<int>(1, 0))));
-						}
-					}
-
-					if (participant->getAddress() == conferenceId.getLocalAddress().getAddressWithoutGruu())
-						me = participant;
-					else
-						participants.push_back(participant);
-				}
-
-				Conference *conference = nullptr;
-				if (!linphone_core_conference_server_enabled(core->getCCore())) {
-					bool hasBeenLeft = !!row.get<int>(8, 0);
-					if (!me) {
-						lError() << "Unable to find me in: (peer=" + conferenceId.getPeerAddress().asString() +
-							", local=" + conferenceId.getLocalAddress().asString() + ").";
-						continue;
-					}
-					shared_ptr<ClientGroupChatRoom> clientGroupChatRoom(new ClientGroupChatRoom(
-						core,
-						conferenceId,
-						me,
-						capabilities,
-						params,
-						subject,
-						move(participants),
-						lastNotifyId,
-						hasBeenLeft
-					));
-					chatRoom = clientGroupChatRoom;
-					conference = clientGroupChatRoom.get();
-					AbstractChatRoomPrivate *dChatRoom = chatRoom->getPrivate();
-					dChatRoom->setState(ChatRoom::State::Instantiated);
-					dChatRoom->setState(hasBeenLeft
-						? ChatRoom::State::Terminated
-						: ChatRoom::State::Created
-					);
-				} else {
-					auto serverGroupChatRoom = std::make_shared<ServerGroupChatRoom>(
-						core,
-						conferenceId.getPeerAddress(),
-						capabilities,
-						params,
-						subject,
-						move(participants),
-						lastNotifyId
-					);
-					chatRoom = serverGroupChatRoom;
-					conference = serverGroupChatRoom.get();
-					AbstractChatRoomPrivate *dChatRoom = chatRoom->getPrivate();
-					dChatRoom->setState(ChatRoom::State::Instantiated);
-					dChatRoom->setState(ChatRoom::State::Created);
-				}
-				for (auto participant : chatRoom->getParticipants())
-					participant->getPrivate()->setConference(conference);
-#else
-				lWarning() << "Advanced IM such as group chat is disabled!";
-#endif
-			}
-
-			if (!chatRoom)
-				continue; // Not fetched.
-
-			AbstractChatRoomPrivate *dChatRoom = chatRoom->getPrivate();
-			dChatRoom->setCreationTime(creationTime);
-			dChatRoom->setLastUpdateTime(lastUpdateTime);
-			dChatRoom->setIsEmpty(lastMessageId == 0);
-
-			lDebug() << "Found chat room in DB: (peer=" <<
-				conferenceId.getPeerAddress().asString() << ", local=" << conferenceId.getLocalAddress().asString() << ").";
-
-			chatRooms.push_back(chatRoom);
-		}
+		list<MainDbPrivate::ChatRoomRow> chatRoomRows;
+		unordered_map<long long, list<MainDbPrivate::ChatRoomParticipantRow>> participantsByChatRoomId;
+		d->selectChatRooms(chatRoomRows, participantsByChatRoomId);
+		list<shared_ptr<AbstractChatRoom>> chatRooms = d->buildChatRooms(chatRoomRows, participantsByChatRoomId);
 
 		tr.commit();
 
@@ -3103,10 +5037,10 @@ void MainDb::deleteChatRoom (const ConferenceId &conferenceId) {
 			dbChatRoomId
 		);
 
+		d->updateUnreadChatMessageCount(conferenceId, dbChatRoomId, -d->selectUnreadChatMessageCount(dbChatRoomId));
 		*d->dbSession.getBackendSession() << "DELETE FROM chat_room WHERE id = :chatRoomId", soci::use(dbChatRoomId);
 
 		tr.commit();
-		d->unreadChatMessageCountCache.insert(conferenceId, 0);
 	};
 #endif
 }
@@ -3137,6 +5071,9 @@ void MainDb::migrateBasicToClientGroupChatRoom (
 			" WHERE id = :chatRoomId", soci::use(capabilities), soci::use(peerSipAddressId),
 			soci::use(localSipAddressId), soci::use(dbChatRoomId);
 
+		// The local address may have changed, reload the unread counts on next use.
+		d->unreadChatMessageCountByLocalAddressLoaded = false;
+
 		shared_ptr<Participant> me = clientGroupChatRoom->getMe();
 		long long meId = d->insertChatRoomParticipant(
 			dbChatRoomId,
@@ -3330,6 +5267,389 @@ void MainDb::deleteChatRoomParticipantDevice (
 	
 // -----------------------------------------------------------------------------
 
+bool MainDb::addServerQueuedChatMessage (
+	const ConferenceId &conferenceId,
+	const ServerQueuedChatMessage &message,
+	const list<IdentityAddress> &deviceAddresses
+) {
+#ifdef HAVE_DB_STORAGE
+	return L_DB_TRANSACTION {
+		L_D();
+
+		const long long &dbChatRoomId = d->selectChatRoomId(conferenceId);
+		if (dbChatRoomId < 0)
+			return false;
+
+		soci::session *session = d->dbSession.getBackendSession();
+
+		const long long &fromSipAddressId = d->insertSipAddress(message.fromAddress.asString());
+		const long long &contentTypeId = d->insertContentType(message.content.getContentType().asString());
+		const vector<char> &body = message.content.getBody();
+		const string &headers = serializeServerQueuedChatMessageHeaders(message.headers);
+		const tm &creationTime = Utils::getTimeTAsTm(message.creationTime);
+		// TODO: Do not test backend, encapsulate!!!
+		if (getBackend() == MainDb::Backend::Sqlite3) {
+			soci::blob data(*session);
+			if (!body.empty())
+				data.write(0, &body[0], body.size());
+			insertServerQueuedChatMessage(
+				session, dbChatRoomId, fromSipAddressId, contentTypeId, data, headers, creationTime
+			);
+		} else {
+			string data(body.begin(), body.end());
+			insertServerQueuedChatMessage(
+				session, dbChatRoomId, fromSipAddressId, contentTypeId, data, headers, creationTime
+			);
+		}
+		const long long &messageId = d->dbSession.getLastInsertId();
+
+		bool trimmed = false;
+		for (const auto &deviceAddress : deviceAddresses) {
+			const long long &deviceSipAddressId = d->insertSipAddress(deviceAddress.asString());
+			*session << "INSERT INTO server_queued_chat_message_device (chat_room_id, device_sip_address_id, message_id)"
+				"  VALUES (:chatRoomId, :deviceSipAddressId, :messageId)",
+				soci::use(dbChatRoomId), soci::use(deviceSipAddressId), soci::use(messageId);
+			if (d->trimServerQueuedChatMessages(dbChatRoomId, deviceSipAddressId)) {
+				lWarning() << "Too many messages queued for `" << deviceAddress << "`, the oldest ones are dropped.";
+				trimmed = true;
+			}
+		}
+		if (trimmed)
+			d->deleteOrphanServerQueuedChatMessages(dbChatRoomId);
+
+		tr.commit();
+		return true;
+	};
+#else
+	return false;
+#endif
+}
+
+list<MainDb::ServerQueuedChatMessage> MainDb::takeServerQueuedChatMessages (
+	const ConferenceId &conferenceId,
+	const IdentityAddress &deviceAddress
+) {
+#ifdef HAVE_DB_STORAGE
+	static const string query = "SELECT from_sip_address.value, content_type.value, body, headers, creation_time"
+		"  FROM server_queued_chat_message_device"
+		"  JOIN server_queued_chat_message"
+		"    ON server_queued_chat_message.id = server_queued_chat_message_device.message_id"
+		"  JOIN sip_address AS from_sip_address"
+		"    ON from_sip_address.id = server_queued_chat_message.from_sip_address_id"
+		"  JOIN content_type ON content_type.id = server_queued_chat_message.content_type_id"
+		"  WHERE server_queued_chat_message_device.chat_room_id = :chatRoomId"
+		"  AND server_queued_chat_message_device.device_sip_address_id = :deviceSipAddressId"
+		"  AND server_queued_chat_message.creation_time >= :limitTime"
+		"  ORDER BY server_queued_chat_message_device.message_id";
+
+	return L_DB_TRANSACTION {
+		L_D();
+
+		list<ServerQueuedChatMessage> messages;
+		const long long &dbChatRoomId = d->selectChatRoomId(conferenceId);
+		const long long &deviceSipAddressId = d->selectSipAddressId(deviceAddress.asString());
+		if (dbChatRoomId < 0 || deviceSipAddressId < 0)
+			return messages;
+
+		soci::session *session = d->dbSession.getBackendSession();
+
+		// Expired messages may not be deleted yet.
+		const tm &limitTime = Utils::getTimeTAsTm(
+			d->serverQueuedMessageTtl ? time(nullptr) - time_t(d->serverQueuedMessageTtl) : 0
+		);
+		// TODO: Do not test backend, encapsulate!!!
+		if (getBackend() == MainDb::Backend::Sqlite3) {
+			soci::blob body(*session);
+			messages = fetchServerQueuedChatMessages(
+				session, query, dbChatRoomId, deviceSipAddressId, limitTime, body
+			);
+		} else {
+			string body;
+			messages = fetchServerQueuedChatMessages(
+				session, query, dbChatRoomId, deviceSipAddressId, limitTime, body
+			);
+		}
+
+		*session << "DELETE FROM server_queued_chat_message_device"
+			"  WHERE chat_room_id = :chatRoomId AND device_sip_address_id = :deviceSipAddressId",
+			soci::use(dbChatRoomId), soci::use(deviceSipAddressId);
+		d->deleteOrphanServerQueuedChatMessages(dbChatRoomId);
+
+		tr.commit();
+		return messages;
+	};
+#else
+	return list<ServerQueuedChatMessage>();
+#endif
+}
+
+void MainDb::deleteServerQueuedChatMessages (const ConferenceId &conferenceId, const IdentityAddress &deviceAddress) {
+#ifdef HAVE_DB_STORAGE
+	L_DB_TRANSACTION {
+		L_D();
+
+		const long long &dbChatRoomId = d->selectChatRoomId(conferenceId);
+		const long long &deviceSipAddressId = d->selectSipAddressId(deviceAddress.asString());
+		if (dbChatRoomId < 0 || deviceSipAddressId < 0)
+			return;
+
+		*d->dbSession.getBackendSession() << "DELETE FROM server_queued_chat_message_device"
+			"  WHERE chat_room_id = :chatRoomId AND device_sip_address_id = :deviceSipAddressId",
+			soci::use(dbChatRoomId), soci::use(deviceSipAddressId);
+		d->deleteOrphanServerQueuedChatMessages(dbChatRoomId);
+
+		tr.commit();
+	};
+#endif
+}
+
+void MainDb::sortServerQueuedChatMessages (list<shared_ptr<ServerQueuedChatMessage>> &messages) {
+	// std::list::sort is stable.
+	messages.sort([](const shared_ptr<ServerQueuedChatMessage> &a, const shared_ptr<ServerQueuedChatMessage> &b) {
+		return a->creationTime < b->creationTime;
+	});
+}
+
+int MainDb::getServerQueuedChatMessageCount (const ConferenceId &conferenceId, const IdentityAddress &deviceAddress) const {
+#ifdef HAVE_DB_STORAGE
+	return L_DB_TRANSACTION {
+		L_D();
+
+		const long long &dbChatRoomId = d->selectChatRoomId(conferenceId);
+		const long long &deviceSipAddressId = d->selectSipAddressId(deviceAddress.asString());
+		if (dbChatRoomId < 0 || deviceSipAddressId < 0)
+			return 0;
+
+		int count = 0;
+		*d->dbSession.getBackendSession() << "SELECT COUNT(*) FROM server_queued_chat_message_device"
+			"  WHERE chat_room_id = :chatRoomId AND device_sip_address_id = :deviceSipAddressId",
+			soci::use(dbChatRoomId), soci::use(deviceSipAddressId), soci::into(count);
+		return count;
+	};
+#else
+	return 0;
+#endif
+}
+
+int MainDb::deleteExpiredServerQueuedChatMessages () {
+#ifdef HAVE_DB_STORAGE
+	L_D();
+
+	if (!d->serverQueuedMessageTtl)
+		return 0;
+
+	return L_DB_TRANSACTION {
+		L_D();
+
+		soci::session *session = d->dbSession.getBackendSession();
+
+		const tm &limitTime = Utils::getTimeTAsTm(time(nullptr) - time_t(d->serverQueuedMessageTtl));
+		soci::rowset<soci::row> rows = (session->prepare << "SELECT id FROM server_queued_chat_message"
+			"  WHERE creation_time < :limitTime ORDER BY creation_time LIMIT " + Utils::toString(max(d->retentionBatchSize, 1u)),
+			soci::use(limitTime)
+		);
+		vector<string> ids;
+		for (const auto &row : rows)
+			ids.push_back(Utils::toString(d->dbSession.resolveId(row, 0)));
+		if (ids.empty())
+			return 0;
+
+		*session << "DELETE FROM server_queued_chat_message WHERE id IN (" + Utils::join(ids, ",") + ")";
+
+		tr.commit();
+		lDebug() << "Deleted " << ids.size() << " expired server queued messages.";
+		return int(ids.size());
+	};
+#else
+	return 0;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+
+bool MainDb::startAsyncThread (Backend backend, const string &parameters) {
+#ifdef HAVE_DB_STORAGE
+	L_D();
+
+	if (d->asyncThread.joinable())
+		return true;
+
+	unique_ptr<MainDb> asyncMainDb(new MainDb(getCore()));
+	MainDbPrivate *dAsyncMainDb = asyncMainDb->getPrivate();
+	dAsyncMainDb->isAsyncWorker = true;
+	dAsyncMainDb->fullTextSearchEnabled = d->fullTextSearchEnabled;
+	if (!asyncMainDb->connect(backend, parameters)) {
+		lError() << "Unable to open database connection of async thread, async calls are synchronous.";
+		return false;
+	}
+
+	// Both connections can write, wait for the lock of the other one instead of failing. The main loop
+	// connection only waits briefly: a write failing there is better than a frozen UI.
+	if (backend == Sqlite3) {
+		*d->dbSession.getBackendSession() << "PRAGMA busy_timeout = 100";
+		*dAsyncMainDb->dbSession.getBackendSession() << "PRAGMA busy_timeout = 5000";
+	}
+
+	d->asyncMainDb = move(asyncMainDb);
+	d->asyncThreadStopped = false;
+	d->asyncThread = thread(&MainDbPrivate::runAsyncLoop, d);
+
+	lInfo() << "MainDb async thread started.";
+	return true;
+#else
+	return false;
+#endif
+}
+
+void MainDb::stopAsyncThread () {
+	L_D();
+	d->stopAsyncThread();
+}
+
+void MainDb::getHistoryAsync (
+	const ConferenceId &conferenceId,
+	int nLast,
+	FilterMask mask,
+	const function<void (const list<shared_ptr<EventLog>> &)> &callback
+) const {
+	L_D();
+
+	if (!d->asyncMainDb) {
+		const list<shared_ptr<EventLog>> events = getHistory(conferenceId, nLast, mask);
+		getCore()->doLater([callback, events] { callback(events); });
+		return;
+	}
+
+	// Only rows are fetched by the async thread, events are built by the main loop.
+	auto eventRows = make_shared<list<MainDbPrivate::EventRow>>();
+	d->runAsync([conferenceId, nLast, mask, eventRows](MainDb &asyncMainDb) {
+		MainDbPrivate *dAsyncMainDb = asyncMainDb.getPrivate();
+		const string query = dAsyncMainDb->getHistoryRangeQuery(0, nLast, mask);
+		L_DB_TRANSACTION_C(&asyncMainDb) {
+			const long long &dbChatRoomId = dAsyncMainDb->selectChatRoomId(conferenceId);
+			soci::rowset<soci::row> rows = (
+				dAsyncMainDb->dbSession.getBackendSession()->prepare << query, soci::use(dbChatRoomId)
+			);
+			for (const auto &row : rows)
+				eventRows->push_front(dAsyncMainDb->selectEventRow(row));
+			tr.commit();
+		};
+	}, [d, conferenceId, callback, eventRows] {
+		list<shared_ptr<EventLog>> events;
+		shared_ptr<AbstractChatRoom> chatRoom = d->findChatRoom(conferenceId);
+		if (chatRoom)
+			for (const auto &eventRow : *eventRows) {
+				shared_ptr<EventLog> event = d->selectGenericConferenceEvent(chatRoom, eventRow);
+				if (event)
+					events.push_back(event);
+			}
+		callback(events);
+	});
+}
+
+void MainDb::getChatRoomsAsync (const function<void (const list<shared_ptr<AbstractChatRoom>> &)> &callback) const {
+	L_D();
+
+	if (!d->asyncMainDb) {
+		const list<shared_ptr<AbstractChatRoom>> chatRooms = getChatRooms();
+		getCore()->doLater([callback, chatRooms] { callback(chatRooms); });
+		return;
+	}
+
+	// Only rows are fetched by the async thread, chat rooms are built by the main loop.
+	auto chatRoomRows = make_shared<list<MainDbPrivate::ChatRoomRow>>();
+	auto participantsByChatRoomId = make_shared<unordered_map<long long, list<MainDbPrivate::ChatRoomParticipantRow>>>();
+	d->runAsync([chatRoomRows, participantsByChatRoomId](MainDb &asyncMainDb) {
+		L_DB_TRANSACTION_C(&asyncMainDb) {
+			asyncMainDb.getPrivate()->selectChatRooms(*chatRoomRows, *participantsByChatRoomId);
+			tr.commit();
+		};
+	}, [d, callback, chatRoomRows, participantsByChatRoomId] {
+		callback(d->buildChatRooms(*chatRoomRows, *participantsByChatRoomId));
+	});
+}
+
+void MainDb::cleanHistoryAsync (const ConferenceId &conferenceId, FilterMask mask, const function<void ()> &callback) {
+	L_D();
+
+	if (!d->asyncMainDb) {
+		cleanHistory(conferenceId, mask);
+		if (callback)
+			getCore()->doLater(callback);
+		return;
+	}
+
+	// Write queued updates first, writes are done in call order.
+	d->flushPendingUpdates();
+
+	auto eventIds = make_shared<list<long long>>();
+	d->runAsync([conferenceId, mask, eventIds](MainDb &asyncMainDb) {
+		asyncMainDb.getPrivate()->cleanHistory(conferenceId, mask, eventIds.get());
+	}, [d, conferenceId, mask, callback, eventIds] {
+		for (const auto &eventId : *eventIds)
+			d->invalidConferenceEvent(eventId);
+
+		if (!mask || (mask & ConferenceChatMessageFilter)) {
+			d->unreadChatMessageCountCache.insert(conferenceId, 0);
+			d->unreadChatMessageCountByLocalAddressLoaded = false;
+		}
+
+		if (callback)
+			callback();
+	});
+}
+
+void MainDb::addEventAsync (const shared_ptr<EventLog> &eventLog, const function<void (bool)> &callback) {
+	L_D();
+
+	// Only chat messages are inserted by the async thread, other events are rare.
+	if (!d->asyncMainDb || eventLog->getType() != EventLog::Type::ConferenceChatMessage) {
+		const bool result = addEvent(eventLog);
+		if (callback)
+			getCore()->doLater([callback, result] { callback(result); });
+		return;
+	}
+
+	if (eventLog->getPrivate()->dbKey.isValid()) {
+		lWarning() << "Unable to add an event twice!!!";
+		if (callback)
+			getCore()->doLater([callback] { callback(false); });
+		return;
+	}
+
+	// Write queued updates first, writes are done in call order.
+	d->flushPendingUpdates();
+
+	// The async thread inserts values copied here, the event gets its key in the main loop.
+	auto chatMessageRow = make_shared<const MainDbPrivate::ChatMessageEventInsertRow>(
+		d->getChatMessageEventInsertRow(eventLog)
+	);
+	auto eventId = make_shared<long long>(-1);
+	d->runAsync([chatMessageRow, eventId](MainDb &asyncMainDb) {
+		L_DB_TRANSACTION_C(&asyncMainDb) {
+			const long long &insertedEventId = asyncMainDb.getPrivate()->insertConferenceChatMessageEvent(*chatMessageRow);
+			if (insertedEventId < 0)
+				return;
+			tr.commit();
+			*eventId = insertedEventId;
+		};
+	}, [d, eventLog, chatMessageRow, callback, eventId] {
+		const bool result = *eventId >= 0;
+		if (result) {
+			d->cache(eventLog, *eventId);
+			d->cache(static_pointer_cast<ConferenceChatMessageEvent>(eventLog)->getChatMessage(), *eventId);
+			if (!chatMessageRow->markedAsRead)
+				d->updateUnreadChatMessageCountCache(chatMessageRow->conferenceId, 1);
+		} else
+			lError() << "MainDb::addEventAsync() failed.";
+
+		if (callback)
+			callback(result);
+	});
+}
+
+// -----------------------------------------------------------------------------
+
 bool MainDb::import (Backend, const string &parameters) {
 #ifdef HAVE_DB_STORAGE
 	L_D();
@@ -3355,4 +5675,22 @@ bool MainDb::import (Backend, const string &parameters) {
 #endif
 }
 
+unsigned long MainDb::getPreparedStatementHitCount () const {
+#ifdef HAVE_DB_STORAGE
+	L_D();
+	return d->dbSession.getPreparedStatementCache().getHitCount();
+#else
+	return 0;
+#endif
+}
+
+unsigned long MainDb::getPreparedStatementMissCount () const {
+#ifdef HAVE_DB_STORAGE
+	L_D();
+	return d->dbSession.getPreparedStatementCache().getMissCount();
+#else
+	return 0;
+#endif
+}
+
 LINPHONE_END_NAMESPACE
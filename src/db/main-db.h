@@ -21,12 +21,14 @@
 #define _L_MAIN_DB_H_
 
 #include <functional>
+#include <unordered_map>
 
 #include "linphone/utils/enum-mask.h"
 
 #include "abstract/abstract-db.h"
 #include "chat/chat-message/chat-message.h"
 #include "conference/conference-id.h"
+#include "content/content.h"
 #include "core/core-accessor.h"
 
 // =============================================================================
@@ -69,6 +71,15 @@ public:
 		time_t timestamp = 0;
 	};
 
+	// Message kept by a server group chat room until the devices it is queued for can receive it.
+	struct ServerQueuedChatMessage {
+		IdentityAddress fromAddress;
+		Content content;
+		// Custom headers forwarded with the message, as (name, value) pairs.
+		std::list<std::pair<std::string, std::string>> headers;
+		time_t creationTime = 0;
+	};
+
 	MainDb (const std::shared_ptr<Core> &core);
 
 	// ---------------------------------------------------------------------------
@@ -76,6 +87,7 @@ public:
 	// ---------------------------------------------------------------------------
 
 	bool addEvent (const std::shared_ptr<EventLog> &eventLog);
+	bool addEvents (const std::list<std::shared_ptr<EventLog>> &eventLogs);
 	bool updateEvent (const std::shared_ptr<EventLog> &eventLog);
 	static bool deleteEvent (const std::shared_ptr<const EventLog> &eventLog);
 	int getEventCount (FilterMask mask = NoFilter) const;
@@ -99,6 +111,7 @@ public:
 
 	int getChatMessageCount (const ConferenceId &conferenceId = ConferenceId()) const;
 	int getUnreadChatMessageCount (const ConferenceId &conferenceId = ConferenceId()) const;
+	const std::unordered_map<IdentityAddress, int> &getUnreadChatMessageCountByLocalAddress () const;
 
 	void markChatMessagesAsRead (const ConferenceId &conferenceId) const;
 	std::list<std::shared_ptr<ChatMessage>> getUnreadChatMessages (const ConferenceId &conferenceId) const;
@@ -119,6 +132,13 @@ public:
 		time_t stateChangeTime
 	);
 
+	// Write pending chat message updates queued by the write-behind mode.
+	void flushPendingUpdates ();
+
+	// Stop the history retention timer enabled by the retention_* settings of the storage section
+	// and the expiry timer of the server queued messages.
+	void stopHistoryRetention ();
+
 	bool isChatRoomEmpty (const ConferenceId &conferenceId) const;
 	std::shared_ptr<ChatMessage> getLastChatMessage (const ConferenceId &conferenceId) const;
 
@@ -129,6 +149,19 @@ public:
 
 	std::list<std::shared_ptr<ChatMessage>> findChatMessagesToBeNotifiedAsDelivered () const;
 
+	// False if the option is disabled or if the SQLite library lacks FTS5.
+	bool isFullTextSearchEnabled () const;
+
+	// Requires the [storage] full_text_search_enabled option. Results are ordered by relevance,
+	// pass the returned cursor to get the next page.
+	std::list<std::shared_ptr<ChatMessage>> searchChatMessages (
+		const std::string &text,
+		const ConferenceId &conferenceId,
+		int count,
+		int cursor = 0,
+		int *nextCursor = nullptr
+	) const;
+
 	// ---------------------------------------------------------------------------
 	// Conference events.
 	// ---------------------------------------------------------------------------
@@ -145,6 +178,14 @@ public:
 		FilterMask mask = NoFilter
 	) const;
 
+	std::list<std::shared_ptr<EventLog>> getHistoryBefore (
+		const ConferenceId &conferenceId,
+		long long beforeEventId,
+		int count,
+		FilterMask mask = NoFilter,
+		long long *nextEventId = nullptr
+	) const;
+
 	int getHistorySize (const ConferenceId &conferenceId, FilterMask mask = NoFilter) const;
 
 	void cleanHistory (const ConferenceId &conferenceId, FilterMask mask = NoFilter);
@@ -198,6 +239,67 @@ public:
 		const std::shared_ptr<ParticipantDevice> &device
 	);
 
+	// ---------------------------------------------------------------------------
+	// Server group chat rooms.
+	// ---------------------------------------------------------------------------
+
+	// The message is stored once for all the devices. Each device keeps at most the number of messages given
+	// by the server_queued_message_max_per_device setting of the storage section, the oldest ones are dropped.
+	// Returns false if the message cannot be stored.
+	bool addServerQueuedChatMessage (
+		const ConferenceId &conferenceId,
+		const ServerQueuedChatMessage &message,
+		const std::list<IdentityAddress> &deviceAddresses
+	);
+
+	// Remove the messages queued for a device and return the ones which are not expired, oldest first.
+	std::list<ServerQueuedChatMessage> takeServerQueuedChatMessages (
+		const ConferenceId &conferenceId,
+		const IdentityAddress &deviceAddress
+	);
+
+	void deleteServerQueuedChatMessages (const ConferenceId &conferenceId, const IdentityAddress &deviceAddress);
+
+	// Order messages taken from the database and from the in-memory fallback queue by creation time.
+	// Messages with the same creation time keep their relative order.
+	static void sortServerQueuedChatMessages (std::list<std::shared_ptr<ServerQueuedChatMessage>> &messages);
+
+	int getServerQueuedChatMessageCount (const ConferenceId &conferenceId, const IdentityAddress &deviceAddress) const;
+
+	// Delete a batch of messages older than the server_queued_message_ttl_s setting of the storage section.
+	// Returns the number of deleted messages.
+	int deleteExpiredServerQueuedChatMessages ();
+
+	// ---------------------------------------------------------------------------
+	// Asynchronous API.
+	// ---------------------------------------------------------------------------
+
+	// Open a second connection used by a dedicated thread to execute async calls.
+	// Without this thread, async calls are executed synchronously.
+	bool startAsyncThread (Backend backend, const std::string &parameters);
+	void stopAsyncThread ();
+
+	// Callbacks are always called from the core main loop. Writes are executed in call order.
+	// An event given to addEventAsync must not be used with MainDb before its callback is called.
+	void getHistoryAsync (
+		const ConferenceId &conferenceId,
+		int nLast,
+		FilterMask mask,
+		const std::function<void (const std::list<std::shared_ptr<EventLog>> &)> &callback
+	) const;
+	void getChatRoomsAsync (
+		const std::function<void (const std::list<std::shared_ptr<AbstractChatRoom>> &)> &callback
+	) const;
+	void cleanHistoryAsync (
+		const ConferenceId &conferenceId,
+		FilterMask mask = NoFilter,
+		const std::function<void ()> &callback = nullptr
+	);
+	void addEventAsync (
+		const std::shared_ptr<EventLog> &eventLog,
+		const std::function<void (bool)> &callback = nullptr
+	);
+
 	// ---------------------------------------------------------------------------
 	// Other.
 	// ---------------------------------------------------------------------------
@@ -205,6 +307,9 @@ public:
 	// Import legacy calls/messages from old db.
 	bool import (Backend backend, const std::string &parameters) override;
 
+	unsigned long getPreparedStatementHitCount () const;
+	unsigned long getPreparedStatementMissCount () const;
+
 protected:
 	void init () override;
 
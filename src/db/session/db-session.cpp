@@ -20,6 +20,7 @@
 #include "linphone/utils/utils.h"
 
 #include "db-session.h"
+#include "db/internal/statements.h"
 #include "logger/logger.h"
 
 // =============================================================================
@@ -37,6 +38,9 @@ public:
 	} backend = Backend::None;
 
 	std::unique_ptr<soci::session> backendSession;
+
+	// Declared after the backend session: prepared statements must be released first.
+	PreparedStatementCache preparedStatementCache;
 };
 
 DbSession::DbSession () : mPrivate(new DbSessionPrivate) {}
@@ -74,6 +78,11 @@ soci::session *DbSession::getBackendSession () const {
 	return d->backendSession.get();
 }
 
+PreparedStatementCache &DbSession::getPreparedStatementCache () const {
+	L_D();
+	return const_cast<PreparedStatementCache &>(d->preparedStatementCache);
+}
+
 string DbSession::primaryKeyStr (const string &type) const {
 	L_D();
 
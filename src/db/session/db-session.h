@@ -29,6 +29,7 @@
 LINPHONE_BEGIN_NAMESPACE
 
 class DbSessionPrivate;
+class PreparedStatementCache;
 
 class DbSession {
 public:
@@ -42,6 +43,7 @@ public:
 	operator bool () const;
 
 	soci::session *getBackendSession () const;
+	PreparedStatementCache &getPreparedStatementCache () const;
 
 	std::string primaryKeyStr (const std::string &type = "INT") const;
 	std::string primaryKeyRefStr (const std::string &type = "INT") const;
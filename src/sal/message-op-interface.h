@@ -28,6 +28,47 @@
 
 LINPHONE_BEGIN_NAMESPACE
 
+// Body and content headers of a MESSAGE. They are built once when the same message is sent to several recipients.
+class SalMessageContent {
+public:
+	explicit SalMessageContent (const Content &content) {
+		std::string contentEncoding = content.getContentEncoding();
+		if (!contentEncoding.empty())
+			mContentEncodingHeader = BELLE_SIP_HEADER(belle_sip_object_ref(
+				belle_sip_header_create("Content-Encoding", contentEncoding.c_str())
+			));
+		std::string contentTypeStr = content.getContentType().asString();
+		belle_sip_header_content_type_t *contentTypeHeader = belle_sip_header_content_type_parse(contentTypeStr.c_str());
+		if (contentTypeHeader)
+			mContentTypeHeader = BELLE_SIP_HEADER(belle_sip_object_ref(contentTypeHeader));
+		if (!content.isEmpty()) {
+			mBody = content.getBodyAsUtf8String();
+			mHasBody = true;
+		}
+	}
+
+	~SalMessageContent () {
+		if (mContentEncodingHeader)
+			belle_sip_object_unref(mContentEncodingHeader);
+		if (mContentTypeHeader)
+			belle_sip_object_unref(mContentTypeHeader);
+	}
+
+	size_t getBodySize () const {
+		return mBody.size();
+	}
+
+private:
+	friend class SalMessageOpInterface;
+
+	belle_sip_header_t *mContentEncodingHeader = nullptr;
+	belle_sip_header_t *mContentTypeHeader = nullptr;
+	std::string mBody;
+	bool mHasBody = false;
+
+	L_DISABLE_COPY(SalMessageContent);
+};
+
 class SalMessageOpInterface {
 public:
 	virtual ~SalMessageOpInterface() = default;
@@ -37,36 +78,38 @@ public:
 
 protected:
 	void prepareMessageRequest (belle_sip_request_t *req, const Content &content) {
+		prepareMessageRequest(req, SalMessageContent(content));
+	}
+
+	// Headers are cloned for each request, the body is copied.
+	void prepareMessageRequest (belle_sip_request_t *req, const SalMessageContent &content) {
 		time_t curtime = std::time(nullptr);
 		belle_sip_message_add_header(
 			BELLE_SIP_MESSAGE(req),
 			BELLE_SIP_HEADER(belle_sip_header_date_create_from_time(&curtime))
 		);
-		std::string contentEncoding = content.getContentEncoding();
-		if (!contentEncoding.empty())
+		if (content.mContentEncodingHeader)
 			belle_sip_message_add_header(
 				BELLE_SIP_MESSAGE(req),
-				belle_sip_header_create("Content-Encoding", contentEncoding.c_str())
+				BELLE_SIP_HEADER(belle_sip_object_clone(BELLE_SIP_OBJECT(content.mContentEncodingHeader)))
 			);
-		const ContentType &contentType = content.getContentType();
-		std::string contentTypeStr = contentType.asString();
-		belle_sip_message_add_header(
-			BELLE_SIP_MESSAGE(req),
-			BELLE_SIP_HEADER(belle_sip_header_content_type_parse(contentTypeStr.c_str()))
-		);
-		if (content.isEmpty()) {
+		if (content.mContentTypeHeader)
+			belle_sip_message_add_header(
+				BELLE_SIP_MESSAGE(req),
+				BELLE_SIP_HEADER(belle_sip_object_clone(BELLE_SIP_OBJECT(content.mContentTypeHeader)))
+			);
+		if (!content.mHasBody) {
 			belle_sip_message_add_header(
 				BELLE_SIP_MESSAGE(req),
 				BELLE_SIP_HEADER(belle_sip_header_content_length_create(0))
 			);
 		} else {
-			std::string body = content.getBodyAsUtf8String();
-			size_t contentLength = body.size();
+			size_t contentLength = content.mBody.size();
 			belle_sip_message_add_header(
 				BELLE_SIP_MESSAGE(req),
 				BELLE_SIP_HEADER(belle_sip_header_content_length_create(contentLength))
 			);
-			belle_sip_message_set_body(BELLE_SIP_MESSAGE(req), body.c_str(), contentLength);
+			belle_sip_message_set_body(BELLE_SIP_MESSAGE(req), content.mBody.c_str(), contentLength);
 		}
 	}
 
@@ -90,4 +90,15 @@ int SalMessageOp::sendMessage (const Content &content) {
 	return sendRequest(request);
 }
 
+int SalMessageOp::sendMessage (const SalMessageContent &content) {
+	mDir = Dir::Outgoing;
+
+	auto request = buildRequest("MESSAGE");
+	if (!request)
+		return -1;
+
+	prepareMessageRequest(request, content);
+	return sendRequest(request);
+}
+
 LINPHONE_END_NAMESPACE
@@ -30,6 +30,7 @@ public:
 	SalMessageOp (Sal *sal);
 
 	int sendMessage (const Content &content) override;
+	int sendMessage (const SalMessageContent &content);
 	int reply (SalReason reason) override { return SalOp::replyMessage(reason); }
 
 private:
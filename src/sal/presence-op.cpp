@@ -379,15 +379,27 @@ belle_sip_request_t *SalPresenceOp::createPresenceNotify () {
 	return request;
 }
 
-void SalPresenceOp::addPresenceInfo (belle_sip_message_t *notify, SalPresenceModel *presence) {
-	char *content = nullptr;
+void SalPresenceOp::addPresenceInfo (belle_sip_message_t *notify, SalPresenceModel *presence, PresenceBodies *bodies) {
+	string content;
 
 	if (presence) {
 		auto fromHeader = belle_sip_message_get_header_by_type(notify, belle_sip_header_from_t);
 		char *contactInfo = belle_sip_uri_to_string(belle_sip_header_address_get_uri(BELLE_SIP_HEADER_ADDRESS(fromHeader)));
-		mRoot->mCallbacks.convert_presence_to_xml_requested(this, presence, contactInfo, &content);
+		PresenceBodies::const_iterator it;
+		if (bodies && (it = bodies->find(contactInfo)) != bodies->end()) {
+			content = it->second;
+		} else {
+			char *xml = nullptr;
+			mRoot->mCallbacks.convert_presence_to_xml_requested(this, presence, contactInfo, &xml);
+			if (xml) {
+				content = xml;
+				ms_free(xml);
+				if (bodies)
+					(*bodies)[contactInfo] = content;
+			}
+		}
 		belle_sip_free(contactInfo);
-		if (!content)
+		if (content.empty())
 			return;
 	}
 
@@ -395,8 +407,8 @@ void SalPresenceOp::addPresenceInfo (belle_sip_message_t *notify, SalPresenceMod
 	belle_sip_message_remove_header(BELLE_SIP_MESSAGE(notify), BELLE_SIP_CONTENT_LENGTH);
 	belle_sip_message_set_body(BELLE_SIP_MESSAGE(notify), nullptr, 0);
 
-	if (content) {
-		size_t contentLength = strlen(content);
+	if (!content.empty()) {
+		size_t contentLength = content.size();
 		belle_sip_message_add_header(
 			BELLE_SIP_MESSAGE(notify),
 			BELLE_SIP_HEADER(belle_sip_header_content_type_create("application", "pidf+xml"))
@@ -405,12 +417,11 @@ void SalPresenceOp::addPresenceInfo (belle_sip_message_t *notify, SalPresenceMod
 			BELLE_SIP_MESSAGE(notify),
 			BELLE_SIP_HEADER(belle_sip_header_content_length_create(contentLength))
 		);
-		belle_sip_message_set_body(BELLE_SIP_MESSAGE(notify), content, contentLength);
-		ms_free(content);
+		belle_sip_message_set_body(BELLE_SIP_MESSAGE(notify), content.c_str(), contentLength);
 	}
 }
 
-int SalPresenceOp::notifyPresence (SalPresenceModel *presence) {
+int SalPresenceOp::notifyPresence (SalPresenceModel *presence, PresenceBodies *bodies) {
 	if (checkDialogState())
 		return -1;
 
@@ -418,7 +429,7 @@ int SalPresenceOp::notifyPresence (SalPresenceModel *presence) {
 	if (!request)
 		return-1;
 
-	addPresenceInfo(BELLE_SIP_MESSAGE(request), presence); // FIXME, what about expires??
+	addPresenceInfo(BELLE_SIP_MESSAGE(request), presence, bodies); // FIXME, what about expires??
 	belle_sip_message_add_header(
 		BELLE_SIP_MESSAGE(request),
 		BELLE_SIP_HEADER(belle_sip_header_subscription_state_create(BELLE_SIP_SUBSCRIPTION_STATE_ACTIVE, 600))
@@ -20,17 +20,23 @@
 #ifndef _L_SAL_PRESENCE_OP_H_
 #define _L_SAL_PRESENCE_OP_H_
 
+#include <string>
+#include <unordered_map>
+
 #include "sal/event-op.h"
 
 LINPHONE_BEGIN_NAMESPACE
 
 class SalPresenceOp : public SalSubscribeOp {
 public:
+	// Presence bodies by contact, to serialize a model once when it is notified to several watchers.
+	using PresenceBodies = std::unordered_map<std::string, std::string>;
+
 	SalPresenceOp (Sal *sal);
 
 	int subscribe (int expires);
 	int unsubscribe () { return SalOp::unsubscribe(); }
-	int notifyPresence (SalPresenceModel *presence);
+	int notifyPresence (SalPresenceModel *presence, PresenceBodies *bodies = nullptr);
 	int notifyPresenceClose ();
 
 private:
@@ -39,7 +45,7 @@ private:
 	SalPresenceModel *processPresenceNotification (belle_sip_request_t *request);
 	int checkDialogState ();
 	belle_sip_request_t *createPresenceNotify ();
-	void addPresenceInfo (belle_sip_message_t *notify, SalPresenceModel *presence);
+	void addPresenceInfo (belle_sip_message_t *notify, SalPresenceModel *presence, PresenceBodies *bodies = nullptr);
 
 	static SalSubscribeStatus getSubscriptionState (const belle_sip_message_t *message);
 
@@ -665,6 +665,14 @@ bool Sal::isContentEncodingAvailable (const string &contentEncoding) const {
 	return !!belle_sip_stack_content_encoding_available(mStack, L_STRING_TO_C(contentEncoding));
 }
 
+// Encode the body now instead of when the first message using it is sent. The encoding is applied only once,
+// so a body handler shared by several messages is compressed a single time.
+void Sal::applyContentEncoding (SalBodyHandler *bodyHandler) const {
+	belle_sip_body_handler_t *bh = BELLE_SIP_BODY_HANDLER(bodyHandler);
+	if (BELLE_SIP_OBJECT_IS_INSTANCE_OF(bh, belle_sip_memory_body_handler_t))
+		belle_sip_memory_body_handler_apply_encoding(BELLE_SIP_MEMORY_BODY_HANDLER(bh), mStack);
+}
+
 bool Sal::isContentTypeSupported (const string &contentType) const {
 	auto it = find_if(mSupportedContentTypes.cbegin(), mSupportedContentTypes.cend(),
 		[contentType](string supportedContentType) {
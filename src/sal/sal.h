@@ -148,6 +148,7 @@ public:
 	void appendStackStringToUserAgent ();
 
 	bool isContentEncodingAvailable (const std::string &contentEncoding) const;
+	void applyContentEncoding (SalBodyHandler *bodyHandler) const;
 	bool isContentTypeSupported (const std::string &contentType) const;
 	void addContentTypeSupport (const std::string &contentType);
 	void removeContentTypeSupport (const std::string &contentType);
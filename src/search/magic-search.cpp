@@ -371,9 +371,11 @@ list<SearchResult> MagicSearch::searchInFriend (const LinphoneFriend *lFriend, c
 	unsigned int weight = getMinWeight();
 
 	// NAME
+	// Use the friend name rather than its vCard so that friends loaded from the database do not get parsed.
 	if (linphone_core_vcard_supported()) {
-		if (linphone_friend_get_vcard(lFriend)) {
-			weight += getWeight(linphone_vcard_get_full_name(linphone_friend_get_vcard(lFriend)), filter) * 3;
+		const char *name = linphone_friend_get_name(lFriend);
+		if (name) {
+			weight += getWeight(name, filter) * 3;
 		}
 	}
 
@@ -18,6 +18,7 @@
  */
 
 
+#include <ctype.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include "linphone/core.h"
@@ -4757,6 +4758,59 @@ static void call_logs_sqlite_storage(void) {
 	end_call(marie, pauline);
 	BC_ASSERT_TRUE(linphone_core_get_call_history_size(marie->lc) == 2);
 
+	{
+		const LinphoneAddress *marie_addr = linphone_proxy_config_get_identity_address(linphone_core_get_default_proxy_config(marie->lc));
+		const LinphoneAddress *pauline_addr = linphone_proxy_config_get_identity_address(linphone_core_get_default_proxy_config(pauline->lc));
+		LinphoneCallLog *last_log = NULL;
+
+		logs = linphone_core_get_call_history_2(marie->lc, pauline_addr, marie_addr);
+		BC_ASSERT_EQUAL((int)bctbx_list_size(logs), 2, int, "%d");
+		if (logs) last_log = linphone_call_log_ref((LinphoneCallLog *)bctbx_list_get_data(logs));
+		bctbx_list_free_with_data(logs, (void (*)(void*))linphone_call_log_unref);
+
+		logs = linphone_core_get_call_history_range(marie->lc, pauline_addr, marie_addr, 0, 1);
+		if (BC_ASSERT_EQUAL((int)bctbx_list_size(logs), 1, int, "%d"))
+			BC_ASSERT_PTR_EQUAL(bctbx_list_get_data(logs), last_log);
+		bctbx_list_free_with_data(logs, (void (*)(void*))linphone_call_log_unref);
+
+		logs = linphone_core_get_call_history_range(marie->lc, pauline_addr, NULL, 1, 10);
+		BC_ASSERT_EQUAL((int)bctbx_list_size(logs), 1, int, "%d");
+		bctbx_list_free_with_data(logs, (void (*)(void*))linphone_call_log_unref);
+
+		logs = linphone_core_get_call_history_range(marie->lc, pauline_addr, marie_addr, 2, 10);
+		BC_ASSERT_PTR_NULL(logs);
+
+		{
+			/* Scheme and host are compared case insensitively, the port is part of the uri. */
+			LinphoneAddress *other_case = linphone_address_clone(pauline_addr);
+			LinphoneAddress *other_port = linphone_address_clone(pauline_addr);
+			char *upper_domain = ms_strdup(linphone_address_get_domain(pauline_addr));
+			char *it;
+
+			for (it = upper_domain; *it != '\0'; it++)
+				*it = (char)toupper((unsigned char)*it);
+			linphone_address_set_domain(other_case, upper_domain);
+			linphone_address_set_port(other_port, 5999);
+
+			logs = linphone_core_get_call_history_for_address(marie->lc, other_case);
+			BC_ASSERT_EQUAL((int)bctbx_list_size(logs), 2, int, "%d");
+			bctbx_list_free_with_data(logs, (void (*)(void*))linphone_call_log_unref);
+
+			logs = linphone_core_get_call_history_2(marie->lc, other_case, marie_addr);
+			BC_ASSERT_EQUAL((int)bctbx_list_size(logs), 2, int, "%d");
+			bctbx_list_free_with_data(logs, (void (*)(void*))linphone_call_log_unref);
+
+			logs = linphone_core_get_call_history_for_address(marie->lc, other_port);
+			BC_ASSERT_PTR_NULL(logs);
+
+			ms_free(upper_domain);
+			linphone_address_unref(other_case);
+			linphone_address_unref(other_port);
+		}
+
+		if (last_log) linphone_call_log_unref(last_log);
+	}
+
 	linphone_core_delete_call_history(marie->lc);
 	BC_ASSERT_TRUE(linphone_core_get_call_history_size(marie->lc) == 0);
 
@@ -4766,6 +4820,47 @@ static void call_logs_sqlite_storage(void) {
 	ms_free(logs_db);
 }
 
+static double store_call_logs(LinphoneCore *lc, int count) {
+	LinphoneAddress *from = linphone_address_new("sip:marie@sip.example.org");
+	LinphoneAddress *to = linphone_address_new("sip:pauline@sip.example.org");
+	uint64_t begin, end;
+	int i;
+
+	begin = ms_get_cur_time_ms();
+	for (i = 0; i < count; i++) {
+		LinphoneCallLog *log = linphone_core_create_call_log(lc, from, to, LinphoneCallOutgoing, 10, time(NULL), time(NULL), LinphoneCallSuccess, FALSE, 5.0f);
+		linphone_call_log_unref(log);
+	}
+	BC_ASSERT_EQUAL(linphone_core_get_call_history_size(lc), count, int, "%d");
+	end = ms_get_cur_time_ms();
+
+	linphone_address_unref(from);
+	linphone_address_unref(to);
+	return count * 1000.0 / (double)(end > begin ? end - begin : 1);
+}
+
+static void call_logs_sqlite_storage_benchmark(void) {
+	LinphoneCoreManager* marie = linphone_core_manager_new("marie_rc");
+	char *logs_db = bc_tester_file("call_logs.db");
+	const int count = 2000;
+	double rate;
+
+	unlink(logs_db);
+	linphone_core_set_call_logs_database_path(marie->lc, logs_db);
+	rate = store_call_logs(marie->lc, count);
+	ms_message("%d call logs stored one by one: %.0f inserts/s", count, rate);
+
+	unlink(logs_db);
+	linphone_config_set_int(linphone_core_get_config(marie->lc), "misc", "call_logs_db_batch_size", 100);
+	linphone_core_set_call_logs_database_path(marie->lc, logs_db);
+	rate = store_call_logs(marie->lc, count);
+	ms_message("%d call logs stored in batches of 100: %.0f inserts/s", count, rate);
+
+	linphone_core_manager_destroy(marie);
+	unlink(logs_db);
+	ms_free(logs_db);
+}
+
 static void call_with_http_proxy(void) {
 	LinphoneCoreManager* marie = linphone_core_manager_create("marie_rc");
 	LinphoneCoreManager* pauline = linphone_core_manager_create("pauline_rc");
@@ -5186,6 +5281,7 @@ test_t call_tests[] = {
 	TEST_NO_TAG("Call log working if no db set", call_logs_if_no_db_set),
 	TEST_NO_TAG("Call log storage migration from rc to db", call_logs_migrate),
 	TEST_NO_TAG("Call log storage in sqlite database", call_logs_sqlite_storage),
+	TEST_NO_TAG("Call log storage in sqlite database benchmark", call_logs_sqlite_storage_benchmark),
 	TEST_NO_TAG("Call with custom RTP Modifier", call_with_custom_rtp_modifier),
 	TEST_NO_TAG("Call paused resumed with custom RTP Modifier", call_paused_resumed_with_custom_rtp_modifier),
 	TEST_NO_TAG("Call record with custom RTP Modifier", call_record_with_custom_rtp_modifier),
@@ -1336,6 +1336,185 @@ void one_to_one_keyword () {
 	linphone_core_manager_destroy(pauline);
 }
 
+void notify_unsubscribed_devices () {
+	LinphoneCoreManager *pauline = linphone_core_manager_new(transport_supported(LinphoneTransportTls) ? "pauline_rc" : "pauline_tcp_rc");
+	char *identityStr = linphone_address_as_string(pauline->identity);
+	Address addr(identityStr);
+	bctbx_free(identityStr);
+	shared_ptr<LocalConference> localConf = make_shared<LocalConference>(pauline->lc->cppPtr, addr, nullptr);
+	LinphoneAddress *cBobAddr = linphone_core_interpret_url(pauline->lc, bobUri);
+	char *bobAddrStr = linphone_address_as_string(cBobAddr);
+	Address bobAddr(bobAddrStr);
+	bctbx_free(bobAddrStr);
+	linphone_address_unref(cBobAddr);
+	LinphoneAddress *cAliceAddr = linphone_core_interpret_url(pauline->lc, aliceUri);
+	char *aliceAddrStr = linphone_address_as_string(cAliceAddr);
+	Address aliceAddr(aliceAddrStr);
+	bctbx_free(aliceAddrStr);
+	linphone_address_unref(cAliceAddr);
+
+	CallSessionParams params;
+	localConf->addParticipant(bobAddr, &params, false);
+	localConf->addParticipant(aliceAddr, &params, false);
+	const unique_ptr<LocalConferenceEventHandler> &localHandler = L_ATTR_GET(L_GET_PRIVATE(localConf), eventHandler);
+	LocalConferenceEventHandlerPrivate *localHandlerPrivate = L_GET_PRIVATE(localHandler);
+	const_cast<IdentityAddress &>(localConf->getConferenceAddress()) = addr;
+
+	// No device is subscribed: the notify id is consumed but no body is built nor compressed.
+	localConf->setSubject("A random test subject");
+	localHandler->notifySubjectChanged();
+	localHandler->notifyParticipantDeviceAdded(aliceAddr, aliceAddr);
+
+	BC_ASSERT_EQUAL(localHandlerPrivate->getLastNotify(), 2, int, "%d");
+	BC_ASSERT_EQUAL(localHandlerPrivate->getFanOutStats().bodiesEncoded, 0, int, "%d");
+	BC_ASSERT_EQUAL(localHandlerPrivate->getFanOutStats().notifiesSent, 0, int, "%d");
+	BC_ASSERT_EQUAL((int)localHandlerPrivate->getFanOutStats().compressedBytesSaved, 0, int, "%d");
+
+	localConf = nullptr;
+	linphone_core_manager_destroy(pauline);
+}
+
+static map<LinphoneCore *, string> receivedConferenceNotifies;
+
+static void conference_notify_received (LinphoneCore *lc, LinphoneEvent *lev, const char *eventname, const LinphoneContent *content) {
+	if (!BC_ASSERT_PTR_NOT_NULL(content))
+		return;
+	// The body is given inflated, whatever the Content-Encoding it was sent with.
+	receivedConferenceNotifies[lc] = linphone_content_get_string_buffer(content);
+	get_manager(lc)->stat.number_of_NotifyReceived++;
+}
+
+void notify_subscribed_devices () {
+	LinphoneCoreManager *marie = linphone_core_manager_new("marie_rc");
+	LinphoneCoreManager *laure = linphone_core_manager_new("laure_rc_udp");
+	LinphoneCoreManager *pauline = linphone_core_manager_new(transport_supported(LinphoneTransportTls) ? "pauline_rc" : "pauline_tcp_rc");
+	linphone_core_cbs_set_notify_received(marie->cbs, conference_notify_received);
+	linphone_core_cbs_set_notify_received(laure->cbs, conference_notify_received);
+	receivedConferenceNotifies.clear();
+	char *identityStr = linphone_address_as_string(pauline->identity);
+	Address addr(identityStr);
+	bctbx_free(identityStr);
+	shared_ptr<LocalConference> localConf = make_shared<LocalConference>(pauline->lc->cppPtr, addr, nullptr);
+	LinphoneAddress *cBobAddr = linphone_core_interpret_url(pauline->lc, bobUri);
+	char *bobAddrStr = linphone_address_as_string(cBobAddr);
+	Address bobAddr(bobAddrStr);
+	bctbx_free(bobAddrStr);
+	linphone_address_unref(cBobAddr);
+
+	CallSessionParams params;
+	localConf->addParticipant(bobAddr, &params, false);
+	L_GET_PRIVATE(localConf->findParticipant(bobAddr))->addDevice(bobAddr);
+
+	// Marie and Laure each have one device subscribed to the conference event package, Bob's device is not subscribed.
+	for (LinphoneCoreManager *mgr : { marie, laure }) {
+		char *mgrAddrStr = linphone_address_as_string(mgr->identity);
+		Address mgrAddr(mgrAddrStr);
+		bctbx_free(mgrAddrStr);
+		localConf->addParticipant(mgrAddr, &params, false);
+		shared_ptr<ParticipantDevice> device = L_GET_PRIVATE(localConf->findParticipant(mgrAddr))->addDevice(mgrAddr);
+		LinphoneEvent *lev = linphone_core_create_notify(pauline->lc, mgr->identity, "conference");
+		device->setConferenceSubscribeEvent(lev);
+		linphone_event_unref(lev);
+	}
+
+	const unique_ptr<LocalConferenceEventHandler> &localHandler = L_ATTR_GET(L_GET_PRIVATE(localConf), eventHandler);
+	LocalConferenceEventHandlerPrivate *localHandlerPrivate = L_GET_PRIVATE(localHandler);
+	const_cast<IdentityAddress &>(localConf->getConferenceAddress()) = addr;
+
+	// The body is built and compressed once, then sent to both subscribed devices.
+	localConf->setSubject("A random test subject");
+	localHandler->notifySubjectChanged();
+
+	BC_ASSERT_TRUE(wait_for_until(marie->lc, laure->lc, &marie->stat.number_of_NotifyReceived, 1, 5000));
+	BC_ASSERT_TRUE(wait_for_until(marie->lc, laure->lc, &laure->stat.number_of_NotifyReceived, 1, 5000));
+	BC_ASSERT_EQUAL(localHandlerPrivate->getFanOutStats().bodiesEncoded, 1, int, "%d");
+	BC_ASSERT_EQUAL(localHandlerPrivate->getFanOutStats().notifiesSent, 2, int, "%d");
+
+	const string &marieNotify = receivedConferenceNotifies[marie->lc];
+	const string &laureNotify = receivedConferenceNotifies[laure->lc];
+	BC_ASSERT_TRUE(marieNotify.find("A random test subject") != string::npos);
+	BC_ASSERT_STRING_EQUAL(laureNotify.c_str(), marieNotify.c_str());
+	// Only the second NOTIFY reused a compressed body.
+	BC_ASSERT_EQUAL((int)localHandlerPrivate->getFanOutStats().compressedBytesSaved, (int)marieNotify.size(), int, "%d");
+
+	localConf = nullptr;
+	receivedConferenceNotifies.clear();
+	linphone_core_manager_destroy(marie);
+	linphone_core_manager_destroy(laure);
+	linphone_core_manager_destroy(pauline);
+}
+
+void cached_notifies () {
+	LinphoneCoreManager *pauline = linphone_core_manager_new(transport_supported(LinphoneTransportTls) ? "pauline_rc" : "pauline_tcp_rc");
+	char *identityStr = linphone_address_as_string(pauline->identity);
+	Address addr(identityStr);
+	bctbx_free(identityStr);
+	shared_ptr<LocalConference> localConf = make_shared<LocalConference>(pauline->lc->cppPtr, addr, nullptr);
+	LinphoneAddress *cBobAddr = linphone_core_interpret_url(pauline->lc, bobUri);
+	char *bobAddrStr = linphone_address_as_string(cBobAddr);
+	Address bobAddr(bobAddrStr);
+	bctbx_free(bobAddrStr);
+	linphone_address_unref(cBobAddr);
+	LinphoneAddress *cFrankAddr = linphone_core_interpret_url(pauline->lc, frankUri);
+	char *frankAddrStr = linphone_address_as_string(cFrankAddr);
+	Address frankAddr(frankAddrStr);
+	bctbx_free(frankAddrStr);
+	linphone_address_unref(cFrankAddr);
+
+	CallSessionParams params;
+	localConf->addParticipant(bobAddr, &params, false);
+	const unique_ptr<LocalConferenceEventHandler> &localHandler = L_ATTR_GET(L_GET_PRIVATE(localConf), eventHandler);
+	LocalConferenceEventHandlerPrivate *localHandlerPrivate = L_GET_PRIVATE(localHandler);
+	const_cast<IdentityAddress &>(localConf->getConferenceAddress()) = addr;
+
+	// The full state of a given version is only built once.
+	string fullState = localHandlerPrivate->createNotifyFullState(static_cast<int>(localHandlerPrivate->getLastNotify()));
+	BC_ASSERT_STRING_EQUAL(localHandlerPrivate->createNotifyFullState(static_cast<int>(localHandlerPrivate->getLastNotify())).c_str(), fullState.c_str());
+	BC_ASSERT_TRUE(fullState.find(frankAddr.asString()) == string::npos);
+	BC_ASSERT_EQUAL(localHandlerPrivate->getCacheStats().hits, 1, int, "%d");
+	BC_ASSERT_EQUAL(localHandlerPrivate->getCacheStats().misses, 1, int, "%d");
+
+	// A notified change makes it obsolete.
+	localConf->addParticipant(frankAddr, &params, false);
+	localHandler->notifyParticipantAdded(frankAddr);
+	fullState = localHandlerPrivate->createNotifyFullState(static_cast<int>(localHandlerPrivate->getLastNotify()));
+	BC_ASSERT_TRUE(fullState.find(frankAddr.asString()) != string::npos);
+
+	// Missed notifies are taken from the cache, the conference is not stored in the database.
+	localConf->setSubject("A random test subject");
+	localHandler->notifySubjectChanged();
+	localConf->setSubject("Another random test subject...");
+	localHandler->notifySubjectChanged();
+	BC_ASSERT_EQUAL(localHandlerPrivate->getLastNotify(), 3, int, "%d");
+	string multipart = localHandlerPrivate->createNotifyMultipart(1);
+	BC_ASSERT_TRUE(multipart.find("A random test subject") != string::npos);
+	BC_ASSERT_TRUE(multipart.find("Another random test subject...") != string::npos);
+	BC_ASSERT_TRUE(multipart.find(frankAddr.asString()) == string::npos);
+	BC_ASSERT_EQUAL(localHandlerPrivate->getCacheStats().hits, 2, int, "%d");
+	BC_ASSERT_EQUAL(localHandlerPrivate->getCacheStats().misses, 2, int, "%d");
+	BC_ASSERT_TRUE(LocalConferenceEventHandlerPrivate::getCachedBytes() >= fullState.size());
+
+	// Over the process-wide budget, the oldest bodies are dropped and have to be built again.
+	LocalConferenceEventHandlerPrivate::setCacheBudget(0);
+	BC_ASSERT_EQUAL((int)LocalConferenceEventHandlerPrivate::getCachedBytes(), 0, int, "%d");
+	localHandlerPrivate->createNotifyFullState(static_cast<int>(localHandlerPrivate->getLastNotify()));
+	BC_ASSERT_EQUAL(localHandlerPrivate->getCacheStats().hits, 2, int, "%d");
+	BC_ASSERT_EQUAL(localHandlerPrivate->getCacheStats().misses, 3, int, "%d");
+	BC_ASSERT_EQUAL((int)LocalConferenceEventHandlerPrivate::getCachedBytes(), 0, int, "%d");
+	LocalConferenceEventHandlerPrivate::setCacheBudget(LocalConferenceEventHandlerPrivate::DefaultCacheBudget);
+
+	// Destroying the conference releases its share of the budget.
+	const size_t cachedBytesBefore = LocalConferenceEventHandlerPrivate::getCachedBytes();
+	fullState = localHandlerPrivate->createNotifyFullState(static_cast<int>(localHandlerPrivate->getLastNotify()));
+	BC_ASSERT_EQUAL(localHandlerPrivate->getCacheStats().misses, 4, int, "%d");
+	BC_ASSERT_EQUAL(
+		(int)LocalConferenceEventHandlerPrivate::getCachedBytes(), (int)(cachedBytesBefore + fullState.size()), int, "%d"
+	);
+	localConf = nullptr;
+	BC_ASSERT_EQUAL((int)LocalConferenceEventHandlerPrivate::getCachedBytes(), (int)cachedBytesBefore, int, "%d");
+	linphone_core_manager_destroy(pauline);
+}
+
 test_t conference_event_tests[] = {
 	TEST_NO_TAG("First notify parsing", first_notify_parsing),
 	TEST_NO_TAG("First notify parsing wrong conf", first_notify_parsing_wrong_conf),
@@ -1352,7 +1531,10 @@ test_t conference_event_tests[] = {
 	TEST_NO_TAG("Send subject changed notify", send_subject_changed_notify),
 	TEST_NO_TAG("Send device added notify", send_device_added_notify),
 	TEST_NO_TAG("Send device removed notify", send_device_removed_notify),
-	TEST_NO_TAG("one-to-one keyword", one_to_one_keyword)
+	TEST_NO_TAG("one-to-one keyword", one_to_one_keyword),
+	TEST_NO_TAG("Notify unsubscribed devices", notify_unsubscribed_devices),
+	TEST_NO_TAG("Notify subscribed devices", notify_subscribed_devices),
+	TEST_NO_TAG("Cached notifies", cached_notifies)
 };
 
 test_suite_t conference_event_test_suite = {
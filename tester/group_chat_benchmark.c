@@ -450,6 +450,60 @@ void groupchat_benchmark(void) {
 	bctbx_list_free_with_data(coresManagerList, (bctbx_list_free_func) linphone_core_manager_destroy);
 }
 
+static uint64_t fan_out_allocated_bytes = 0;
+
+static void *fan_out_malloc(size_t sz) {
+	fan_out_allocated_bytes += sz;
+	return malloc(sz);
+}
+
+static void *fan_out_realloc(void *ptr, size_t sz) {
+	fan_out_allocated_bytes += sz;
+	return realloc(ptr, sz);
+}
+
+static void fan_out_free(void *ptr) {
+	free(ptr);
+}
+
+//Sends nb_messages messages to nb_participants devices the way a server group chat room does, and reports
+//the throughput and the memory allocated through bctoolbox for each recipient (C++ operator new is not counted)
+void groupchat_fan_out_benchmark(void) {
+	BctoolboxMemoryFunctions countingFunctions = {fan_out_malloc, fan_out_realloc, fan_out_free};
+	BctoolboxMemoryFunctions defaultFunctions = {malloc, realloc, free};
+	LinphoneCoreManager *mgr = linphone_core_manager_new("groupchat_rc");
+	LinphoneAddress *from = linphone_address_new("sip:conference-factory@sip.example.org");
+	bctbx_list_t *recipients = create_participants_addresses(nb_participants);
+	size_t nb_recipients = bctbx_list_size(recipients);
+	char *body = bctbx_strdup_printf("Hi! I'm a message sent to %u devices", (unsigned int)nb_recipients);
+	uint64_t sent = 0;
+	uint64_t start, elapsed;
+	uint32_t i;
+	int dummy = 0;
+
+	fan_out_allocated_bytes = 0;
+	bctbx_set_memory_functions(&countingFunctions);
+	start = bctbx_get_cur_time_ms();
+	for (i = 0; i < nb_messages; ++i)
+		sent += (uint64_t)linphone_core_fan_out_message(mgr->lc, from, recipients, "text/plain", body);
+	elapsed = bctbx_get_cur_time_ms() - start;
+	bctbx_set_memory_functions(&defaultFunctions);
+
+	BC_ASSERT_EQUAL((unsigned long)sent, (unsigned long)(nb_messages * nb_recipients), unsigned long, "%lu");
+	ms_message("Fan-out of %u messages to %u devices: %llu requests in %llu ms (%.1f requests/s), %.1f bytes allocated through bctoolbox per recipient",
+		nb_messages, (unsigned int)nb_recipients, (unsigned long long)sent, (unsigned long long)elapsed,
+		elapsed ? (double)sent * 1000. / (double)elapsed : 0.,
+		sent ? (double)fan_out_allocated_bytes / (double)sent : 0.);
+
+	//Let the transactions go out before destroying the core
+	wait_for_until(mgr->lc, NULL, &dummy, 1, 1000);
+
+	bctbx_free(body);
+	bctbx_list_free_with_data(recipients, (bctbx_list_free_func) linphone_address_unref);
+	linphone_address_unref(from);
+	linphone_core_manager_destroy(mgr);
+}
+
 int check_params(void) {
 	if (nb_participants < 2) {
 		bctbx_fatal("There must be at least 2 participants to create chat rooms!");
@@ -512,8 +566,12 @@ int main (int argc, char *argv[])
 	groupchat_benchmark_init(NULL);
 	linphone_core_set_log_level(ORTP_ERROR);
 
-	test_t setup_tests = TEST_NO_TAG("Group chat benchmark", groupchat_benchmark);
-	test_suite_t test_suite = {"Group Chat Benchmark", NULL, NULL, liblinphone_tester_before_each, liblinphone_tester_after_each, 1, &setup_tests};
+	test_t setup_tests[] = {
+		TEST_NO_TAG("Group chat benchmark", groupchat_benchmark),
+		TEST_NO_TAG("Group chat fan-out benchmark", groupchat_fan_out_benchmark)
+	};
+	test_suite_t test_suite = {"Group Chat Benchmark", NULL, NULL, liblinphone_tester_before_each, liblinphone_tester_after_each,
+		sizeof(setup_tests) / sizeof(setup_tests[0]), setup_tests};
 	bc_tester_add_suite(&test_suite);
 
 	for(i = 1; i < argc; ++i) {
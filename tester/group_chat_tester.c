@@ -1817,6 +1817,80 @@ end:
 	linphone_core_manager_destroy(laure);
 }
 
+static void group_chat_room_message_queued_for_offline_participant (void) {
+	LinphoneCoreManager *marie = linphone_core_manager_create("marie_rc");
+	LinphoneCoreManager *pauline = linphone_core_manager_create("pauline_rc");
+	LinphoneCoreManager *laure = linphone_core_manager_create("laure_tcp_rc");
+	bctbx_list_t *coresManagerList = NULL;
+	bctbx_list_t *participantsAddresses = NULL;
+	LinphoneChatRoom *laureCr = NULL;
+	coresManagerList = bctbx_list_append(coresManagerList, marie);
+	coresManagerList = bctbx_list_append(coresManagerList, pauline);
+	coresManagerList = bctbx_list_append(coresManagerList, laure);
+	bctbx_list_t *coresList = init_core_for_conference(coresManagerList);
+	start_core_for_conference(coresManagerList);
+	participantsAddresses = bctbx_list_append(participantsAddresses, linphone_address_new(linphone_core_get_identity(pauline->lc)));
+	participantsAddresses = bctbx_list_append(participantsAddresses, linphone_address_new(linphone_core_get_identity(laure->lc)));
+	stats initialMarieStats = marie->stat;
+	stats initialPaulineStats = pauline->stat;
+	stats initialLaureStats = laure->stat;
+
+	// Marie creates a new group chat room
+	const char *initialSubject = "Colleagues";
+	LinphoneChatRoom *marieCr = create_chat_room_client_side(coresList, marie, &initialMarieStats, participantsAddresses, initialSubject, FALSE);
+	const LinphoneAddress *confAddr = linphone_chat_room_get_conference_address(marieCr);
+	LinphoneChatRoom *paulineCr = check_creation_chat_room_client_side(coresList, pauline, &initialPaulineStats, confAddr, initialSubject, 2, FALSE);
+	laureCr = check_creation_chat_room_client_side(coresList, laure, &initialLaureStats, confAddr, initialSubject, 2, FALSE);
+	LinphoneAddress *laureCrAddr = linphone_address_clone(linphone_chat_room_get_peer_address(laureCr));
+
+	// Laure goes offline
+	linphone_core_set_network_reachable(laure->lc, FALSE);
+	initialPaulineStats = pauline->stat;
+	initialLaureStats = laure->stat;
+
+	// Pauline is present and gets the messages right away, they are queued by the server for Laure
+	linphone_chat_message_unref(_send_message(marieCr, "First"));
+	linphone_chat_message_unref(_send_message(marieCr, "Second"));
+	BC_ASSERT_TRUE(wait_for_list(coresList, &pauline->stat.number_of_LinphoneMessageReceived, initialPaulineStats.number_of_LinphoneMessageReceived + 2, 3000));
+	BC_ASSERT_FALSE(wait_for_list(coresList, &laure->stat.number_of_LinphoneMessageReceived, initialLaureStats.number_of_LinphoneMessageReceived + 1, 3000));
+
+	// Laure restarts, her queue is sent once she subscribes to the chat room again
+	coresList = bctbx_list_remove(coresList, laure->lc);
+	linphone_core_manager_reinit(laure);
+	bctbx_list_t *tmpCoresManagerList = bctbx_list_append(NULL, laure);
+	bctbx_list_t *tmpCoresList = init_core_for_conference(tmpCoresManagerList);
+	bctbx_list_free(tmpCoresManagerList);
+	coresList = bctbx_list_concat(coresList, tmpCoresList);
+	linphone_core_manager_start(laure, TRUE);
+	laureCr = linphone_core_get_chat_room(laure->lc, laureCrAddr);
+	linphone_address_unref(laureCrAddr);
+	BC_ASSERT_PTR_NOT_NULL(laureCr);
+
+	if (BC_ASSERT_TRUE(wait_for_list(coresList, &laure->stat.number_of_LinphoneMessageReceived, 2, 5000)) && laureCr) {
+		// Queued messages are delivered in the order they were sent
+		bctbx_list_t *history = linphone_chat_room_get_history(laureCr, 2);
+		if (BC_ASSERT_EQUAL((int)bctbx_list_size(history), 2, int, "%d")) {
+			BC_ASSERT_STRING_EQUAL(linphone_chat_message_get_text((LinphoneChatMessage *)bctbx_list_nth_data(history, 0)), "First");
+			BC_ASSERT_STRING_EQUAL(linphone_chat_message_get_text((LinphoneChatMessage *)bctbx_list_nth_data(history, 1)), "Second");
+		}
+		bctbx_list_free_with_data(history, (bctbx_list_free_func)linphone_chat_message_unref);
+	}
+	// Nothing is sent twice
+	BC_ASSERT_FALSE(wait_for_list(coresList, &laure->stat.number_of_LinphoneMessageReceived, 3, 2000));
+	BC_ASSERT_EQUAL(pauline->stat.number_of_LinphoneMessageReceived, initialPaulineStats.number_of_LinphoneMessageReceived + 2, int, "%d");
+
+	// Clean db from chat room
+	linphone_core_manager_delete_chat_room(marie, marieCr, coresList);
+	linphone_core_manager_delete_chat_room(pauline, paulineCr, coresList);
+	if (laureCr) linphone_core_manager_delete_chat_room(laure, laureCr, coresList);
+
+	bctbx_list_free(coresList);
+	bctbx_list_free(coresManagerList);
+	linphone_core_manager_destroy(marie);
+	linphone_core_manager_destroy(pauline);
+	linphone_core_manager_destroy(laure);
+}
+
 static void group_chat_room_create_room_with_disconnected_friends (void) {
 	group_chat_room_create_room_with_disconnected_friends_base(FALSE);
 }
@@ -5720,6 +5794,7 @@ test_t group_chat_tests[] = {
 	TEST_NO_TAG("Come back on a group chat room after a disconnection", group_chat_room_come_back_after_disconnection),
 	TEST_NO_TAG("Create chat room with disconnected friends", group_chat_room_create_room_with_disconnected_friends),
 	TEST_NO_TAG("Create chat room with disconnected friends and initial message", group_chat_room_create_room_with_disconnected_friends_and_initial_message),
+	TEST_NO_TAG("Message queued for offline participant", group_chat_room_message_queued_for_offline_participant),
 	TEST_NO_TAG("Reinvited after removed from group chat room", group_chat_room_reinvited_after_removed),
 	TEST_ONE_TAG("Reinvited after removed from group chat room 2", group_chat_room_reinvited_after_removed_2, "LeaksMemory"),
 	TEST_ONE_TAG("Reinvited after removed from group chat room while offline", group_chat_room_reinvited_after_removed_while_offline, "LeaksMemory"),
@@ -18,6 +18,7 @@
  */
 
 #include "address/address.h"
+#include "chat/chat-message/chat-message-p.h"
 #include "core/core-p.h"
 #include "db/main-db.h"
 #include "event-log/events.h"
@@ -38,14 +39,33 @@ using namespace LinphonePrivate;
 
 class MainDbProvider {
 public:
+	struct Options {
+		bool fullTextSearchEnabled = false;
+		bool asyncEnabled = false;
+		int retentionMaxEventsPerChatRoom = 0;
+		int writeBehindBatchSize = 0; // 0 disables the write-behind queue.
+	};
+
 	MainDbProvider () : MainDbProvider("db/linphone.db") { }
 
-	MainDbProvider (const char *db_file) {
+	MainDbProvider (const char *db_file) : MainDbProvider(db_file, Options()) { }
+
+	MainDbProvider (const char *db_file, const Options &options) {
 		mCoreManager = linphone_core_manager_create("marie_rc");
 		char *roDbPath = bc_tester_res(db_file);
 		char *rwDbPath = bc_tester_file("linphone.db");
 		BC_ASSERT_FALSE(liblinphone_tester_copy_file(roDbPath, rwDbPath));
 		linphone_config_set_string(linphone_core_get_config(mCoreManager->lc), "storage", "uri", rwDbPath);
+		linphone_config_set_bool(linphone_core_get_config(mCoreManager->lc), "storage", "full_text_search_enabled", options.fullTextSearchEnabled);
+		linphone_config_set_bool(linphone_core_get_config(mCoreManager->lc), "storage", "async_enabled", options.asyncEnabled);
+		linphone_config_set_int(linphone_core_get_config(mCoreManager->lc), "storage", "retention_max_events_per_chat_room", options.retentionMaxEventsPerChatRoom);
+		linphone_config_set_int(linphone_core_get_config(mCoreManager->lc), "storage", "retention_step_interval_ms", 10);
+		// Passes run back to back.
+		linphone_config_set_int(linphone_core_get_config(mCoreManager->lc), "storage", "retention_pass_interval_s", 0);
+		linphone_config_set_bool(linphone_core_get_config(mCoreManager->lc), "storage", "write_behind_enabled", options.writeBehindBatchSize > 0);
+		linphone_config_set_int(linphone_core_get_config(mCoreManager->lc), "storage", "write_behind_batch_size", options.writeBehindBatchSize);
+		// Only the batch size or the core shutdown flush the queue during a test.
+		linphone_config_set_int(linphone_core_get_config(mCoreManager->lc), "storage", "write_behind_delay_ms", 60000);
 		bc_free(roDbPath);
 		bc_free(rwDbPath);
 		linphone_core_manager_start(mCoreManager, false);
@@ -55,10 +75,14 @@ public:
 		linphone_core_manager_destroy(mCoreManager);
 	}
 
-	const MainDb &getMainDb () {
+	MainDb &getMainDb () {
 		return *L_GET_PRIVATE(mCoreManager->lc->cppPtr)->mainDb;
 	}
 
+	LinphoneCore *getCCore () {
+		return mCoreManager->lc;
+	}
+
 private:
 	LinphoneCoreManager *mCoreManager;
 };
@@ -97,6 +121,11 @@ static void get_unread_messages_count (void) {
 		),
 		0, int, "%d"
 	);
+
+	int count = 0;
+	for (const auto &entry : mainDb.getUnreadChatMessageCountByLocalAddress())
+		count += entry.second;
+	BC_ASSERT_EQUAL(count, 2, int, "%d");
 }
 
 static void get_history (void) {
@@ -140,6 +169,43 @@ static void get_history (void) {
 	);
 }
 
+static void get_history_before (void) {
+	MainDbProvider provider;
+	const MainDb &mainDb = provider.getMainDb();
+	ConferenceId conferenceId(IdentityAddress("sip:test-1@sip.linphone.org"), IdentityAddress("sip:test-1@sip.linphone.org"));
+
+	long long cursor = 0;
+	size_t total = 0;
+	int nPages = 0;
+	do {
+		list<shared_ptr<EventLog>> page = mainDb.getHistoryBefore(
+			conferenceId, cursor, 100, MainDb::Filter::ConferenceChatMessageFilter, &cursor
+		);
+		BC_ASSERT_LOWER(page.size(), 100, size_t, "%zu");
+		total += page.size();
+		++nPages;
+	} while (cursor > 0 && nPages < 100);
+
+	BC_ASSERT_EQUAL(total, 804, size_t, "%zu");
+	BC_ASSERT_EQUAL(nPages, 9, int, "%d");
+
+	// When the history size is a multiple of the page size, the last full page has no next cursor.
+	cursor = 0;
+	total = 0;
+	nPages = 0;
+	do {
+		list<shared_ptr<EventLog>> page = mainDb.getHistoryBefore(
+			conferenceId, cursor, 201, MainDb::Filter::ConferenceChatMessageFilter, &cursor
+		);
+		BC_ASSERT_EQUAL(page.size(), 201, size_t, "%zu");
+		total += page.size();
+		++nPages;
+	} while (cursor > 0 && nPages < 100);
+
+	BC_ASSERT_EQUAL(total, 804, size_t, "%zu");
+	BC_ASSERT_EQUAL(nPages, 4, int, "%d");
+}
+
 static void get_conference_notified_events (void) {
 	MainDbProvider provider;
 	const MainDb &mainDb = provider.getMainDb();
@@ -261,6 +327,251 @@ static void get_chat_rooms() {
 	}
 }
 
+static void search_chat_messages (void) {
+	MainDbProvider::Options options;
+	options.fullTextSearchEnabled = true;
+	MainDbProvider provider("db/linphone.db", options);
+	const MainDb &mainDb = provider.getMainDb();
+	// Use the chat room owned by the core, messages are stored through it.
+	shared_ptr<AbstractChatRoom> chatRoom = provider.getCCore()->cppPtr->findChatRoom(
+		ConferenceId(IdentityAddress("sip:test-3@sip.linphone.org"), IdentityAddress("sip:test-1@sip.linphone.org"))
+	);
+	BC_ASSERT_PTR_NOT_NULL(chatRoom);
+	if (!chatRoom)
+		return;
+
+	shared_ptr<ChatMessage> message = chatRoom->createChatMessage("Looking for a quokka in the history");
+	message->send();
+
+	// SQLite may be built without FTS5.
+	if (!mainDb.isFullTextSearchEnabled()) {
+		ms_warning("Full text search is not available, skipping the search checks.");
+		BC_ASSERT_EQUAL(mainDb.searchChatMessages("quokka", ConferenceId(), 10).size(), 0, size_t, "%zu");
+		return;
+	}
+
+	int nextCursor = -1;
+	list<shared_ptr<ChatMessage>> results = mainDb.searchChatMessages(
+		"quokka history", chatRoom->getConferenceId(), 10, 0, &nextCursor
+	);
+	BC_ASSERT_EQUAL(results.size(), 1, size_t, "%zu");
+	if (!results.empty())
+		BC_ASSERT_PTR_EQUAL(results.front(), message);
+	BC_ASSERT_EQUAL(nextCursor, 0, int, "%d");
+	BC_ASSERT_EQUAL(mainDb.searchChatMessages("quokka", ConferenceId(), 10).size(), 1, size_t, "%zu");
+
+	// Deleted messages must not be found anymore.
+	chatRoom->deleteMessageFromHistory(message);
+	BC_ASSERT_EQUAL(mainDb.searchChatMessages("quokka", ConferenceId(), 10).size(), 0, size_t, "%zu");
+}
+
+static void reuse_prepared_statements (void) {
+	MainDbProvider provider;
+	const MainDb &mainDb = provider.getMainDb();
+	ConferenceId conferenceId(IdentityAddress("sip:test-3@sip.linphone.org"), IdentityAddress("sip:test-1@sip.linphone.org"));
+
+	mainDb.getHistorySize(conferenceId, MainDb::ConferenceChatMessageFilter);
+	unsigned long missCount = mainDb.getPreparedStatementMissCount();
+	unsigned long hitCount = mainDb.getPreparedStatementHitCount();
+	for (int i = 0; i < 10; ++i)
+		mainDb.getHistorySize(conferenceId, MainDb::ConferenceChatMessageFilter);
+
+	// Same statements: only hits are expected.
+	BC_ASSERT_EQUAL(mainDb.getPreparedStatementMissCount(), missCount, unsigned long, "%lu");
+	BC_ASSERT_GREATER(mainDb.getPreparedStatementHitCount(), hitCount, unsigned long, "%lu");
+	BC_ASSERT_EQUAL(mainDb.getHistorySize(conferenceId, MainDb::ConferenceChatMessageFilter), 861, int, "%d");
+}
+
+static void cache_sip_address_ids (void) {
+	MainDbProvider provider;
+	const MainDb &mainDb = provider.getMainDb();
+	ConferenceId conferenceId(IdentityAddress("sip:test-3@sip.linphone.org"), IdentityAddress("sip:test-1@sip.linphone.org"));
+
+	// Chat room addresses are warmed at init: only the chat room id lookup must reach the database.
+	unsigned long count = mainDb.getPreparedStatementHitCount() + mainDb.getPreparedStatementMissCount();
+	mainDb.getHistorySize(conferenceId, MainDb::ConferenceChatMessageFilter);
+	BC_ASSERT_EQUAL(
+		mainDb.getPreparedStatementHitCount() + mainDb.getPreparedStatementMissCount() - count,
+		1, unsigned long, "%lu"
+	);
+}
+
+static void add_events_benchmark (void) {
+	MainDbProvider provider;
+	MainDb &mainDb = provider.getMainDb();
+	ConferenceId conferenceId(IdentityAddress("sip:test-3@sip.linphone.org"), IdentityAddress("sip:test-1@sip.linphone.org"));
+	shared_ptr<AbstractChatRoom> chatRoom = mainDb.getCore()->findChatRoom(conferenceId);
+	BC_ASSERT_PTR_NOT_NULL(chatRoom);
+	if (!chatRoom)
+		return;
+
+	const int eventsCount = 5000;
+	const int historySize = mainDb.getHistorySize(conferenceId, MainDb::ConferenceChatMessageFilter);
+	list<shared_ptr<EventLog>> eventLogs;
+	for (int i = 0; i < eventsCount; ++i)
+		eventLogs.push_back(make_shared<ConferenceChatMessageEvent>(
+			time(nullptr), chatRoom->createChatMessage("Imported message " + to_string(i))
+		));
+	shared_ptr<ChatMessage> lastMessage = static_pointer_cast<ConferenceChatMessageEvent>(eventLogs.back())->getChatMessage();
+
+	chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+	BC_ASSERT_TRUE(mainDb.addEvents(eventLogs));
+	chrono::high_resolution_clock::time_point end = chrono::high_resolution_clock::now();
+	long ms = (long) chrono::duration_cast<chrono::milliseconds>(end - start).count();
+
+	BC_ASSERT_EQUAL(
+		mainDb.getHistorySize(conferenceId, MainDb::ConferenceChatMessageFilter),
+		historySize + eventsCount, int, "%d"
+	);
+	BC_ASSERT_PTR_EQUAL(mainDb.getLastChatMessage(conferenceId), lastMessage);
+	ms_message("Added %d events in %li ms (%.0f events/s)", eventsCount, ms,
+		ms > 0 ? eventsCount * 1000.0 / ms : 0.0);
+}
+
+static void get_history_async (void) {
+	MainDbProvider::Options options;
+	options.asyncEnabled = true;
+	MainDbProvider provider("db/linphone.db", options);
+	MainDb &mainDb = provider.getMainDb();
+	ConferenceId conferenceId(IdentityAddress("sip:test-3@sip.linphone.org"), IdentityAddress("sip:test-1@sip.linphone.org"));
+
+	int historyFetched = 0;
+	list<shared_ptr<EventLog>> history;
+	mainDb.getHistoryAsync(conferenceId, 0, MainDb::ConferenceChatMessageFilter,
+		[&history, &historyFetched](const list<shared_ptr<EventLog>> &events) {
+			history = events;
+			historyFetched++;
+		}
+	);
+	BC_ASSERT_TRUE(wait_for_until(provider.getCCore(), NULL, &historyFetched, 1, 5000));
+	BC_ASSERT_EQUAL(history.size(), 861, size_t, "%zu");
+
+	// Events fetched by the async thread are shared with synchronous calls.
+	list<shared_ptr<EventLog>> lastEvents = mainDb.getHistory(conferenceId, 1, MainDb::ConferenceChatMessageFilter);
+	if (!history.empty() && !lastEvents.empty())
+		BC_ASSERT_PTR_EQUAL(
+			static_pointer_cast<ConferenceChatMessageEvent>(history.back())->getChatMessage(),
+			static_pointer_cast<ConferenceChatMessageEvent>(lastEvents.back())->getChatMessage()
+		);
+
+	int historyCleaned = 0;
+	mainDb.cleanHistoryAsync(conferenceId, MainDb::NoFilter, [&historyCleaned] { historyCleaned++; });
+	BC_ASSERT_TRUE(wait_for_until(provider.getCCore(), NULL, &historyCleaned, 1, 5000));
+	BC_ASSERT_EQUAL(mainDb.getHistorySize(conferenceId), 0, int, "%d");
+	BC_ASSERT_EQUAL(mainDb.getUnreadChatMessageCount(conferenceId), 0, int, "%d");
+
+	// Callbacks of the calls still queued when the thread is stopped are dropped.
+	historyFetched = 0;
+	mainDb.getHistoryAsync(conferenceId, 0, MainDb::ConferenceChatMessageFilter,
+		[&historyFetched](const list<shared_ptr<EventLog>> &) { historyFetched++; }
+	);
+	mainDb.stopAsyncThread();
+	wait_for_until(provider.getCCore(), NULL, &historyFetched, 1, 500);
+	BC_ASSERT_EQUAL(historyFetched, 0, int, "%d");
+}
+
+static void history_retention (void) {
+	MainDbProvider::Options options;
+	options.retentionMaxEventsPerChatRoom = 100;
+	MainDbProvider provider("db/linphone.db", options);
+	MainDb &mainDb = provider.getMainDb();
+	ConferenceId conferenceId(IdentityAddress("sip:test-3@sip.linphone.org"), IdentityAddress("sip:test-1@sip.linphone.org"));
+	shared_ptr<AbstractChatRoom> chatRoom = mainDb.getCore()->findChatRoom(conferenceId);
+	BC_ASSERT_PTR_NOT_NULL(chatRoom);
+	if (!chatRoom)
+		return;
+
+	// The newest events are kept: only the seeded unread messages must remain.
+	const int unreadCount = 150;
+	list<shared_ptr<EventLog>> eventLogs;
+	for (int i = 0; i < unreadCount; ++i)
+		eventLogs.push_back(make_shared<ConferenceChatMessageEvent>(
+			time(nullptr), chatRoom->createChatMessage("Unread message " + to_string(i))
+		));
+	BC_ASSERT_TRUE(mainDb.addEvents(eventLogs));
+	BC_ASSERT_EQUAL(mainDb.getUnreadChatMessageCount(conferenceId), unreadCount, int, "%d");
+
+	const auto chatRoomsOverLimit = [&mainDb] {
+		for (const auto &chatRoom : mainDb.getCore()->getChatRooms())
+			if (mainDb.getHistorySize(chatRoom->getConferenceId()) > 100)
+				return true;
+		return false;
+	};
+
+	// Events are deleted in small batches by the core timer.
+	for (int i = 0; i < 1000 && chatRoomsOverLimit(); i++) {
+		linphone_core_iterate(provider.getCCore());
+		ms_usleep(10000);
+	}
+	BC_ASSERT_EQUAL(mainDb.getHistorySize(conferenceId), 100, int, "%d");
+	BC_ASSERT_EQUAL(mainDb.getChatMessageCount(conferenceId), 100, int, "%d");
+
+	// Unread counters are updated with the deleted messages.
+	BC_ASSERT_EQUAL(mainDb.getUnreadChatMessageCount(conferenceId), 100, int, "%d");
+	BC_ASSERT_EQUAL(mainDb.getUnreadChatMessages(conferenceId).size(), 100, size_t, "%zu");
+
+	// No other chat room is over the limit and no event is left outside of them.
+	int eventCount = 0;
+	for (const auto &chatRoom : mainDb.getCore()->getChatRooms()) {
+		const int historySize = mainDb.getHistorySize(chatRoom->getConferenceId());
+		BC_ASSERT_LOWER(historySize, 100, int, "%d");
+		eventCount += historySize;
+	}
+	BC_ASSERT_EQUAL(mainDb.getEventCount(), eventCount, int, "%d");
+}
+
+static void server_queued_messages (void) {
+	MainDbProvider provider;
+	MainDb &mainDb = provider.getMainDb();
+	ConferenceId conferenceId(IdentityAddress("sip:test-3@sip.linphone.org"), IdentityAddress("sip:test-1@sip.linphone.org"));
+	IdentityAddress deviceA("sip:test-1@sip.linphone.org;gr=device-a");
+	IdentityAddress deviceB("sip:test-1@sip.linphone.org;gr=device-b");
+
+	MainDb::ServerQueuedChatMessage message;
+	message.fromAddress = IdentityAddress("sip:test-3@sip.linphone.org");
+	message.content.setContentType(ContentType::PlainText);
+	message.content.setBody("Queued for two devices");
+	message.headers.emplace_back("Priority", "urgent");
+	message.creationTime = time(nullptr);
+	BC_ASSERT_TRUE(mainDb.addServerQueuedChatMessage(conferenceId, message, { deviceA, deviceB }));
+	BC_ASSERT_EQUAL(mainDb.getServerQueuedChatMessageCount(conferenceId, deviceA), 1, int, "%d");
+	BC_ASSERT_EQUAL(mainDb.getServerQueuedChatMessageCount(conferenceId, deviceB), 1, int, "%d");
+
+	// Taking the messages of a device does not change the queue of the others.
+	list<MainDb::ServerQueuedChatMessage> messages = mainDb.takeServerQueuedChatMessages(conferenceId, deviceA);
+	BC_ASSERT_EQUAL(messages.size(), 1, size_t, "%zu");
+	if (!messages.empty()) {
+		BC_ASSERT_STRING_EQUAL(messages.front().content.getBodyAsString().c_str(), "Queued for two devices");
+		BC_ASSERT_TRUE(messages.front().content.getContentType() == ContentType::PlainText);
+		BC_ASSERT_TRUE(messages.front().fromAddress == message.fromAddress);
+		BC_ASSERT_EQUAL(messages.front().headers.size(), 1, size_t, "%zu");
+	}
+	BC_ASSERT_EQUAL(mainDb.getServerQueuedChatMessageCount(conferenceId, deviceA), 0, int, "%d");
+	BC_ASSERT_EQUAL(mainDb.getServerQueuedChatMessageCount(conferenceId, deviceB), 1, int, "%d");
+
+	// Binary bodies, e.g. encrypted ones, are stored as is.
+	const vector<char> binaryBody = { 'a', '\0', '\xff', '\x80', 'z' };
+	MainDb::ServerQueuedChatMessage binaryMessage = message;
+	binaryMessage.content.setContentType(ContentType("application/octet-stream"));
+	binaryMessage.content.setBody(binaryBody);
+	BC_ASSERT_TRUE(mainDb.addServerQueuedChatMessage(conferenceId, binaryMessage, { deviceA }));
+	messages = mainDb.takeServerQueuedChatMessages(conferenceId, deviceA);
+	BC_ASSERT_EQUAL(messages.size(), 1, size_t, "%zu");
+	if (!messages.empty())
+		BC_ASSERT_TRUE(messages.front().content.getBody() == binaryBody);
+
+	// Expired messages are never dispatched and are deleted in batches.
+	message.content.setBody("Expired");
+	message.creationTime = time(nullptr) - 8 * 24 * 3600;
+	BC_ASSERT_TRUE(mainDb.addServerQueuedChatMessage(conferenceId, message, { deviceA }));
+	BC_ASSERT_EQUAL(mainDb.deleteExpiredServerQueuedChatMessages(), 1, int, "%d");
+	BC_ASSERT_EQUAL(mainDb.getServerQueuedChatMessageCount(conferenceId, deviceA), 0, int, "%d");
+
+	mainDb.deleteServerQueuedChatMessages(conferenceId, deviceB);
+	BC_ASSERT_EQUAL(mainDb.getServerQueuedChatMessageCount(conferenceId, deviceB), 0, int, "%d");
+	BC_ASSERT_EQUAL(mainDb.takeServerQueuedChatMessages(conferenceId, deviceB).size(), 0, size_t, "%zu");
+}
+
 static void load_a_lot_of_chatrooms(void) {
 	chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
 	MainDbProvider provider("db/chatrooms.db");
@@ -273,14 +584,201 @@ static void load_a_lot_of_chatrooms(void) {
 #endif
 }
 
+static void load_a_lot_of_chatrooms_benchmark (void) {
+	// The core does not open the database itself, so the timed call builds the only set of chat rooms.
+	LinphoneCoreManager *coreManager = linphone_core_manager_create("marie_rc");
+	char *roDbPath = bc_tester_res("db/chatrooms.db");
+	char *rwDbPath = bc_tester_file("linphone.db");
+	BC_ASSERT_FALSE(liblinphone_tester_copy_file(roDbPath, rwDbPath));
+	linphone_config_set_string(linphone_core_get_config(coreManager->lc), "storage", "uri", "null");
+	linphone_core_manager_start(coreManager, false);
+
+	{
+		MainDb mainDb(coreManager->lc->cppPtr);
+		BC_ASSERT_TRUE(mainDb.connect(MainDb::Sqlite3, rwDbPath));
+
+		chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+		list<shared_ptr<AbstractChatRoom>> chatRooms = mainDb.getChatRooms();
+		chrono::high_resolution_clock::time_point end = chrono::high_resolution_clock::now();
+		long ms = (long) chrono::duration_cast<chrono::milliseconds>(end - start).count();
+
+		BC_ASSERT_GREATER(chatRooms.size(), 0, size_t, "%zu");
+		ms_message("Loaded %zu chat rooms in %li ms (%.0f rooms/s)", chatRooms.size(), ms,
+			ms > 0 ? chatRooms.size() * 1000.0 / ms : 0.0);
+	}
+
+	bc_free(roDbPath);
+	bc_free(rwDbPath);
+	linphone_core_manager_destroy(coreManager);
+}
+
+static int get_stored_unread_messages_count (const string &dbPath) {
+	// Read the database with a connection which has no queued updates.
+	LinphoneCoreManager *coreManager = linphone_core_manager_create("marie_rc");
+	linphone_config_set_string(linphone_core_get_config(coreManager->lc), "storage", "uri", "null");
+	linphone_core_manager_start(coreManager, false);
+
+	int count;
+	{
+		MainDb mainDb(coreManager->lc->cppPtr);
+		BC_ASSERT_TRUE(mainDb.connect(MainDb::Sqlite3, dbPath));
+		count = mainDb.getUnreadChatMessageCount();
+	}
+
+	linphone_core_manager_destroy(coreManager);
+	return count;
+}
+
+static list<shared_ptr<ChatMessage>> get_unread_messages (MainDbProvider &provider) {
+	list<shared_ptr<ChatMessage>> chatMessages;
+	for (const auto &chatRoom : provider.getCCore()->cppPtr->getChatRooms())
+		chatMessages.splice(chatMessages.end(), provider.getMainDb().getUnreadChatMessages(chatRoom->getConferenceId()));
+	return chatMessages;
+}
+
+static void write_behind_updates (void) {
+	char *dbPath = bc_tester_file("linphone.db");
+	const string rwDbPath(dbPath);
+	bc_free(dbPath);
+	MainDbProvider::Options options;
+	options.writeBehindBatchSize = 2;
+
+	{
+		MainDbProvider provider("db/linphone.db", options);
+		MainDb &mainDb = provider.getMainDb();
+		list<shared_ptr<ChatMessage>> chatMessages = get_unread_messages(provider);
+		BC_ASSERT_EQUAL(chatMessages.size(), 2, size_t, "%zu");
+		if (chatMessages.size() != 2)
+			return;
+
+		// The first update is queued, reads include it.
+		L_GET_PRIVATE(chatMessages.front())->markAsRead();
+		L_GET_PRIVATE(chatMessages.front())->updateInDb();
+		BC_ASSERT_EQUAL(mainDb.getUnreadChatMessageCount(), 1, int, "%d");
+		BC_ASSERT_EQUAL(get_unread_messages(provider).size(), 1, size_t, "%zu");
+		BC_ASSERT_EQUAL(get_stored_unread_messages_count(rwDbPath), 2, int, "%d");
+
+		// The second one fills the batch, both are written together.
+		L_GET_PRIVATE(chatMessages.back())->markAsRead();
+		L_GET_PRIVATE(chatMessages.back())->updateInDb();
+		BC_ASSERT_EQUAL(mainDb.getUnreadChatMessageCount(), 0, int, "%d");
+		BC_ASSERT_EQUAL(get_stored_unread_messages_count(rwDbPath), 0, int, "%d");
+	}
+
+	{
+		MainDbProvider provider("db/linphone.db", options);
+		list<shared_ptr<ChatMessage>> chatMessages = get_unread_messages(provider);
+		BC_ASSERT_EQUAL(chatMessages.size(), 2, size_t, "%zu");
+		if (chatMessages.size() != 2)
+			return;
+
+		L_GET_PRIVATE(chatMessages.front())->markAsRead();
+		L_GET_PRIVATE(chatMessages.front())->updateInDb();
+		BC_ASSERT_EQUAL(get_stored_unread_messages_count(rwDbPath), 2, int, "%d");
+	}
+
+	// The queued update is written when the core is stopped.
+	BC_ASSERT_EQUAL(get_stored_unread_messages_count(rwDbPath), 1, int, "%d");
+}
+
+static list<MainDb::ServerQueuedChatMessage> take_stored_server_queued_messages (
+	const string &dbPath,
+	const ConferenceId &conferenceId,
+	const IdentityAddress &deviceAddress
+) {
+	// A new connection to the database, as a restarted conference server would open.
+	LinphoneCoreManager *coreManager = linphone_core_manager_create("marie_rc");
+	linphone_config_set_string(linphone_core_get_config(coreManager->lc), "storage", "uri", "null");
+	linphone_core_manager_start(coreManager, false);
+
+	list<MainDb::ServerQueuedChatMessage> messages;
+	{
+		MainDb mainDb(coreManager->lc->cppPtr);
+		BC_ASSERT_TRUE(mainDb.connect(MainDb::Sqlite3, dbPath));
+		messages = mainDb.takeServerQueuedChatMessages(conferenceId, deviceAddress);
+	}
+
+	linphone_core_manager_destroy(coreManager);
+	return messages;
+}
+
+static void server_queued_messages_after_restart (void) {
+	char *dbPath = bc_tester_file("linphone.db");
+	const string rwDbPath(dbPath);
+	bc_free(dbPath);
+
+	ConferenceId conferenceId(IdentityAddress("sip:test-3@sip.linphone.org"), IdentityAddress("sip:test-1@sip.linphone.org"));
+	IdentityAddress deviceA("sip:test-1@sip.linphone.org;gr=device-a");
+	IdentityAddress deviceB("sip:test-1@sip.linphone.org;gr=device-b");
+
+	{
+		MainDbProvider provider;
+		MainDb &mainDb = provider.getMainDb();
+		MainDb::ServerQueuedChatMessage message;
+		message.fromAddress = IdentityAddress("sip:test-3@sip.linphone.org");
+		message.content.setContentType(ContentType::PlainText);
+		message.creationTime = time(nullptr) - 10;
+		message.content.setBody("First");
+		BC_ASSERT_TRUE(mainDb.addServerQueuedChatMessage(conferenceId, message, { deviceA, deviceB }));
+		message.creationTime++;
+		message.content.setBody("Second");
+		BC_ASSERT_TRUE(mainDb.addServerQueuedChatMessage(conferenceId, message, { deviceA }));
+
+		// Device B came back before the restart.
+		BC_ASSERT_EQUAL(mainDb.takeServerQueuedChatMessages(conferenceId, deviceB).size(), 1, size_t, "%zu");
+	}
+
+	// Device A comes back after the restart and gets its messages in order.
+	list<MainDb::ServerQueuedChatMessage> messages = take_stored_server_queued_messages(rwDbPath, conferenceId, deviceA);
+	BC_ASSERT_EQUAL(messages.size(), 2, size_t, "%zu");
+	if (messages.size() == 2) {
+		BC_ASSERT_STRING_EQUAL(messages.front().content.getBodyAsString().c_str(), "First");
+		BC_ASSERT_STRING_EQUAL(messages.back().content.getBodyAsString().c_str(), "Second");
+	}
+	BC_ASSERT_EQUAL(take_stored_server_queued_messages(rwDbPath, conferenceId, deviceA).size(), 0, size_t, "%zu");
+	BC_ASSERT_EQUAL(take_stored_server_queued_messages(rwDbPath, conferenceId, deviceB).size(), 0, size_t, "%zu");
+}
+
+static void server_queued_messages_order (void) {
+	// Messages taken from the database come first, then the ones queued in memory while the database was not available.
+	list<shared_ptr<MainDb::ServerQueuedChatMessage>> messages;
+	const pair<time_t, string> queued[] = {
+		{ 100, "db-1" }, { 300, "db-3" }, { 200, "memory-2" }, { 300, "memory-3" }
+	};
+	for (const auto &entry : queued) {
+		shared_ptr<MainDb::ServerQueuedChatMessage> message = make_shared<MainDb::ServerQueuedChatMessage>();
+		message->creationTime = entry.first;
+		message->content.setBody(entry.second);
+		messages.push_back(message);
+	}
+
+	MainDb::sortServerQueuedChatMessages(messages);
+	const char *expected[] = { "db-1", "memory-2", "db-3", "memory-3" };
+	size_t i = 0;
+	for (const auto &message : messages)
+		BC_ASSERT_STRING_EQUAL(message->content.getBodyAsString().c_str(), expected[i++]);
+}
+
 test_t main_db_tests[] = {
 	TEST_NO_TAG("Get events count", get_events_count),
 	TEST_NO_TAG("Get messages count", get_messages_count),
 	TEST_NO_TAG("Get unread messages count", get_unread_messages_count),
 	TEST_NO_TAG("Get history", get_history),
+	TEST_NO_TAG("Get history before", get_history_before),
 	TEST_NO_TAG("Get conference events", get_conference_notified_events),
 	TEST_NO_TAG("Get chat rooms", get_chat_rooms),
-	TEST_NO_TAG("Load a lot of chatrooms", load_a_lot_of_chatrooms)
+	TEST_NO_TAG("Search chat messages", search_chat_messages),
+	TEST_NO_TAG("Reuse prepared statements", reuse_prepared_statements),
+	TEST_NO_TAG("Cache sip address ids", cache_sip_address_ids),
+	TEST_NO_TAG("Add events benchmark", add_events_benchmark),
+	TEST_NO_TAG("Get history async", get_history_async),
+	TEST_NO_TAG("History retention", history_retention),
+	TEST_NO_TAG("Write behind updates", write_behind_updates),
+	TEST_NO_TAG("Server queued messages", server_queued_messages),
+	TEST_NO_TAG("Server queued messages after restart", server_queued_messages_after_restart),
+	TEST_NO_TAG("Server queued messages order", server_queued_messages_order),
+	TEST_NO_TAG("Load a lot of chatrooms", load_a_lot_of_chatrooms),
+	TEST_NO_TAG("Load a lot of chatrooms benchmark", load_a_lot_of_chatrooms_benchmark)
 };
 
 test_suite_t main_db_test_suite = {
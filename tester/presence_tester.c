@@ -302,6 +302,45 @@ static void presence_information(void) {
 	linphone_core_manager_destroy(pauline);
 }
 
+static void presence_notify_coalescing(void) {
+	LinphoneCoreManager *marie = presence_linphone_core_manager_new("marie");
+	LinphoneCoreManager *pauline = presence_linphone_core_manager_new("pauline");
+	LinphonePresenceModel *presence;
+	int notify_count;
+
+	lp_config_set_int(linphone_core_get_config(pauline->lc), "sip", "presence_notify_coalescing_delay", 500);
+	BC_ASSERT_TRUE(subscribe_to_callee_presence(marie, pauline));
+	notify_count = marie->stat.number_of_NotifyPresenceReceived;
+
+	/* Quick activity changes: only the latest one is notified. */
+	presence = linphone_presence_model_new_with_activity(LinphonePresenceActivityDinner, NULL);
+	linphone_core_set_presence_model(pauline->lc, presence);
+	linphone_presence_model_unref(presence);
+	presence = linphone_presence_model_new_with_activity(LinphonePresenceActivitySteering, NULL);
+	linphone_core_set_presence_model(pauline->lc, presence);
+	linphone_presence_model_unref(presence);
+	presence = linphone_presence_model_new_with_activity(LinphonePresenceActivityVacation, NULL);
+	linphone_core_set_presence_model(pauline->lc, presence);
+	linphone_presence_model_unref(presence);
+
+	BC_ASSERT_TRUE(wait_for(marie->lc, pauline->lc, &marie->stat.number_of_LinphonePresenceActivityVacation, 1));
+	BC_ASSERT_EQUAL(marie->stat.number_of_LinphonePresenceActivityDinner, 0, int, "%d");
+	BC_ASSERT_EQUAL(marie->stat.number_of_LinphonePresenceActivitySteering, 0, int, "%d");
+	BC_ASSERT_EQUAL(marie->stat.number_of_NotifyPresenceReceived, notify_count + 1, int, "%d");
+
+	/* With a min interval, the next change waits for the interval to elapse. */
+	lp_config_set_int(linphone_core_get_config(pauline->lc), "sip", "presence_notify_coalescing_delay", 0);
+	lp_config_set_int(linphone_core_get_config(pauline->lc), "sip", "presence_notify_min_interval", 2000);
+	presence = linphone_presence_model_new_with_activity(LinphonePresenceActivityShopping, NULL);
+	linphone_core_set_presence_model(pauline->lc, presence);
+	linphone_presence_model_unref(presence);
+	BC_ASSERT_FALSE(wait_for_until(marie->lc, pauline->lc, &marie->stat.number_of_LinphonePresenceActivityShopping, 1, 500));
+	BC_ASSERT_TRUE(wait_for_until(marie->lc, pauline->lc, &marie->stat.number_of_LinphonePresenceActivityShopping, 1, 5000));
+	BC_ASSERT_EQUAL(marie->stat.number_of_NotifyPresenceReceived, notify_count + 2, int, "%d");
+
+	linphone_core_manager_destroy(marie);
+	linphone_core_manager_destroy(pauline);
+}
 
 static void subscribe_presence_forked(void){
 	LinphoneCoreManager* marie = linphone_core_manager_new("marie_rc");
@@ -409,6 +448,137 @@ static void simple_subscribe_with_friend_from_rc(void) {
 	linphone_core_manager_destroy(pauline);
 }
 
+/* Documents as sent by Linphone, and as shown in RFC 3863 and RFC 4480. */
+static const char *pidf_corpus[] = {
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	"<presence xmlns=\"urn:ietf:params:xml:ns:pidf\" xmlns:dm=\"urn:ietf:params:xml:ns:pidf:data-model\" "
+	"xmlns:rpid=\"urn:ietf:params:xml:ns:pidf:rpid\" xmlns:pidfonline=\"http://www.linphone.org/xsds/pidfonline.xsd\" "
+	"xmlns:oma-pres=\"urn:oma:xml:prs:pidf:oma-pres\" entity=\"sip:marie@sip.example.org\">\n"
+	"  <tuple id=\"qmtiwo\">\n"
+	"    <status>\n"
+	"      <basic>open</basic>\n"
+	"      <pidfonline:online/>\n"
+	"    </status>\n"
+	"    <contact>sip:marie@sip.example.org</contact>\n"
+	"    <timestamp>2020-05-12T14:02:31Z</timestamp>\n"
+	"    <oma-pres:service-description>\n"
+	"      <oma-pres:service-id>groupchat</oma-pres:service-id>\n"
+	"      <oma-pres:version>1.1</oma-pres:version>\n"
+	"    </oma-pres:service-description>\n"
+	"    <oma-pres:service-description>\n"
+	"      <oma-pres:service-id>lime</oma-pres:service-id>\n"
+	"      <oma-pres:version>1.0</oma-pres:version>\n"
+	"    </oma-pres:service-description>\n"
+	"  </tuple>\n"
+	"  <dm:person id=\"fb7hpk\">\n"
+	"    <rpid:activities>\n"
+	"      <rpid:away/>\n"
+	"    </rpid:activities>\n"
+	"  </dm:person>\n"
+	"</presence>\n",
+
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	"<presence xmlns=\"urn:ietf:params:xml:ns:pidf\" xmlns:dm=\"urn:ietf:params:xml:ns:pidf:data-model\" "
+	"xmlns:rpid=\"urn:ietf:params:xml:ns:pidf:rpid\" entity=\"pres:someone@example.com\">\n"
+	"  <tuple id=\"bs35r9\">\n"
+	"    <status><basic>closed</basic></status>\n"
+	"    <note xml:lang=\"en\">Don't Disturb Please!</note>\n"
+	"    <note xml:lang=\"fr\">Ne derangez pas, s'il vous plait</note>\n"
+	"    <contact priority=\"0.8\">im:someone@mobilecarrier.net</contact>\n"
+	"    <timestamp>2005-05-30T22:00:29Z</timestamp>\n"
+	"  </tuple>\n"
+	"  <dm:person id=\"p1\">\n"
+	"    <rpid:activities>\n"
+	"      <rpid:note>Lunch with customers</rpid:note>\n"
+	"      <rpid:meeting/>\n"
+	"      <rpid:on-the-phone/>\n"
+	"    </rpid:activities>\n"
+	"    <dm:note>Busy until 3pm</dm:note>\n"
+	"  </dm:person>\n"
+	"  <note>I'll be in Tokyo next week</note>\n"
+	"</presence>\n",
+
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	"<presence xmlns=\"urn:ietf:params:xml:ns:pidf\" entity=\"pres:someone@example.com\">\n"
+	"  <tuple id=\"sg89ae\">\n"
+	"    <status><basic>open</basic></status>\n"
+	"    <contact priority=\"0.8\">tel:+09012345678</contact>\n"
+	"  </tuple>\n"
+	"</presence>\n"
+};
+
+static void check_pidf_corpus_models(LinphonePresenceModel **models) {
+	LinphonePresenceService *service;
+	LinphonePresencePerson *person;
+	bctbx_list_t *descriptions;
+	char *contact;
+
+	BC_ASSERT_TRUE(linphone_presence_model_is_online(models[0]));
+	BC_ASSERT_EQUAL(linphone_presence_model_get_basic_status(models[0]), LinphonePresenceBasicStatusOpen, int, "%d");
+	BC_ASSERT_EQUAL(linphone_presence_model_get_nb_services(models[0]), 1, int, "%d");
+	service = linphone_presence_model_get_nth_service(models[0], 0);
+	descriptions = linphone_presence_service_get_service_descriptions(service);
+	BC_ASSERT_EQUAL((int)bctbx_list_size(descriptions), 2, int, "%d");
+	contact = linphone_presence_service_get_contact(service);
+	BC_ASSERT_STRING_EQUAL(contact, "sip:marie@sip.example.org");
+	if (contact) ms_free(contact);
+	BC_ASSERT_EQUAL(linphone_presence_model_get_nb_persons(models[0]), 1, int, "%d");
+	BC_ASSERT_EQUAL(linphone_presence_model_get_activity(models[0]) ? (int)linphone_presence_activity_get_type(linphone_presence_model_get_activity(models[0])) : -1,
+		LinphonePresenceActivityAway, int, "%d");
+
+	BC_ASSERT_FALSE(linphone_presence_model_is_online(models[1]));
+	BC_ASSERT_EQUAL(linphone_presence_model_get_basic_status(models[1]), LinphonePresenceBasicStatusClosed, int, "%d");
+	service = linphone_presence_model_get_nth_service(models[1], 0);
+	BC_ASSERT_EQUAL(linphone_presence_service_get_nb_notes(service), 2, int, "%d");
+	person = linphone_presence_model_get_nth_person(models[1], 0);
+	BC_ASSERT_EQUAL(linphone_presence_person_get_nb_activities(person), 2, int, "%d");
+	BC_ASSERT_EQUAL(linphone_presence_person_get_nb_activities_notes(person), 1, int, "%d");
+	BC_ASSERT_EQUAL(linphone_presence_person_get_nb_notes(person), 1, int, "%d");
+	BC_ASSERT_PTR_NOT_NULL(linphone_presence_model_get_note(models[1], NULL));
+
+	BC_ASSERT_EQUAL(linphone_presence_model_get_nb_services(models[2]), 1, int, "%d");
+	BC_ASSERT_EQUAL(linphone_presence_model_get_nb_persons(models[2]), 0, int, "%d");
+	BC_ASSERT_EQUAL(linphone_presence_model_get_basic_status(models[2]), LinphonePresenceBasicStatusOpen, int, "%d");
+}
+
+static void pidf_parsing_benchmark(void) {
+	const int nb_docs = (int)(sizeof(pidf_corpus) / sizeof(pidf_corpus[0]));
+	const int iterations = 2000;
+	LinphonePresenceModel *models[sizeof(pidf_corpus) / sizeof(pidf_corpus[0])] = {NULL};
+	unsigned int allocations = 0;
+	unsigned int total_allocations = 0;
+	uint64_t begin, elapsed;
+	int i, j;
+
+	for (j = 0; j < nb_docs; j++) {
+		models[j] = linphone_presence_model_parse_pidf(pidf_corpus[j], &allocations);
+		total_allocations += allocations;
+		if (!BC_ASSERT_PTR_NOT_NULL(models[j])) goto end;
+	}
+	check_pidf_corpus_models(models);
+	ms_message("PIDF parsing: %.1f libxml2 allocations per document", (double)total_allocations / nb_docs);
+
+	/* An invalid basic status makes the whole document invalid. */
+	BC_ASSERT_PTR_NULL(linphone_presence_model_parse_pidf(
+		"<presence xmlns=\"urn:ietf:params:xml:ns:pidf\"><tuple id=\"a\"><status><basic>maybe</basic></status></tuple></presence>", NULL));
+
+	begin = ms_get_cur_time_ms();
+	for (i = 0; i < iterations; i++) {
+		for (j = 0; j < nb_docs; j++) {
+			LinphonePresenceModel *model = linphone_presence_model_parse_pidf(pidf_corpus[j], NULL);
+			if (model) linphone_presence_model_unref(model);
+		}
+	}
+	elapsed = ms_get_cur_time_ms() - begin;
+	ms_message("PIDF parsing: %i documents in %i ms, %.0f documents/s", iterations * nb_docs, (int)elapsed,
+		elapsed > 0 ? (double)(iterations * nb_docs) * 1000.0 / (double)elapsed : 0.0);
+
+end:
+	for (j = 0; j < nb_docs; j++) {
+		if (models[j]) linphone_presence_model_unref(models[j]);
+	}
+}
+
 test_t presence_tests[] = {
 	TEST_ONE_TAG("Simple Subscribe", simple_subscribe,"presence"),
 	TEST_ONE_TAG("Simple Subscribe with early NOTIFY", simple_subscribe_with_early_notify,"presence"),
@@ -416,9 +586,11 @@ test_t presence_tests[] = {
 	/*TEST_ONE_TAG("Call with presence", call_with_presence, "LeaksMemory"),*/
 	TEST_NO_TAG("Unsubscribe while subscribing", unsubscribe_while_subscribing),
 	TEST_NO_TAG("Presence information", presence_information),
+	TEST_NO_TAG("Presence NOTIFY coalescing", presence_notify_coalescing),
 	TEST_ONE_TAG("App managed presence failure", subscribe_failure_handle_by_app,"presence"),
 	TEST_NO_TAG("Presence SUBSCRIBE forked", subscribe_presence_forked),
 	TEST_NO_TAG("Presence SUBSCRIBE expired", subscribe_presence_expired),
+	TEST_NO_TAG("PIDF parsing benchmark", pidf_parsing_benchmark),
 };
 
 test_suite_t presence_test_suite = {"Presence", NULL, NULL, liblinphone_tester_before_each, liblinphone_tester_after_each,
@@ -318,6 +318,207 @@ static void linphone_lpconfig_from_file_zerolen_value(void){
 	lp_config_destroy(conf);
 }
 
+static void linphone_lpconfig_lookup_benchmark(void){
+	/* Realistic linphonerc size: 100 sections of 20 entries. */
+	char *buffer = ms_strdup("");
+	char section[32];
+	char key[32];
+	LpConfig* conf;
+	uint64_t begin, end;
+	int i, j;
+	int found = 0;
+
+	for (i = 0; i < 100; i++) {
+		buffer = ms_strcat_printf(buffer, "[section_%i]\n", i);
+		for (j = 0; j < 20; j++) {
+			buffer = ms_strcat_printf(buffer, "key_%i=%i\n", j, i * 20 + j);
+		}
+	}
+	conf = lp_config_new_from_buffer(buffer);
+	ms_free(buffer);
+
+	begin = ms_get_cur_time_ms();
+	for (i = 0; i < 200000; i++) {
+		snprintf(section, sizeof(section), "section_%i", (i * 7) % 100);
+		snprintf(key, sizeof(key), "key_%i", i % 20);
+		if (lp_config_get_string(conf, section, key, NULL)) found++;
+		if (lp_config_get_int(conf, section, key, -1) == ((i * 7) % 100) * 20 + i % 20) found++;
+	}
+	end = ms_get_cur_time_ms();
+	ms_message("400000 lookups in a 2000 entries config done in %i ms", (int)(end - begin));
+	BC_ASSERT_EQUAL(found, 400000, int, "%i");
+
+	BC_ASSERT_EQUAL(lp_config_get_int(conf, "section_unknown", "key_0", -1), -1, int, "%i");
+	BC_ASSERT_EQUAL(lp_config_get_int(conf, "section_0", "key_unknown", -1), -1, int, "%i");
+	lp_config_set_string(conf, "section_0", "key_0", NULL);
+	BC_ASSERT_EQUAL(lp_config_get_int(conf, "section_0", "key_0", -1), -1, int, "%i");
+	lp_config_clean_section(conf, "section_1");
+	BC_ASSERT_FALSE(lp_config_has_section(conf, "section_1"));
+	lp_config_set_int(conf, "section_1", "key_0", 42);
+	BC_ASSERT_EQUAL(lp_config_get_int(conf, "section_1", "key_0", -1), 42, int, "%i");
+	lp_config_destroy(conf);
+}
+
+static void linphone_lpconfig_flush(void){
+	char *rc_path = bc_tester_file("lpconfig_flush_rc");
+	LpConfig *conf;
+	LpConfig *reloaded;
+
+	unlink(rc_path);
+	conf = lp_config_new(rc_path);
+	BC_ASSERT_PTR_NOT_NULL(conf);
+	if (!conf) goto end;
+
+	lp_config_set_int(conf, "flush", "first", 1);
+	lp_config_set_string(conf, "flush", "second", "value");
+	BC_ASSERT_TRUE(lp_config_needs_commit(conf));
+	BC_ASSERT_EQUAL(linphone_config_flush(conf), 0, int, "%i");
+	BC_ASSERT_FALSE(lp_config_needs_commit(conf));
+	/* Nothing left to write, flushing again is a no-op. */
+	BC_ASSERT_EQUAL(linphone_config_flush(conf), 0, int, "%i");
+
+	reloaded = lp_config_new(rc_path);
+	BC_ASSERT_EQUAL(lp_config_get_int(reloaded, "flush", "first", -1), 1, int, "%i");
+	BC_ASSERT_STRING_EQUAL(lp_config_get_string(reloaded, "flush", "second", NULL), "value");
+	lp_config_destroy(reloaded);
+
+	lp_config_set_int(conf, "flush", "first", 2);
+	BC_ASSERT_EQUAL(lp_config_sync(conf), 0, int, "%i");
+	reloaded = lp_config_new(rc_path);
+	BC_ASSERT_EQUAL(lp_config_get_int(reloaded, "flush", "first", -1), 2, int, "%i");
+	lp_config_destroy(reloaded);
+
+	lp_config_destroy(conf);
+	unlink(rc_path);
+end:
+	bc_free(rc_path);
+}
+
+static void write_text_file(const char *path, const char *content){
+	FILE *f = fopen(path, "w");
+	if (!BC_ASSERT_PTR_NOT_NULL(f)) return;
+	fputs(content, f);
+	fclose(f);
+}
+
+static void linphone_lpconfig_binary_cache(void){
+	char *rc_path = bc_tester_file("lpconfig_cache_rc");
+	char *factory_path = bc_tester_file("lpconfig_cache_factory_rc");
+	char *cache_path = bc_tester_file("lpconfig_cache_rc.bin");
+	char *core_cache_path;
+	LinphoneCore *lc;
+	LpConfig *conf;
+
+	write_text_file(rc_path, "[sip]\n#a comment\nsip_port=5060\nempty=\n[proxy_0 overwrite=true]\nreg_proxy=<sip:example.org>\n");
+	write_text_file(factory_path, "[sip]\nsip_port=5070\n[misc]\nfactory=1\n");
+	unlink(cache_path);
+
+	/* No snapshot yet: the files are parsed and the snapshot is built. */
+	conf = linphone_config_new_with_cache(rc_path, factory_path, cache_path);
+	BC_ASSERT_EQUAL(lp_config_get_int(conf, "sip", "sip_port", -1), 5070, int, "%i");
+	lp_config_destroy(conf);
+	BC_ASSERT_EQUAL(ortp_file_exist(cache_path), 0, int, "%i");
+
+	/* Valid snapshot: the merged config is the same. */
+	conf = linphone_config_new_with_cache(rc_path, factory_path, cache_path);
+	BC_ASSERT_EQUAL(lp_config_get_int(conf, "sip", "sip_port", -1), 5070, int, "%i");
+	BC_ASSERT_EQUAL(lp_config_get_int(conf, "misc", "factory", -1), 1, int, "%i");
+	BC_ASSERT_STRING_EQUAL(lp_config_get_string(conf, "proxy_0", "reg_proxy", NULL), "<sip:example.org>");
+	BC_ASSERT_FALSE(lp_config_has_entry(conf, "sip", "empty"));
+	BC_ASSERT_FALSE(lp_config_needs_commit(conf));
+
+	/* Writing the config refreshes the snapshot. */
+	lp_config_set_int(conf, "sip", "sip_port", 5080);
+	lp_config_set_int(conf, "misc", "factory", 2);
+	BC_ASSERT_EQUAL(lp_config_sync(conf), 0, int, "%i");
+	lp_config_destroy(conf);
+	conf = linphone_config_new_with_cache(rc_path, NULL, cache_path);
+	/* The factory file is not given anymore, the snapshot is outdated. */
+	BC_ASSERT_EQUAL(lp_config_get_int(conf, "sip", "sip_port", -1), 5080, int, "%i");
+	BC_ASSERT_EQUAL(lp_config_get_int(conf, "misc", "factory", -1), 2, int, "%i");
+	lp_config_destroy(conf);
+
+	/* The config file is modified by someone else: the snapshot is outdated. */
+	write_text_file(rc_path, "[sip]\nsip_port=5090\n");
+	conf = linphone_config_new_with_cache(rc_path, NULL, cache_path);
+	BC_ASSERT_EQUAL(lp_config_get_int(conf, "sip", "sip_port", -1), 5090, int, "%i");
+	BC_ASSERT_FALSE(lp_config_has_section(conf, "misc"));
+	lp_config_destroy(conf);
+
+	/* Cores only use a snapshot when the application opts in through the factory. */
+	core_cache_path = bctbx_strdup_printf("%s.cache", rc_path);
+	unlink(core_cache_path);
+	lc = linphone_factory_create_core_2(linphone_factory_get(), NULL, NULL, rc_path, NULL, system_context);
+	if (BC_ASSERT_PTR_NOT_NULL(lc)) linphone_core_unref(lc);
+	BC_ASSERT_NOT_EQUAL(ortp_file_exist(core_cache_path), 0, int, "%i");
+	linphone_factory_enable_config_cache(linphone_factory_get(), TRUE);
+	lc = linphone_factory_create_core_2(linphone_factory_get(), NULL, NULL, rc_path, NULL, system_context);
+	if (BC_ASSERT_PTR_NOT_NULL(lc)) linphone_core_unref(lc);
+	linphone_factory_enable_config_cache(linphone_factory_get(), FALSE);
+	BC_ASSERT_EQUAL(ortp_file_exist(core_cache_path), 0, int, "%i");
+	unlink(core_cache_path);
+	bctbx_free(core_cache_path);
+
+	unlink(rc_path);
+	unlink(factory_path);
+	unlink(cache_path);
+	bc_free(rc_path);
+	bc_free(factory_path);
+	bc_free(cache_path);
+}
+
+/* The core hands modified configs over to the background writer from linphone_core_iterate(), once per second. */
+static bool_t wait_for_background_sync(LinphoneCore *lc){
+	LpConfig *conf = linphone_core_get_config(lc);
+	MSTimeSpec start;
+
+	liblinphone_tester_clock_start(&start);
+	while (lp_config_needs_commit(conf) && !liblinphone_tester_clock_elapsed(&start, 5000)){
+		linphone_core_iterate(lc);
+		ms_usleep(20000);
+	}
+	return !lp_config_needs_commit(conf);
+}
+
+static void linphone_lpconfig_background_sync(void){
+	char *rc_path = bc_tester_file("lpconfig_background_sync_rc");
+	LinphoneCore *lc;
+	LpConfig *conf;
+	LpConfig *reloaded;
+	int write_count;
+	int i;
+
+	unlink(rc_path);
+	lc = linphone_factory_create_core_2(linphone_factory_get(), NULL, NULL, rc_path, NULL, system_context);
+	if (!BC_ASSERT_PTR_NOT_NULL(lc)) goto end;
+	conf = linphone_core_get_config(lc);
+
+	lp_config_set_int(conf, "background", "value", 0);
+	BC_ASSERT_TRUE(wait_for_background_sync(lc));
+	BC_ASSERT_EQUAL(linphone_config_flush(conf), 0, int, "%i");
+	write_count = _linphone_config_get_background_write_count(conf);
+	BC_ASSERT_GREATER(write_count, 1, int, "%i");
+
+	/* Snapshots taken while the writer is busy replace each other, only the last one is written. */
+	_linphone_config_pause_background_writer(conf, TRUE);
+	for (i = 1; i <= 3; i++){
+		lp_config_set_int(conf, "background", "value", i);
+		BC_ASSERT_TRUE(wait_for_background_sync(lc));
+	}
+	BC_ASSERT_EQUAL(_linphone_config_get_background_write_count(conf), write_count, int, "%i");
+	BC_ASSERT_EQUAL(linphone_config_flush(conf), 0, int, "%i");
+	BC_ASSERT_EQUAL(_linphone_config_get_background_write_count(conf), write_count + 1, int, "%i");
+
+	reloaded = lp_config_new(rc_path);
+	BC_ASSERT_EQUAL(lp_config_get_int(reloaded, "background", "value", -1), 3, int, "%i");
+	lp_config_destroy(reloaded);
+
+	linphone_core_unref(lc);
+	unlink(rc_path);
+end:
+	bc_free(rc_path);
+}
+
 static void linphone_lpconfig_from_xml_zerolen_value(void){
 	const char* zero_xml_file = "remote_zero_length_params_rc";
 	char* xml_path = ms_strdup_printf("%s/rcfiles/%s", bc_tester_get_resource_dir_prefix(), zero_xml_file);
@@ -1662,6 +1863,10 @@ test_t setup_tests[] = {
 	TEST_NO_TAG("LPConfig zero_len value from buffer", linphone_lpconfig_from_buffer_zerolen_value),
 	TEST_NO_TAG("LPConfig zero_len value from file", linphone_lpconfig_from_file_zerolen_value),
 	TEST_NO_TAG("LPConfig zero_len value from XML", linphone_lpconfig_from_xml_zerolen_value),
+	TEST_NO_TAG("LPConfig lookup benchmark", linphone_lpconfig_lookup_benchmark),
+	TEST_NO_TAG("LPConfig flush", linphone_lpconfig_flush),
+	TEST_NO_TAG("LPConfig background sync", linphone_lpconfig_background_sync),
+	TEST_NO_TAG("LPConfig binary cache", linphone_lpconfig_binary_cache),
 	TEST_NO_TAG("Chat room", chat_room_test),
 	TEST_NO_TAG("Devices reload", devices_reload_test),
 	TEST_NO_TAG("Codec usability", codec_usability_test),
@@ -17,8 +17,12 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <thread>
+
 #include "linphone/utils/utils.h"
 
+#include "address/identity-address-parser.h"
+
 #include "liblinphone_tester.h"
 #include "tester_utils.h"
 
@@ -72,9 +76,91 @@ static void trim () {
 	BC_ASSERT_STRING_EQUAL(result.c_str(), "hello world!");
 }
 
+static void identity_address_parser () {
+	IdentityAddressParser *parser = IdentityAddressParser::getInstance();
+	const int capacity = parser->getCacheCapacity();
+	const bool fastParsingEnabled = parser->isFastParsingEnabled();
+	const vector<string> inputs = {
+		"sip:alice@sip.example.org",
+		"sips:bob.smith@example.org;gr=urn:uuid:5a3e8b5c-2bd2-4fa4-b6a9-2bd3c8a6c7b1",
+		"sip:d%40ve@example.org;gr=abc"
+	};
+
+	// The fast path and the grammar must agree.
+	for (const auto &input : inputs) {
+		parser->clearCache();
+		parser->enableFastParsing(false);
+		shared_ptr<IdentityAddress> grammarAddress = parser->parseAddress(input);
+		parser->clearCache();
+		parser->enableFastParsing(true);
+		shared_ptr<IdentityAddress> fastAddress = parser->parseAddress(input);
+		if (!BC_ASSERT_PTR_NOT_NULL(grammarAddress) || !BC_ASSERT_PTR_NOT_NULL(fastAddress))
+			continue;
+		BC_ASSERT_STRING_EQUAL(fastAddress->getScheme().c_str(), grammarAddress->getScheme().c_str());
+		BC_ASSERT_STRING_EQUAL(fastAddress->getUsername().c_str(), grammarAddress->getUsername().c_str());
+		BC_ASSERT_STRING_EQUAL(fastAddress->getDomain().c_str(), grammarAddress->getDomain().c_str());
+		BC_ASSERT_STRING_EQUAL(fastAddress->getGruu().c_str(), grammarAddress->getGruu().c_str());
+	}
+
+	// The cache is bounded and the least recently used addresses are parsed again. Each shard holds at least
+	// LruCache::MinCapacity addresses, hence a capacity of 10 per shard.
+	parser->clearCache();
+	parser->setCacheCapacity(IdentityAddressParser::CacheShardCount * 10);
+	parser->resetCacheStats();
+	for (int i = 0; i < 2000; i++)
+		parser->parseAddress("sip:user_" + Utils::toString(i) + "@sip.example.org");
+	parser->parseAddress("sip:user_1999@sip.example.org");
+	parser->parseAddress("sip:user_0@sip.example.org");
+	BC_ASSERT_EQUAL((int)parser->getCacheStats().hits, 1, int, "%d");
+	BC_ASSERT_EQUAL((int)parser->getCacheStats().misses, 2001, int, "%d");
+	BC_ASSERT_EQUAL((int)parser->getCacheStats().fastParses, 2001, int, "%d");
+	BC_ASSERT_TRUE(parser->getCacheHitRate() > 0. && parser->getCacheHitRate() < 0.1);
+
+	parser->setCacheCapacity(capacity);
+	parser->enableFastParsing(fastParsingEnabled);
+	parser->resetCacheStats();
+}
+
+static void identity_address_parser_threads () {
+	IdentityAddressParser *parser = IdentityAddressParser::getInstance();
+	const int capacity = parser->getCacheCapacity();
+	const int threadCount = 4;
+	const int parsesPerThread = 500;
+
+	// A small cache shared by several threads: lookups and evictions keep reordering its shards.
+	parser->clearCache();
+	parser->setCacheCapacity(10);
+	parser->resetCacheStats();
+	vector<thread> threads;
+	vector<int> failures(threadCount, 0);
+	for (int t = 0; t < threadCount; t++) {
+		threads.emplace_back([parser, &failures, t] {
+			for (int i = 0; i < parsesPerThread; i++) {
+				string username = "user_" + Utils::toString((i * (t + 1)) % 300);
+				shared_ptr<IdentityAddress> address = parser->parseAddress("sip:" + username + "@sip.example.org");
+				if (!address || address->getUsername() != username)
+					failures[t]++;
+			}
+		});
+	}
+	for (auto &t : threads)
+		t.join();
+
+	for (int t = 0; t < threadCount; t++)
+		BC_ASSERT_EQUAL(failures[t], 0, int, "%d");
+	IdentityAddressParser::CacheStats stats = parser->getCacheStats();
+	BC_ASSERT_EQUAL((int)(stats.hits + stats.misses), threadCount * parsesPerThread, int, "%d");
+	BC_ASSERT_EQUAL(parser->getCacheCapacity(), 10, int, "%d");
+
+	parser->setCacheCapacity(capacity);
+	parser->resetCacheStats();
+}
+
 test_t utils_tests[] = {
 	TEST_NO_TAG("split", split),
-	TEST_NO_TAG("trim", trim)
+	TEST_NO_TAG("trim", trim),
+	TEST_NO_TAG("Identity address parser", identity_address_parser),
+	TEST_NO_TAG("Identity address parser threads", identity_address_parser_threads)
 };
 
 test_suite_t utils_test_suite = {
@@ -262,6 +262,7 @@ static void friends_sqlite_storage(void) {
 	LinphoneFriendListStats *stats = (LinphoneFriendListStats *)ms_new0(LinphoneFriendListStats, 1);
 	const LinphoneAddress *laddress = NULL, *laddress2 = NULL;
 	char *address = NULL, *address2 = NULL;
+	bctbx_list_t *phone_numbers = NULL;
 
 	cbs = linphone_factory_create_core_cbs(linphone_factory_get());
 	linphone_core_cbs_set_friend_list_created(cbs, friend_list_created_cb);
@@ -286,6 +287,7 @@ static void friends_sqlite_storage(void) {
 	linphone_vcard_unref(lvc);
 	linphone_friend_set_address(lf, addr);
 	linphone_friend_set_name(lf, "Sylvain");
+	linphone_friend_add_phone_number(lf, "+33612345678");
 
 	linphone_core_add_friend_list(lc, lfl);
 	wait_for_until(lc, NULL, &stats->new_list_count, 1, 1000);
@@ -317,13 +319,24 @@ static void friends_sqlite_storage(void) {
 	lf2 = (LinphoneFriend *)friends_from_db->data;
 	BC_ASSERT_STRING_EQUAL(linphone_friend_get_name(lf2), linphone_friend_get_name(lf));
 	BC_ASSERT_EQUAL(linphone_friend_get_storage_id(lf2), linphone_friend_get_storage_id(lf), unsigned int, "%u");
-	BC_ASSERT_STRING_EQUAL(linphone_vcard_get_etag(linphone_friend_get_vcard(lf2)), linphone_vcard_get_etag(linphone_friend_get_vcard(lf)));
-	BC_ASSERT_STRING_EQUAL(linphone_vcard_get_url(linphone_friend_get_vcard(lf2)), linphone_vcard_get_url(linphone_friend_get_vcard(lf)));
 	laddress = linphone_friend_get_address(lf);
 	address = linphone_address_as_string(laddress);
 	laddress2 = linphone_friend_get_address(lf2);
 	address2 = linphone_address_as_string(laddress2);
 	BC_ASSERT_STRING_EQUAL(address2, address);
+	phone_numbers = linphone_friend_get_phone_numbers(lf2);
+	BC_ASSERT_EQUAL((unsigned int)bctbx_list_size(phone_numbers), 1, unsigned int, "%u");
+	if (phone_numbers) BC_ASSERT_STRING_EQUAL((const char *)bctbx_list_get_data(phone_numbers), "+33612345678");
+	bctbx_list_free(phone_numbers);
+	/* The vCard itself is only parsed from here */
+	BC_ASSERT_STRING_EQUAL(linphone_vcard_get_etag(linphone_friend_get_vcard(lf2)), linphone_vcard_get_etag(linphone_friend_get_vcard(lf)));
+	BC_ASSERT_STRING_EQUAL(linphone_vcard_get_url(linphone_friend_get_vcard(lf2)), linphone_vcard_get_url(linphone_friend_get_vcard(lf)));
+	BC_ASSERT_STRING_EQUAL(linphone_friend_get_name(lf2), linphone_friend_get_name(lf));
+	/* The cached values are dropped once the vCard is parsed, the address is now read from the vCard */
+	ms_free(address2);
+	laddress2 = linphone_friend_get_address(lf2);
+	address2 = linphone_address_as_string(laddress2);
+	BC_ASSERT_STRING_EQUAL(address2, address);
 
 	ms_free(address);
 	ms_free(address2);
@@ -1018,6 +1031,129 @@ end:
 	linphone_core_manager_destroy(manager);
 }
 
+static void find_friend_by_subscription_call_id_test(void) {
+	LinphoneCoreManager *marie = linphone_core_manager_new("marie_rc");
+	LinphoneCoreManager *pauline = linphone_core_manager_new(transport_supported(LinphoneTransportTls) ? "pauline_rc" : "pauline_tcp_rc");
+	LinphoneFriendList *lfl = linphone_core_get_default_friend_list(marie->lc);
+	LinphoneFriend *lf = linphone_core_create_friend(marie->lc);
+	char *call_id = NULL;
+
+	linphone_friend_set_address(lf, pauline->identity);
+	linphone_friend_enable_subscribes(lf, TRUE);
+	linphone_friend_list_add_friend(lfl, lf);
+	BC_ASSERT_TRUE(wait_for(marie->lc, pauline->lc, &marie->stat.number_of_NotifyPresenceReceived, 1));
+
+	if (linphone_friend_get_out_subscribe_call_id(lf))
+		call_id = ms_strdup(linphone_friend_get_out_subscribe_call_id(lf));
+	if (!BC_ASSERT_PTR_NOT_NULL(call_id)) goto end;
+
+	BC_ASSERT_PTR_EQUAL(linphone_friend_list_find_friend_by_out_subscribe_of(lfl, lf), lf);
+	BC_ASSERT_PTR_EQUAL(linphone_friend_list_find_friend_by_call_id(lfl, call_id), lf);
+
+	linphone_friend_list_remove_friend(lfl, lf);
+	BC_ASSERT_PTR_NULL(linphone_friend_list_find_friend_by_call_id(lfl, call_id));
+
+end:
+	if (call_id) ms_free(call_id);
+	linphone_friend_unref(lf);
+	linphone_core_manager_destroy(marie);
+	linphone_core_manager_destroy(pauline);
+}
+
+static void add_lot_of_local_friends(LinphoneCore *lc, int count) {
+	LinphoneFriendList *lfl = linphone_core_get_default_friend_list(lc);
+	char uri[64];
+	char key[64];
+	int i;
+
+	for (i = 0; i < count; i++) {
+		LinphoneFriend *lf;
+		snprintf(uri, sizeof(uri), "sip:friend_%i@sip.example.org", i);
+		snprintf(key, sizeof(key), "key_%i", i);
+		lf = linphone_core_create_friend_with_address(lc, uri);
+		linphone_friend_set_ref_key(lf, key);
+		linphone_friend_enable_subscribes(lf, FALSE);
+		linphone_friend_list_add_local_friend(lfl, lf);
+		linphone_friend_unref(lf);
+	}
+}
+
+static void find_friend_in_lot_of_friends_benchmark(void) {
+	LinphoneCoreManager *marie = linphone_core_manager_new("marie_rc");
+	LinphoneCoreManager *pauline = linphone_core_manager_new(transport_supported(LinphoneTransportTls) ? "pauline_rc" : "pauline_tcp_rc");
+	LinphoneFriendList *lfl = linphone_core_get_default_friend_list(marie->lc);
+	LinphoneFriend *pauline_friend = linphone_core_create_friend(marie->lc);
+	LinphoneFriend *marie_friend = linphone_core_create_friend(pauline->lc);
+	uint64_t begin, end;
+	char uri[64];
+	char key[64];
+	int i;
+	int found_by_address = 0;
+	int found_by_ref_key = 0;
+	int found_by_out_subscribe = 0;
+	int found_by_inc_subscribe = 0;
+
+	begin = ms_get_cur_time_ms();
+	add_lot_of_local_friends(marie->lc, 50000);
+	end = ms_get_cur_time_ms();
+	ms_message("50000 friends added in %i ms", (int)(end - begin));
+	BC_ASSERT_GREATER((unsigned int)bctbx_list_size(linphone_friend_list_get_friends(lfl)), 50000, unsigned int, "%u");
+
+	begin = ms_get_cur_time_ms();
+	for (i = 0; i < 50000; i++) {
+		LinphoneAddress *addr;
+		snprintf(uri, sizeof(uri), "sip:friend_%i@sip.example.org", i);
+		addr = linphone_address_new(uri);
+		if (linphone_core_find_friend(marie->lc, addr)) found_by_address++;
+		linphone_address_unref(addr);
+	}
+	end = ms_get_cur_time_ms();
+	ms_message("50000 friends found by address in %i ms", (int)(end - begin));
+	BC_ASSERT_EQUAL(found_by_address, 50000, int, "%i");
+
+	begin = ms_get_cur_time_ms();
+	for (i = 0; i < 50000; i++) {
+		snprintf(key, sizeof(key), "key_%i", i);
+		if (linphone_core_get_friend_by_ref_key(marie->lc, key)) found_by_ref_key++;
+	}
+	end = ms_get_cur_time_ms();
+	ms_message("50000 friends found by ref key in %i ms", (int)(end - begin));
+	BC_ASSERT_EQUAL(found_by_ref_key, 50000, int, "%i");
+
+	/* Marie subscribes to Pauline, both having a lot of other friends: the subscription is found among all of them. */
+	add_lot_of_local_friends(pauline->lc, 50000);
+	linphone_friend_set_address(marie_friend, marie->identity);
+	linphone_friend_enable_subscribes(marie_friend, FALSE);
+	linphone_friend_list_add_friend(linphone_core_get_default_friend_list(pauline->lc), marie_friend);
+	linphone_friend_set_address(pauline_friend, pauline->identity);
+	linphone_friend_enable_subscribes(pauline_friend, TRUE);
+	linphone_friend_list_add_friend(lfl, pauline_friend);
+	BC_ASSERT_TRUE(wait_for(marie->lc, pauline->lc, &marie->stat.number_of_NotifyPresenceReceived, 1));
+	if (!BC_ASSERT_PTR_NOT_NULL(linphone_friend_get_out_subscribe_call_id(pauline_friend))) goto end;
+
+	begin = ms_get_cur_time_ms();
+	for (i = 0; i < 50000; i++) {
+		if (linphone_core_find_friend_by_out_subscribe_of(marie->lc, pauline_friend) == pauline_friend) found_by_out_subscribe++;
+	}
+	end = ms_get_cur_time_ms();
+	ms_message("50000 friends found by outgoing subscription in %i ms", (int)(end - begin));
+	BC_ASSERT_EQUAL(found_by_out_subscribe, 50000, int, "%i");
+
+	begin = ms_get_cur_time_ms();
+	for (i = 0; i < 50000; i++) {
+		if (linphone_core_find_friend_by_inc_subscribe_of(pauline->lc, marie_friend) == marie_friend) found_by_inc_subscribe++;
+	}
+	end = ms_get_cur_time_ms();
+	ms_message("50000 friends found by incoming subscription in %i ms", (int)(end - begin));
+	BC_ASSERT_EQUAL(found_by_inc_subscribe, 50000, int, "%i");
+
+end:
+	linphone_friend_unref(pauline_friend);
+	linphone_friend_unref(marie_friend);
+	linphone_core_manager_destroy(marie);
+	linphone_core_manager_destroy(pauline);
+}
+
 test_t vcard_tests[] = {
 	TEST_NO_TAG("Import / Export friends from vCards", linphone_vcard_import_export_friends_test),
 	TEST_NO_TAG("Import a lot of friends from vCards", linphone_vcard_import_a_lot_of_friends_test),
@@ -1038,7 +1174,9 @@ test_t vcard_tests[] = {
 	TEST_NO_TAG("Find friend by ref key", find_friend_by_ref_key_test),
 	TEST_NO_TAG("create a map and insert 20000 objects", insert_lot_of_friends_map_test),
 	TEST_NO_TAG("Find ref key in 20000 objects map", find_friend_by_ref_key_in_lot_of_friends_test),
-	TEST_NO_TAG("Find friend by ref key in empty list", find_friend_by_ref_key_empty_list_test)
+	TEST_NO_TAG("Find friend by ref key in empty list", find_friend_by_ref_key_empty_list_test),
+	TEST_NO_TAG("Find friend by subscription Call-ID", find_friend_by_subscription_call_id_test),
+	TEST_NO_TAG("Find friends among 50000 friends benchmark", find_friend_in_lot_of_friends_benchmark)
 };
 
 test_suite_t vcard_test_suite = {